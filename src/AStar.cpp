@@ -58,10 +58,18 @@ namespace PathAlgorithm
 		static const int xOffset[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
 		static const int yOffset[] = { 1, 1, 0, -1, -1, -1, 0, 1 };
 
-		const std::vector< Model::WallPtr >& walls = Model::RobotWorld::getRobotWorld().getWalls();
+		// Only the walls near aVertex can be within aFreeRadius of a neighbour
+		const std::vector< Model::WallPtr > walls = Model::RobotWorld::getRobotWorld().getWallsIn( Model::SpatialIndex::Bounds::around( aVertex.asPoint(), aFreeRadius + 1));
+		Utils::LineSegmentBatch wallLines;
+		wallLines.reserve( walls.size());
+		for (Model::WallPtr wall : walls)
+		{
+			wallLines.add( wall->getPoint1(), wall->getPoint2());
+		}
 		std::vector< Vertex > neighbours;
 
-		const std::vector<Model::RobotPtr>& robots = Model::RobotWorld::getRobotWorld().getRobots();
+		Model::WorldSnapshotPtr worldSnapshot = Model::RobotWorld::getRobotWorld().getSnapshot();
+		const std::vector<Model::RobotPtr>& robots = worldSnapshot->getRobots();
 		Model::RobotPtr remoteRobot;
 		if (robots.size() > 1)
 		{
@@ -73,16 +81,13 @@ namespace PathAlgorithm
 			bool addToNeigbours = true;
 
 			Vertex vertex( aVertex.x + xOffset[i], aVertex.y + yOffset[i]);
-			for (Model::WallPtr wall : walls)
+			if (Utils::Shape2DUtils::isOnAnyLine( wallLines, vertex.asPoint(), aFreeRadius))
 			{
-				if (Utils::Shape2DUtils::isOnLine( wall->getPoint1(), wall->getPoint2(), vertex.asPoint(), aFreeRadius))
-				{
-					addToNeigbours = false;
-					break;
-				}
+				addToNeigbours = false;
 			}
 			if (remoteRobot) {
-				wxPoint translatedPoints[] = { remoteRobot->getFrontRight(), remoteRobot->getFrontLeft(), remoteRobot->getBackLeft(), remoteRobot->getBackRight() };
+				Model::Robot::Corners corners = remoteRobot->getCorners();
+				wxPoint translatedPoints[] = { corners.frontRight, corners.frontLeft, corners.backLeft, corners.backRight };
 				if(Utils::Shape2DUtils::isOnLine(translatedPoints, 4, vertex.asPoint(),aFreeRadius+10))
 				{
 					addToNeigbours = false;
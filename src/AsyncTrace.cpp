@@ -0,0 +1,477 @@
+#include "AsyncTrace.hpp"
+
+#include "BinaryTraceFormat.hpp"
+#include "Trace.hpp"
+#include "TimeStamp.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace Base
+{
+	/**
+	 *
+	 */
+	/* static */ AsyncTrace& AsyncTrace::getAsyncTrace()
+	{
+		static AsyncTrace asyncTrace;
+		return asyncTrace;
+	}
+	/**
+	 *
+	 */
+	AsyncTrace::AsyncTrace() :
+								wallClockOffset( std::chrono::system_clock::now().time_since_epoch() - std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::steady_clock::now().time_since_epoch()))
+	{
+	}
+	/**
+	 *
+	 */
+	AsyncTrace::~AsyncTrace()
+	{
+		// Threads that trace during the static destruction trace synchronously
+		Trace::asyncTraceOn.store( false);
+		stop();
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::start()
+	{
+		std::unique_lock< std::mutex > lock( runBusy);
+		if (!running)
+		{
+			running = true;
+			traceThread = std::thread( [this]()
+									   {
+											run();
+									   });
+		}
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::stop()
+	{
+		{
+			std::unique_lock< std::mutex > lock( runBusy);
+			if (!running)
+			{
+				return;
+			}
+			running = false;
+			stopRequested.notify_all();
+		}
+		traceThread.join();
+		flush();
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::record(	char aTraceMarker,
+								const char* aCallSite,
+								const std::string& aText,
+								long aLineNumber,
+								bool withTimeStamp)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+		TraceRecord* traceRecord = claimRecord( buffer, aTraceMarker, aCallSite, aLineNumber, withTimeStamp);
+		if (!traceRecord)
+		{
+			return;
+		}
+
+		traceRecord->truncated = aText.length() > sizeof( traceRecord->text);
+		traceRecord->length = static_cast< std::uint16_t >( std::min( aText.length(), sizeof( traceRecord->text)));
+		std::memcpy( traceRecord->text, aText.data(), traceRecord->length);
+
+		publishRecord( buffer);
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::recordValues(	const char* aCallSite,
+									std::initializer_list< TraceValue > someValues,
+									long aLineNumber,
+									bool withTimeStamp)
+	{
+		static_assert(	Trace::maximumNumberOfValues * sizeof( TraceValue) <= sizeof( TraceRecord::text),
+						"the values do not fit in the text of a record");
+		static_assert( std::is_trivially_copyable_v< TraceValue >);
+
+		ThreadBuffer& buffer = getThreadBuffer();
+		TraceRecord* traceRecord = claimRecord( buffer, '>', aCallSite, aLineNumber, withTimeStamp);
+		if (!traceRecord)
+		{
+			return;
+		}
+
+		std::size_t numberOfValues = std::min( someValues.size(), Trace::maximumNumberOfValues);
+		traceRecord->truncated = someValues.size() > numberOfValues;
+		traceRecord->numberOfValues = static_cast< std::uint8_t >( numberOfValues);
+		std::memcpy( traceRecord->text, someValues.begin(), numberOfValues * sizeof( TraceValue));
+
+		publishRecord( buffer);
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::flush()
+	{
+		while (drain() > 0)
+		{
+		}
+	}
+	/**
+	 *
+	 */
+	bool AsyncTrace::openBinaryTrace( const std::string& aFileName)
+	{
+		flush();
+
+		std::unique_lock< std::mutex > drainLock( drainBusy);
+		if (binaryFile.is_open())
+		{
+			binaryFile.close();
+		}
+		// A large buffer, so the file is written once per drained batch
+		binaryFileBuffer.resize( 1024 * 1024); // @suppress("Avoid magic numbers")
+		binaryFile.rdbuf()->pubsetbuf( binaryFileBuffer.data(), static_cast< std::streamsize >( binaryFileBuffer.size()));
+		binaryFile.open( aFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!binaryFile.is_open())
+		{
+			return false;
+		}
+		callSiteIds.clear();
+		BinaryTraceFormat::writeHeader( binaryFile, std::chrono::duration_cast< std::chrono::nanoseconds >( wallClockOffset).count());
+		BinaryTraceFormat::writeCallSite( binaryFile, 0, "");
+		return true;
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::closeBinaryTrace()
+	{
+		flush();
+
+		std::unique_lock< std::mutex > drainLock( drainBusy);
+		if (binaryFile.is_open())
+		{
+			binaryFile.close();
+		}
+	}
+	/**
+	 *
+	 */
+	AsyncTrace::ThreadBufferOwner::~ThreadBufferOwner()
+	{
+		if (buffer)
+		{
+			buffer->threadEnded.store( true, std::memory_order_release);
+		}
+	}
+	/**
+	 *
+	 */
+	AsyncTrace::ThreadBuffer& AsyncTrace::getThreadBuffer()
+	{
+		thread_local ThreadBufferOwner owner;
+		if (!owner.buffer)
+		{
+			owner.buffer = std::make_shared< ThreadBuffer >();
+			owner.buffer->threadId = std::this_thread::get_id();
+
+			std::unique_lock< std::mutex > lock( registryBusy);
+			threadBuffers.push_back( owner.buffer);
+		}
+		return *owner.buffer;
+	}
+	/**
+	 *
+	 */
+	/* static */ AsyncTrace::TraceRecord* AsyncTrace::claimRecord(	ThreadBuffer& aBuffer,
+																	char aTraceMarker,
+																	const char* aCallSite,
+																	long aLineNumber,
+																	bool withTimeStamp)
+	{
+		std::size_t head = aBuffer.head.load( std::memory_order_relaxed);
+		if (head - aBuffer.tail.load( std::memory_order_acquire) >= bufferCapacity)
+		{
+			aBuffer.dropped.fetch_add( 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		TraceRecord& traceRecord = aBuffer.records[head % bufferCapacity];
+		traceRecord.time = std::chrono::steady_clock::now();
+		traceRecord.threadId = aBuffer.threadId;
+		traceRecord.callSite = aCallSite;
+		traceRecord.lineNumber = aLineNumber;
+		traceRecord.traceMarker = aTraceMarker;
+		traceRecord.withTimeStamp = withTimeStamp;
+		traceRecord.truncated = false;
+		traceRecord.length = 0;
+		traceRecord.numberOfValues = 0;
+		return &traceRecord;
+	}
+	/**
+	 *
+	 */
+	/* static */ void AsyncTrace::publishRecord( ThreadBuffer& aBuffer)
+	{
+		// Only the owning thread changes head
+		aBuffer.head.store( aBuffer.head.load( std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::run()
+	{
+		std::unique_lock< std::mutex > lock( runBusy);
+		while (running)
+		{
+			lock.unlock();
+			std::size_t traced = drain();
+			lock.lock();
+
+			// The writers do not signal, an idle trace thread polls
+			if (traced == 0 && running)
+			{
+				stopRequested.wait_for( lock, std::chrono::milliseconds( 10)); // @suppress("Avoid magic numbers")
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	std::size_t AsyncTrace::drain()
+	{
+		std::unique_lock< std::mutex > drainLock( drainBusy);
+
+		std::vector< std::shared_ptr< ThreadBuffer > > buffers;
+		{
+			std::unique_lock< std::mutex > registryLock( registryBusy);
+			buffers = threadBuffers;
+		}
+
+		batch.clear();
+		std::vector< std::pair< std::thread::id, unsigned long > > droppedRecords;
+		std::vector< std::thread::id > endedThreads;
+		for (const std::shared_ptr< ThreadBuffer >& buffer : buffers)
+		{
+			bool threadEnded = buffer->threadEnded.load( std::memory_order_acquire);
+
+			std::size_t tail = buffer->tail.load( std::memory_order_relaxed);
+			std::size_t head = buffer->head.load( std::memory_order_acquire);
+			for (std::size_t i = tail; i != head; ++i)
+			{
+				batch.push_back( buffer->records[i % bufferCapacity]);
+			}
+			buffer->tail.store( head, std::memory_order_release);
+
+			unsigned long dropped = buffer->dropped.exchange( 0, std::memory_order_relaxed);
+			if (dropped > 0)
+			{
+				numberOfDroppedRecords += dropped;
+				droppedRecords.push_back( std::make_pair( buffer->threadId, dropped));
+			}
+			if (threadEnded)
+			{
+				endedThreads.push_back( buffer->threadId);
+			}
+		}
+
+		if (!endedThreads.empty())
+		{
+			std::unique_lock< std::mutex > registryLock( registryBusy);
+			threadBuffers.erase( std::remove_if(	threadBuffers.begin(),
+													threadBuffers.end(),
+													[](const std::shared_ptr< ThreadBuffer >& aBuffer)
+													{
+														return aBuffer->threadEnded.load( std::memory_order_acquire) &&
+															   aBuffer->head.load( std::memory_order_acquire) == aBuffer->tail.load( std::memory_order_relaxed);
+													}),
+								 threadBuffers.end());
+		}
+
+		if (batch.empty() && droppedRecords.empty())
+		{
+			return 0;
+		}
+
+		// The records of one thread are already in order, stable_sort keeps them that way
+		std::stable_sort(	batch.begin(),
+							batch.end(),
+							[](const TraceRecord& lhs, const TraceRecord& rhs)
+							{
+								return lhs.time < rhs.time;
+							});
+
+		if (binaryFile.is_open())
+		{
+			for (const std::pair< std::thread::id, unsigned long >& dropped : droppedRecords)
+			{
+				BinaryTraceFormat::writeDropped( binaryFile, toNumber( dropped.first), dropped.second);
+			}
+			for (const TraceRecord& traceRecord : batch)
+			{
+				writeBinaryRecord( traceRecord);
+			}
+			binaryFile.flush();
+			return batch.size() + droppedRecords.size();
+		}
+
+		std::vector< std::string > lines;
+		lines.reserve( batch.size() + droppedRecords.size());
+		for (const std::pair< std::thread::id, unsigned long >& dropped : droppedRecords)
+		{
+			std::ostringstream os;
+			os << "*** AsyncTrace: " << dropped.second << " trace records of thread " << dropped.first << " dropped, the buffer was full";
+			lines.push_back( os.str());
+		}
+		for (const TraceRecord& traceRecord : batch)
+		{
+			lines.push_back( formatRecord( traceRecord));
+		}
+		for (const std::thread::id& threadId : endedThreads)
+		{
+			// A new thread may get the id of an ended thread
+			threadIndentionLevels.erase( threadId);
+		}
+
+		std::lock_guard< std::mutex > lock( Trace::traceFunctionMutex);
+		for (const std::string& line : lines)
+		{
+			Trace::traceFunction->trace( line);
+		}
+		return batch.size() + droppedRecords.size();
+	}
+	/**
+	 *
+	 */
+	std::string AsyncTrace::formatRecord( const TraceRecord& aRecord)
+	{
+		std::string text;
+		if (aRecord.withTimeStamp)
+		{
+			text += Utils::TimeStamp( std::chrono::system_clock::time_point( std::chrono::duration_cast< std::chrono::system_clock::duration >( aRecord.time.time_since_epoch()) + wallClockOffset)) + ": ";
+		}
+		if (aRecord.callSite)
+		{
+			text += aRecord.callSite;
+			if (aRecord.length > 0)
+			{
+				text += ' ';
+			}
+		}
+		text.append( aRecord.text, aRecord.length);
+		for (std::size_t i = 0; i < aRecord.numberOfValues; ++i)
+		{
+			TraceValue value;
+			std::memcpy( &value, aRecord.text + i * sizeof( TraceValue), sizeof( TraceValue));
+			text += ' ' + value.asString();
+		}
+		if (aRecord.truncated)
+		{
+			text += aRecord.numberOfValues > 0 ? " ..." : "...";
+		}
+		if (aRecord.lineNumber != noLineNumber)
+		{
+			text += " (line " + std::to_string( aRecord.lineNumber) + ")";
+		}
+		return Trace::formatTraceLine( aRecord.threadId, aRecord.traceMarker, text, threadIndentionLevels);
+	}
+	/**
+	 *
+	 */
+	void AsyncTrace::writeBinaryRecord( const TraceRecord& aRecord)
+	{
+		BinaryTraceFormat::Event event;
+		event.callSiteId = getCallSiteId( aRecord.callSite);
+		event.time = static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( aRecord.time.time_since_epoch()).count());
+		event.threadId = toNumber( aRecord.threadId);
+		event.traceMarker = aRecord.traceMarker;
+		event.flags = aRecord.withTimeStamp ? BinaryTraceFormat::WithTimeStamp : 0;
+		event.lineNumber = static_cast< std::int32_t >( aRecord.lineNumber);
+		for (std::size_t i = 0; i < aRecord.numberOfValues; ++i)
+		{
+			TraceValue value;
+			std::memcpy( &value, aRecord.text + i * sizeof( TraceValue), sizeof( TraceValue));
+
+			BinaryTraceFormat::Argument argument;
+			switch (value.type)
+			{
+				case TraceValue::Integer:
+				{
+					argument.type = BinaryTraceFormat::IntegerArgument;
+					argument.integer = value.integer;
+					break;
+				}
+				case TraceValue::Unsigned:
+				{
+					argument.type = BinaryTraceFormat::UnsignedArgument;
+					argument.unsignedInteger = value.unsignedInteger;
+					break;
+				}
+				case TraceValue::Real:
+				{
+					argument.type = BinaryTraceFormat::RealArgument;
+					argument.real = value.real;
+					break;
+				}
+			}
+			event.arguments.push_back( std::move( argument));
+		}
+		if (aRecord.truncated && aRecord.numberOfValues > 0)
+		{
+			BinaryTraceFormat::Argument argument;
+			argument.type = BinaryTraceFormat::StringArgument;
+			argument.text = "...";
+			event.arguments.push_back( std::move( argument));
+		}
+		if (aRecord.length > 0)
+		{
+			BinaryTraceFormat::Argument argument;
+			argument.type = BinaryTraceFormat::StringArgument;
+			argument.text.assign( aRecord.text, aRecord.length);
+			if (aRecord.truncated)
+			{
+				argument.text += "...";
+			}
+			event.arguments.push_back( std::move( argument));
+		}
+		BinaryTraceFormat::writeEvent( binaryFile, event);
+	}
+	/**
+	 *
+	 */
+	std::uint32_t AsyncTrace::getCallSiteId( const char* aCallSite)
+	{
+		if (!aCallSite)
+		{
+			return 0;
+		}
+		std::map< const char*, std::uint32_t >::iterator callSite = callSiteIds.find( aCallSite);
+		if (callSite != callSiteIds.end())
+		{
+			return callSite->second;
+		}
+		std::uint32_t id = static_cast< std::uint32_t >( callSiteIds.size() + 1);
+		callSiteIds.insert( std::make_pair( aCallSite, id));
+		BinaryTraceFormat::writeCallSite( binaryFile, id, aCallSite);
+		return id;
+	}
+	/**
+	 *
+	 */
+	/* static */ std::uint64_t AsyncTrace::toNumber( std::thread::id aThreadId)
+	{
+		// The text trace prints the native handle of the thread, which is what std::thread::id holds
+		std::uint64_t number = 0;
+		std::memcpy( &number, &aThreadId, std::min( sizeof( number), sizeof( aThreadId)));
+		return number;
+	}
+} /* namespace Base */
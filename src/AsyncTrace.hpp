@@ -0,0 +1,231 @@
+#ifndef ASYNCTRACE_HPP_
+#define ASYNCTRACE_HPP_
+
+#include "Config.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Base
+{
+	struct TraceValue;
+
+	/**
+	 * AsyncTrace is the backend of Trace if asynchronous tracing is enabled with Trace::enableAsyncTrace.
+	 *
+	 * A thread that traces only writes a fixed size record (time, thread id, marker, line number and the text)
+	 * into its own buffer. There is one buffer per thread with one writer and one reader, so writing
+	 * a record does not take a lock and does not wait for the trace function. If the buffer of a thread is
+	 * full the record is dropped and counted.
+	 *
+	 * A background thread collects the records of all threads, orders them by time, formats them like
+	 * Trace does, including the indention per thread, and hands them to the installed ITraceFunction.
+	 *
+	 * Texts longer than the record are truncated.
+	 *
+	 * With openBinaryTrace the background thread writes the records in the BinaryTraceFormat instead of
+	 * formatting them: the function name becomes an interned call site id, the text a string argument and
+	 * the values of recordValues typed arguments.
+	 */
+	class AsyncTrace
+	{
+		public:
+			/**
+			 * The number of records per thread
+			 */
+			static constexpr std::size_t bufferCapacity = 512;
+			/**
+			 * Passed as line number if the line number is not traced
+			 */
+			static constexpr long noLineNumber = -1;
+			/**
+			 *
+			 */
+			static AsyncTrace& getAsyncTrace();
+			/**
+			 *
+			 */
+			AsyncTrace( const AsyncTrace&) = delete;
+			/**
+			 *
+			 */
+			AsyncTrace& operator=( const AsyncTrace&) = delete;
+			/**
+			 * Starts the background thread if it is not running
+			 */
+			void start();
+			/**
+			 * Stops the background thread after the records that are written are traced
+			 */
+			void stop();
+			/**
+			 * Writes a record into the buffer of the calling thread. Never blocks.
+			 *
+			 * @param aCallSite A string that lives as long as the application, e.g. __PRETTY_FUNCTION__, or nullptr
+			 * @param aText The text after the call site
+			 */
+			void record(	char aTraceMarker,
+							const char* aCallSite,
+							const std::string& aText,
+							long aLineNumber,
+							bool withTimeStamp);
+			/**
+			 * Writes a record with the numbers someValues instead of a text into the buffer of the calling thread,
+			 * the values after Trace::maximumNumberOfValues are left out. Never blocks.
+			 *
+			 * @param aCallSite A string that lives as long as the application, e.g. __PRETTY_FUNCTION__
+			 */
+			void recordValues(	const char* aCallSite,
+								std::initializer_list< TraceValue > someValues,
+								long aLineNumber,
+								bool withTimeStamp);
+			/**
+			 * Traces the records that are written up to now, on the calling thread
+			 */
+			void flush();
+			/**
+			 * From now on the records are written to aFileName in the BinaryTraceFormat instead of to the trace function
+			 *
+			 * @return False if the file cannot be opened
+			 */
+			bool openBinaryTrace( const std::string& aFileName);
+			/**
+			 * Writes the records that are left to the binary trace file and closes it, the trace function is used again
+			 */
+			void closeBinaryTrace();
+			/**
+			 *
+			 * @return The number of records that were dropped because the buffer of a thread was full
+			 */
+			unsigned long getNumberOfDroppedRecords() const
+			{
+				return numberOfDroppedRecords.load();
+			}
+		private:
+			/**
+			 *
+			 */
+			AsyncTrace();
+			/**
+			 *
+			 */
+			~AsyncTrace();
+			/**
+			 * A record fills 4 cache lines, the text is what is left of it. If numberOfValues is not 0
+			 * the text holds that number of TraceValues instead of characters.
+			 */
+			struct TraceRecord
+			{
+					std::chrono::steady_clock::time_point time;
+					std::thread::id threadId;
+					const char* callSite;
+					long lineNumber;
+					std::uint16_t length;
+					char traceMarker;
+					bool withTimeStamp;
+					bool truncated;
+					std::uint8_t numberOfValues;
+					char text[256 - sizeof( std::chrono::steady_clock::time_point) - sizeof( std::thread::id) - sizeof( const char*) - sizeof( long) - sizeof( std::uint16_t) - 3 * sizeof( char) - sizeof( std::uint8_t)]; // @suppress("Avoid magic numbers")
+			};
+			/**
+			 * Only the owning thread writes and only the thread that holds drainBusy reads
+			 */
+			struct ThreadBuffer
+			{
+					std::array< TraceRecord, bufferCapacity > records;
+					alignas( 64 ) std::atomic< std::size_t > head = 0; // @suppress("Avoid magic numbers")
+					alignas( 64 ) std::atomic< std::size_t > tail = 0; // @suppress("Avoid magic numbers")
+					std::atomic< unsigned long > dropped = 0;
+					std::atomic< bool > threadEnded = false;
+					std::thread::id threadId;
+			};
+			/**
+			 * Registers the buffer of a thread on first use and marks it as ended when the thread ends
+			 */
+			struct ThreadBufferOwner
+			{
+					~ThreadBufferOwner();
+					std::shared_ptr< ThreadBuffer > buffer;
+			};
+			/**
+			 *
+			 */
+			ThreadBuffer& getThreadBuffer();
+			/**
+			 * Fills in the common part of the next free record of aBuffer, which is published with publishRecord
+			 *
+			 * @return The record or nullptr if the buffer is full, the record is counted as dropped then
+			 */
+			static TraceRecord* claimRecord(	ThreadBuffer& aBuffer,
+												char aTraceMarker,
+												const char* aCallSite,
+												long aLineNumber,
+												bool withTimeStamp);
+			/**
+			 * Makes the record that was claimed last visible to the background thread
+			 */
+			static void publishRecord( ThreadBuffer& aBuffer);
+			/**
+			 * The loop of the background thread
+			 */
+			void run();
+			/**
+			 * Takes the records out of all buffers and traces them
+			 *
+			 * @return The number of records that were traced
+			 */
+			std::size_t drain();
+			/**
+			 *
+			 */
+			std::string formatRecord( const TraceRecord& aRecord);
+			/**
+			 *
+			 */
+			void writeBinaryRecord( const TraceRecord& aRecord);
+			/**
+			 * Writes the call site record the first time aCallSite is seen
+			 */
+			std::uint32_t getCallSiteId( const char* aCallSite);
+			/**
+			 * The number that the text trace shows for aThreadId
+			 */
+			static std::uint64_t toNumber( std::thread::id aThreadId);
+
+			/**
+			 * Converts the steady clock of the records to the wall clock for the time stamps
+			 */
+			const std::chrono::system_clock::duration wallClockOffset;
+
+			std::mutex registryBusy;
+			std::vector< std::shared_ptr< ThreadBuffer > > threadBuffers;
+
+			std::mutex drainBusy;
+			std::vector< TraceRecord > batch;
+			std::map< std::thread::id, unsigned long > threadIndentionLevels;
+
+			std::vector< char > binaryFileBuffer;
+			std::ofstream binaryFile;
+			std::map< const char*, std::uint32_t > callSiteIds;
+
+			std::mutex runBusy;
+			std::condition_variable stopRequested;
+			bool running = false;
+			std::thread traceThread;
+
+			std::atomic< unsigned long > numberOfDroppedRecords = 0;
+	}; // class AsyncTrace
+} /* namespace Base */
+
+#endif // ASYNCTRACE_HPP_
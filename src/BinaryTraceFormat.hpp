@@ -0,0 +1,332 @@
+#ifndef BINARYTRACEFORMAT_HPP_
+#define BINARYTRACEFORMAT_HPP_
+
+#include "Config.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Base
+{
+	/**
+	 * The binary trace format that AsyncTrace writes if it is enabled with Trace::enableBinaryTrace, and
+	 * that tracedecoder reads. All numbers are little endian.
+	 *
+	 * The file starts with the 8 bytes "RWTRACE1" and the offset of the wall clock to the monotonic clock
+	 * of the events in nanoseconds (int64). Then follow records that start with their type (uint8):
+	 *
+	 * - CallSiteRecord: id (uint32), length (uint32) and the text of a call site, normally the function name.
+	 *   A call site is written once, before the first event that refers to it. Id 0 is the empty call site.
+	 * - EventRecord: call site id (uint32), monotonic time in nanoseconds (uint64), thread id (uint64),
+	 *   trace marker (uint8, '+' enter, '-' leave or '>' text), flags (uint8), line number (int32, -1 for none),
+	 *   number of arguments (uint8) and the arguments. An argument is its type (uint8) and its value: int64,
+	 *   uint64, double or a string as length (uint32) and bytes.
+	 * - DroppedRecord: thread id (uint64) and the number of events of that thread that were dropped (uint64).
+	 */
+	class BinaryTraceFormat
+	{
+		public:
+			/**
+			 *
+			 */
+			enum RecordType : std::uint8_t
+			{
+				CallSiteRecord = 1,
+				EventRecord = 2,
+				DroppedRecord = 3
+			};
+			/**
+			 *
+			 */
+			enum ArgumentType : std::uint8_t
+			{
+				IntegerArgument = 1,
+				UnsignedArgument = 2,
+				RealArgument = 3,
+				StringArgument = 4
+			};
+			/**
+			 *
+			 */
+			enum EventFlags : std::uint8_t
+			{
+				WithTimeStamp = 1
+			};
+			/**
+			 * Only the member that belongs to the type is used
+			 */
+			struct Argument
+			{
+					ArgumentType type = StringArgument;
+					std::int64_t integer = 0;
+					std::uint64_t unsignedInteger = 0;
+					double real = 0.0;
+					std::string text;
+			};
+			/**
+			 *
+			 */
+			struct Event
+			{
+					std::uint32_t callSiteId = 0;
+					std::uint64_t time = 0;
+					std::uint64_t threadId = 0;
+					char traceMarker = '>';
+					std::uint8_t flags = 0;
+					std::int32_t lineNumber = -1;
+					std::vector< Argument > arguments;
+			};
+			/**
+			 *
+			 */
+			static constexpr char magic[8] = { 'R', 'W', 'T', 'R', 'A', 'C', 'E', '1' }; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			static void writeHeader(	std::ostream& aStream,
+										std::int64_t aWallClockOffset)
+			{
+				aStream.write( magic, sizeof( magic));
+				writeNumber( aStream, static_cast< std::uint64_t >( aWallClockOffset), 8); // @suppress("Avoid magic numbers")
+			}
+			/**
+			 *
+			 * @return False if the stream does not start with a binary trace header
+			 */
+			static bool readHeader(	std::istream& aStream,
+									std::int64_t& aWallClockOffset)
+			{
+				char header[sizeof( magic)];
+				std::uint64_t offset = 0;
+				if (!aStream.read( header, sizeof( header)) || std::memcmp( header, magic, sizeof( magic)) != 0 || !readNumber( aStream, offset, 8)) // @suppress("Avoid magic numbers")
+				{
+					return false;
+				}
+				aWallClockOffset = static_cast< std::int64_t >( offset);
+				return true;
+			}
+			/**
+			 *
+			 */
+			static void writeCallSite(	std::ostream& aStream,
+										std::uint32_t anId,
+										const std::string& aText)
+			{
+				writeNumber( aStream, CallSiteRecord, 1);
+				writeNumber( aStream, anId, 4); // @suppress("Avoid magic numbers")
+				writeString( aStream, aText);
+			}
+			/**
+			 * Reads the call site after the record type
+			 */
+			static bool readCallSite(	std::istream& aStream,
+										std::uint32_t& anId,
+										std::string& aText)
+			{
+				std::uint64_t id = 0;
+				if (!readNumber( aStream, id, 4) || !readString( aStream, aText)) // @suppress("Avoid magic numbers")
+				{
+					return false;
+				}
+				anId = static_cast< std::uint32_t >( id);
+				return true;
+			}
+			/**
+			 *
+			 */
+			static void writeEvent(	std::ostream& aStream,
+									const Event& anEvent)
+			{
+				writeNumber( aStream, EventRecord, 1);
+				writeNumber( aStream, anEvent.callSiteId, 4); // @suppress("Avoid magic numbers")
+				writeNumber( aStream, anEvent.time, 8); // @suppress("Avoid magic numbers")
+				writeNumber( aStream, anEvent.threadId, 8); // @suppress("Avoid magic numbers")
+				writeNumber( aStream, static_cast< std::uint8_t >( anEvent.traceMarker), 1);
+				writeNumber( aStream, anEvent.flags, 1);
+				writeNumber( aStream, static_cast< std::uint32_t >( anEvent.lineNumber), 4); // @suppress("Avoid magic numbers")
+				writeNumber( aStream, anEvent.arguments.size(), 1);
+				for (const Argument& argument : anEvent.arguments)
+				{
+					writeNumber( aStream, argument.type, 1);
+					switch (argument.type)
+					{
+						case IntegerArgument:
+						{
+							writeNumber( aStream, static_cast< std::uint64_t >( argument.integer), 8); // @suppress("Avoid magic numbers")
+							break;
+						}
+						case UnsignedArgument:
+						{
+							writeNumber( aStream, argument.unsignedInteger, 8); // @suppress("Avoid magic numbers")
+							break;
+						}
+						case RealArgument:
+						{
+							std::uint64_t bits = 0;
+							std::memcpy( &bits, &argument.real, sizeof( bits));
+							writeNumber( aStream, bits, 8); // @suppress("Avoid magic numbers")
+							break;
+						}
+						case StringArgument:
+						{
+							writeString( aStream, argument.text);
+							break;
+						}
+					}
+				}
+			}
+			/**
+			 * Reads the event after the record type
+			 */
+			static bool readEvent(	std::istream& aStream,
+									Event& anEvent)
+			{
+				std::uint64_t callSiteId = 0;
+				std::uint64_t traceMarker = 0;
+				std::uint64_t flags = 0;
+				std::uint64_t lineNumber = 0;
+				std::uint64_t numberOfArguments = 0;
+				if (!readNumber( aStream, callSiteId, 4) || // @suppress("Avoid magic numbers")
+					!readNumber( aStream, anEvent.time, 8) || // @suppress("Avoid magic numbers")
+					!readNumber( aStream, anEvent.threadId, 8) || // @suppress("Avoid magic numbers")
+					!readNumber( aStream, traceMarker, 1) ||
+					!readNumber( aStream, flags, 1) ||
+					!readNumber( aStream, lineNumber, 4) || // @suppress("Avoid magic numbers")
+					!readNumber( aStream, numberOfArguments, 1))
+				{
+					return false;
+				}
+				anEvent.callSiteId = static_cast< std::uint32_t >( callSiteId);
+				anEvent.traceMarker = static_cast< char >( traceMarker);
+				anEvent.flags = static_cast< std::uint8_t >( flags);
+				anEvent.lineNumber = static_cast< std::int32_t >( static_cast< std::uint32_t >( lineNumber));
+				anEvent.arguments.resize( numberOfArguments);
+				for (Argument& argument : anEvent.arguments)
+				{
+					std::uint64_t type = 0;
+					std::uint64_t value = 0;
+					if (!readNumber( aStream, type, 1))
+					{
+						return false;
+					}
+					argument.type = static_cast< ArgumentType >( type);
+					switch (argument.type)
+					{
+						case IntegerArgument:
+						case UnsignedArgument:
+						case RealArgument:
+						{
+							if (!readNumber( aStream, value, 8)) // @suppress("Avoid magic numbers")
+							{
+								return false;
+							}
+							argument.integer = static_cast< std::int64_t >( value);
+							argument.unsignedInteger = value;
+							std::memcpy( &argument.real, &value, sizeof( value));
+							break;
+						}
+						case StringArgument:
+						{
+							if (!readString( aStream, argument.text))
+							{
+								return false;
+							}
+							break;
+						}
+						default:
+						{
+							return false;
+						}
+					}
+				}
+				return true;
+			}
+			/**
+			 *
+			 */
+			static void writeDropped(	std::ostream& aStream,
+										std::uint64_t aThreadId,
+										std::uint64_t aNumberOfEvents)
+			{
+				writeNumber( aStream, DroppedRecord, 1);
+				writeNumber( aStream, aThreadId, 8); // @suppress("Avoid magic numbers")
+				writeNumber( aStream, aNumberOfEvents, 8); // @suppress("Avoid magic numbers")
+			}
+			/**
+			 * Reads the dropped events after the record type
+			 */
+			static bool readDropped(	std::istream& aStream,
+										std::uint64_t& aThreadId,
+										std::uint64_t& aNumberOfEvents)
+			{
+				return readNumber( aStream, aThreadId, 8) && readNumber( aStream, aNumberOfEvents, 8); // @suppress("Avoid magic numbers")
+			}
+			/**
+			 * Writes the aSize least significant bytes of aNumber, least significant byte first
+			 */
+			static void writeNumber(	std::ostream& aStream,
+										std::uint64_t aNumber,
+										std::size_t aSize)
+			{
+				char bytes[8]; // @suppress("Avoid magic numbers")
+				for (std::size_t i = 0; i < aSize; ++i)
+				{
+					bytes[i] = static_cast< char >((aNumber >> (8 * i)) & 0xFF); // @suppress("Avoid magic numbers")
+				}
+				aStream.write( bytes, static_cast< std::streamsize >( aSize));
+			}
+			/**
+			 *
+			 */
+			static bool readNumber(	std::istream& aStream,
+									std::uint64_t& aNumber,
+									std::size_t aSize)
+			{
+				unsigned char bytes[8]; // @suppress("Avoid magic numbers")
+				if (!aStream.read( reinterpret_cast< char* >( bytes), static_cast< std::streamsize >( aSize)))
+				{
+					return false;
+				}
+				aNumber = 0;
+				for (std::size_t i = 0; i < aSize; ++i)
+				{
+					aNumber |= static_cast< std::uint64_t >( bytes[i]) << (8 * i); // @suppress("Avoid magic numbers")
+				}
+				return true;
+			}
+		private:
+			/**
+			 * The longest string that is read, protects against a corrupt length
+			 */
+			static constexpr std::uint64_t maximumStringLength = 16 * 1024 * 1024; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			static void writeString(	std::ostream& aStream,
+										const std::string& aText)
+			{
+				writeNumber( aStream, aText.length(), 4); // @suppress("Avoid magic numbers")
+				aStream.write( aText.data(), static_cast< std::streamsize >( aText.length()));
+			}
+			/**
+			 *
+			 */
+			static bool readString(	std::istream& aStream,
+									std::string& aText)
+			{
+				std::uint64_t length = 0;
+				if (!readNumber( aStream, length, 4) || length > maximumStringLength) // @suppress("Avoid magic numbers")
+				{
+					return false;
+				}
+				aText.resize( length);
+				return length == 0 || static_cast< bool >( aStream.read( aText.data(), static_cast< std::streamsize >( length)));
+			}
+	}; // class BinaryTraceFormat
+} /* namespace Base */
+
+#endif // BINARYTRACEFORMAT_HPP_
@@ -0,0 +1,88 @@
+#include "ChangeSet.hpp"
+
+#include <sstream>
+
+namespace Model
+{
+	/**
+	 *
+	 */
+	ChangeSet::ChangeSet( std::uint64_t aVersion /* = 0 */) :
+								fromVersion( aVersion),
+								toVersion( aVersion)
+	{
+	}
+	/**
+	 *
+	 */
+	void ChangeSet::add( const Base::ObjectId& anObjectId)
+	{
+		if (removed.erase( anObjectId) > 0)
+		{
+			// Removed and added again, whoever knew the old object has to look at it again
+			modified.insert( anObjectId);
+		} else
+		{
+			added.insert( anObjectId);
+		}
+	}
+	/**
+	 *
+	 */
+	void ChangeSet::remove( const Base::ObjectId& anObjectId)
+	{
+		modified.erase( anObjectId);
+		if (added.erase( anObjectId) == 0)
+		{
+			removed.insert( anObjectId);
+		}
+	}
+	/**
+	 *
+	 */
+	void ChangeSet::modify( const Base::ObjectId& anObjectId)
+	{
+		if (!added.contains( anObjectId))
+		{
+			modified.insert( anObjectId);
+		}
+	}
+	/**
+	 *
+	 */
+	void ChangeSet::merge( const ChangeSet& aChangeSet)
+	{
+		for (const Base::ObjectId& objectId : aChangeSet.removed)
+		{
+			remove( objectId);
+		}
+		for (const Base::ObjectId& objectId : aChangeSet.added)
+		{
+			add( objectId);
+		}
+		for (const Base::ObjectId& objectId : aChangeSet.modified)
+		{
+			modify( objectId);
+		}
+		toVersion = aChangeSet.toVersion;
+	}
+	/**
+	 *
+	 */
+	void ChangeSet::clear()
+	{
+		added.clear();
+		removed.clear();
+		modified.clear();
+		fromVersion = toVersion;
+	}
+	/**
+	 *
+	 */
+	std::string ChangeSet::asString() const
+	{
+		std::ostringstream os;
+		os << "ChangeSet " << fromVersion << "->" << toVersion << ": " << added.size() << " added, " << removed.size() << " removed, " << modified.size() << " modified";
+		return os.str();
+	}
+} // namespace Model
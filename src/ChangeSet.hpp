@@ -0,0 +1,127 @@
+#ifndef CHANGESET_HPP_
+#define CHANGESET_HPP_
+
+#include "Config.hpp"
+
+#include "ObjectId.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+namespace Model
+{
+	/**
+	 * The ObjectIds of the objects that were added to, removed from or modified in RobotWorld between
+	 * two versions. An object is in at most one of the three sets: an object that is added and removed
+	 * again within the change set is in none of them, an object that is removed and added again with
+	 * the same ObjectId is modified.
+	 */
+	class ChangeSet
+	{
+		public:
+			/**
+			 * The empty change set of aVersion
+			 */
+			explicit ChangeSet( std::uint64_t aVersion = 0);
+			/**
+			 * The changes are from the world of getFromVersion() to the world of getToVersion()
+			 */
+			std::uint64_t getFromVersion() const
+			{
+				return fromVersion;
+			}
+			/**
+			 *
+			 */
+			std::uint64_t getToVersion() const
+			{
+				return toVersion;
+			}
+			/**
+			 *
+			 */
+			const std::unordered_set< Base::ObjectId >& getAdded() const
+			{
+				return added;
+			}
+			/**
+			 *
+			 */
+			const std::unordered_set< Base::ObjectId >& getRemoved() const
+			{
+				return removed;
+			}
+			/**
+			 *
+			 */
+			const std::unordered_set< Base::ObjectId >& getModified() const
+			{
+				return modified;
+			}
+			/**
+			 *
+			 */
+			bool empty() const
+			{
+				return added.empty() && removed.empty() && modified.empty();
+			}
+			/**
+			 * True if objects were added or removed, i.e. the set of objects changed
+			 */
+			bool changesObjects() const
+			{
+				return !added.empty() || !removed.empty();
+			}
+			/**
+			 * @name Recording
+			 */
+			//@{
+			/**
+			 *
+			 */
+			void add( const Base::ObjectId& anObjectId);
+			/**
+			 *
+			 */
+			void remove( const Base::ObjectId& anObjectId);
+			/**
+			 *
+			 */
+			void modify( const Base::ObjectId& anObjectId);
+			/**
+			 * Appends the changes of aChangeSet, that starts where this change set ends
+			 */
+			void merge( const ChangeSet& aChangeSet);
+			/**
+			 * Empties the change set and makes it start at its end
+			 */
+			void clear();
+			/**
+			 *
+			 */
+			void setToVersion( std::uint64_t aVersion)
+			{
+				toVersion = aVersion;
+			}
+			//@}
+			/**
+			 * @name Debug functions
+			 */
+			//@{
+			/**
+			 * Returns a 1-line description of the object
+			 */
+			std::string asString() const;
+			//@}
+
+		private:
+			std::uint64_t fromVersion;
+			std::uint64_t toVersion;
+			std::unordered_set< Base::ObjectId > added;
+			std::unordered_set< Base::ObjectId > removed;
+			std::unordered_set< Base::ObjectId > modified;
+	}; // class ChangeSet
+} // namespace Model
+
+#endif // CHANGESET_HPP_
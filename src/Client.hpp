@@ -3,9 +3,24 @@
 
 #include "Config.hpp"
 
-#include "Session.hpp"
+#include "CommunicationService.hpp"
+#include "Compression.hpp"
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "MessageTypes.hpp"
+#include "Trace.hpp"
+#include "Transport.hpp"
 
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace Messaging
 {
@@ -27,129 +42,363 @@ namespace Messaging
 			{
 			}
 			/**
-			 * Dispatch the message to the client's remote server
+			 * Dispatch the message to the client's remote server, the response is passed to the response handler.
+			 * With TCP every request has its own connection.
 			 *
-			 * @startuml
-			 * -> client: dispatchMessage(message)
-			 * activate client
-			 * client -->> session
-			 * activate session
-			 * deactivate session
-			 * client -->> endpoint
-			 * client -\ socket: async_connect(endpoint,(){handleConnect();})
-			 * <-- client
-			 * deactivate client
-			 * client <- socket : handleConnect(session,error)
-			 * activate socket
-			 * activate client
-			 * client -> session :start
-			 * deactivate client
-			 * deactivate socket
-			 * activate session
-			 * == Writing the request ==
-			 * session -> session: writeMessage(message)
-			 * activate session
-			 * session -\ socket: async_write(socket,messageHeaderBuffer,(){handleHeaderWriten();})
-			 * deactivate session
-			 * activate socket
-			 * client <-- session
-			 * deactivate session
-			 * session <- socket : handleHeaderWriten()
-			 * deactivate socket
-			 * activate session
-			 * session -\ socket: async_write(socket,messageBodyBuffer,(){handleBodyWriten();})
-			 * deactivate session
-			 * activate socket
-			 * session <- socket : handleBodyWriten()
-			 * deactivate socket
-			 * activate session
-			 * session -> session : handleMessageWritten(error)
-			 * activate session
-			 * session -> session : handleMessageWritten()
-			 * activate session
-			 * == Reading the response ==
-			 * session -> session: readMessage
-			 * activate session
-			 * session -\ socket: async_read(socket messageHeaderBuffer, (){handleHeaderRead();})
-			 * deactivate session
-			 * activate socket
-			 * deactivate session
-			 * deactivate session
-			 * deactivate session
-			 * session <- socket : handleHeaderRead(message,error)
-			 * deactivate socket
-			 * activate session
-			 * session -\ socket: async_read(socket messageBodyBuffer,(){handleBodyRead();})
-			 * deactivate session
-			 * activate socket
-			 * session <- socket : handleBodyRead()
-			 * deactivate socket
-			 * activate session
-			 * session -> session : handleMessageRead(error)
-			 * activate session
-			 * session -> session : handleMessageRead()
-			 * activate session
-			 * == Handling the response ==
-			 * session -> responseHandler: handleResponse(message)
-			 * activate responseHandler
-			 * session <-- responseHandler
-			 * deactivate responseHandler
-			 * deactivate session
-			 * deactivate session
-			 * destroy session
-			 * @enduml
+			 * @see Transport::dispatchMessage
 			 */
 			void dispatchMessage( const Message& aMessage)
 			{
-				// Create the session that will handle the next outgoing connection
-				ClientSession* session = new ClientSession( aMessage,
-															responseHandler);
-
-				// Build up the remote address to which we will connect
-				boost::asio::ip::tcp::resolver resolver( CommunicationService::getCommunicationService().getIOContext()); // @suppress("Ambiguous problem")
-				boost::asio::ip::tcp::resolver::query query( boost::asio::ip::tcp::v4(), host, std::to_string(port));
-				boost::asio::ip::tcp::resolver::iterator endpoint_iterator = resolver.resolve( query);
-				boost::asio::ip::tcp::endpoint endpoint = *endpoint_iterator;
-
-				// Let the session handle any outgoing messages
-				session->getSocket().async_connect( endpoint, // @suppress("Method cannot be resolved") // @suppress("Invalid arguments")
-													[session](const boost::system::error_code& error)
-													{
-														Client::handleConnect(session, error);
-													});
+				CommunicationService::getCommunicationService().getTransport().dispatchMessage( host, port, aMessage, responseHandler);
 			}
 		private:
 			/**
 			 *
 			 */
-			static void handleConnect( ClientSession* aSession,
-									   const boost::system::error_code& error)
+			std::string host;
+			/**
+			 *
+			 */
+			unsigned short port;
+			/**
+			 *
+			 */
+			ResponseHandlerPtr responseHandler;
+	};
+	/**
+	 * A PipelinedClient sends all its requests over one connection to the remote server. A request is sent
+	 * without waiting for the responses to the previous requests: every request gets a correlation id and
+	 * the response with the same id is passed to the response function that was given with the request.
+	 *
+	 * The connection is made when the first request is dispatched and is made again after it is lost.
+	 * If the connection is lost or closed, every request that is still waiting for its response gets a
+	 * CommunicationReadError response. A request whose response does not come within the response
+	 * timeout gets a CommunicationReadError response as well, so a peer that stopped answering
+	 * does not leave its requests behind.
+	 *
+	 * The requests are sent over a Channel of the transport. With the in-process and shared memory
+	 * transports there is no connection, the correlation ids are used in the same way.
+	 */
+	class PipelinedClient
+	{
+		public:
+			/**
+			 *
+			 */
+			typedef std::function< void( const Message&) > ResponseFunction;
+			/**
+			 *
+			 */
+			static constexpr std::chrono::seconds defaultResponseTimeout = std::chrono::seconds( 30); // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 * @param aResponseHandler Handles the responses to the requests that are dispatched without a response function
+			 * @param aResponseTimeout The time a request waits for its response
+			 */
+			PipelinedClient( 	const std::string& aHostName,
+								unsigned short aPort,
+								ResponseHandlerPtr aResponseHandler,
+								std::chrono::steady_clock::duration aResponseTimeout = defaultResponseTimeout) :
+							connection( std::make_shared< Connection >( aHostName, aPort, aResponseHandler, aResponseTimeout))
 			{
-				if (!error)
-				{
-					aSession->start();
-				} else
+				// The channel must not keep the connection alive, the connection owns the channel
+				std::weak_ptr< Connection > weakConnection = connection;
+				connection->channel = CommunicationService::getCommunicationService().getTransport().openChannel(	aHostName,
+																													aPort,
+																													[weakConnection](const Message& aResponse)
+																													{
+																														if (std::shared_ptr< Connection > responseConnection = weakConnection.lock())
+																														{
+																															responseConnection->handleResponse( aResponse);
+																														}
+																													});
+			}
+			/**
+			 * The connection is closed, the responses that are still pending are passed
+			 * to their response functions as CommunicationReadError.
+			 */
+			~PipelinedClient()
+			{
+				close();
+			}
+			/**
+			 *
+			 */
+			PipelinedClient( const PipelinedClient&) = delete;
+			/**
+			 *
+			 */
+			PipelinedClient& operator=( const PipelinedClient&) = delete;
+			/**
+			 * Dispatch the message to the client's remote server. May be called from any thread.
+			 * The body is compressed if the server has said in a response that it accepts compressed bodies.
+			 *
+			 * @param aResponseFunction Is called with the response, if empty the response handler of the client is used
+			 * @return The correlation id of the request
+			 */
+			unsigned long dispatchMessage(	const Message& aMessage,
+											ResponseFunction aResponseFunction = ResponseFunction())
+			{
+				Message request( aMessage);
+				// The ids wrap around before they no longer fit in the header, 0 is not used
+				unsigned long correlationId = connection->correlationCounter.fetch_add( 1) % maximumCorrelationId + 1;
+				request.setCorrelationId( correlationId);
+				if (connection->peerAcceptsCompressedBodies.load())
 				{
-					std::ostringstream os;
-					os << __PRETTY_FUNCTION__ << ": error connecting to " << aSession->getSocket().remote_endpoint().address().to_string() << ":" << aSession->getSocket().remote_endpoint().port() << ", reason: " << error.message();
-					TRACE_DEVELOP(os.str());
-
-					delete aSession;
+					Compression::compress( request);
 				}
+				connection->addPendingResponse( correlationId, std::move( aResponseFunction));
+				connection->channel->sendMessage( std::move( request));
+				return correlationId;
+			}
+			/**
+			 * Closes the connection. The next dispatched message opens a new one.
+			 * The requests that are still waiting for their response get a CommunicationReadError response.
+			 */
+			void close()
+			{
+				boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+									[connection = connection]()
+									{
+										connection->close();
+									});
 			}
 			/**
 			 *
+			 * @return True if the last response of the server said that it accepts compressed bodies
 			 */
-			std::string host;
+			bool peerAcceptsCompressedBodies() const
+			{
+				return connection->peerAcceptsCompressedBodies.load();
+			}
 			/**
 			 *
+			 * @return The number of requests that are waiting for their response
 			 */
-			unsigned short port;
+			std::size_t getNumberOfPendingResponses() const
+			{
+				std::unique_lock< std::mutex > lock( connection->pendingResponsesMutex);
+				return connection->pendingResponses.size();
+			}
+		private:
 			/**
+			 * The state that is shared between the client and the functions that are posted to the io_context,
+			 * which keep it alive. A response that comes in after the connection is destroyed is dropped.
 			 *
+			 * Apart from the pending responses all members are only used by the thread that runs the io_context.
 			 */
-			ResponseHandlerPtr responseHandler;
+			struct Connection : public std::enable_shared_from_this< Connection >
+			{
+					/**
+					 *
+					 */
+					Connection( const std::string& aHostName,
+								unsigned short aPort,
+								ResponseHandlerPtr aResponseHandler,
+								std::chrono::steady_clock::duration aResponseTimeout) :
+									host( aHostName),
+									port( aPort),
+									responseHandler( aResponseHandler),
+									responseTimeout( aResponseTimeout),
+									timeoutTimer( CommunicationService::getCommunicationService().getIOContext())
+					{
+					}
+					/**
+					 * Registers the response function of a request. The timeout timer is started if it is not running.
+					 * May be called from any thread.
+					 */
+					void addPendingResponse(	unsigned long aCorrelationId,
+												ResponseFunction&& aResponseFunction)
+					{
+						bool startTimer = false;
+						{
+							std::unique_lock< std::mutex > lock( pendingResponsesMutex);
+							auto deadline = deadlines.emplace( std::chrono::steady_clock::now() + responseTimeout, aCorrelationId);
+							auto [pendingResponse, inserted] = pendingResponses.try_emplace( aCorrelationId);
+							if (!inserted)
+							{
+								// The ids wrapped around onto a request that is still waiting, it is dropped
+								deadlines.erase( pendingResponse->second.deadline);
+							}
+							pendingResponse->second = PendingResponse{ std::move( aResponseFunction), deadline};
+							startTimer = !timeoutTimerRunning;
+							timeoutTimerRunning = true;
+						}
+						if (startTimer)
+						{
+							boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+												[self = shared_from_this()]()
+												{
+													self->startTimeoutTimer();
+												});
+						}
+					}
+					/**
+					 * Lets the timer expire at the earliest deadline of the pending responses, or stops it if there is none
+					 */
+					void startTimeoutTimer()
+					{
+						std::chrono::steady_clock::time_point deadline;
+						{
+							std::unique_lock< std::mutex > lock( pendingResponsesMutex);
+							if (pendingResponses.empty())
+							{
+								timeoutTimerRunning = false;
+								return;
+							}
+							deadline = deadlines.begin()->first;
+						}
+						timeoutTimer.expires_at( deadline);
+						timeoutTimer.async_wait(	[self = shared_from_this()](const boost::system::error_code& UNUSEDPARAM(error))
+													{
+														self->handleTimeout();
+													});
+					}
+					/**
+					 * Fails the pending responses whose deadline has passed. Also called when the timer is cancelled.
+					 */
+					void handleTimeout()
+					{
+						std::vector< std::pair< unsigned long, ResponseFunction > > expiredResponses;
+						{
+							std::unique_lock< std::mutex > lock( pendingResponsesMutex);
+							std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+							while (!deadlines.empty() && deadlines.begin()->first <= now)
+							{
+								auto pendingResponse = pendingResponses.find( deadlines.begin()->second);
+								expiredResponses.emplace_back( pendingResponse->first, std::move( pendingResponse->second.responseFunction));
+								pendingResponses.erase( pendingResponse);
+								deadlines.erase( deadlines.begin());
+							}
+						}
+						for (auto& [correlationId, responseFunction] : expiredResponses)
+						{
+							std::ostringstream os;
+							os << "*** PipelinedClient: no response from " << host << ":" << port << " for request " << correlationId;
+							TRACE_DEVELOP(os.str());
+
+							Message error( CommunicationReadError, os.str());
+							error.setCorrelationId( correlationId);
+							callResponseFunction( responseFunction, error);
+						}
+						startTimeoutTimer();
+					}
+					/**
+					 * A CommunicationReadError without correlation id means the channel lost its connection
+					 */
+					void handleResponse( const Message& aResponse)
+					{
+						if (aResponse.getMessageType() == CommunicationReadError && aResponse.getCorrelationId() == 0)
+						{
+							// The next connection may be to a server that does not accept compressed bodies
+							peerAcceptsCompressedBodies.store( false);
+							failPendingResponses( aResponse);
+							return;
+						}
+						if (aResponse.getMessageType() != CommunicationReadError && aResponse.getMessageType() != CommunicationWriteError)
+						{
+							peerAcceptsCompressedBodies.store( aResponse.acceptsCompressedBody());
+						}
+						completeResponse( aResponse);
+					}
+					/**
+					 * Hands aResponse to the response function of the request with the same correlation id
+					 */
+					void completeResponse( const Message& aResponse)
+					{
+						ResponseFunction responseFunction;
+						{
+							std::unique_lock< std::mutex > lock( pendingResponsesMutex);
+							auto pendingResponse = pendingResponses.find( aResponse.getCorrelationId());
+							if (pendingResponse == pendingResponses.end())
+							{
+								TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": response without request, ") + aResponse.asString());
+								return;
+							}
+							responseFunction = std::move( pendingResponse->second.responseFunction);
+							deadlines.erase( pendingResponse->second.deadline);
+							pendingResponses.erase( pendingResponse);
+						}
+						callResponseFunction( responseFunction, aResponse);
+					}
+					/**
+					 * Passes a copy of anError with the correlation id of the request to every pending response function
+					 */
+					void failPendingResponses( const Message& anError)
+					{
+						std::map< unsigned long, PendingResponse > failedResponses;
+						{
+							std::unique_lock< std::mutex > lock( pendingResponsesMutex);
+							failedResponses.swap( pendingResponses);
+							deadlines.clear();
+						}
+						for (auto& [correlationId, pendingResponse] : failedResponses)
+						{
+							Message error( anError);
+							error.setCorrelationId( correlationId);
+							callResponseFunction( pendingResponse.responseFunction, error);
+						}
+					}
+					/**
+					 *
+					 */
+					void callResponseFunction(	const ResponseFunction& aResponseFunction,
+												const Message& aResponse)
+					{
+						if (aResponseFunction)
+						{
+							aResponseFunction( aResponse);
+						} else if (responseHandler)
+						{
+							responseHandler->handleResponse( aResponse);
+						}
+					}
+					/**
+					 * The pending responses are failed here, not every channel has a connection whose end fails them
+					 */
+					void close()
+					{
+						channel->close();
+						failPendingResponses( Message( CommunicationReadError, "*** PipelinedClient: connection closed"));
+						timeoutTimer.cancel();
+					}
+					/**
+					 * deadline -> correlation id, the timer expires at the first deadline
+					 */
+					typedef std::multimap< std::chrono::steady_clock::time_point, unsigned long > Deadlines;
+					/**
+					 *
+					 */
+					struct PendingResponse
+					{
+							ResponseFunction responseFunction;
+							Deadlines::iterator deadline;
+					};
+
+					std::string host;
+					unsigned short port;
+					ResponseHandlerPtr responseHandler;
+					std::chrono::steady_clock::duration responseTimeout;
+
+					std::atomic< unsigned long > correlationCounter = 0;
+					std::atomic< bool > peerAcceptsCompressedBodies = false;
+					mutable std::mutex pendingResponsesMutex;
+					std::map< unsigned long, PendingResponse > pendingResponses;
+					/**
+					 * The correlation ids wrap around, so their order is not the order of the deadlines
+					 */
+					Deadlines deadlines;
+					bool timeoutTimerRunning = false;
+					boost::asio::steady_timer timeoutTimer;
+
+					ChannelPtr channel;
+			};
+			/**
+			 *
+			 */
+			std::shared_ptr< Connection > connection;
 	};
+	typedef std::shared_ptr< PipelinedClient > PipelinedClientPtr;
 } // namespace Messaging
 
 #endif // CLIENT_HPP_
@@ -1,6 +1,9 @@
 #include "CommunicationService.hpp"
 
+#include "InProcessRouter.hpp"
 #include "Server.hpp"
+#include "SharedMemoryRouter.hpp"
+#include "TcpTransport.hpp"
 
 #include <sstream>
 
@@ -14,6 +17,49 @@ namespace Messaging
 		static CommunicationService communicationService;
 		return communicationService;
 	}
+	/**
+	 *
+	 */
+	/* static */TransportType CommunicationService::toTransportType( const std::string& aTransportName)
+	{
+		if (aTransportName == "tcp")
+		{
+			return TransportType::Tcp;
+		}
+		if (aTransportName == "inprocess")
+		{
+			return TransportType::InProcess;
+		}
+		if (aTransportName == "shm")
+		{
+			return TransportType::SharedMemory;
+		}
+		std::ostringstream os;
+		os << __PRETTY_FUNCTION__ << ": unknown transport " << aTransportName << ", expected tcp, inprocess or shm";
+		throw std::runtime_error( os.str());
+	}
+	/**
+	 *
+	 */
+	Transport& CommunicationService::getTransport()
+	{
+		switch (getTransportType())
+		{
+			case TransportType::InProcess:
+			{
+				return InProcessRouter::getInProcessRouter();
+			}
+			case TransportType::SharedMemory:
+			{
+				return SharedMemoryRouter::getSharedMemoryRouter();
+			}
+			case TransportType::Tcp:
+			{
+				break;
+			}
+		}
+		return TcpTransport::getTcpTransport();
+	}
 	/**
 	 *
 	 */
@@ -7,14 +7,36 @@
 
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <condition_variable>
 #include <map>
 #include <mutex>
+#include <string>
 
 namespace Messaging
 {
 	class Server;
 	typedef std::shared_ptr< Server > ServerPtr;
+	class Transport;
+
+	/**
+	 * The way the messages of Client, PipelinedClient and Server are transported
+	 */
+	enum class TransportType
+	{
+		/**
+		 * TCP/IP, the default
+		 */
+		Tcp,
+		/**
+		 * Function calls on the io_context of this process, for tests and several worlds in one process
+		 */
+		InProcess,
+		/**
+		 * Shared memory message queues, for processes on the same host
+		 */
+		SharedMemory
+	};
 
 	/*
 	 *
@@ -34,6 +56,31 @@ namespace Messaging
 			{
 				return io_context;
 			}
+			/**
+			 *
+			 */
+			TransportType getTransportType() const
+			{
+				return transportType.load();
+			}
+			/**
+			 * Should be set before the first Server is started or message is sent
+			 */
+			void setTransportType( TransportType aTransportType)
+			{
+				transportType.store( aTransportType);
+			}
+			/**
+			 *
+			 * @return The transport of the current TransportType
+			 */
+			Transport& getTransport();
+			/**
+			 *
+			 * @param aTransportName "tcp", "inprocess" or "shm"
+			 * @throw std::runtime_error if aTransportName is unknown
+			 */
+			static TransportType toTransportType( const std::string& aTransportName);
 			/**
 			 *
 			 */
@@ -115,6 +162,10 @@ namespace Messaging
 			 *
 			 */
 			boost::asio::deadline_timer timer;
+			/**
+			 *
+			 */
+			std::atomic< TransportType > transportType = TransportType::Tcp;
 
 
 	};
@@ -0,0 +1,180 @@
+#ifndef COMPRESSION_HPP_
+#define COMPRESSION_HPP_
+
+#include "Config.hpp"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Message.hpp"
+#include "MessageTypes.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <zlib.h>
+
+namespace Messaging
+{
+	/**
+	 * Compression compresses and decompresses message bodies with zlib.
+	 *
+	 * Compression is negotiated per connection: the sessions, routers and clients that send the messages
+	 * set the AcceptsCompressedBody flag in their headers if compression was enabled when they were created,
+	 * and a body is only compressed for a peer whose messages carry that flag. Bodies shorter than the
+	 * threshold, like the poses of robots, are never compressed.
+	 *
+	 * A compressed body is the length of the original body as 4 bytes, most significant byte first,
+	 * followed by the zlib stream.
+	 */
+	class Compression
+	{
+		public:
+			/**
+			 * The default minimum body length that is compressed
+			 */
+			static constexpr std::size_t defaultThreshold = 1024;
+			/**
+			 * The largest body that is decompressed, protects against corrupt or hostile length fields
+			 */
+			static constexpr std::size_t maximumBodyLength = 64 * 1024 * 1024;
+			/**
+			 * Enables or disables the compression of the bodies that are sent. The sessions, routers and clients
+			 * that are created or reused afterwards take the setting for the AcceptsCompressedBody flag of their
+			 * headers. Compressed bodies that are received are always decompressed.
+			 */
+			static void setEnabled( bool anEnabled)
+			{
+				enabled.store( anEnabled);
+			}
+			/**
+			 *
+			 */
+			static bool isEnabled()
+			{
+				return enabled.load();
+			}
+			/**
+			 *
+			 */
+			static void setThreshold( std::size_t aThreshold)
+			{
+				threshold.store( aThreshold);
+			}
+			/**
+			 *
+			 */
+			static std::size_t getThreshold()
+			{
+				return threshold.load();
+			}
+			/**
+			 * Compresses the body of aMessage if compression is enabled, the body is at least as long as the
+			 * threshold and the compressed body is shorter than the original.
+			 *
+			 * @return True if the body is compressed
+			 */
+			static bool compress( Message& aMessage)
+			{
+				if (!isEnabled() || aMessage.isCompressed() || aMessage.length() < getThreshold() || aMessage.length() > maximumBodyLength)
+				{
+					return false;
+				}
+
+				uLongf compressedLength = compressBound( static_cast< uLong >( aMessage.length()));
+				std::string body( lengthPrefixSize + compressedLength, '\0');
+				writeLength( body, aMessage.length());
+				if (compress2(	reinterpret_cast< Bytef* >( &body[lengthPrefixSize]),
+								&compressedLength,
+								reinterpret_cast< const Bytef* >( aMessage.message.data()),
+								static_cast< uLong >( aMessage.length()),
+								Z_BEST_SPEED) != Z_OK || lengthPrefixSize + compressedLength >= aMessage.length())
+				{
+					return false;
+				}
+				body.resize( lengthPrefixSize + compressedLength);
+				aMessage.message.swap( body);
+				aMessage.setFlags( aMessage.getFlags() | Message::CompressedBody);
+				return true;
+			}
+			/**
+			 * Compresses the body of aMessage if aPeerMessage, a message from the receiver, says that the receiver accepts it
+			 *
+			 * @return True if the body is compressed
+			 */
+			static bool compressFor(	Message& aMessage,
+										const Message& aPeerMessage)
+			{
+				return aPeerMessage.acceptsCompressedBody() && compress( aMessage);
+			}
+			/**
+			 * Decompresses the body of aMessage if it is compressed. If the body cannot be decompressed
+			 * aMessage becomes a CommunicationReadError with the reason as body.
+			 *
+			 * @return False if the body is compressed and cannot be decompressed
+			 */
+			static bool decompress( Message& aMessage)
+			{
+				if (!aMessage.isCompressed())
+				{
+					return true;
+				}
+				aMessage.setFlags( aMessage.getFlags() & ~Message::CompressedBody);
+				if (aMessage.length() >= lengthPrefixSize)
+				{
+					std::size_t length = readLength( aMessage.message);
+					if (length <= maximumBodyLength)
+					{
+						std::string body( length, '\0');
+						uLongf uncompressedLength = static_cast< uLongf >( length);
+						if (uncompress(	reinterpret_cast< Bytef* >( body.data()),
+										&uncompressedLength,
+										reinterpret_cast< const Bytef* >( aMessage.message.data() + lengthPrefixSize),
+										static_cast< uLong >( aMessage.length() - lengthPrefixSize)) == Z_OK && uncompressedLength == length)
+						{
+							aMessage.message.swap( body);
+							return true;
+						}
+					}
+				}
+				aMessage.setBody( "*** Compression::decompress: corrupt compressed body, message type " + std::to_string( static_cast< int >( aMessage.getMessageType())));
+				aMessage.setMessageType( CommunicationReadError);
+				return false;
+			}
+		private:
+			/**
+			 * The number of bytes of the length of the original body
+			 */
+			static constexpr std::size_t lengthPrefixSize = 4;
+			/**
+			 *
+			 */
+			static void writeLength(	std::string& aBody,
+										std::size_t aLength)
+			{
+				for (std::size_t i = 0; i < lengthPrefixSize; ++i)
+				{
+					aBody[i] = static_cast< char >((aLength >> (8 * (lengthPrefixSize - 1 - i))) & 0xFF); // @suppress("Avoid magic numbers")
+				}
+			}
+			/**
+			 *
+			 */
+			static std::size_t readLength( const std::string& aBody)
+			{
+				std::size_t length = 0;
+				for (std::size_t i = 0; i < lengthPrefixSize; ++i)
+				{
+					length = (length << 8) | static_cast< unsigned char >( aBody[i]); // @suppress("Avoid magic numbers")
+				}
+				return length;
+			}
+
+			inline static std::atomic< bool > enabled = false;
+			inline static std::atomic< std::size_t > threshold = defaultThreshold;
+	};
+} // namespace Messaging
+
+#endif // COMPRESSION_HPP_
@@ -0,0 +1,321 @@
+#ifndef DATAGRAM_HPP_
+#define DATAGRAM_HPP_
+
+#include "Config.hpp"
+
+#include "CommunicationService.hpp"
+#include "Compression.hpp"
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "Trace.hpp"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Messaging
+{
+	/**
+	 * The largest payload of a UDP datagram over IPv4
+	 */
+	const std::size_t maximumDatagramSize = 65507;
+	/**
+	 * Sequence numbers are compared with serial number arithmetic (RFC 1982) so they may wrap around.
+	 *
+	 * @return true if aSequenceNumber is later than aPreviousSequenceNumber
+	 */
+	inline bool isNewerSequenceNumber(	std::uint32_t aSequenceNumber,
+										std::uint32_t aPreviousSequenceNumber)
+	{
+		return static_cast< std::int32_t >( aSequenceNumber - aPreviousSequenceNumber) > 0;
+	}
+	/**
+	 * A DatagramServer receives messages that are sent by a DatagramClient. Every message is one
+	 * datagram: the ASCII header followed by the body. The correlation id of the header carries the
+	 * sequence number of the sender.
+	 *
+	 * The transport is unreliable and is meant for latest-value-wins messages like the poses of robots:
+	 * a message that is older than the last message of the same type from the same sender is dropped.
+	 * There is no response, whatever the request handler puts in the message is ignored.
+	 *
+	 * UDP has no connection, so anybody can send a datagram to the port. If a peer is set only the
+	 * datagrams that come from the address of the peer are handled. The port of the sender is not
+	 * checked as a DatagramClient sends from a port that is chosen by the operating system.
+	 */
+	class DatagramServer : public std::enable_shared_from_this< DatagramServer >
+	{
+		public:
+			/**
+			 *
+			 */
+			DatagramServer(	unsigned short aPort,
+							RequestHandlerPtr aRequestHandler) :
+								port( aPort),
+								socket( CommunicationService::getCommunicationService().getIOContext()),
+								requestHandler( aRequestHandler)
+			{
+			}
+			/**
+			 *
+			 */
+			unsigned short getPort() const
+			{
+				return port;
+			}
+			/**
+			 * Only the datagrams from the addresses of aHostName are handled. Must be called before startHandlingRequests.
+			 *
+			 * @throw boost::system::system_error if aHostName cannot be resolved
+			 */
+			void setPeer( const std::string& aHostName)
+			{
+				boost::asio::ip::udp::resolver resolver( CommunicationService::getCommunicationService().getIOContext()); // @suppress("Ambiguous problem")
+				peerAddresses.clear();
+				for (const boost::asio::ip::udp::resolver::results_type::value_type& entry : resolver.resolve( boost::asio::ip::udp::v4(), aHostName, std::to_string( port)))
+				{
+					peerAddresses.push_back( entry.endpoint().address());
+				}
+			}
+			/**
+			 *
+			 */
+			void startHandlingRequests()
+			{
+				boost::asio::ip::udp::endpoint ep( boost::asio::ip::udp::v4(), port);
+				socket.open( ep.protocol());
+				socket.set_option( boost::asio::ip::udp::socket::reuse_address( true));
+				socket.bind( ep);
+
+				receive();
+			}
+			/**
+			 *
+			 */
+			void stopHandlingRequests()
+			{
+				std::shared_ptr< DatagramServer > self = shared_from_this();
+				boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+									[self]()
+									{
+										boost::system::error_code ignored;
+										self->socket.close( ignored);
+									});
+			}
+			/**
+			 *
+			 * @return The number of messages that were dropped because they were older than an already handled one
+			 */
+			unsigned long getNumberOfStaleMessages() const
+			{
+				return numberOfStaleMessages.load();
+			}
+			/**
+			 *
+			 * @return The number of messages that were dropped because they did not come from the peer
+			 */
+			unsigned long getNumberOfRejectedMessages() const
+			{
+				return numberOfRejectedMessages.load();
+			}
+		private:
+			/**
+			 *
+			 */
+			void receive()
+			{
+				std::shared_ptr< DatagramServer > self = shared_from_this();
+				socket.async_receive_from(	boost::asio::buffer( receiveBuffer), // @suppress("Invalid arguments")
+											senderEndpoint,
+											[self](const boost::system::error_code& error, std::size_t bytes_transferred)
+											{
+												self->handleReceive( error, bytes_transferred);
+											});
+			}
+			/**
+			 *
+			 */
+			void handleReceive(	const boost::system::error_code& error,
+								std::size_t bytes_transferred)
+			{
+				if (error == boost::asio::error::operation_aborted || !socket.is_open())
+				{
+					return;
+				}
+				if (!error)
+				{
+					handleDatagram( bytes_transferred);
+				} else
+				{
+					TRACE_DEVELOP("*** DatagramServer::handleReceive: " + error.message());
+				}
+				receive();
+			}
+			/**
+			 *
+			 */
+			void handleDatagram( std::size_t aLength)
+			{
+				if (!peerAddresses.empty() && std::find( peerAddresses.begin(), peerAddresses.end(), senderEndpoint.address()) == peerAddresses.end())
+				{
+					++numberOfRejectedMessages;
+					return;
+				}
+				std::size_t headerLength = Message::MessageHeader::headerLength;
+				if (aLength < headerLength)
+				{
+					TRACE_DEVELOP("*** DatagramServer::handleDatagram: datagram shorter than a header");
+					return;
+				}
+				Message::MessageHeader header( std::string_view( receiveBuffer.data(), headerLength));
+				if (header.getMessageLength() != aLength - headerLength)
+				{
+					TRACE_DEVELOP("*** DatagramServer::handleDatagram: truncated datagram, " + header.asString());
+					return;
+				}
+
+				std::uint32_t sequenceNumber = static_cast< std::uint32_t >( header.getCorrelationId());
+				auto [lastSequenceNumber, isFirst] = lastSequenceNumbers.try_emplace( std::make_pair( senderEndpoint, header.getMessageType()), sequenceNumber);
+				if (!isFirst)
+				{
+					if (!isNewerSequenceNumber( sequenceNumber, lastSequenceNumber->second))
+					{
+						++numberOfStaleMessages;
+						return;
+					}
+					lastSequenceNumber->second = sequenceNumber;
+				}
+
+				Message message;
+				message.setHeader( header);
+				message.setBody( std::string( receiveBuffer.data() + headerLength, header.getMessageLength()));
+				if (!Compression::decompress( message))
+				{
+					TRACE_DEVELOP("*** DatagramServer::handleDatagram: " + message.getBody());
+					return;
+				}
+				requestHandler->handleRequest( message);
+			}
+			/**
+			 *
+			 */
+			unsigned short port;
+			/**
+			 *
+			 */
+			boost::asio::ip::udp::socket socket;
+			/**
+			 *
+			 */
+			RequestHandlerPtr requestHandler;
+			/**
+			 * The sender of the datagram that is being received
+			 */
+			boost::asio::ip::udp::endpoint senderEndpoint;
+			/**
+			 * The addresses the datagrams must come from, empty if any sender is accepted
+			 */
+			std::vector< boost::asio::ip::address > peerAddresses;
+			/**
+			 *
+			 */
+			std::array< char, maximumDatagramSize > receiveBuffer;
+			/**
+			 * (sender, message type) -> sequence number of the last handled message
+			 */
+			std::map< std::pair< boost::asio::ip::udp::endpoint, char >, std::uint32_t > lastSequenceNumbers;
+			/**
+			 *
+			 */
+			std::atomic< unsigned long > numberOfStaleMessages = 0;
+			/**
+			 *
+			 */
+			std::atomic< unsigned long > numberOfRejectedMessages = 0;
+	};
+	/**
+	 *
+	 */
+	typedef std::shared_ptr< DatagramServer > DatagramServerPtr;
+	/**
+	 * A DatagramClient sends messages to a DatagramServer, one datagram per message.
+	 * Every message gets the next sequence number of the client.
+	 */
+	class DatagramClient
+	{
+		public:
+			/**
+			 *
+			 */
+			DatagramClient(	const std::string& aHostName,
+							unsigned short aPort) :
+								socket( CommunicationService::getCommunicationService().getIOContext())
+			{
+				boost::asio::ip::udp::resolver resolver( CommunicationService::getCommunicationService().getIOContext()); // @suppress("Ambiguous problem")
+				endpoint = *resolver.resolve( boost::asio::ip::udp::v4(), aHostName, std::to_string( aPort)).begin();
+				socket.open( boost::asio::ip::udp::v4());
+			}
+			/**
+			 * Sends the message. May be called from any thread, the message is sent before the function returns.
+			 *
+			 * @return true if the message is sent, false if it is too large for a datagram or could not be sent
+			 */
+			bool dispatchMessage( const Message& aMessage)
+			{
+				std::unique_lock< std::mutex > lock( clientMutex);
+
+				Message message( aMessage);
+				message.setCorrelationId( ++sequenceNumber);
+
+				// A datagram gets no response, so there is nothing to accept compressed bodies for
+				std::string header = message.getHeader().toString();
+				if (header.length() + message.length() > maximumDatagramSize)
+				{
+					TRACE_DEVELOP("*** DatagramClient::dispatchMessage: message too large for a datagram, " + message.getHeader().asString());
+					return false;
+				}
+
+				std::array< boost::asio::const_buffer, 2 > buffers = { boost::asio::buffer( header),
+																	   boost::asio::buffer( message.message) };
+				boost::system::error_code error;
+				socket.send_to( buffers, endpoint, 0, error);
+				if (error)
+				{
+					TRACE_DEVELOP("*** DatagramClient::dispatchMessage: " + error.message());
+					return false;
+				}
+				return true;
+			}
+		private:
+			/**
+			 *
+			 */
+			boost::asio::ip::udp::socket socket;
+			/**
+			 *
+			 */
+			boost::asio::ip::udp::endpoint endpoint;
+			/**
+			 *
+			 */
+			std::uint32_t sequenceNumber = 0;
+			/**
+			 *
+			 */
+			std::mutex clientMutex;
+	};
+	/**
+	 *
+	 */
+	typedef std::shared_ptr< DatagramClient > DatagramClientPtr;
+} // namespace Messaging
+
+#endif // DATAGRAM_HPP_
@@ -2,20 +2,43 @@
 
 #include "TimeStamp.hpp"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 #include <string>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 namespace Base
 {
+	/**
+	 * The size of the chunks that the memory mapped writer maps, a multiple of the page size
+	 */
+	const std::size_t MAPCHUNKSIZE = 4 * 1024 * 1024; // @suppress("Avoid magic numbers")
+
 	/**
 	 *
 	 */
 	FileTraceFunction::FileTraceFunction( const std::string& aFileStem /* = "trace" */,
 										  const std::string& aFileExtension /* = "log" */,
-										  bool timeStamped /* = false */ )
+										  bool timeStamped /* = false */,
+										  const FileTraceConfiguration& aConfiguration /* = FileTraceConfiguration() */)
 
-						:	logFile((aFileStem + (timeStamped ? "-" + Utils::TimeStamp() : "") + "." + aFileExtension).c_str(), std::ios_base::app)
+						:	fileStem( aFileStem + (timeStamped ? "-" + Utils::TimeStamp() : "")),
+							fileExtension( aFileExtension),
+							configuration( aConfiguration)
 	{
+		buffer.reserve( configuration.bufferSize + 1024); // @suppress("Avoid magic numbers")
+		openFile();
 		FileTraceFunction::trace( " ******************* START " + Utils::TimeStamp() + " START *******************");
+
+		flushThread = std::thread( [this]()
+								   {
+										flushPeriodically();
+								   });
 	}
 	/**
 	 *
@@ -23,13 +46,232 @@ namespace Base
 	FileTraceFunction::~FileTraceFunction()
 	{
 		FileTraceFunction::trace( " ******************* END " + Utils::TimeStamp() + " END *******************");
-		logFile.close();
+		{
+			std::unique_lock< std::mutex > lock( bufferBusy);
+			stopFlushing = true;
+			stopRequested.notify_all();
+		}
+		flushThread.join();
+
+		std::unique_lock< std::mutex > lock( bufferBusy);
+		writeBuffer();
+		closeFile();
 	}
 	/**
 	 *
 	 */
 	void FileTraceFunction::trace( const std::string& aText)
 	{
-		logFile << aText << std::endl;
+		std::unique_lock< std::mutex > lock( bufferBusy);
+		if (needsRotation( aText.length() + 1))
+		{
+			writeBuffer();
+			rotate();
+		}
+		buffer += aText;
+		buffer += '\n';
+		if (buffer.length() >= configuration.bufferSize)
+		{
+			writeBuffer();
+		}
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::flush()
+	{
+		std::unique_lock< std::mutex > lock( bufferBusy);
+		writeBuffer();
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::flushPeriodically()
+	{
+		std::unique_lock< std::mutex > lock( bufferBusy);
+		while (!stopFlushing)
+		{
+			stopRequested.wait_for( lock, configuration.flushInterval);
+			writeBuffer();
+			if (!stopFlushing && needsRotation( 0))
+			{
+				rotate();
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	bool FileTraceFunction::needsRotation( std::size_t aLength) const
+	{
+		std::size_t size = fileSize + buffer.length();
+		if (size == 0)
+		{
+			return false;
+		}
+		if (configuration.maximumFileSize != 0 && size + aLength > configuration.maximumFileSize)
+		{
+			return true;
+		}
+		return configuration.maximumFileAge.count() != 0 && std::chrono::steady_clock::now() - fileOpened >= configuration.maximumFileAge;
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::writeBuffer()
+	{
+		if (!buffer.empty())
+		{
+			writeToFile( buffer.data(), buffer.length());
+			buffer.clear();
+		}
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::rotate()
+	{
+		closeFile();
+
+		if (configuration.numberOfRotatedFiles == 0)
+		{
+			std::remove( getFileName( 0).c_str());
+		} else
+		{
+			// The oldest file is overwritten by the one before it
+			for (unsigned long rotation = configuration.numberOfRotatedFiles; rotation > 0; --rotation)
+			{
+				std::rename( getFileName( rotation - 1).c_str(), getFileName( rotation).c_str());
+			}
+		}
+
+		openFile();
+	}
+	/**
+	 *
+	 */
+	std::string FileTraceFunction::getFileName( unsigned long aRotation) const
+	{
+		if (aRotation == 0)
+		{
+			return fileStem + "." + fileExtension;
+		}
+		return fileStem + "." + std::to_string( aRotation) + "." + fileExtension;
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::openFile()
+	{
+		std::string fileName = getFileName( 0);
+		if (configuration.writerType == FileTraceConfiguration::WriterType::MemoryMapped)
+		{
+			fileDescriptor = ::open( fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644); // @suppress("Avoid magic numbers")
+		} else
+		{
+			fileDescriptor = ::open( fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); // @suppress("Avoid magic numbers")
+		}
+		if (fileDescriptor == -1)
+		{
+			std::cerr << __PRETTY_FUNCTION__ << ": " << fileName << ": " << std::strerror( errno) << std::endl;
+			fileSize = 0;
+		} else
+		{
+			off_t end = ::lseek( fileDescriptor, 0, SEEK_END);
+			fileSize = end > 0 ? static_cast< std::size_t >( end) : 0;
+		}
+		fileOpened = std::chrono::steady_clock::now();
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::closeFile()
+	{
+		if (fileDescriptor == -1)
+		{
+			return;
+		}
+		if (mappedData)
+		{
+			::munmap( mappedData, mappedLength);
+			mappedData = nullptr;
+		}
+		if (configuration.writerType == FileTraceConfiguration::WriterType::MemoryMapped)
+		{
+			// Cut off the unused part of the last chunk
+			if (::ftruncate( fileDescriptor, static_cast< off_t >( fileSize)) == -1)
+			{
+				std::cerr << __PRETTY_FUNCTION__ << ": " << std::strerror( errno) << std::endl;
+			}
+		}
+		::close( fileDescriptor);
+		fileDescriptor = -1;
+	}
+	/**
+	 *
+	 */
+	void FileTraceFunction::writeToFile(	const char* aData,
+											std::size_t aLength)
+	{
+		if (fileDescriptor == -1)
+		{
+			return;
+		}
+
+		if (configuration.writerType == FileTraceConfiguration::WriterType::MemoryMapped)
+		{
+			if ((mappedData && fileSize + aLength <= mappedOffset + mappedLength) || mapFile( aLength))
+			{
+				std::memcpy( mappedData + (fileSize - mappedOffset), aData, aLength);
+				fileSize += aLength;
+			}
+			return;
+		}
+
+		while (aLength > 0)
+		{
+			ssize_t written = ::write( fileDescriptor, aData, aLength);
+			if (written == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				std::cerr << __PRETTY_FUNCTION__ << ": " << std::strerror( errno) << std::endl;
+				return;
+			}
+			aData += written;
+			aLength -= static_cast< std::size_t >( written);
+			fileSize += static_cast< std::size_t >( written);
+		}
+	}
+	/**
+	 *
+	 */
+	bool FileTraceFunction::mapFile( std::size_t aLength)
+	{
+		if (mappedData)
+		{
+			::munmap( mappedData, mappedLength);
+			mappedData = nullptr;
+		}
+
+		std::size_t pageSize = static_cast< std::size_t >( ::sysconf( _SC_PAGESIZE));
+		mappedOffset = fileSize - fileSize % pageSize;
+		mappedLength = ((fileSize - mappedOffset + aLength + MAPCHUNKSIZE - 1) / MAPCHUNKSIZE) * MAPCHUNKSIZE;
+
+		if (::ftruncate( fileDescriptor, static_cast< off_t >( mappedOffset + mappedLength)) == -1)
+		{
+			std::cerr << __PRETTY_FUNCTION__ << ": " << std::strerror( errno) << std::endl;
+			return false;
+		}
+		void* data = ::mmap( nullptr, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, static_cast< off_t >( mappedOffset));
+		if (data == MAP_FAILED)
+		{
+			std::cerr << __PRETTY_FUNCTION__ << ": " << std::strerror( errno) << std::endl;
+			return false;
+		}
+		mappedData = static_cast< char* >( data);
+		return true;
 	}
 } /* namespace Base */
@@ -3,12 +3,65 @@
 
 #include "ITraceFunction.hpp"
 
-#include <fstream>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
 
 namespace Base
 {
 	/**
-	 *
+	 * How the FileTraceFunction writes, buffers and rotates the trace file
+	 */
+	struct FileTraceConfiguration
+	{
+			/**
+			 *
+			 */
+			enum class WriterType
+			{
+				/**
+				 * The buffer is written with one write call
+				 */
+				Stream,
+				/**
+				 * The file is memory mapped in chunks and the buffer is copied into the mapping, writing
+				 * does not need a system call until a new chunk is mapped. Until the file is closed it
+				 * ends with the unused part of the last chunk.
+				 */
+				MemoryMapped
+			};
+			/**
+			 * The number of bytes that are buffered before they are written
+			 */
+			std::size_t bufferSize = 1024 * 1024; // @suppress("Avoid magic numbers")
+			/**
+			 * The buffer is also written if it is older than this
+			 */
+			std::chrono::milliseconds flushInterval = std::chrono::milliseconds( 1000); // @suppress("Avoid magic numbers")
+			/**
+			 * The file is rotated before it grows beyond this number of bytes, 0 for no maximum
+			 */
+			std::size_t maximumFileSize = 16 * 1024 * 1024; // @suppress("Avoid magic numbers")
+			/**
+			 * The file is rotated if it is older than this, 0 for no maximum
+			 */
+			std::chrono::seconds maximumFileAge = std::chrono::seconds( 0);
+			/**
+			 * The number of rotated files that are kept: stem.1.extension is the newest, stem.n.extension the oldest
+			 */
+			unsigned long numberOfRotatedFiles = 4; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			WriterType writerType = WriterType::Stream;
+	}; // struct FileTraceConfiguration
+
+	/**
+	 * The FileTraceFunction buffers the trace in memory and writes it to the file when the buffer is full or
+	 * every flush interval, so tracing does not cost a system call per line. The trace of the last flush
+	 * interval is lost if the application crashes.
 	 */
 	class FileTraceFunction :  public ITraceFunction
 	{
@@ -18,10 +71,12 @@ namespace Base
 			 * @param aFileStem
 			 * @param aFileExtension
 			 * @param timeStamped If true, the file name contains a timestamp so that the log file of multiple runs can coexist.
+			 * @param aConfiguration The buffering and rotation
 			 */
 			explicit FileTraceFunction(const std::string& aFileStem= "trace",
 									   const std::string& aFileExtension= "log",
-									   bool timeStamped = false);
+									   bool timeStamped = false,
+									   const FileTraceConfiguration& aConfiguration = FileTraceConfiguration());
 			/**
 			 *
 			 */
@@ -30,10 +85,69 @@ namespace Base
 			 *
 			 */
 			virtual void trace(	const std::string& aText) override;
+			/**
+			 * Writes the buffer to the file
+			 */
+			void flush();
 		private:
-			std::ofstream logFile;
-	}; // class StdOutTraceFunction
+			/**
+			 * The loop of the flush thread
+			 */
+			void flushPeriodically();
+			/**
+			 * Must be called with bufferBusy locked
+			 */
+			bool needsRotation( std::size_t aLength) const;
+			/**
+			 * Must be called with bufferBusy locked
+			 */
+			void writeBuffer();
+			/**
+			 * Must be called with bufferBusy locked
+			 */
+			void rotate();
+			/**
+			 *
+			 */
+			std::string getFileName( unsigned long aRotation) const;
+			/**
+			 *
+			 */
+			void openFile();
+			/**
+			 *
+			 */
+			void closeFile();
+			/**
+			 *
+			 */
+			void writeToFile(	const char* aData,
+								std::size_t aLength);
+			/**
+			 * Maps the chunk of the file that contains the write position and at least aLength bytes after it
+			 */
+			bool mapFile( std::size_t aLength);
+
+			const std::string fileStem;
+			const std::string fileExtension;
+			const FileTraceConfiguration configuration;
+
+			std::mutex bufferBusy;
+			std::string buffer;
+
+			int fileDescriptor = -1;
+			std::size_t fileSize = 0;
+			std::chrono::steady_clock::time_point fileOpened;
+
+			char* mappedData = nullptr;
+			std::size_t mappedOffset = 0;
+			std::size_t mappedLength = 0;
+
+			std::condition_variable stopRequested;
+			bool stopFlushing = false;
+			std::thread flushThread;
+	}; // class FileTraceFunction
 
 } /* namespace Base */
 
-#endif // SRC_FILETRACEFUNCTION_HPP_ 
+#endif // SRC_FILETRACEFUNCTION_HPP_
@@ -0,0 +1,160 @@
+#ifndef INPROCESSROUTER_HPP_
+#define INPROCESSROUTER_HPP_
+
+#include "Config.hpp"
+
+#include "CommunicationService.hpp"
+#include "Compression.hpp"
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "MessageTypes.hpp"
+#include "RequestDispatcher.hpp"
+#include "Trace.hpp"
+#include "Transport.hpp"
+
+#include <boost/asio.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Messaging
+{
+	/**
+	 * The InProcessRouter is the transport for TransportType::InProcess. A Server registers its request handler
+	 * under its port number and a message for that port is handed to the request handler as a copy, without
+	 * sockets, name resolution or a text header. The request and the response are handled on the io_context of
+	 * the CommunicationService, the same thread on which the TCP sessions call the handlers, or the request is
+	 * handled by the model thread of the RequestDispatcher of the server.
+	 */
+	class InProcessRouter : public RouterTransport
+	{
+		public:
+			/**
+			 *
+			 */
+			static InProcessRouter& getInProcessRouter()
+			{
+				static InProcessRouter inProcessRouter;
+				return inProcessRouter;
+			}
+			/**
+			 * @see Transport::registerRequestHandler
+			 */
+			virtual void registerRequestHandler(	unsigned short aPort,
+													RequestHandlerPtr aRequestHandler,
+													RequestDispatcherPtr aRequestDispatcher) override
+			{
+				std::unique_lock< std::mutex > lock( routerMutex);
+				if (!registrations.emplace( aPort, Registration{ aRequestHandler, aRequestDispatcher }).second)
+				{
+					throw std::runtime_error( __PRETTY_FUNCTION__ + std::string( ": only one server per port allowed, port = ") + std::to_string( aPort));
+				}
+			}
+			/**
+			 * @see Transport::deregisterRequestHandler
+			 */
+			virtual void deregisterRequestHandler( unsigned short aPort) override
+			{
+				std::unique_lock< std::mutex > lock( routerMutex);
+				registrations.erase( aPort);
+			}
+			/**
+			 * Hands a copy of aRequest to the request handler of aPort and the response to aResponseFunction.
+			 * If there is no request handler for aPort, aResponseFunction gets a CommunicationReadError.
+			 *
+			 * @see RouterTransport::routeMessage
+			 */
+			virtual void routeMessage(	unsigned short aPort,
+										const Message& aRequest,
+										ResponseFunction aResponseFunction) override
+			{
+				boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+									[this, aPort, aRequest, aResponseFunction]()
+									{
+										Message message( aRequest);
+										// The flags as they would be in the header of the request
+										message.setFlags( message.getHeader( acceptsCompressedBodies).getFlags());
+										// The sender may have compressed the body as it does for a remote peer
+										Compression::decompress( message);
+
+										Registration registration;
+										{
+											std::unique_lock< std::mutex > lock( routerMutex);
+											auto result = registrations.find( aPort);
+											if (result != registrations.end())
+											{
+												registration = result->second;
+											}
+										}
+										if (!registration.requestHandler)
+										{
+											message.setMessageType( CommunicationReadError);
+											message.setBody( "*** InProcessRouter::routeMessage: no server for port " + std::to_string( aPort));
+											aResponseFunction( message);
+											return;
+										}
+										if (!registration.requestDispatcher)
+										{
+											registration.requestHandler->handleRequest( message);
+											respond( message, aResponseFunction);
+											return;
+										}
+										// The dispatcher calls the response function on the io_context
+										if (!registration.requestDispatcher->dispatch(	message,
+																					registration.requestHandler,
+																					[this, aResponseFunction](const Message& aResponse)
+																					{
+																						Message response( aResponse);
+																						respond( response, aResponseFunction);
+																					}))
+										{
+											TRACE_DEVELOP("*** InProcessRouter::routeMessage: dispatch queue full, " + message.getHeader().asString());
+											message.setMessageType( ServerSideExceptionResponse);
+											message.setBody( "*** InProcessRouter::routeMessage: server busy");
+											aResponseFunction( message);
+										}
+									});
+			}
+		private:
+			/**
+			 * The request handler of a port and the dispatcher of its server, if any
+			 */
+			struct Registration
+			{
+					RequestHandlerPtr requestHandler;
+					RequestDispatcherPtr requestDispatcher;
+			};
+			/**
+			 *
+			 */
+			InProcessRouter() = default;
+			/**
+			 * Passes aResponse with a plain body and the flags of its header to aResponseFunction
+			 */
+			void respond(	Message& aResponse,
+							const ResponseFunction& aResponseFunction)
+			{
+				// The request handler may have compressed the response for a remote peer
+				Compression::decompress( aResponse);
+				aResponse.setFlags( aResponse.getHeader( acceptsCompressedBodies).getFlags());
+				aResponseFunction( aResponse);
+			}
+			/**
+			 *
+			 */
+			std::map< unsigned short, Registration > registrations;
+			/**
+			 *
+			 */
+			std::mutex routerMutex;
+			/**
+			 * True if the messages that are routed say that compressed bodies are accepted
+			 */
+			bool acceptsCompressedBodies = Compression::isEnabled();
+	};
+} // namespace Messaging
+
+#endif // INPROCESSROUTER_HPP_
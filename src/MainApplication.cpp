@@ -1,7 +1,10 @@
 #include "MainApplication.hpp"
 
+#include "CommunicationService.hpp"
+#include "Compression.hpp"
 #include "MainFrameWindow.hpp"
 #include "ObjectId.hpp"
+#include "Trace.hpp"
 
 #include <stdexcept>
 #include <algorithm>
@@ -38,6 +41,44 @@ namespace Application
 
 		MainApplication::setCommandlineArguments( argc, argv);
 
+		if(MainApplication::isArgGiven("-transport"))
+		{
+			try
+			{
+				Messaging::CommunicationService::getCommunicationService().setTransportType( Messaging::CommunicationService::toTransportType( MainApplication::getArg("-transport").value));
+			}
+			catch (std::exception& e)
+			{
+				// An unknown transport is not a reason not to start, TCP is used
+				TRACE_DEVELOP( e.what());
+			}
+		}
+
+		// With -trace=async the tracing threads only write into a buffer, a background thread does the output.
+		// -trace=binary does the same but writes trace.bin, tracedecoder turns it into text.
+		if(MainApplication::isArgGiven("-trace") && MainApplication::getArg("-trace").value == "async")
+		{
+			Base::Trace::enableAsyncTrace();
+		}else if(MainApplication::isArgGiven("-trace") && MainApplication::getArg("-trace").value == "binary")
+		{
+			Base::Trace::enableBinaryTrace( "trace.bin");
+		}
+
+		// Large bodies, like the world info, are compressed unless it is turned off with -compression=off
+		Messaging::Compression::setEnabled( !MainApplication::isArgGiven("-compression") || MainApplication::getArg("-compression").value != "off");
+		if(MainApplication::isArgGiven("-compression_threshold"))
+		{
+			try
+			{
+				Messaging::Compression::setThreshold( std::stoul( MainApplication::getArg("-compression_threshold").value));
+			}
+			catch (std::exception& e)
+			{
+				// A threshold that is not a number is not a reason not to start, the default is used
+				TRACE_DEVELOP( e.what());
+			}
+		}
+
 		MainFrameWindow* frame = nullptr;
 		if(MainApplication::isArgGiven("-worldname"))
 		{
@@ -3,23 +3,49 @@
 
 #include "Config.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iomanip>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 /**
  *
  */
 namespace Messaging
 {
-	const int charWidth = 3; // char : 255, ergo 3 numbers
-	const int intWidth = 10; // unsigned long : 4,294,967,295 ergo 10 numbers
+	const std::size_t charWidth = 3; // char : 255, ergo 3 numbers
+	const std::size_t intWidth = 10; // unsigned long : 4,294,967,295 ergo 10 numbers
+	const std::size_t flagsWidth = 1; // the flags are 1 digit
+	/**
+	 * The largest correlation id that fits in the header, the ids of a PipelinedClient wrap around to 1 after it
+	 */
+	const unsigned long maximumCorrelationId = static_cast<unsigned long>(std::min< unsigned long long >( 9999999999ULL, std::numeric_limits< unsigned long >::max())); // @suppress("Avoid magic numbers")
 	/**
 	 *
 	 */
 	struct Message
 	{
 			typedef std::string MessageBody;
+			/**
+			 * The bits of the flags in the header
+			 */
+			enum Flags : unsigned char
+			{
+				NoFlags = 0,
+				/**
+				 * The body is compressed, see Compression
+				 */
+				CompressedBody = 1,
+				/**
+				 * The sender can decompress a compressed body, so the peer may compress what it sends back
+				 */
+				AcceptsCompressedBody = 2
+			};
 
 			/**
 			 *
@@ -31,7 +57,9 @@ namespace Messaging
 					 */
 					MessageHeader() :
 									messageType( 0),
-									messageLength( 0)
+									messageLength( 0),
+									correlationId( 0),
+									flags( NoFlags)
 					{
 					}
 					/**
@@ -40,18 +68,24 @@ namespace Messaging
 					 * @param aMessageLength
 					 */
 					MessageHeader( 	char aMessageType,
-									std::size_t aMessageLength) :
+									std::size_t aMessageLength,
+									unsigned long aCorrelationId = 0,
+									unsigned char aFlags = NoFlags) :
 									messageType( aMessageType),
-									messageLength( aMessageLength)
+									messageLength( aMessageLength),
+									correlationId( aCorrelationId),
+									flags( aFlags)
 					{
 					}
 					/**
 					 *
 					 * @param aMessageHeaderBuffer
 					 */
-					explicit MessageHeader(	const std::string& aMessageHeaderBuffer) :
+					explicit MessageHeader(	std::string_view aMessageHeaderBuffer) :
 									messageType( 0),
-									messageLength( 0)
+									messageLength( 0),
+									correlationId( 0),
+									flags( NoFlags)
 					{
 						fromString( aMessageHeaderBuffer);
 					}
@@ -62,9 +96,42 @@ namespace Messaging
 					 */
 					std::string toString() const
 					{
-						std::ostringstream os;
-						os << magicNumber1 << magicNumber2 << magicNumber3 << magicNumber4 << majorVersion << minorVersion << std::setw(charWidth) << static_cast<int>(messageType) << std::setw(intWidth) << messageLength;
-						return os.str();
+						char buffer[headerLength];
+						return std::string( buffer, format( buffer));
+					}
+					/**
+					 * Writes the same ASCII representation as MessageHeader::toString into aBuffer, without allocating.
+					 *
+					 * @param aBuffer must have room for headerLength characters
+					 * @param aLegacyFormat If true the 1.0 header is written, which has no correlation id and flags
+					 * @return The number of characters written, headerLength or legacyHeaderLength
+					 */
+					std::size_t format(	char* aBuffer,
+										bool aLegacyFormat = false) const
+					{
+						aBuffer[0] = magicNumber1;
+						aBuffer[1] = magicNumber2;
+						aBuffer[2] = magicNumber3;
+						aBuffer[3] = magicNumber4;
+						aBuffer[4] = majorVersion;
+						aBuffer[minorVersionOffset] = aLegacyFormat ? legacyMinorVersion : minorVersion;
+						formatField( aBuffer + typeOffset, charWidth, static_cast<int>(messageType));
+						formatField( aBuffer + lengthOffset, intWidth, messageLength);
+						if (aLegacyFormat)
+						{
+							return legacyHeaderLength;
+						}
+						formatField( aBuffer + correlationIdOffset, intWidth, correlationId);
+						formatField( aBuffer + flagsOffset, flagsWidth, static_cast<int>(flags));
+						return headerLength;
+					}
+					/**
+					 * @param aHeaderStart The first legacyHeaderLength characters of a header
+					 * @return True if the header is a 1.0 header, which ends after the length
+					 */
+					static bool isLegacyHeader( std::string_view aHeaderStart)
+					{
+						return aHeaderStart.length() > minorVersionOffset && aHeaderStart[minorVersionOffset] == legacyMinorVersion;
 					}
 					/**
 					 * Stores a ASCII representation of a message header into this header.
@@ -73,21 +140,36 @@ namespace Messaging
 					 *
 					 * @param aString in the same format as MessageHeader::toString.
 					 */
-					void fromString( const std::string& aString)
+					void fromString( std::string_view aString)
 					{
-						std::istringstream is( aString);
-						char magic[4];
-						char major;
-						char minor;
-						is >> magic[0] >> magic[1] >> magic[2] >> magic[3] >> major >> minor >> std::setw(charWidth) >> reinterpret_cast<int&>(messageType) >> std::setw( intWidth) >> messageLength;
+						// The fields have a fixed width and are not separated, so they are parsed by position
+						bool legacyHeader = isLegacyHeader( aString);
+						if (aString.length() < (legacyHeader ? legacyHeaderLength : headerLength))
+						{
+							return;
+						}
+						int type = 0;
+						parseField( aString.substr( typeOffset, charWidth), type);
+						messageType = static_cast<char>(type);
+						parseField( aString.substr( lengthOffset, intWidth), messageLength);
+						if (legacyHeader)
+						{
+							// A 1.0 peer does not know about correlation ids and flags
+							correlationId = 0;
+							flags = NoFlags;
+							return;
+						}
+						parseField( aString.substr( correlationIdOffset, intWidth), correlationId);
+						int parsedFlags = 0;
+						parseField( aString.substr( flagsOffset, flagsWidth), parsedFlags);
+						flags = static_cast<unsigned char>(parsedFlags);
 					}
 					/**
 					 * @return The length of the header in bytes
 					 */
 					std::size_t getHeaderLength() const
 					{
-						static std::size_t l = toString().length();
-						return l;
+						return headerLength;
 					}
 					/**
 					 *
@@ -104,6 +186,20 @@ namespace Messaging
 					{
 						return messageLength;
 					}
+					/**
+					 * @return The id that ties a response to its request, 0 if the message is not part of a pipelined session
+					 */
+					unsigned long getCorrelationId() const
+					{
+						return correlationId;
+					}
+					/**
+					 * @return The Message::Flags bits of the message
+					 */
+					unsigned char getFlags() const
+					{
+						return flags;
+					}
 					/**
 					 * @name Debug functions
 					 */
@@ -114,7 +210,7 @@ namespace Messaging
 					std::string asString() const
 					{
 						std::ostringstream os;
-						os << magicNumber1 << magicNumber2 << magicNumber3 << magicNumber4 << " " << majorVersion << " " <<  minorVersion << " " << static_cast<int>(messageType) << " " << messageLength;
+						os << magicNumber1 << magicNumber2 << magicNumber3 << magicNumber4 << " " << majorVersion << " " <<  minorVersion << " " << static_cast<int>(messageType) << " " << messageLength << " " << correlationId << " " << static_cast<int>(flags);
 						return os.str();
 					}
 					/**
@@ -126,20 +222,70 @@ namespace Messaging
 					}
 					//@}
 
+					/**
+					 * The layout of the header: 4 magic characters, the major and minor version,
+					 * the type, the length, the correlation id and the flags. A 1.0 header ends after the length.
+					 */
+					static constexpr std::size_t minorVersionOffset = 5;
+					static constexpr std::size_t typeOffset = minorVersionOffset + 1;
+					static constexpr std::size_t lengthOffset = typeOffset + charWidth;
+					static constexpr std::size_t correlationIdOffset = lengthOffset + intWidth;
+					static constexpr std::size_t flagsOffset = correlationIdOffset + intWidth;
+					static constexpr std::size_t headerLength = flagsOffset + flagsWidth;
+					static constexpr std::size_t legacyHeaderLength = correlationIdOffset;
+
 					static const char magicNumber1 = 'A';
 					static const char magicNumber2 = 'S';
 					static const char magicNumber3 = 'I';
 					static const char magicNumber4 = 'O';
 					static const char majorVersion = '1';
-					static const char minorVersion = '0';
+					static const char minorVersion = '2';
+					static const char legacyMinorVersion = '0';
 					char messageType;
 					std::size_t messageLength;
+					unsigned long correlationId;
+					unsigned char flags;
+				private:
+					/**
+					 * Writes aValue right aligned in a field of aWidth characters, padded with spaces
+					 *
+					 * @throw std::runtime_error if aValue has more than aWidth digits, the peer would parse another value
+					 */
+					template< typename Number >
+					static void formatField(	char* aField,
+												std::size_t aWidth,
+												Number aValue)
+					{
+						char digits[24]; // @suppress("Avoid magic numbers")
+						std::size_t length = static_cast<std::size_t>(std::to_chars( digits, digits + sizeof( digits), aValue).ptr - digits);
+						if (length > aWidth)
+						{
+							throw std::runtime_error( "MessageHeader::formatField: " + std::string( digits, length) + " does not fit in " + std::to_string( aWidth) + " characters");
+						}
+						std::memset( aField, ' ', aWidth - length);
+						std::memcpy( aField + aWidth - length, digits, length);
+					}
+					/**
+					 * Parses a field written by formatField
+					 */
+					template< typename Number >
+					static void parseField(	std::string_view aField,
+											Number& aValue)
+					{
+						std::string_view::size_type first = aField.find_first_not_of( ' ');
+						if (first != std::string_view::npos)
+						{
+							std::from_chars( aField.data() + first, aField.data() + aField.size(), aValue);
+						}
+					}
 			}; // struct MessageHeader
 			/**
 			 *
 			 */
 			Message() :
-							messageType( 0)
+							messageType( 0),
+							correlationId( 0),
+							flags( NoFlags)
 			{
 			}
 			/**
@@ -147,7 +293,9 @@ namespace Messaging
 			 * @param aMessageType
 			 */
 			explicit Message( char aMessageType) :
-							messageType( aMessageType)
+							messageType( aMessageType),
+							correlationId( 0),
+							flags( NoFlags)
 			{
 			}
 			/**
@@ -158,6 +306,8 @@ namespace Messaging
 			Message( 	char aMessageType,
 						const std::string& aMessage) :
 							messageType( aMessageType),
+							correlationId( 0),
+							flags( NoFlags),
 							message( aMessage)
 			{
 			}
@@ -167,6 +317,8 @@ namespace Messaging
 			 */
 			Message( const Message& aMessage) :
 							messageType( aMessage.messageType),
+							correlationId( aMessage.correlationId),
+							flags( aMessage.flags),
 							message( aMessage.message)
 			{
 			}
@@ -179,12 +331,19 @@ namespace Messaging
 			 */
 			Message& operator=(const Message& aMessage) = default;
 			/**
+			 * The AcceptsCompressedBody flag says what the sender accepts, not what the message is,
+			 * so it is given by the session, router or client that sends the message.
 			 *
 			 * @return The header of this message
 			 */
-			MessageHeader getHeader() const
+			MessageHeader getHeader( bool anAcceptsCompressedBodies = false) const
 			{
-				return MessageHeader( messageType, message.length());
+				unsigned char headerFlags = static_cast<unsigned char>(flags & CompressedBody);
+				if (anAcceptsCompressedBodies)
+				{
+					headerFlags |= AcceptsCompressedBody;
+				}
+				return MessageHeader( messageType, message.length(), correlationId, headerFlags);
 			}
 			/**
 			 *
@@ -193,6 +352,8 @@ namespace Messaging
 			void setHeader( const MessageHeader& aHeader)
 			{
 				setMessageType( aHeader.messageType);
+				setCorrelationId( aHeader.correlationId);
+				setFlags( aHeader.flags);
 				message.resize( aHeader.messageLength);
 			}
 			/**
@@ -211,6 +372,56 @@ namespace Messaging
 			{
 				messageType = aMessageType;
 			}
+			/**
+			 *
+			 * @return The id that ties a response to its request, 0 if the message is not part of a pipelined session
+			 */
+			unsigned long getCorrelationId() const
+			{
+				return correlationId;
+			}
+			/**
+			 * The request handler should leave the correlation id as it is, the response is matched
+			 * to the request by it.
+			 *
+			 * @param aCorrelationId
+			 */
+			void setCorrelationId( unsigned long aCorrelationId)
+			{
+				correlationId = aCorrelationId;
+			}
+			/**
+			 *
+			 * @return The Message::Flags bits as received, or as set by Compression
+			 */
+			unsigned char getFlags() const
+			{
+				return flags;
+			}
+			/**
+			 *
+			 * @param aFlags
+			 */
+			void setFlags( unsigned char aFlags)
+			{
+				flags = aFlags;
+			}
+			/**
+			 *
+			 * @return True if the body is compressed and must be decompressed with Compression::decompress before use
+			 */
+			bool isCompressed() const
+			{
+				return (flags & CompressedBody) != 0;
+			}
+			/**
+			 *
+			 * @return True if the sender of this message accepts compressed bodies
+			 */
+			bool acceptsCompressedBody() const
+			{
+				return (flags & AcceptsCompressedBody) != 0;
+			}
 			/**
 			 *
 			 * @return
@@ -259,6 +470,14 @@ namespace Messaging
 			 *
 			 */
 			char messageType;
+			/**
+			 *
+			 */
+			unsigned long correlationId;
+			/**
+			 *
+			 */
+			unsigned char flags;
 			/**
 			 *
 			 */
@@ -62,6 +62,38 @@ namespace Messaging
 	}; // class ResponseHandler
 	typedef std::shared_ptr< ResponseHandler > ResponseHandlerPtr;
 
+	/**
+	 * Passes the responses on to a ResponseHandler without keeping it alive. Used by a handler
+	 * that owns the client it gives itself to, which would otherwise never be destroyed.
+	 * Responses that come in after the handler is destroyed are dropped.
+	 */
+	class WeakResponseHandler : public ResponseHandler
+	{
+		public:
+			/**
+			 *
+			 */
+			explicit WeakResponseHandler( const ResponseHandlerPtr& aResponseHandler) :
+							responseHandler( aResponseHandler)
+			{
+			}
+			/**
+			 * @see ResponseHandler::handleResponse( const Message& aMessage)
+			 */
+			virtual void handleResponse( const Message& aMessage) override
+			{
+				if (ResponseHandlerPtr handler = responseHandler.lock())
+				{
+					handler->handleResponse( aMessage);
+				}
+			}
+		private:
+			/**
+			 *
+			 */
+			std::weak_ptr< ResponseHandler > responseHandler;
+	}; // class WeakResponseHandler
+
 	/**
 	 * Convenience interface class for a class that acts both as server and client in the Messaging protocol.
 	 *
@@ -26,6 +26,10 @@ namespace Messaging
 		SyncRobotRequest,
 		SyncRobotResponse,
 		StartRobotRequest,
+		SyncRobotFrameRequest,
+		SyncRobotFrameResponse,
+		SyncWorldChunkRequest,
+		SyncWorldChunkResponse,
 	};
 	//@}
 } /* namespace Messaging */
@@ -0,0 +1,641 @@
+#include "Config.hpp"
+
+#include "Client.hpp"
+#include "CommunicationService.hpp"
+#include "Datagram.hpp"
+#include "Message.hpp"
+#include "MessageTypes.hpp"
+#include "MessagingPool.hpp"
+#include "RequestDispatcher.hpp"
+#include "Server.hpp"
+#include "Session.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// \file
+// The messaging benchmark starts a Server and a number of client threads in one process and
+// reports the throughput and the round-trip latency of the requests. Run "messagingbenchmark -help"
+// for the options.
+//
+// The server answers with a stub request handler, not with Robot::handleRequest: the numbers are
+// those of the messaging layer alone, the time a robot needs to apply a request is not included.
+
+namespace Messaging
+{
+	namespace
+	{
+		/**
+		 *
+		 */
+		typedef std::chrono::steady_clock Clock;
+		/**
+		 * The options of a benchmark run, every option is given as "-name=value"
+		 */
+		struct Options
+		{
+				std::string transport = "tcp";
+				std::string protocol = "pipelined";
+				unsigned short port = 12345; // @suppress("Avoid magic numbers")
+				unsigned long clients = 4; // @suppress("Avoid magic numbers")
+				unsigned long messages = 10000; // @suppress("Avoid magic numbers")
+				unsigned long window = 16; // @suppress("Avoid magic numbers")
+				unsigned long seed = 42; // @suppress("Avoid magic numbers")
+				bool dispatcher = false;
+				/**
+				 * If not empty a check is run instead of the benchmark
+				 */
+				std::string check;
+				/**
+				 * (message type, weight)
+				 */
+				std::vector< std::pair< MessageType, unsigned long > > mix = { { SyncRobotRequest, 1 } };
+				/**
+				 * (body size, weight)
+				 */
+				std::vector< std::pair< std::size_t, unsigned long > > sizes = { { 64, 1 } }; // @suppress("Avoid magic numbers")
+		};
+		/**
+		 *
+		 */
+		void printUsage()
+		{
+			std::cout << "messagingbenchmark [-option=value]...\n"
+						 "The requests are answered by a stub request handler, not by a Robot.\n"
+						 "  -transport=tcp|inprocess|shm           the transport of the requests, default tcp\n"
+						 "  -protocol=classic|pipelined|udp        Client with a connection per request, PipelinedClient or\n"
+						 "                                         DatagramClient (one way, the transport is ignored), default pipelined\n"
+						 "  -port=n                                default 12345\n"
+						 "  -clients=n                             the number of client threads, default 4\n"
+						 "  -messages=n                            the number of requests per client, default 10000\n"
+						 "  -window=n                              the number of outstanding requests per client, default 16\n"
+						 "  -mix=type:weight,...                   robot (SyncRobotRequest), frame (SyncRobotFrameRequest) or echo, default robot:1\n"
+						 "  -sizes=bytes:weight,...                the size distribution of the request bodies, default 64:1\n"
+						 "  -seed=n                                the seed of the message mix and sizes, default 42\n"
+						 "  -dispatcher=on|off                     handle the requests on the model thread of a RequestDispatcher, default off\n"
+						 "  -check=udp                             check that robot frames arrive unchanged over UDP on the loopback interface\n"
+						 "                                         and that a server whose peer has another address drops them, uses port and port + 1\n";
+		}
+		/**
+		 *
+		 */
+		MessageType toMessageType( const std::string& aName)
+		{
+			if (aName == "robot")
+			{
+				return SyncRobotRequest;
+			}
+			if (aName == "frame")
+			{
+				return SyncRobotFrameRequest;
+			}
+			if (aName == "echo")
+			{
+				return EchoRequest;
+			}
+			throw std::runtime_error( "unknown message type " + aName + ", expected robot, frame or echo");
+		}
+		/**
+		 * Parses "key:weight,key:weight", aKeyFunction converts a key
+		 */
+		template< typename KeyType, typename KeyFunction >
+		std::vector< std::pair< KeyType, unsigned long > > parseWeights(	const std::string& aValue,
+																			KeyFunction aKeyFunction)
+		{
+			std::vector< std::pair< KeyType, unsigned long > > weights;
+			std::istringstream is( aValue);
+			std::string item;
+			while (std::getline( is, item, ','))
+			{
+				std::size_t colon = item.find( ':');
+				unsigned long weight = colon == std::string::npos ? 1 : std::stoul( item.substr( colon + 1));
+				weights.emplace_back( aKeyFunction( item.substr( 0, colon)), weight);
+			}
+			if (weights.empty())
+			{
+				throw std::runtime_error( "empty distribution " + aValue);
+			}
+			return weights;
+		}
+		/**
+		 *
+		 * @throw std::runtime_error if an option is unknown or its value cannot be parsed
+		 */
+		Options parseOptions(	int argc,
+								char* argv[])
+		{
+			Options options;
+			for (int i = 1; i < argc; ++i)
+			{
+				std::string argument( argv[i]);
+				std::size_t equals = argument.find( '=');
+				std::string name = argument.substr( 0, equals);
+				std::string value = equals == std::string::npos ? "" : argument.substr( equals + 1);
+
+				if (name == "-transport")
+				{
+					CommunicationService::toTransportType( value);
+					options.transport = value;
+				} else if (name == "-protocol")
+				{
+					if (value != "classic" && value != "pipelined" && value != "udp")
+					{
+						throw std::runtime_error( "unknown protocol " + value + ", expected classic, pipelined or udp");
+					}
+					options.protocol = value;
+				} else if (name == "-port")
+				{
+					options.port = static_cast< unsigned short >( std::stoul( value));
+				} else if (name == "-clients")
+				{
+					options.clients = std::max( 1UL, std::stoul( value));
+				} else if (name == "-messages")
+				{
+					options.messages = std::stoul( value);
+				} else if (name == "-window")
+				{
+					options.window = std::max( 1UL, std::stoul( value));
+				} else if (name == "-mix")
+				{
+					options.mix = parseWeights< MessageType >( value, toMessageType);
+				} else if (name == "-sizes")
+				{
+					options.sizes = parseWeights< std::size_t >( value, [](const std::string& aSize)
+																		{
+																			return static_cast< std::size_t >( std::stoul( aSize));
+																		});
+				} else if (name == "-seed")
+				{
+					options.seed = std::stoul( value);
+				} else if (name == "-dispatcher")
+				{
+					options.dispatcher = value == "on";
+				} else if (name == "-check")
+				{
+					if (value != "udp")
+					{
+						throw std::runtime_error( "unknown check " + value + ", expected udp");
+					}
+					options.check = value;
+				} else
+				{
+					throw std::runtime_error( "unknown option " + argument);
+				}
+			}
+			return options;
+		}
+		/**
+		 * Every request body starts with the time it was sent, so the latency can be computed from
+		 * any response without looking up the request. The rest of the body is padding.
+		 */
+		std::string makeBody(	MessageType aMessageType,
+								std::size_t aSize)
+		{
+			std::string body = std::to_string( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now().time_since_epoch()).count()) + "|";
+			// Robot::handleRequest only handles a SyncRobotRequest that mentions a robot
+			const std::string filler = aMessageType == SyncRobotFrameRequest ? "0,0,1,0,Robot_" : "Robot ";
+			while (body.length() < aSize)
+			{
+				body.append( filler, 0, aSize - body.length());
+			}
+			return body;
+		}
+		/**
+		 *
+		 * @return The time since the body of aMessage was made by makeBody, in nanoseconds
+		 */
+		std::uint64_t latencyOf( const Message& aMessage)
+		{
+			std::uint64_t sendTime = 0;
+			const std::string& body = aMessage.message;
+			std::from_chars( body.data(), body.data() + body.length(), sendTime);
+			std::uint64_t now = static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now().time_since_epoch()).count());
+			return now > sendTime ? now - sendTime : 0;
+		}
+		/**
+		 * The stub request handler of the Server. It only answers the requests the way Robot::handleRequest
+		 * does, without a RobotWorld to apply them to. It is not Robot::handleRequest.
+		 */
+		class StubRequestHandler : public RequestHandler
+		{
+			public:
+				/**
+				 * @see RequestHandler::handleRequest( Message& aMessage)
+				 */
+				virtual void handleRequest( Message& aMessage) override
+				{
+					if (oneWay)
+					{
+						std::unique_lock< std::mutex > lock( latenciesMutex);
+						latencies.push_back( latencyOf( aMessage));
+						receivedBytes += aMessage.getHeader().getHeaderLength() + aMessage.length();
+					}
+					switch (aMessage.getMessageType())
+					{
+						case SyncRobotRequest:
+						{
+							// Robot answers with the request itself
+							break;
+						}
+						case SyncRobotFrameRequest:
+						{
+							// Robot answers with the number of robot states, the send time is kept for the latency
+							std::size_t numberOfStates = static_cast< std::size_t >( std::count( aMessage.message.begin(), aMessage.message.end(), '_'));
+							aMessage.setMessageType( SyncRobotFrameResponse);
+							aMessage.setBody( aMessage.message.substr( 0, aMessage.message.find( '|') + 1) + std::to_string( numberOfStates));
+							break;
+						}
+						default:
+						{
+							aMessage.setMessageType( EchoResponse);
+							break;
+						}
+					}
+				}
+				/**
+				 * Set when the requests are sent over UDP and get no response, the latency is measured one way
+				 */
+				bool oneWay = false;
+				std::mutex latenciesMutex;
+				std::vector< std::uint64_t > latencies;
+				std::uint64_t receivedBytes = 0;
+		};
+		/**
+		 * The state of one client thread, shared with the response functions that are called on the io_context
+		 */
+		struct ClientState
+		{
+				std::mutex stateMutex;
+				std::condition_variable responseReceived;
+				unsigned long outstanding = 0;
+				unsigned long errors = 0;
+				std::uint64_t bytes = 0;
+				std::vector< std::uint64_t > latencies;
+				/**
+				 *
+				 */
+				void handleResponse(	const Message& aResponse,
+										std::size_t aRequestBytes)
+				{
+					std::unique_lock< std::mutex > lock( stateMutex);
+					if (aResponse.getMessageType() == CommunicationReadError || aResponse.getMessageType() == CommunicationWriteError)
+					{
+						++errors;
+					} else
+					{
+						latencies.push_back( latencyOf( aResponse));
+						bytes += aRequestBytes + aResponse.getHeader().getHeaderLength() + aResponse.length();
+					}
+					--outstanding;
+					responseReceived.notify_one();
+				}
+		};
+		/**
+		 * A ResponseHandler for the classic Client, which has no response function per request
+		 */
+		class ClientResponseHandler : public ResponseHandler
+		{
+			public:
+				/**
+				 *
+				 */
+				explicit ClientResponseHandler( ClientState& aClientState) :
+								clientState( aClientState)
+				{
+				}
+				/**
+				 * @see ResponseHandler::handleResponse( const Message& aMessage)
+				 */
+				virtual void handleResponse( const Message& aMessage) override
+				{
+					// The request and its response have the same size except for frames
+					clientState.handleResponse( aMessage, aMessage.getHeader().getHeaderLength() + aMessage.length());
+				}
+			private:
+				ClientState& clientState;
+		};
+		/**
+		 * Sends the requests of one client thread, at most Options::window requests are outstanding
+		 */
+		void runClient(	const Options& anOptions,
+						unsigned long aClientNumber,
+						ClientState& aClientState)
+		{
+			std::mt19937_64 random( anOptions.seed + aClientNumber);
+			std::vector< unsigned long > mixWeights;
+			std::transform( anOptions.mix.begin(), anOptions.mix.end(), std::back_inserter( mixWeights), [](const auto& aWeight){return aWeight.second;});
+			std::vector< unsigned long > sizeWeights;
+			std::transform( anOptions.sizes.begin(), anOptions.sizes.end(), std::back_inserter( sizeWeights), [](const auto& aWeight){return aWeight.second;});
+			std::discrete_distribution< std::size_t > mixDistribution( mixWeights.begin(), mixWeights.end());
+			std::discrete_distribution< std::size_t > sizeDistribution( sizeWeights.begin(), sizeWeights.end());
+
+			std::unique_ptr< Client > client;
+			std::unique_ptr< PipelinedClient > pipelinedClient;
+			std::unique_ptr< DatagramClient > datagramClient;
+			if (anOptions.protocol == "classic")
+			{
+				client = std::make_unique< Client >( "localhost", anOptions.port, std::make_shared< ClientResponseHandler >( aClientState));
+			} else if (anOptions.protocol == "pipelined")
+			{
+				pipelinedClient = std::make_unique< PipelinedClient >( "localhost", anOptions.port, nullptr);
+			} else
+			{
+				datagramClient = std::make_unique< DatagramClient >( "localhost", anOptions.port);
+			}
+
+			for (unsigned long i = 0; i < anOptions.messages; ++i)
+			{
+				MessageType messageType = anOptions.mix[mixDistribution( random)].first;
+				Message request( messageType, makeBody( messageType, anOptions.sizes[sizeDistribution( random)].first));
+				std::size_t requestBytes = request.getHeader().getHeaderLength() + request.length();
+
+				if (datagramClient)
+				{
+					if (!datagramClient->dispatchMessage( request))
+					{
+						++aClientState.errors;
+					}
+					continue;
+				}
+				{
+					std::unique_lock< std::mutex > lock( aClientState.stateMutex);
+					aClientState.responseReceived.wait( lock, [&aClientState, &anOptions](){return aClientState.outstanding < anOptions.window;});
+					++aClientState.outstanding;
+				}
+				if (pipelinedClient)
+				{
+					pipelinedClient->dispatchMessage( request, [&aClientState, requestBytes](const Message& aResponse)
+																{
+																	aClientState.handleResponse( aResponse, requestBytes);
+																});
+				} else
+				{
+					client->dispatchMessage( request);
+				}
+			}
+
+			std::unique_lock< std::mutex > lock( aClientState.stateMutex);
+			if (!aClientState.responseReceived.wait_for( lock, std::chrono::seconds( 10), [&aClientState](){return aClientState.outstanding == 0;})) // @suppress("Avoid magic numbers")
+			{
+				std::cerr << "client " << aClientNumber << ": " << aClientState.outstanding << " responses did not arrive" << std::endl;
+				aClientState.errors += aClientState.outstanding;
+			}
+		}
+		/**
+		 *
+		 * @return The latency at aFraction of the sorted latencies in microseconds
+		 */
+		double percentile(	const std::vector< std::uint64_t >& someSortedLatencies,
+							double aFraction)
+		{
+			if (someSortedLatencies.empty())
+			{
+				return 0.0;
+			}
+			std::size_t index = static_cast< std::size_t >( aFraction * static_cast< double >( someSortedLatencies.size() - 1));
+			return static_cast< double >( someSortedLatencies[index]) / 1000.0; // @suppress("Avoid magic numbers")
+		}
+		/**
+		 *
+		 */
+		void runBenchmark( const Options& anOptions)
+		{
+			CommunicationService::getCommunicationService().setTransportType( CommunicationService::toTransportType( anOptions.transport));
+
+			std::shared_ptr< StubRequestHandler > requestHandler = std::make_shared< StubRequestHandler >();
+			ServerPtr server;
+			DatagramServerPtr datagramServer;
+			RequestDispatcherPtr requestDispatcher;
+			if (anOptions.protocol == "udp")
+			{
+				requestHandler->oneWay = true;
+				datagramServer = std::make_shared< DatagramServer >( anOptions.port, requestHandler);
+				datagramServer->startHandlingRequests();
+			} else
+			{
+				server = std::make_shared< Server >( anOptions.port, requestHandler);
+				if (anOptions.dispatcher)
+				{
+					requestDispatcher = std::make_shared< RequestDispatcher >();
+					requestDispatcher->start();
+					server->setRequestDispatcher( requestDispatcher);
+				}
+				CommunicationService::getCommunicationService().registerServer( server);
+			}
+
+			std::vector< std::unique_ptr< ClientState > > clientStates;
+			std::vector< std::thread > clientThreads;
+			Clock::time_point start = Clock::now();
+			for (unsigned long i = 0; i < anOptions.clients; ++i)
+			{
+				clientStates.push_back( std::make_unique< ClientState >());
+				clientThreads.emplace_back( runClient, std::cref( anOptions), i, std::ref( *clientStates.back()));
+			}
+			for (std::thread& clientThread : clientThreads)
+			{
+				clientThread.join();
+			}
+
+			std::vector< std::uint64_t > latencies;
+			std::uint64_t bytes = 0;
+			unsigned long errors = 0;
+			if (datagramServer)
+			{
+				// Wait until the datagrams that are still on their way are handled
+				std::size_t handled = 0;
+				do
+				{
+					{
+						std::unique_lock< std::mutex > lock( requestHandler->latenciesMutex);
+						handled = requestHandler->latencies.size();
+					}
+					std::this_thread::sleep_for( std::chrono::milliseconds( 200)); // @suppress("Avoid magic numbers")
+					std::unique_lock< std::mutex > lock( requestHandler->latenciesMutex);
+					if (handled == requestHandler->latencies.size())
+					{
+						latencies = requestHandler->latencies;
+						bytes = requestHandler->receivedBytes;
+						break;
+					}
+				} while (true);
+			}
+			Clock::time_point stop = Clock::now();
+			for (const std::unique_ptr< ClientState >& clientState : clientStates)
+			{
+				latencies.insert( latencies.end(), clientState->latencies.begin(), clientState->latencies.end());
+				bytes += clientState->bytes;
+				errors += clientState->errors;
+			}
+			std::sort( latencies.begin(), latencies.end());
+
+			double seconds = std::chrono::duration< double >( stop - start).count();
+			unsigned long requests = anOptions.clients * anOptions.messages;
+			std::cout << std::fixed << std::setprecision( 1)
+					  << "transport " << (datagramServer ? "udp" : anOptions.transport) << ", protocol " << anOptions.protocol
+					  << (requestDispatcher ? ", dispatcher" : "") << ", stub handler, " << anOptions.clients << " clients x " << anOptions.messages << " requests, window " << anOptions.window << "\n"
+					  << "completed " << latencies.size() << ", errors " << errors << ", lost " << (requests - std::min< unsigned long >( requests, latencies.size() + errors))
+					  << ", seconds " << std::setprecision( 3) << seconds << "\n" << std::setprecision( 1)
+					  << "msgs/s " << static_cast< double >( latencies.size()) / seconds
+					  << ", bytes/s " << static_cast< double >( bytes) / seconds << "\n"
+					  << (datagramServer ? "one-way" : "round-trip") << " latency us: p50 " << percentile( latencies, 0.5)
+					  << ", p99 " << percentile( latencies, 0.99) << ", p999 " << percentile( latencies, 0.999) // @suppress("Avoid magic numbers")
+					  << ", max " << percentile( latencies, 1.0) << "\n"
+					  << "server sessions: " << SessionPool< PipelinedServerSession >::getSessionPool().getMetrics().asString() << "\n"
+					  << "client sessions: " << SessionPool< ClientSession >::getSessionPool().getMetrics().asString() << "\n"
+					  << MessagePool::getMessagePool().asString() << std::flush;
+
+			if (datagramServer)
+			{
+				datagramServer->stopHandlingRequests();
+			} else
+			{
+				server->stopHandlingRequests();
+			}
+			if (requestDispatcher)
+			{
+				std::cout << "dispatcher: " << requestDispatcher->getNumberOfRequests() << " requests in " << requestDispatcher->getNumberOfBatches() << " batches" << std::endl;
+				requestDispatcher->stop();
+			}
+			// The io_context must be done before it is destroyed at the exit of the process
+			CommunicationService::getCommunicationService().stop();
+			CommunicationService::getCommunicationService().wait();
+		}
+		/**
+		 * The request handler of the UDP check, it keeps the bodies of the requests
+		 */
+		class RecordingRequestHandler : public RequestHandler
+		{
+			public:
+				/**
+				 * @see RequestHandler::handleRequest( Message& aMessage)
+				 */
+				virtual void handleRequest( Message& aMessage) override
+				{
+					std::unique_lock< std::mutex > lock( bodiesMutex);
+					bodies.push_back( aMessage.getBody());
+				}
+				/**
+				 *
+				 */
+				std::size_t getNumberOfBodies()
+				{
+					std::unique_lock< std::mutex > lock( bodiesMutex);
+					return bodies.size();
+				}
+				std::mutex bodiesMutex;
+				std::vector< std::string > bodies;
+		};
+		/**
+		 * Sends robot frames over UDP on the loopback interface to a DatagramServer whose peer is the loopback
+		 * address and to one whose peer is another address. The first must handle every frame unchanged and in
+		 * order, the second must reject every frame.
+		 *
+		 * @return true if the check passed
+		 */
+		bool runUdpCheck( const Options& anOptions)
+		{
+			const unsigned long numberOfFrames = 100; // @suppress("Avoid magic numbers")
+
+			std::shared_ptr< RecordingRequestHandler > peerHandler = std::make_shared< RecordingRequestHandler >();
+			DatagramServerPtr peerServer = std::make_shared< DatagramServer >( anOptions.port, peerHandler);
+			peerServer->setPeer( "127.0.0.1");
+			peerServer->startHandlingRequests();
+
+			// The whole 127.0.0.0/8 network is the loopback interface, but the datagrams come from 127.0.0.1
+			std::shared_ptr< RecordingRequestHandler > otherHandler = std::make_shared< RecordingRequestHandler >();
+			DatagramServerPtr otherServer = std::make_shared< DatagramServer >( static_cast< unsigned short >( anOptions.port + 1), otherHandler);
+			otherServer->setPeer( "127.0.0.2");
+			otherServer->startHandlingRequests();
+
+			DatagramClient peerClient( "127.0.0.1", anOptions.port);
+			DatagramClient otherClient( "127.0.0.1", static_cast< unsigned short >( anOptions.port + 1));
+			std::vector< std::string > frames;
+			for (unsigned long i = 0; i < numberOfFrames; ++i)
+			{
+				// x,y,angle,speed,name like Robot::sendRobotFrame
+				frames.push_back( std::to_string( i) + "," + std::to_string( 2 * i) + ",1,0,Robot_" + std::to_string( i % 3)); // @suppress("Avoid magic numbers")
+				Message frame( SyncRobotFrameRequest, frames.back());
+				peerClient.dispatchMessage( frame);
+				otherClient.dispatchMessage( frame);
+			}
+
+			Clock::time_point deadline = Clock::now() + std::chrono::seconds( 2); // @suppress("Avoid magic numbers")
+			while ((peerHandler->getNumberOfBodies() + peerServer->getNumberOfStaleMessages() < numberOfFrames || otherServer->getNumberOfRejectedMessages() < numberOfFrames) && Clock::now() < deadline)
+			{
+				std::this_thread::sleep_for( std::chrono::milliseconds( 10)); // @suppress("Avoid magic numbers")
+			}
+			peerServer->stopHandlingRequests();
+			otherServer->stopHandlingRequests();
+			// The io_context must be done before it is destroyed at the exit of the process
+			CommunicationService::getCommunicationService().stop();
+			CommunicationService::getCommunicationService().wait();
+
+			bool passed = true;
+			{
+				std::unique_lock< std::mutex > lock( peerHandler->bodiesMutex);
+				if (peerHandler->bodies != frames)
+				{
+					std::cerr << "udp check: the peer server handled " << peerHandler->bodies.size() << " of " << numberOfFrames << " frames, "
+							  << peerServer->getNumberOfStaleMessages() << " stale, or a frame was changed" << std::endl;
+					passed = false;
+				}
+			}
+			if (otherHandler->getNumberOfBodies() != 0 || otherServer->getNumberOfRejectedMessages() != numberOfFrames)
+			{
+				std::cerr << "udp check: the server of another peer handled " << otherHandler->getNumberOfBodies() << " frames and rejected "
+						  << otherServer->getNumberOfRejectedMessages() << " of " << numberOfFrames << std::endl;
+				passed = false;
+			}
+			std::cout << "udp check " << (passed ? "passed" : "failed") << std::endl;
+			return passed;
+		}
+	} // namespace
+} // namespace Messaging
+
+/**
+ *
+ * @param argc The number of arguments
+ * @param argv The value of the arguments
+ * @return 0 on success, 1 if the options are wrong or the benchmark failed
+ */
+int main( 	int argc,
+			char* argv[])
+{
+	if (argc > 1 && (std::string( argv[1]) == "-help" || std::string( argv[1]) == "-h"))
+	{
+		Messaging::printUsage();
+		return 0;
+	}
+	try
+	{
+		Messaging::Options options = Messaging::parseOptions( argc, argv);
+		if (options.check == "udp")
+		{
+			return Messaging::runUdpCheck( options) ? 0 : 1;
+		}
+		Messaging::runBenchmark( options);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << __PRETTY_FUNCTION__ << ": " << e.what() << std::endl;
+		Messaging::printUsage();
+		return 1;
+	}
+	return 0;
+}
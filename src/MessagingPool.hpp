@@ -0,0 +1,302 @@
+#ifndef MESSAGINGPOOL_HPP_
+#define MESSAGINGPOOL_HPP_
+
+#include "Config.hpp"
+
+#include "CommunicationService.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Messaging
+{
+	/**
+	 * The occupancy of a pool
+	 */
+	struct PoolMetrics
+	{
+			/**
+			 * The number of objects that were allocated because the pool was empty
+			 */
+			unsigned long created = 0;
+			/**
+			 * The number of objects that were taken from the pool instead of being allocated
+			 */
+			unsigned long reused = 0;
+			/**
+			 * The number of objects that were not taken back because the pool was full
+			 */
+			unsigned long discarded = 0;
+			/**
+			 * The number of objects that are handed out
+			 */
+			unsigned long inUse = 0;
+			/**
+			 * The number of objects that wait in the pool
+			 */
+			unsigned long idle = 0;
+			/**
+			 * Returns a 1-line description of the object
+			 */
+			std::string asString() const
+			{
+				std::ostringstream os;
+				os << "created " << created << ", reused " << reused << ", discarded " << discarded << ", in use " << inUse << ", idle " << idle;
+				return os.str();
+			}
+	};
+	/**
+	 * A SessionPool keeps finished sessions of one type so the next connection can use them again, together with
+	 * their socket object and the capacity of their buffers. In the steady state no session or socket is allocated,
+	 * the messages themselves still are: every request and response is a Message that is copied to its handler.
+	 *
+	 * SessionType must have a function reset( Args...) that prepares a recycled session for a new connection with
+	 * the same arguments as its constructor, and a function clear() that closes the socket and drops all references.
+	 */
+	template< typename SessionType >
+	class SessionPool
+	{
+		public:
+			/**
+			 * The maximum number of idle sessions that are kept
+			 */
+			static constexpr std::size_t maximumIdleSessions = 64;
+			/**
+			 *
+			 */
+			static SessionPool& getSessionPool()
+			{
+				static SessionPool sessionPool;
+				return sessionPool;
+			}
+			/**
+			 *
+			 * @return A new or recycled session, to be given back with release
+			 */
+			template< typename... Args >
+			SessionType* acquire( Args&&... anArgs)
+			{
+				SessionType* session = nullptr;
+				{
+					std::unique_lock< std::mutex > lock( poolMutex);
+					++metrics.inUse;
+					if (!idleSessions.empty())
+					{
+						session = idleSessions.back();
+						idleSessions.pop_back();
+						++metrics.reused;
+					} else
+					{
+						++metrics.created;
+					}
+					metrics.idle = idleSessions.size();
+				}
+				if (session)
+				{
+					session->reset( std::forward< Args >( anArgs)...);
+					return session;
+				}
+				return new SessionType( std::forward< Args >( anArgs)...);
+			}
+			/**
+			 * Takes back a session that has no outstanding asynchronous operations
+			 */
+			void release( SessionType* aSession)
+			{
+				aSession->clear();
+
+				std::unique_lock< std::mutex > lock( poolMutex);
+				--metrics.inUse;
+				if (idleSessions.size() < maximumIdleSessions)
+				{
+					idleSessions.push_back( aSession);
+					metrics.idle = idleSessions.size();
+					return;
+				}
+				++metrics.discarded;
+				lock.unlock();
+				delete aSession;
+			}
+			/**
+			 *
+			 */
+			PoolMetrics getMetrics() const
+			{
+				std::unique_lock< std::mutex > lock( poolMutex);
+				return metrics;
+			}
+		private:
+			/**
+			 *
+			 */
+			SessionPool()
+			{
+				// The sockets of the idle sessions need the io_context when the pool is destroyed,
+				// so the CommunicationService must be constructed before, and destroyed after, the pool
+				CommunicationService::getCommunicationService();
+				idleSessions.reserve( maximumIdleSessions);
+			}
+			/**
+			 *
+			 */
+			~SessionPool()
+			{
+				for (SessionType* session : idleSessions)
+				{
+					delete session;
+				}
+			}
+
+			std::vector< SessionType* > idleSessions;
+			PoolMetrics metrics;
+			mutable std::mutex poolMutex;
+	};
+	/**
+	 * The MessagePool keeps message bodies, std::strings, in size classes so their capacity can be used again.
+	 * A body is taken from the smallest class that fits and given back to the largest class its capacity fits.
+	 * Bodies larger than the largest class are not pooled.
+	 */
+	class MessagePool
+	{
+		public:
+			/**
+			 * The capacities of the size classes
+			 */
+			static constexpr std::array< std::size_t, 4 > sizeClasses = { 256, 4 * 1024, 64 * 1024, 1024 * 1024 };
+			/**
+			 * The maximum number of idle bodies that are kept per size class
+			 */
+			static constexpr std::size_t maximumIdleBodies = 64;
+			/**
+			 *
+			 */
+			static MessagePool& getMessagePool()
+			{
+				static MessagePool messagePool;
+				return messagePool;
+			}
+			/**
+			 *
+			 * @return An empty string with a capacity of at least aSize
+			 */
+			std::string acquireBody( std::size_t aSize)
+			{
+				std::size_t sizeClass = getSizeClass( aSize);
+				std::string body;
+				if (sizeClass < sizeClasses.size())
+				{
+					std::unique_lock< std::mutex > lock( poolMutex);
+					SizeClass& pool = pools[sizeClass];
+					++pool.metrics.inUse;
+					if (!pool.idleBodies.empty())
+					{
+						body = std::move( pool.idleBodies.back());
+						pool.idleBodies.pop_back();
+						++pool.metrics.reused;
+						pool.metrics.idle = pool.idleBodies.size();
+						return body;
+					}
+					++pool.metrics.created;
+					lock.unlock();
+					body.reserve( sizeClasses[sizeClass]);
+					return body;
+				}
+				body.reserve( aSize);
+				return body;
+			}
+			/**
+			 * Takes back a body that was acquired with acquireBody
+			 */
+			void releaseBody( std::string&& aBody)
+			{
+				std::size_t sizeClass = sizeClasses.size();
+				for (std::size_t i = sizeClasses.size(); i > 0; --i)
+				{
+					if (aBody.capacity() >= sizeClasses[i - 1])
+					{
+						sizeClass = i - 1;
+						break;
+					}
+				}
+				if (sizeClass == sizeClasses.size() || aBody.capacity() > 2 * sizeClasses.back())
+				{
+					return;
+				}
+
+				std::unique_lock< std::mutex > lock( poolMutex);
+				SizeClass& pool = pools[sizeClass];
+				if (pool.metrics.inUse > 0)
+				{
+					--pool.metrics.inUse;
+				}
+				if (pool.idleBodies.size() < maximumIdleBodies)
+				{
+					aBody.clear();
+					pool.idleBodies.push_back( std::move( aBody));
+					pool.metrics.idle = pool.idleBodies.size();
+				} else
+				{
+					++pool.metrics.discarded;
+				}
+			}
+			/**
+			 *
+			 * @return The metrics of the size class with index aSizeClass
+			 */
+			PoolMetrics getMetrics( std::size_t aSizeClass) const
+			{
+				std::unique_lock< std::mutex > lock( poolMutex);
+				return pools.at( aSizeClass).metrics;
+			}
+			/**
+			 * Returns a description of the metrics of all size classes
+			 */
+			std::string asString() const
+			{
+				std::ostringstream os;
+				for (std::size_t i = 0; i < sizeClasses.size(); ++i)
+				{
+					os << "bodies <= " << sizeClasses[i] << ": " << getMetrics( i).asString() << "\n";
+				}
+				return os.str();
+			}
+		private:
+			/**
+			 *
+			 */
+			struct SizeClass
+			{
+					std::vector< std::string > idleBodies;
+					PoolMetrics metrics;
+			};
+			/**
+			 *
+			 */
+			MessagePool() = default;
+			/**
+			 *
+			 * @return The index of the smallest size class that fits aSize, sizeClasses.size() if none fits
+			 */
+			static std::size_t getSizeClass( std::size_t aSize)
+			{
+				for (std::size_t i = 0; i < sizeClasses.size(); ++i)
+				{
+					if (aSize <= sizeClasses[i])
+					{
+						return i;
+					}
+				}
+				return sizeClasses.size();
+			}
+
+			std::array< SizeClass, sizeClasses.size() > pools;
+			mutable std::mutex poolMutex;
+	};
+} // namespace Messaging
+
+#endif // MESSAGINGPOOL_HPP_
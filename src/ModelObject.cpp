@@ -12,6 +12,12 @@ namespace Model
 	ModelObject::ModelObject() : objectId(Base::ObjectId::newObjectId())
 	{
 	}
+	/**
+	 *
+	 */
+	ModelObject::ModelObject( const Base::ObjectId& anObjectId) : objectId(anObjectId)
+	{
+	}
 	/**
 	 *
 	 */
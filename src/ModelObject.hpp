@@ -30,6 +30,14 @@ namespace Model
 			 *
 			 */
 			ModelObject();
+			/**
+			 * Only to be used if this ModelObject mirrors a ModelObject in a remote world so that
+			 * both share the same identity. The identity cannot change afterwards because the world
+			 * and its views use it as key.
+			 *
+			 * @param anObjectId The objectId (identity) of the mirrored ModelObject
+			 */
+			explicit ModelObject( const Base::ObjectId& anObjectId);
 			/**
 			 * ModelObject may not be copied
 			 */
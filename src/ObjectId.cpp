@@ -1,145 +1,208 @@
 #include "ObjectId.hpp"
 
-#include <boost/date_time/posix_time/posix_time.hpp>
-#include <boost/date_time/c_local_time_adjustor.hpp>
-
-#include <ctime>
-#include <climits>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
 
 namespace Base
 {
-	/**
-	 * newObjectId() uses gmtime() as it is faster than localtime().
-	 * We just calculates our offset to GMT once and cache it
-	 */
-	struct GMTOffset
+	namespace
 	{
-			GMTOffset()
+		/**
+		 * The texts of the ObjectIds that are not in the text form of an ObjectId, indexed by the counter
+		 * of the interned ObjectId. Only used when converting from and to text.
+		 */
+		struct InternedTexts
+		{
+				std::mutex busy;
+				std::vector< std::string > texts;
+				std::unordered_map< std::string, std::uint64_t > indices;
+		};
+		/**
+		 *
+		 */
+		InternedTexts& getInternedTexts()
+		{
+			static InternedTexts internedTexts;
+			return internedTexts;
+		}
+		/**
+		 *
+		 */
+		std::uint64_t mix( std::uint64_t aValue)
+		{
+			aValue ^= aValue >> 33; // @suppress("Avoid magic numbers")
+			aValue *= 0xFF51AFD7ED558CCDULL; // @suppress("Avoid magic numbers")
+			aValue ^= aValue >> 33; // @suppress("Avoid magic numbers")
+			aValue *= 0xC4CEB9FE1A85EC53ULL; // @suppress("Avoid magic numbers")
+			aValue ^= aValue >> 33; // @suppress("Avoid magic numbers")
+			return aValue;
+		}
+		/**
+		 *
+		 * @return The value of aHexDigit, -1 if it is not a lower case hex digit
+		 */
+		int hexValue( char aHexDigit)
+		{
+			if (aHexDigit >= '0' && aHexDigit <= '9')
 			{
-				// Get the current time in UTC and local form.
-				auto utc_time = boost::posix_time::microsec_clock::universal_time();
-				auto local_time = boost::date_time::c_local_adjustor< boost::posix_time::ptime >::utc_to_local( utc_time);
-
-				// Calculate the difference in milliseconds between local time and the UTC time.
-				auto time_t_diff = boost::posix_time::to_time_t( local_time) - boost::posix_time::to_time_t( utc_time);
-
-				offset = time_t_diff / 3600; // @suppress("Avoid magic numbers")
+				return aHexDigit - '0';
 			}
-			std::size_t offset;
-
-	};
-	static GMTOffset gmtOffset;
-
-	/**
-	 *
-	 */
-	/* static */ std::string ObjectId::objectIdNamespace = "";
-
-	static std::mutex newObjectIdMutex;
-
-	/* static */ObjectId ObjectId::newObjectId()
-	{
-		std::lock_guard< std::mutex > lock( newObjectIdMutex);
-
-		static time_t currentSecond = 0;
-		static unsigned long fraction = 0;
-
-		time_t newSecond = 0;
-
-		struct timespec now;
-
-		clock_gettime(CLOCK_REALTIME, &now);
-		newSecond = now.tv_sec;
-
-		// Reset seconds and fraction if in a new second
-		if (currentSecond < newSecond)
-		{
-			currentSecond = newSecond;
-			fraction = 0;
+			if (aHexDigit >= 'a' && aHexDigit <= 'f')
+			{
+				return aHexDigit - 'a' + 10; // @suppress("Avoid magic numbers")
+			}
+			return -1;
 		}
-
-		// Prevent overflow to 0 within the second. This should only happen on fast machines
-		// as the creation of the fraction part is processor speed dependent
-		if (fraction == ULONG_MAX)
+		/**
+		 *
+		 */
+		bool parseHex(	const std::string& aText,
+						std::size_t aPosition,
+						std::uint64_t& aValue)
 		{
-			// Wait for the next second
-			do
+			aValue = 0;
+			for (std::size_t i = aPosition; i < aPosition + 16; ++i) // @suppress("Avoid magic numbers")
 			{
-				clock_gettime(CLOCK_REALTIME, &now);
-				newSecond = now.tv_sec;
-			}while(currentSecond >= newSecond);
-			currentSecond = newSecond;
-			fraction = 0;
+				int value = hexValue( aText[i]);
+				if (value < 0)
+				{
+					return false;
+				}
+				aValue = (aValue << 4) | static_cast< std::uint64_t >( value); // @suppress("Avoid magic numbers")
+			}
+			return true;
 		}
+		/**
+		 *
+		 * @return True if aText is in the text form of an ObjectId that is not null and not interned
+		 */
+		bool parseObjectId(	const std::string& aText,
+							std::uint64_t anInternedPrefix,
+							std::uint64_t& aPrefix,
+							std::uint64_t& aCounter)
+		{
+			return aText.length() == 33 && aText[16] == '-' && // @suppress("Avoid magic numbers")
+				   parseHex( aText, 0, aPrefix) &&
+				   parseHex( aText, 17, aCounter) && // @suppress("Avoid magic numbers")
+				   (aPrefix & anInternedPrefix) == 0 &&
+				   (aPrefix != 0 || aCounter != 0);
+		}
+	} // namespace
 
-		// See https://stackoverflow.com/questions/41544774/localtime-takes-24-times-more-than-gmtime-performance-issue-on-linux
-		// for using gmtime + offset
-		//struct tm* timeStruct = localtime( &currentSecond); //
-		struct tm tm = *gmtime( &currentSecond);
-
-		// We actually only use 27 chars but it could be 93, based on the maximum int values....
-		char timestampBuffer[93] = {'\0'};
-		sprintf( timestampBuffer,
-				 "%04d-%02d-%02d-%02zu-%02d-%02d-%06lu",
-				 tm.tm_year + 1900, // @suppress("Avoid magic numbers")
-				 tm.tm_mon + 1,
-				 tm.tm_mday,
-				 tm.tm_hour + gmtOffset.offset,
-				 tm.tm_min,
-				 tm.tm_sec,
-				 fraction++);
+	/**
+	 *
+	 */
+	/* static */ std::string ObjectId::objectIdNamespace = "";
 
-		return ObjectId(timestampBuffer);
-	}
 	/**
 	 *
 	 */
-	bool ObjectId::operator==( const ObjectId& anObjectId) const
+	/* static */ObjectId ObjectId::newObjectId()
 	{
-		return (static_cast<base>(*this) == static_cast<base>(anObjectId));
+		// Computed once, the namespace, process id, start time and a random number make it unique per application
+		static const std::uint64_t applicationPrefix = []()
+		{
+			std::uint64_t value = std::hash< std::string >()( objectIdNamespace);
+			value = mix( value ^ static_cast< std::uint64_t >( ::getpid()));
+			value = mix( value ^ static_cast< std::uint64_t >( std::chrono::system_clock::now().time_since_epoch().count()));
+			value = mix( value ^ std::random_device()());
+			// Never the null prefix and never an interned prefix
+			value &= ~internedPrefix;
+			return value == 0 ? 1 : value;
+		}();
+		static std::atomic< std::uint64_t > nextCounter = 1;
+
+		return ObjectId( applicationPrefix, nextCounter.fetch_add( 1, std::memory_order_relaxed));
 	}
 	/**
 	 *
 	 */
-	bool ObjectId::operator<( const ObjectId& anObjectId) const
+	std::string ObjectId::toString() const
 	{
-		return (static_cast<base>(*this) < static_cast<base>(anObjectId));
+		if (isNull())
+		{
+			return "";
+		}
+		if (prefix == internedPrefix)
+		{
+			InternedTexts& internedTexts = getInternedTexts();
+			std::lock_guard< std::mutex > lock( internedTexts.busy);
+			return counter < internedTexts.texts.size() ? internedTexts.texts[counter] : "";
+		}
+		char text[34]; // @suppress("Avoid magic numbers")
+		std::snprintf(	text,
+						sizeof( text),
+						"%016llx-%016llx",
+						static_cast< unsigned long long >( prefix),
+						static_cast< unsigned long long >( counter));
+		return text;
 	}
 	/**
 	 *
 	 */
-	bool ObjectId::isNull() const
+	void ObjectId::fromString( const std::string& anObjectIdString)
 	{
-		if (base::empty())
+		if (anObjectIdString.empty())
 		{
-			return true;
+			prefix = 0;
+			counter = 0;
+			return;
+		}
+
+		std::uint64_t textPrefix = 0;
+		std::uint64_t textCounter = 0;
+		if (parseObjectId( anObjectIdString, internedPrefix, textPrefix, textCounter))
+		{
+			prefix = textPrefix;
+			counter = textCounter;
+			return;
 		}
-		return false;
+
+		InternedTexts& internedTexts = getInternedTexts();
+		std::lock_guard< std::mutex > lock( internedTexts.busy);
+		auto [index, inserted] = internedTexts.indices.insert( std::make_pair( anObjectIdString, internedTexts.texts.size()));
+		if (inserted)
+		{
+			internedTexts.texts.push_back( anObjectIdString);
+		}
+		prefix = internedPrefix;
+		counter = index->second;
 	}
 	/**
 	 *
 	 */
-	bool ObjectId::isValid() const
+	/* static */ObjectId ObjectId::fromWireString( const std::string& anObjectIdString)
 	{
-		if (isNull())
+		std::uint64_t textPrefix = 0;
+		std::uint64_t textCounter = 0;
+		if (anObjectIdString.empty() || parseObjectId( anObjectIdString, internedPrefix, textPrefix, textCounter))
 		{
-			return false;
+			return ObjectId( textPrefix, textCounter);
 		}
-		return true;
+
+		InternedTexts& internedTexts = getInternedTexts();
+		std::lock_guard< std::mutex > lock( internedTexts.busy);
+		auto index = internedTexts.indices.find( anObjectIdString);
+		if (index == internedTexts.indices.end())
+		{
+			return ObjectId();
+		}
+		return ObjectId( internedPrefix, index->second);
 	}
 	/**
 	 *
 	 */
 	/*virtual*/std::string ObjectId::asString() const
 	{
-		if (isNull())
-		{
-			return "";
-		}
-		return std::string( base::begin(), base::end());
+		return toString();
 	}
-
 	/**
 	 *
 	 */
@@ -3,282 +3,142 @@
 
 #include "Config.hpp"
 
-#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
-#include <iterator>
 #include <string>
-#include <vector>
-
+#include <type_traits>
 
 namespace Base
 {
 	/**
-	 * The ObjectId class is also used in Dagda. Therefore it has the required
-	 * PortableServer::ObjectId / unbounded sequence interface.
+	 * An ObjectId is 16 bytes: a 64 bit prefix that identifies the application that created it and
+	 * a 64 bit counter. It is trivially copyable and compares and hashes in constant time, so it can
+	 * be used as key without heap allocations.
 	 *
-	 * The OID class is 16 bytes, this class is 24 bytes. If one is memory constraint
-	 * the OID class may be of some help. Be warned: the OID class is not actively
-	 * maintained anymore (but than, who reeds this besides me, the maintainer).
+	 * The text form, 16 hex digits of the prefix, a '-' and 16 hex digits of the counter, is only used
+	 * for display and on the wire. Text that is not in that form, e.g. an ObjectId from an older peer,
+	 * is interned by fromString: the ObjectId refers to an entry in a table of the application and toString
+	 * returns the original text, so the ObjectId round trips unchanged. The table only grows, so text from
+	 * the wire is converted with fromWireString, which does not intern.
 	 */
-	class ObjectId : public std::vector< unsigned char >
+	class ObjectId
 	{
 		public:
-			typedef unsigned char value_type;
-			typedef unsigned char* pointer;
-			typedef const unsigned char* const_pointer;
-			typedef unsigned char& reference;
-			typedef const unsigned char& const_reference;
-			typedef std::vector< unsigned char > base;
 			/**
-			 * If an ObjectId should be *really* universal unique every application should have its own namespace
+			 * If an ObjectId should be *really* universal unique every application should have its own namespace.
+			 * The namespace is mixed into the prefix, it must be set before the first ObjectId is created.
 			 */
 			static std::string objectIdNamespace;
 			/**
-			 * This function returns an ObjectId that is guaranteed to be unique in the application it
-			 * is generated in. If multiple application use the same library it is the responsibility of
-			 * the applications to ensure uniqueness between applications.
+			 * This function returns an ObjectId that is unique in the application it is generated in. The prefix
+			 * is derived from the namespace, the process and the start time so ObjectIds of different applications
+			 * differ as well. Does not lock.
 			 */
 			static ObjectId newObjectId();
 			/**
-			 * @name CORBA required interface for PortableServer::ObjectId and sequence< T >
-			 */
-			//@{
-			/**
-			 * Default ctor.
-			 *
-			 * Also specified by
-			 */
-			ObjectId() :
-				base()
-			{
-			}
-			/**
-			 * Maximum ctor.
-			 *
-			 * @param max Initial elements reservation
-			 */
-			explicit ObjectId( unsigned long max) :
-				base( max)
-			{
-			}
-			/**
-			 * Data ctor.
-			 *
-			 * @param max 		Initial elements reservation. Is actually ignored
-			 * @param length 	Length of the data
-			 * @param data 		Start of the data
-			 * @param release 	If true the sequences owns and manages any containing pointers
-			 * 				  	Is actually ignored and always true.
-			 */
-			ObjectId( 	unsigned long /*max*/,
-						unsigned long len,
-						unsigned char* aDataPointer,
-						bool /*rel = true-*/) :
-							base( aDataPointer, aDataPointer + len)
-			{
-			}
-			/**
-			 *	Makes a deep copy.
-			 */
-			ObjectId( const ObjectId& anObjectId) :
-				base( anObjectId)
-			{
-			}
-			/**
-			 * @return The virtual maximum of bytes for this ObjectId. This maximum can safely be ignored.
-			 *
+			 * The null ObjectId
 			 */
-			std::size_t maximum() const
+			constexpr ObjectId() :
+								prefix( 0),
+								counter( 0)
 			{
-				return base::capacity();
 			}
-
 			/**
-			 * If the current length of the sequence is less than the new length we append new elements
-			 * which are created by calling the default constructor.  If the current length is more
-			 * than the new length we just cut of the tail of the sequence.
 			 *
-			 * @param length The new length of the sequence
 			 */
-			void length( unsigned long len)
+			constexpr ObjectId(	std::uint64_t aPrefix,
+								std::uint64_t aCounter) :
+								prefix( aPrefix),
+								counter( aCounter)
 			{
-				if (base::size() < len)
-				{
-					base::insert( base::end(), len - base::size(), value_type());
-				} else
-				{
-					base::erase( base::begin() + len, base::end());
-				}
 			}
-
 			/**
-			 *
-			 * @return The current length of the ObjectId
+			 * @see fromString
 			 */
-			std::size_t length() const
+			explicit ObjectId( const std::string& anObjectIdString)
 			{
-				return base::size();
+				fromString( anObjectIdString);
 			}
-
 			/**
 			 *
-			 * @param index
-			 * @return The mutable character at index.
 			 */
-			reference operator[]( unsigned long index)
+			constexpr std::uint64_t getPrefix() const
 			{
-				return base::operator[]( index);
+				return prefix;
 			}
-
 			/**
 			 *
-			 * @param index
-			 * @return The non-mutable character at index.
 			 */
-			const_reference operator[]( unsigned long index) const
+			constexpr std::uint64_t getCounter() const
 			{
-				return base::operator[]( index);
+				return counter;
 			}
-
 			/**
-			 * This returns always true for a value container
 			 *
-			 * @return true if this container owns the data.
 			 */
-			bool release() const
+			constexpr bool operator==( const ObjectId& anObjectId) const
 			{
-				return true;
+				return prefix == anObjectId.prefix && counter == anObjectId.counter;
 			}
-
-			/**
-			 * @param max Is ignored
-			 * @param rel Is ignored and is treated as true
-			 */
-			void replace( 	unsigned long /*max*/,
-							unsigned long len,
-							pointer newData,
-							bool /*rel = true*/)
-			{
-				base::erase( base::begin(), base::end());
-				base::insert( base::begin(), newData, newData + len);
-			}
-
 			/**
 			 *
-			 * @param 	orphan
-			 * @return 	The ObjectId as a modifyable continues buffer.
-			 * 			If the buffer is modified as that it expands the buffer this \will
-			 * 			lead to failure eventually
 			 */
-			pointer get_buffer( bool orphan = false)
+			constexpr bool operator!=( const ObjectId& anObjectId) const
 			{
-				if (orphan)
-				{
-					pointer t = allocbuf( base::size());
-					std::copy( base::begin(), base::end(), t);
-					base::erase( base::begin(), base::end());
-					return t;
-				} else
-				{
-					return &base::operator[]( 0);
-				}
+				return !(*this == anObjectId);
 			}
-
 			/**
 			 *
-			 * @return The ObjectId as a readonly continues buffer.
 			 */
-			const_pointer get_buffer() const
+			constexpr bool operator<( const ObjectId& anObjectId) const
 			{
-				return &base::operator[]( 0);
+				return prefix < anObjectId.prefix || (prefix == anObjectId.prefix && counter < anObjectId.counter);
 			}
-
 			/**
-			 * Do not use. It always throws an Danu::InvalidRequest exception.
 			 *
-			 * @param nelems
-			 * @return a new-ed buffer
 			 */
-			static pointer allocbuf( std::size_t nelems)
+			std::size_t hash() const
 			{
-				return new value_type[nelems];
+				// The counter changes with every ObjectId, mix the prefix in for ObjectIds of other applications
+				std::uint64_t value = counter ^ (prefix * 0x9E3779B97F4A7C15ULL); // @suppress("Avoid magic numbers")
+				value ^= value >> 32; // @suppress("Avoid magic numbers")
+				return static_cast< std::size_t >( value * 0xD6E8FEB86659FD93ULL); // @suppress("Avoid magic numbers")
 			}
 			/**
-			 * Do not use. It always throws an Danu::InvalidRequest exception.
-			 *
-			 * @param aT The buffer to free
-			 */
-			static void freebuf( pointer aT)
-			{
-				delete[] aT;
-			}
-			//@} // CORBA required interface
-
-			/**
+			 * Calling obj1.fromString( obj2.toString()) has the same effect as assignment, obj1 = obj2.
 			 *
+			 * @return std::string
 			 */
-			template< typename InputIterator >
-			ObjectId( 	InputIterator first,
-						InputIterator last) :
-						base( first, last)
-			{
-			}
+			std::string toString() const;
 			/**
+			 * Calling obj1.fromString( obj2.toString()) has the same effect as assignment, obj1 = obj2.
 			 *
+			 * @param anObjectIdString A string representation of an ObjectId, the empty string is the null ObjectId
 			 */
-			explicit ObjectId( const std::string& anObjectIdString) :
-				base( anObjectIdString.begin(), anObjectIdString.end())
-			{
-			}
+			void fromString( const std::string& anObjectIdString);
 			/**
+			 * Converts text that is received from another application. Text that is not in the text form of an
+			 * ObjectId is only looked up in the table of interned texts and is not added to it.
 			 *
+			 * @return The ObjectId, the null ObjectId if the text is empty or is not in the text form and not interned
 			 */
-			ObjectId& operator=( const ObjectId& anObjectId)
-			{
-				if (this != &anObjectId)
-				{
-					base::operator=( anObjectId);
-				}
-				return *this;
-			}
-
-			/**
-			 * @param anObjectId
-			 * @return True if the Danu::ObjectId part is the same
-			 */
-			bool operator==( const ObjectId& anObjectId) const;
-			/**
-			 * @param anObjectId
-			 * @return True if the Danu::ObjectId part is less
-			 */
-			bool operator<( const ObjectId& anObjectId) const;
+			static ObjectId fromWireString( const std::string& anObjectIdString);
 			/**
-			 * Calling obj1.fromString( obj2.toString()) has the same effect as assignment, obj1 = obj2.
 			 *
-			 * @return std::string
 			 */
-			std::string toString() const
+			constexpr bool isNull() const
 			{
-				return std::string( begin(), end());
+				return prefix == 0 && counter == 0;
 			}
 			/**
-			 * Calling obj1.fromString( obj2.toString()) has the same effect as assignment, obj1 = obj2.
 			 *
-			 * @param anObjectIdString A string representation of an ObjectId.
 			 */
-			void fromString( const std::string& anObjectIdString)
+			constexpr bool isValid() const
 			{
-				clear();
-				insert( begin(), anObjectIdString.begin(), anObjectIdString.end());
+				return !isNull();
 			}
-			/**
-			 *
-			 */
-			bool isNull() const;
-			/**
-			 *
-			 */
-			bool isValid() const;
 			/**
 			 * @name Debug functions
 			 */
@@ -295,11 +155,36 @@ namespace Base
 			std::string asDebugString() const;
 			//@}
 
+		private:
+			/**
+			 * Set in the prefix of ObjectIds whose counter is an index in the table of interned texts
+			 */
+			static constexpr std::uint64_t internedPrefix = 0x8000000000000000ULL; // @suppress("Avoid magic numbers")
 
+			std::uint64_t prefix;
+			std::uint64_t counter;
 	};
 	//	class ObjectId
 
+	static_assert( sizeof( ObjectId) == 16, "ObjectId must be 16 bytes"); // @suppress("Avoid magic numbers")
+	static_assert( std::is_trivially_copyable_v< ObjectId >, "ObjectId must be trivially copyable");
+
 	std::ostream& operator<<( 	std::ostream& os,
 								const ObjectId& anObjectId);
 } // namespace Base
+
+namespace std
+{
+	/**
+	 *
+	 */
+	template<>
+	struct hash< Base::ObjectId >
+	{
+			std::size_t operator()( const Base::ObjectId& anObjectId) const
+			{
+				return anObjectId.hash();
+			}
+	};
+} // namespace std
 #endif // OBJECTID_HPP_
@@ -0,0 +1,273 @@
+#ifndef OBJECTREGISTRY_HPP_
+#define OBJECTREGISTRY_HPP_
+
+#include "Config.hpp"
+
+#include "ObjectId.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Model
+{
+	/**
+	 * The objects of one kind in the world: a vector of the objects for iteration and hash indices by
+	 * ObjectId and, for objects with a getName, by name.
+	 *
+	 * Insert, erase and the lookups are O(1). Erase moves the last object into the hole (swap and pop)
+	 * and fixes up its index, so the order of the vector is not stable; the ObjectId is the stable
+	 * handle of an object.
+	 *
+	 * The name of an object can be changed without the registry knowing, so the name index is a hint:
+	 * a hit is verified and a miss falls back to a scan that repairs the index. Of objects with the
+	 * same name the index holds one.
+	 *
+	 * Like a standard container the registry must not be changed while it is read. Lookups by name
+	 * may run at the same time: the repair of the name index is done under a lock of its own.
+	 */
+	template< typename T >
+	class ObjectRegistry
+	{
+		public:
+			/**
+			 *
+			 */
+			typedef std::shared_ptr< T > ObjectPtr;
+			/**
+			 *
+			 */
+			typedef std::shared_ptr< const std::vector< ObjectPtr > > SharedObjects;
+			/**
+			 *
+			 */
+			static constexpr bool hasName = requires( const T& anObject)
+			{
+				anObject.getName();
+			};
+			/**
+			 *
+			 */
+			const std::vector< ObjectPtr >& getObjects() const
+			{
+				return objects;
+			}
+			/**
+			 * An immutable copy of the objects for a snapshot. The copy is only made again after the
+			 * objects have changed, so snapshots share the objects of the registries that did not change.
+			 */
+			SharedObjects getSharedObjects()
+			{
+				if (!sharedObjects)
+				{
+					sharedObjects = std::make_shared< const std::vector< ObjectPtr > >( objects);
+				}
+				return sharedObjects;
+			}
+			/**
+			 *
+			 */
+			std::size_t size() const
+			{
+				return objects.size();
+			}
+			/**
+			 *
+			 */
+			bool empty() const
+			{
+				return objects.empty();
+			}
+			/**
+			 *
+			 */
+			void reserve( std::size_t aSize)
+			{
+				objects.reserve( aSize);
+				objectIdIndex.reserve( aSize);
+			}
+			/**
+			 *
+			 * @return False if an object with the same ObjectId is already registered
+			 */
+			bool insert( const ObjectPtr& anObject)
+			{
+				if (!objectIdIndex.emplace( anObject->getObjectId(), objects.size()).second)
+				{
+					return false;
+				}
+				objects.push_back( anObject);
+				sharedObjects.reset();
+				if constexpr (hasName)
+				{
+					std::lock_guard< std::mutex > lock( nameIndexBusy);
+					nameIndex.emplace( anObject->getName(), anObject->getObjectId());
+				}
+				return true;
+			}
+			/**
+			 *
+			 * @return False if there is no object with anObjectId
+			 */
+			bool erase( const Base::ObjectId& anObjectId)
+			{
+				auto i = objectIdIndex.find( anObjectId);
+				if (i == objectIdIndex.end())
+				{
+					return false;
+				}
+				std::size_t index = i->second;
+				objectIdIndex.erase( i);
+				if constexpr (hasName)
+				{
+					eraseName( objects[index]->getName(), anObjectId);
+				}
+				if (index != objects.size() - 1)
+				{
+					objects[index] = std::move( objects.back());
+					objectIdIndex[objects[index]->getObjectId()] = index;
+				}
+				objects.pop_back();
+				sharedObjects.reset();
+				return true;
+			}
+			/**
+			 * Erases the last object of the vector
+			 */
+			void popBack()
+			{
+				if (!objects.empty())
+				{
+					erase( objects.back()->getObjectId());
+				}
+			}
+			/**
+			 * Erases the objects for which aPredicate returns true. O(N), the order of the remaining objects is kept.
+			 */
+			template< typename Predicate >
+			std::size_t eraseIf( Predicate aPredicate)
+			{
+				std::size_t oldSize = objects.size();
+				std::erase_if( objects, aPredicate);
+				if (objects.size() != oldSize)
+				{
+					sharedObjects.reset();
+					rebuildIndices();
+				}
+				return oldSize - objects.size();
+			}
+			/**
+			 * Keeps only the objects whose ObjectId is in aKeepObjects
+			 */
+			std::size_t keepOnly( const std::unordered_set< Base::ObjectId >& aKeepObjects)
+			{
+				return eraseIf( [&aKeepObjects]( const ObjectPtr& anObject)
+								{
+									return !aKeepObjects.contains( anObject->getObjectId());
+								});
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				objects.clear();
+				sharedObjects.reset();
+				objectIdIndex.clear();
+				std::lock_guard< std::mutex > lock( nameIndexBusy);
+				nameIndex.clear();
+			}
+			/**
+			 *
+			 * @return The object or nullptr
+			 */
+			ObjectPtr find( const Base::ObjectId& anObjectId) const
+			{
+				auto i = objectIdIndex.find( anObjectId);
+				if (i == objectIdIndex.end())
+				{
+					return nullptr;
+				}
+				return objects[i->second];
+			}
+			/**
+			 *
+			 * @return The object or nullptr
+			 */
+			ObjectPtr find( const std::string& aName) const requires hasName
+			{
+				std::lock_guard< std::mutex > lock( nameIndexBusy);
+				if (auto i = nameIndex.find( aName); i != nameIndex.end())
+				{
+					ObjectPtr object = find( i->second);
+					if (object && object->getName() == aName)
+					{
+						return object;
+					}
+					nameIndex.erase( i);
+				}
+				// Not indexed or renamed since it was indexed
+				for (const ObjectPtr& object : objects)
+				{
+					if (object->getName() == aName)
+					{
+						nameIndex[aName] = object->getObjectId();
+						return object;
+					}
+				}
+				return nullptr;
+			}
+
+		private:
+			/**
+			 *
+			 */
+			void eraseName(	const std::string& aName,
+							const Base::ObjectId& anObjectId)
+			{
+				std::lock_guard< std::mutex > lock( nameIndexBusy);
+				if (auto i = nameIndex.find( aName); i != nameIndex.end() && i->second == anObjectId)
+				{
+					nameIndex.erase( i);
+				}
+			}
+			/**
+			 *
+			 */
+			void rebuildIndices()
+			{
+				std::lock_guard< std::mutex > lock( nameIndexBusy);
+				objectIdIndex.clear();
+				nameIndex.clear();
+				for (std::size_t i = 0; i < objects.size(); ++i)
+				{
+					objectIdIndex.emplace( objects[i]->getObjectId(), i);
+					if constexpr (hasName)
+					{
+						nameIndex.emplace( objects[i]->getName(), objects[i]->getObjectId());
+					}
+				}
+			}
+
+			std::vector< ObjectPtr > objects;
+			/**
+			 * The copy of objects that getSharedObjects returned, empty after objects changed
+			 */
+			SharedObjects sharedObjects;
+			std::unordered_map< Base::ObjectId, std::size_t > objectIdIndex;
+			/**
+			 * Mutable because a lookup by name repairs it
+			 */
+			mutable std::unordered_map< std::string, Base::ObjectId > nameIndex;
+			/**
+			 * Serialises the lookups by name, which are const but change nameIndex
+			 */
+			mutable std::mutex nameIndexBusy;
+	}; // class ObjectRegistry
+} // namespace Model
+
+#endif // OBJECTREGISTRY_HPP_
@@ -0,0 +1,167 @@
+#include "OrientedBox.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <utility>
+
+namespace Utils
+{
+	namespace
+	{
+		/**
+		 *
+		 */
+		struct Projection
+		{
+				std::int64_t minimum;
+				std::int64_t maximum;
+		};
+		/**
+		 *
+		 */
+		Projection project(	const wxPoint* aPoints,
+							std::size_t aNumberOfPoints,
+							std::int64_t anAxisX,
+							std::int64_t anAxisY)
+		{
+			std::int64_t value = anAxisX * aPoints[0].x + anAxisY * aPoints[0].y;
+			Projection projection{ value, value };
+			for (std::size_t i = 1; i < aNumberOfPoints; ++i)
+			{
+				value = anAxisX * aPoints[i].x + anAxisY * aPoints[i].y;
+				projection.minimum = std::min( projection.minimum, value);
+				projection.maximum = std::max( projection.maximum, value);
+			}
+			return projection;
+		}
+		/**
+		 *
+		 * @return True if one of the edge normals of the polygon aPoints separates it from anOtherPoints
+		 */
+		bool separatedByEdgeOf(	const wxPoint* aPoints,
+								std::size_t aNumberOfPoints,
+								const wxPoint* anOtherPoints,
+								std::size_t aNumberOfOtherPoints)
+		{
+			for (std::size_t i = 0; i < aNumberOfPoints; ++i)
+			{
+				const wxPoint& start = aPoints[i];
+				const wxPoint& end = aPoints[(i + 1) % aNumberOfPoints];
+				// The normal of the edge, a degenerate edge has no normal and separates nothing
+				std::int64_t axisX = -(static_cast< std::int64_t >( end.y) - start.y);
+				std::int64_t axisY = static_cast< std::int64_t >( end.x) - start.x;
+				if (axisX == 0 && axisY == 0)
+				{
+					continue;
+				}
+				Projection projection = project( aPoints, aNumberOfPoints, axisX, axisY);
+				Projection otherProjection = project( anOtherPoints, aNumberOfOtherPoints, axisX, axisY);
+				if (projection.maximum < otherProjection.minimum || otherProjection.maximum < projection.minimum)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		/**
+		 *
+		 */
+		bool intersectsConvex(	const wxPoint* aPoints,
+								std::size_t aNumberOfPoints,
+								const wxPoint* anOtherPoints,
+								std::size_t aNumberOfOtherPoints)
+		{
+			// The x and y axes first: a cheap bounding box test and the axes that separate a box that collapsed
+			// to a segment or point, which has no edge normal along its own direction
+			for (const auto& [axisX, axisY] : { std::pair< std::int64_t, std::int64_t >( 1, 0), std::pair< std::int64_t, std::int64_t >( 0, 1) })
+			{
+				Projection projection = project( aPoints, aNumberOfPoints, axisX, axisY);
+				Projection otherProjection = project( anOtherPoints, aNumberOfOtherPoints, axisX, axisY);
+				if (projection.maximum < otherProjection.minimum || otherProjection.maximum < projection.minimum)
+				{
+					return false;
+				}
+			}
+			return !separatedByEdgeOf( aPoints, aNumberOfPoints, anOtherPoints, aNumberOfOtherPoints) &&
+				   !separatedByEdgeOf( anOtherPoints, aNumberOfOtherPoints, aPoints, aNumberOfPoints);
+		}
+	} // namespace
+
+	/**
+	 *
+	 */
+	OrientedBox::OrientedBox(	const wxPoint& aCorner1,
+								const wxPoint& aCorner2,
+								const wxPoint& aCorner3,
+								const wxPoint& aCorner4) :
+								corners{ aCorner1, aCorner2, aCorner3, aCorner4 }
+	{
+	}
+	/**
+	 *
+	 */
+	/* static */OrientedBox OrientedBox::around(	const wxPoint& aCentre,
+													const wxSize& aSize)
+	{
+		// x and y are pointing to top left now
+		int x = aCentre.x - (aSize.x / 2);
+		int y = aCentre.y - (aSize.y / 2);
+		return OrientedBox( wxPoint( x, y), wxPoint( x + aSize.x, y), wxPoint( x + aSize.x, y + aSize.y), wxPoint( x, y + aSize.y));
+	}
+	/**
+	 *
+	 */
+	/* static */OrientedBox OrientedBox::of( const wxRect& aRect)
+	{
+		return OrientedBox( wxPoint( aRect.x, aRect.y),
+							wxPoint( aRect.x + aRect.width, aRect.y),
+							wxPoint( aRect.x + aRect.width, aRect.y + aRect.height),
+							wxPoint( aRect.x, aRect.y + aRect.height));
+	}
+	/**
+	 *
+	 */
+	bool OrientedBox::intersects( const OrientedBox& anOrientedBox) const
+	{
+		return intersectsConvex( corners.data(), corners.size(), anOrientedBox.corners.data(), anOrientedBox.corners.size());
+	}
+	/**
+	 *
+	 */
+	bool OrientedBox::intersects( const wxRect& aRect) const
+	{
+		return intersects( of( aRect));
+	}
+	/**
+	 *
+	 */
+	bool OrientedBox::intersects(	const wxPoint& aStartPoint,
+									const wxPoint& anEndPoint) const
+	{
+		// A segment is a convex polygon with 2 points, its only edge normal is the normal of the segment
+		const wxPoint segment[] = { aStartPoint, anEndPoint };
+		return intersectsConvex( corners.data(), corners.size(), segment, 2);
+	}
+	/**
+	 *
+	 */
+	bool OrientedBox::contains( const wxPoint& aPoint) const
+	{
+		return intersectsConvex( corners.data(), corners.size(), &aPoint, 1);
+	}
+	/**
+	 *
+	 */
+	std::string OrientedBox::asString() const
+	{
+		std::ostringstream os;
+		os << "OrientedBox";
+		for (const wxPoint& corner : corners)
+		{
+			os << " (" << corner.x << "," << corner.y << ")";
+		}
+		return os.str();
+	}
+} // namespace Utils
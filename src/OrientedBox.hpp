@@ -0,0 +1,83 @@
+#ifndef ORIENTEDBOX_HPP_
+#define ORIENTEDBOX_HPP_
+
+#include "Config.hpp"
+
+#include "Point.hpp"
+#include "Size.hpp"
+
+#include <array>
+#include <string>
+
+namespace Utils
+{
+	/**
+	 * A convex quadrilateral given by its 4 corners in order around it, e.g. the rotated rectangle of a
+	 * robot whose corners are rounded to pixels, or an axis aligned rectangle.
+	 *
+	 * The intersection tests use the separating axis theorem: two convex shapes do not intersect if and
+	 * only if their projections on one of the edge normals of either shape do not overlap. The
+	 * projections are computed in 64 bit integers, so the tests are exact and do not allocate. The
+	 * edges belong to the box, boxes that only touch intersect.
+	 */
+	class OrientedBox
+	{
+		public:
+			/**
+			 *
+			 */
+			OrientedBox(	const wxPoint& aCorner1,
+							const wxPoint& aCorner2,
+							const wxPoint& aCorner3,
+							const wxPoint& aCorner4);
+			/**
+			 *
+			 * @return The axis aligned box of aSize with aCentre in the middle
+			 */
+			static OrientedBox around(	const wxPoint& aCentre,
+										const wxSize& aSize);
+			/**
+			 *
+			 * @return The axis aligned box from the top left of aRect to the top left plus the size of aRect
+			 */
+			static OrientedBox of( const wxRect& aRect);
+			/**
+			 *
+			 */
+			const std::array< wxPoint, 4 >& getCorners() const
+			{
+				return corners;
+			}
+			/**
+			 * OBB vs OBB
+			 */
+			bool intersects( const OrientedBox& anOrientedBox) const;
+			/**
+			 * OBB vs AABB
+			 */
+			bool intersects( const wxRect& aRect) const;
+			/**
+			 * OBB vs segment
+			 */
+			bool intersects(	const wxPoint& aStartPoint,
+								const wxPoint& anEndPoint) const;
+			/**
+			 *
+			 */
+			bool contains( const wxPoint& aPoint) const;
+			/**
+			 * @name Debug functions
+			 */
+			//@{
+			/**
+			 * Returns a 1-line description of the object
+			 */
+			std::string asString() const;
+			//@}
+
+		private:
+			std::array< wxPoint, 4 > corners;
+	}; // class OrientedBox
+} // namespace Utils
+
+#endif // ORIENTEDBOX_HPP_
@@ -9,21 +9,63 @@
 #include <queue>
 #include <optional>
 #include <atomic>
+#include <chrono>
+#include <utility>
+#include <vector>
 
 namespace Base
 {
+	/**
+	 * A queue for passing elements between threads. Any number of threads may enqueue and dequeue.
+	 *
+	 * A queue with a capacity is bounded: enqueue waits for room and tryEnqueue fails if the queue is full.
+	 */
 	template< typename QueueContentType >
 	class Queue
 	{
 		public:
 			/**
 			 *
+			 * @param aCapacity The maximum number of elements in the queue, 0 for no maximum
 			 */
-			void enqueue( const QueueContentType& anElement)
+			explicit Queue( size_t aCapacity = 0) :
+								capacity( aCapacity)
+			{
+			}
+			/**
+			 * Waits until there is room in the queue
+			 *
+			 * @return false if the queue is shut down, the element is not queued then
+			 */
+			bool enqueue( const QueueContentType& anElement)
 			{
 				std::unique_lock< std::mutex > lock( queueBusy);
+				while (isFull() && stop.load() == false)
+					queueNotFull.wait( lock);
+
+				if (stop.load())
+				{
+					return false;
+				}
 				queue.push( anElement);
 				queueFull.notify_one();
+				return true;
+			}
+			/**
+			 * Does not wait if the queue is full
+			 *
+			 * @return false if the queue is full or shut down
+			 */
+			bool tryEnqueue( QueueContentType&& anElement)
+			{
+				std::unique_lock< std::mutex > lock( queueBusy);
+				if (isFull() || stop.load())
+				{
+					return false;
+				}
+				queue.push( std::move( anElement));
+				queueFull.notify_one();
+				return true;
 			}
 			/**
 			 *
@@ -39,27 +81,104 @@ namespace Base
 					return {};
 				}else
 				{
-					QueueContentType front = queue.front();
+					QueueContentType front = std::move( queue.front());
 					queue.pop();
+					queueNotFull.notify_one();
 					return front;
 				}
 			}
+			/**
+			 * Does not wait if the queue is empty
+			 */
+			std::optional< QueueContentType > tryDequeue()
+			{
+				std::unique_lock< std::mutex > lock( queueBusy);
+				if (queue.empty())
+				{
+					return {};
+				}
+				QueueContentType front = std::move( queue.front());
+				queue.pop();
+				queueNotFull.notify_one();
+				return front;
+			}
+			/**
+			 * Waits at most aTimeout for an element
+			 *
+			 * @return The element, empty if the time is up or the queue is shut down and empty
+			 */
+			template< typename Rep, typename Period >
+			std::optional< QueueContentType > dequeueFor( const std::chrono::duration< Rep, Period >& aTimeout)
+			{
+				std::unique_lock< std::mutex > lock( queueBusy);
+				if (!queueFull.wait_for( lock, aTimeout, [this](){return !queue.empty() || stop.load();}) || queue.empty())
+				{
+					return {};
+				}
+				QueueContentType front = std::move( queue.front());
+				queue.pop();
+				queueNotFull.notify_one();
+				return front;
+			}
+			/**
+			 * Waits for at least one element and moves up to aMaximum elements into someElements with one lock
+			 *
+			 * @return The number of elements that are added to someElements, 0 if the queue is shut down and empty
+			 */
+			size_t dequeueBulk(	std::vector< QueueContentType >& someElements,
+								size_t aMaximum)
+			{
+				std::unique_lock< std::mutex > lock( queueBusy);
+				while (queue.empty() && stop.load() == false)
+					queueFull.wait( lock);
+
+				size_t count = 0;
+				while (!queue.empty() && count < aMaximum)
+				{
+					someElements.push_back( std::move( queue.front()));
+					queue.pop();
+					++count;
+				}
+				if (count > 0)
+				{
+					queueNotFull.notify_all();
+				}
+				return count;
+			}
 			/**
 			 *
 			 */
 			size_t size() const
 			{
+				std::unique_lock< std::mutex > lock( queueBusy);
 				return queue.size();
 			}
 			/**
 			 *
 			 */
+			size_t getCapacity() const
+			{
+				return capacity;
+			}
+			/**
+			 * Wakes up all waiting threads, the elements that are still queued can be dequeued
+			 */
 			void shutDown()
 			{
+				std::unique_lock< std::mutex > lock( queueBusy);
 				stop.store(true);
+				queueFull.notify_all();
+				queueNotFull.notify_all();
 			}
 
 		private:
+			/**
+			 * Must be called with queueBusy locked
+			 */
+			bool isFull() const
+			{
+				return capacity != 0 && queue.size() >= capacity;
+			}
 			/**
 			 *
 			 */
@@ -67,11 +186,19 @@ namespace Base
 			/**
 			 *
 			 */
-			std::mutex queueBusy;
+			size_t capacity;
+			/**
+			 *
+			 */
+			mutable std::mutex queueBusy;
 			/**
 			 *
 			 */
 			std::condition_variable queueFull;
+			/**
+			 *
+			 */
+			std::condition_variable queueNotFull;
 			/**
 			 *
 			 */
@@ -0,0 +1,206 @@
+#ifndef REQUESTDISPATCHER_HPP_
+#define REQUESTDISPATCHER_HPP_
+
+#include "Config.hpp"
+
+#include "CommunicationService.hpp"
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "MessageTypes.hpp"
+#include "RingBufferQueue.hpp"
+#include "Trace.hpp"
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Messaging
+{
+	/**
+	 * A RequestDispatcher decouples the thread that runs the io_context from the request handlers.
+	 * A session hands every request to the dispatcher, which queues it in a bounded lock-free queue. The model
+	 * thread of the dispatcher takes the requests out of the queue in batches and handles them, and
+	 * the responses are handed back to the io_context so they are written asynchronously.
+	 *
+	 * A slow request handler, e.g. one that changes the model and notifies the views, no longer
+	 * holds up the reading and writing of the other connections.
+	 *
+	 * The model thread keeps the dispatcher alive until stop is called.
+	 */
+	class RequestDispatcher : public std::enable_shared_from_this< RequestDispatcher >
+	{
+		public:
+			/**
+			 * Is called on the thread that runs the io_context with the response to the request
+			 */
+			typedef std::function< void( const Message&) > ResponseFunction;
+			/**
+			 * The default maximum number of requests that wait to be handled
+			 */
+			static constexpr std::size_t defaultCapacity = 1024;
+			/**
+			 * The maximum number of requests that is taken from the queue at once
+			 */
+			static constexpr std::size_t maximumBatchSize = 64;
+			/**
+			 *
+			 */
+			explicit RequestDispatcher( std::size_t aCapacity = defaultCapacity) :
+								requestQueue( aCapacity)
+			{
+			}
+			/**
+			 *
+			 */
+			~RequestDispatcher()
+			{
+				stop();
+			}
+			/**
+			 *
+			 */
+			RequestDispatcher( const RequestDispatcher&) = delete;
+			/**
+			 *
+			 */
+			RequestDispatcher& operator=( const RequestDispatcher&) = delete;
+			/**
+			 * Starts the model thread
+			 */
+			void start()
+			{
+				std::shared_ptr< RequestDispatcher > self = shared_from_this();
+				modelThread = std::thread( [self]()
+										   {
+												self->run();
+										   });
+			}
+			/**
+			 * Stops the model thread after the queued requests are handled, may be called more than once
+			 */
+			void stop()
+			{
+				requestQueue.shutDown();
+				if (modelThread.joinable())
+				{
+					if (modelThread.get_id() == std::this_thread::get_id())
+					{
+						// Called by a request handler, the model thread ends after the current batch
+						modelThread.detach();
+					} else
+					{
+						modelThread.join();
+					}
+				}
+			}
+			/**
+			 * Queues aRequest for aRequestHandler. May be called from any thread.
+			 *
+			 * @return false if the queue is full or the dispatcher is stopped, aResponseFunction is not called then
+			 */
+			bool dispatch(	const Message& aRequest,
+							RequestHandlerPtr aRequestHandler,
+							ResponseFunction aResponseFunction)
+			{
+				return requestQueue.tryEnqueue( Request{ aRequest, aRequestHandler, std::move( aResponseFunction) });
+			}
+			/**
+			 *
+			 * @return The number of requests that wait to be handled
+			 */
+			std::size_t getQueueSize() const
+			{
+				return requestQueue.size();
+			}
+			/**
+			 *
+			 * @return The number of batches that were handled, together with getNumberOfRequests the average batch size
+			 */
+			unsigned long getNumberOfBatches() const
+			{
+				return numberOfBatches.load();
+			}
+			/**
+			 *
+			 */
+			unsigned long getNumberOfRequests() const
+			{
+				return numberOfRequests.load();
+			}
+		private:
+			/**
+			 *
+			 */
+			struct Request
+			{
+					Message message;
+					RequestHandlerPtr requestHandler;
+					ResponseFunction responseFunction;
+			};
+			/**
+			 * The loop of the model thread
+			 */
+			void run()
+			{
+				std::vector< Request > batch;
+				batch.reserve( maximumBatchSize);
+				while (requestQueue.dequeueBulk( batch, maximumBatchSize) > 0)
+				{
+					for (Request& request : batch)
+					{
+						handleRequest( request);
+					}
+					++numberOfBatches;
+					numberOfRequests += batch.size();
+
+					// One post per batch instead of one per response
+					boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+										[responses = std::move( batch)]()
+										{
+											for (const Request& response : responses)
+											{
+												response.responseFunction( response.message);
+											}
+										});
+					batch = std::vector< Request >();
+					batch.reserve( maximumBatchSize);
+				}
+			}
+			/**
+			 * Handles aRequest, the response replaces the request. An exception of the request handler becomes a ServerSideExceptionResponse.
+			 */
+			static void handleRequest( Request& aRequest)
+			{
+				try
+				{
+					aRequest.requestHandler->handleRequest( aRequest.message);
+				}
+				catch (std::exception& e)
+				{
+					TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": ") + e.what());
+					aRequest.message.setMessageType( ServerSideExceptionResponse);
+					aRequest.message.setBody( e.what());
+				}
+				// The handler is released on the model thread, not on the thread that runs the io_context
+				aRequest.requestHandler.reset();
+			}
+
+			Base::RingBufferQueue< Request > requestQueue;
+			std::thread modelThread;
+			std::atomic< unsigned long > numberOfBatches = 0;
+			std::atomic< unsigned long > numberOfRequests = 0;
+	};
+	/**
+	 *
+	 */
+	typedef std::shared_ptr< RequestDispatcher > RequestDispatcherPtr;
+} // namespace Messaging
+
+#endif // REQUESTDISPATCHER_HPP_
@@ -0,0 +1,350 @@
+#ifndef RINGBUFFERQUEUE_HPP_
+#define RINGBUFFERQUEUE_HPP_
+
+#include "Config.hpp"
+
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Base
+{
+	/**
+	 * A bounded queue for any number of producers and consumers that does not use locks. It has the
+	 * same interface as Base::Queue, so a pipeline can use either.
+	 *
+	 * The queue is a ring buffer of cells with a sequence number each (D. Vyukov's bounded MPMC queue):
+	 * a producer claims a cell by advancing the enqueue position with a compare-and-swap and publishes the
+	 * element by storing the next sequence number, a consumer does the same with the dequeue position.
+	 * Producers and consumers only contend on their own position.
+	 *
+	 * The try functions never block. The other functions spin for a short time and then wait on an atomic,
+	 * the producers only wake a consumer if one is waiting.
+	 */
+	template< typename QueueContentType >
+	class RingBufferQueue
+	{
+		public:
+			/**
+			 *
+			 * @param aCapacity The maximum number of elements, rounded up to a power of 2 and at least 2
+			 */
+			explicit RingBufferQueue( size_t aCapacity) :
+								capacity( roundUpToPowerOf2( aCapacity)),
+								mask( capacity - 1),
+								cells( std::make_unique< Cell[] >( capacity))
+			{
+				for (size_t i = 0; i < capacity; ++i)
+				{
+					cells[i].sequence.store( i, std::memory_order_relaxed);
+				}
+			}
+			/**
+			 *
+			 */
+			~RingBufferQueue()
+			{
+				while (tryDequeue())
+				{
+				}
+			}
+			/**
+			 *
+			 */
+			RingBufferQueue( const RingBufferQueue&) = delete;
+			/**
+			 *
+			 */
+			RingBufferQueue& operator=( const RingBufferQueue&) = delete;
+			/**
+			 * Waits until there is room in the queue
+			 *
+			 * @return false if the queue is shut down, the element is not queued then
+			 */
+			bool enqueue( const QueueContentType& anElement)
+			{
+				QueueContentType element( anElement);
+				for (unsigned long attempt = 0; !tryEnqueue( std::move( element)); ++attempt)
+				{
+					if (stop.load( std::memory_order_acquire))
+					{
+						return false;
+					}
+					backOff( attempt);
+				}
+				return true;
+			}
+			/**
+			 * Does not wait if the queue is full
+			 *
+			 * @return false if the queue is full or shut down, anElement is not moved from then
+			 */
+			bool tryEnqueue( QueueContentType&& anElement)
+			{
+				if (stop.load( std::memory_order_relaxed))
+				{
+					return false;
+				}
+				size_t position = enqueuePosition.load( std::memory_order_relaxed);
+				Cell* cell = nullptr;
+				for (;;)
+				{
+					cell = &cells[position & mask];
+					size_t sequence = cell->sequence.load( std::memory_order_acquire);
+					std::intptr_t difference = static_cast< std::intptr_t >( sequence) - static_cast< std::intptr_t >( position);
+					if (difference == 0)
+					{
+						if (enqueuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					} else if (difference < 0)
+					{
+						return false;
+					} else
+					{
+						position = enqueuePosition.load( std::memory_order_relaxed);
+					}
+				}
+				new (cell->storage) QueueContentType( std::move( anElement));
+				cell->sequence.store( position + 1, std::memory_order_release);
+				wakeConsumer();
+				return true;
+			}
+			/**
+			 *
+			 */
+			bool tryEnqueue( const QueueContentType& anElement)
+			{
+				return tryEnqueue( QueueContentType( anElement));
+			}
+			/**
+			 * Does not wait if the queue is empty
+			 */
+			std::optional< QueueContentType > tryDequeue()
+			{
+				size_t position = dequeuePosition.load( std::memory_order_relaxed);
+				Cell* cell = nullptr;
+				for (;;)
+				{
+					cell = &cells[position & mask];
+					size_t sequence = cell->sequence.load( std::memory_order_acquire);
+					std::intptr_t difference = static_cast< std::intptr_t >( sequence) - static_cast< std::intptr_t >( position + 1);
+					if (difference == 0)
+					{
+						if (dequeuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					} else if (difference < 0)
+					{
+						return {};
+					} else
+					{
+						position = dequeuePosition.load( std::memory_order_relaxed);
+					}
+				}
+				QueueContentType* element = std::launder( reinterpret_cast< QueueContentType* >( cell->storage));
+				std::optional< QueueContentType > result( std::move( *element));
+				element->~QueueContentType();
+				cell->sequence.store( position + mask + 1, std::memory_order_release);
+				return result;
+			}
+			/**
+			 * Waits until there is an element or the queue is shut down
+			 *
+			 * @return The element, empty if the queue is shut down and empty
+			 */
+			std::optional< QueueContentType > dequeue()
+			{
+				for (unsigned long attempt = 0;; ++attempt)
+				{
+					std::optional< QueueContentType > element = tryDequeue();
+					if (element || stop.load( std::memory_order_acquire))
+					{
+						// An element that was enqueued just before the shut down is still returned
+						return element ? std::move( element) : tryDequeue();
+					}
+					if (attempt < spinCount)
+					{
+						std::this_thread::yield();
+					} else
+					{
+						waitForElement();
+					}
+				}
+			}
+			/**
+			 * Waits at most aTimeout for an element
+			 *
+			 * @return The element, empty if the time is up or the queue is shut down and empty
+			 */
+			template< typename Rep, typename Period >
+			std::optional< QueueContentType > dequeueFor( const std::chrono::duration< Rep, Period >& aTimeout)
+			{
+				std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + aTimeout;
+				for (unsigned long attempt = 0;; ++attempt)
+				{
+					std::optional< QueueContentType > element = tryDequeue();
+					if (element || stop.load( std::memory_order_acquire) || std::chrono::steady_clock::now() >= deadline)
+					{
+						return element;
+					}
+					backOff( attempt);
+				}
+			}
+			/**
+			 * Waits for at least one element and moves up to aMaximum elements into someElements
+			 *
+			 * @return The number of elements that are added to someElements, 0 if the queue is shut down and empty
+			 */
+			size_t dequeueBulk(	std::vector< QueueContentType >& someElements,
+								size_t aMaximum)
+			{
+				if (aMaximum == 0)
+				{
+					return 0;
+				}
+				std::optional< QueueContentType > first = dequeue();
+				if (!first)
+				{
+					return 0;
+				}
+				someElements.push_back( std::move( *first));
+				size_t count = 1;
+				while (count < aMaximum)
+				{
+					std::optional< QueueContentType > element = tryDequeue();
+					if (!element)
+					{
+						break;
+					}
+					someElements.push_back( std::move( *element));
+					++count;
+				}
+				return count;
+			}
+			/**
+			 *
+			 * @return The number of elements in the queue, only exact if no other thread uses the queue
+			 */
+			size_t size() const
+			{
+				size_t dequeued = dequeuePosition.load( std::memory_order_acquire);
+				size_t enqueued = enqueuePosition.load( std::memory_order_acquire);
+				return enqueued > dequeued ? enqueued - dequeued : 0;
+			}
+			/**
+			 *
+			 */
+			size_t getCapacity() const
+			{
+				return capacity;
+			}
+			/**
+			 * Wakes up all waiting threads, the elements that are still queued can be dequeued
+			 */
+			void shutDown()
+			{
+				stop.store( true, std::memory_order_release);
+				signal.fetch_add( 1, std::memory_order_release);
+				signal.notify_all();
+			}
+
+		private:
+			/**
+			 * The number of times a waiting thread yields before it sleeps
+			 */
+			static constexpr unsigned long spinCount = 64;
+			/**
+			 * A cell has its own cache line so producers and consumers of neighbouring cells do not contend
+			 */
+			struct alignas( 64 ) Cell // @suppress("Avoid magic numbers")
+			{
+					std::atomic< size_t > sequence;
+					alignas( QueueContentType ) unsigned char storage[sizeof( QueueContentType)];
+			};
+			/**
+			 *
+			 */
+			static size_t roundUpToPowerOf2( size_t aCapacity)
+			{
+				size_t result = 2;
+				while (result < aCapacity)
+				{
+					result <<= 1;
+				}
+				return result;
+			}
+			/**
+			 * Yields for the first attempts and then sleeps longer with every attempt, up to a millisecond
+			 */
+			static void backOff( unsigned long anAttempt)
+			{
+				if (anAttempt < spinCount)
+				{
+					std::this_thread::yield();
+				} else
+				{
+					std::this_thread::sleep_for( std::chrono::microseconds( std::min( 1000UL, 10 * (anAttempt - spinCount + 1)))); // @suppress("Avoid magic numbers")
+				}
+			}
+			/**
+			 * Sleeps until a producer or shutDown changes the signal
+			 */
+			void waitForElement()
+			{
+				std::uint32_t observed = signal.load( std::memory_order_acquire);
+				waitingConsumers.fetch_add( 1, std::memory_order_seq_cst);
+				// Checked again after registering as waiter, the fences make sure that either this check
+				// sees the new element or the producer sees the waiter
+				std::atomic_thread_fence( std::memory_order_seq_cst);
+				if (!isNextElementPublished() && !stop.load( std::memory_order_acquire))
+				{
+					signal.wait( observed, std::memory_order_acquire);
+				}
+				waitingConsumers.fetch_sub( 1, std::memory_order_seq_cst);
+			}
+			/**
+			 * The enqueue position is advanced before the element is stored, so size() may count an element that
+			 * cannot be dequeued yet. The sequence number of the cell is only advanced when the element is there.
+			 *
+			 * @return true if the cell at the dequeue position holds a published element
+			 */
+			bool isNextElementPublished() const
+			{
+				size_t position = dequeuePosition.load( std::memory_order_acquire);
+				return cells[position & mask].sequence.load( std::memory_order_acquire) == position + 1;
+			}
+			/**
+			 *
+			 */
+			void wakeConsumer()
+			{
+				std::atomic_thread_fence( std::memory_order_seq_cst);
+				if (waitingConsumers.load( std::memory_order_seq_cst) > 0)
+				{
+					signal.fetch_add( 1, std::memory_order_release);
+					signal.notify_one();
+				}
+			}
+
+			const size_t capacity;
+			const size_t mask;
+			std::unique_ptr< Cell[] > cells;
+			alignas( 64 ) std::atomic< size_t > enqueuePosition = 0; // @suppress("Avoid magic numbers")
+			alignas( 64 ) std::atomic< size_t > dequeuePosition = 0; // @suppress("Avoid magic numbers")
+			alignas( 64 ) std::atomic< std::uint32_t > signal = 0; // @suppress("Avoid magic numbers")
+			std::atomic< unsigned long > waitingConsumers = 0;
+			std::atomic< bool > stop = false;
+	};
+} // namespace Base
+#endif /* RINGBUFFERQUEUE_HPP_ */
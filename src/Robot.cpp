@@ -2,12 +2,16 @@
 
 #include "Client.hpp"
 #include "CommunicationService.hpp"
+#include "Compression.hpp"
+#include "Datagram.hpp"
 #include "Goal.hpp"
 #include "Logger.hpp"
 #include "MainApplication.hpp"
 #include "MathUtils.hpp"
 #include "Message.hpp"
 #include "MessageTypes.hpp"
+#include "RequestDispatcher.hpp"
+#include "RobotStateFrame.hpp"
 #include "RobotWorld.hpp"
 #include "Server.hpp"
 #include "Shape2DUtils.hpp"
@@ -22,7 +26,6 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <regex>
 
 namespace Model
 {
@@ -43,19 +46,27 @@ namespace Model
 	 */
 	Robot::Robot(	const std::string& aName,
 					const wxPoint& aPosition) :
+								Robot( aName, aPosition, Base::ObjectId::newObjectId())
+	{
+	}
+	/**
+	 *
+	 */
+	Robot::Robot(	const std::string& aName,
+					const wxPoint& aPosition,
+					const Base::ObjectId& anObjectId) :
+								ModelObject( anObjectId),
 								name( aName),
-								size( wxDefaultSize),
-								position( aPosition),
-								front( 0, 0),
-								speed( 0.0),
-								acting(false),
-								driving(false),
+								stateTable( RobotWorld::getRobotWorld().getRobotStateTable()),
+								stateIndex( stateTable->allocate( getObjectId())),
 								communicating(false),
 								almostCollided(false),
 								worldSyncer(false)
 	{
+		stateTable->setSize( stateIndex, wxDefaultSize);
+		stateTable->setPosition( stateIndex, aPosition);
 		// We use the real position for starters, not an estimated position.
-		startPosition = position;
+		startPosition = aPosition;
 		if(Application::MainApplication::isArgGiven("-name"))
 		{
 			name = Application::MainApplication::getArg("-name").value;
@@ -67,11 +78,11 @@ namespace Model
 	Robot::~Robot()
 	{
 		Application::Logger::log(__PRETTY_FUNCTION__);
-		if(driving)
+		if(isDriving())
 		{
 			Robot::stopDriving();
 		}
-		if(acting)
+		if(isActing())
 		{
 			Robot::stopActing();
 		}
@@ -79,6 +90,11 @@ namespace Model
 		{
 			stopCommunicating();
 		}
+		if(requestDispatcher)
+		{
+			requestDispatcher->stop();
+		}
+		stateTable->release( stateIndex);
 	}
 	/**
 	 *
@@ -97,7 +113,7 @@ namespace Model
 	 */
 	wxSize Robot::getSize() const
 	{
-		return size;
+		return stateTable->getSize( stateIndex);
 	}
 	/**
 	 *
@@ -105,7 +121,8 @@ namespace Model
 	void Robot::setSize(	const wxSize& aSize,
 							bool aNotifyObservers /*= true*/)
 	{
-		size = aSize;
+		stateTable->setSize( stateIndex, aSize);
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -117,7 +134,8 @@ namespace Model
 	void Robot::setPosition(	const wxPoint& aPosition,
 								bool aNotifyObservers /*= true*/)
 	{
-		position = aPosition;
+		stateTable->setPosition( stateIndex, aPosition);
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -128,7 +146,7 @@ namespace Model
 	 */
 	BoundedVector Robot::getFront() const
 	{
-		return front;
+		return stateTable->getFront( stateIndex);
 	}
 	/**
 	 *
@@ -136,7 +154,7 @@ namespace Model
 	void Robot::setFront(	const BoundedVector& aVector,
 							bool aNotifyObservers /*= true*/)
 	{
-		front = aVector;
+		stateTable->setFront( stateIndex, aVector);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -147,7 +165,7 @@ namespace Model
 	 */
 	float Robot::getSpeed() const
 	{
-		return speed;
+		return stateTable->getSpeed( stateIndex);
 	}
 	/**
 	 *
@@ -155,7 +173,7 @@ namespace Model
 	void Robot::setSpeed( float aNewSpeed,
 						  bool aNotifyObservers /*= true*/)
 	{
-		speed = aNewSpeed;
+		stateTable->setSpeed( stateIndex, aNewSpeed);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -166,7 +184,7 @@ namespace Model
 	 */
 	void Robot::startActing()
 	{
-		acting = true;
+		stateTable->setActing( stateIndex, true);
 		std::thread newRobotThread( [this]{	startDriving();});
 		robotThread.swap( newRobotThread);
 	}
@@ -175,8 +193,8 @@ namespace Model
 	 */
 	void Robot::stopActing()
 	{
-		acting = false;
-		driving = false;
+		stateTable->setActing( stateIndex, false);
+		stateTable->setDriving( stateIndex, false);
 		robotThread.join();
 	}
 	/**
@@ -184,7 +202,7 @@ namespace Model
 	 */
 	void Robot::startDriving()
 	{
-		driving = true;
+		stateTable->setDriving( stateIndex, true);
 		goal = RobotWorld::getRobotWorld().getGoal( "Goal");
 		calculateRoute(goal);
 
@@ -195,7 +213,7 @@ namespace Model
 	 */
 	void Robot::stopDriving()
 	{
-		driving = false;
+		stateTable->setDriving( stateIndex, false);
 	}
 	/**
 	 *
@@ -218,9 +236,33 @@ namespace Model
 				Messaging::CommunicationService::getCommunicationService().restart();
 			}
 
+			// The dispatcher of a previous session may still be handling its StopCommunicatingRequest
+			if (requestDispatcher)
+			{
+				requestDispatcher->stop();
+			}
+			requestDispatcher = std::make_shared<Messaging::RequestDispatcher>();
+			requestDispatcher->start();
+
 			server = std::make_shared<Messaging::Server>(	static_cast<unsigned short>(std::stoi(localPort)),
 															toPtr<Robot>());
+			server->setRequestDispatcher( requestDispatcher);
 			Messaging::CommunicationService::getCommunicationService().registerServer( server);
+
+			if (isPoseTransportDatagram())
+			{
+				// UDP has its own port numbers so the same port as the TCP server is used
+				datagramServer = std::make_shared<Messaging::DatagramServer>(	static_cast<unsigned short>(std::stoi(localPort)),
+																				toPtr<Robot>());
+				// Only the poses of the robot we are communicating with are applied
+				std::string remoteIpAdres = "localhost";
+				if (Application::MainApplication::isArgGiven( "-remote_ip"))
+				{
+					remoteIpAdres = Application::MainApplication::getArg( "-remote_ip").value;
+				}
+				datagramServer->setPeer( remoteIpAdres);
+				datagramServer->startHandlingRequests();
+			}
 		}
 	}
 	/**
@@ -243,6 +285,16 @@ namespace Model
 										toPtr<Robot>());
 			Messaging::Message message( Messaging::StopCommunicatingRequest, "stop");
 			c1ient.dispatchMessage( message);
+
+			if (datagramServer)
+			{
+				datagramServer->stopHandlingRequests();
+				datagramServer.reset();
+			}
+
+			std::unique_lock<std::recursive_mutex> lock(robotMutex);
+			remoteClient.reset();
+			datagramClient.reset();
 		}
 	}
 	/**
@@ -250,27 +302,42 @@ namespace Model
 	 */
 	std::string Robot::getWorldInfo()
 	{
-		std::vector<WallPtr> walls = RobotWorld::getRobotWorld().getWalls();
-		
-		std::string worldInfo = "Walls";
-		for(WallPtr wall : walls)
+		RobotWorld& robotWorld = RobotWorld::getRobotWorld();
+
+		// One snapshot so the walls, goals and robot are of the same version
+		WorldSnapshotPtr worldSnapshot = robotWorld.getSnapshot();
+		const std::vector<WallPtr>& walls = worldSnapshot->getWalls();
+		const std::vector<GoalPtr>& goals = worldSnapshot->getGoals();
+
+		std::string worldInfo;
+		// Every record is at most 4 numbers of 11 characters plus the separators
+		worldInfo.reserve(64 + (walls.size() + goals.size()) * 48); // @suppress("Avoid magic numbers")
+
+		worldInfo += "Walls";
+		for (std::size_t i = 0; i < walls.size(); ++i)
 		{
-			worldInfo += std::to_string(wall->getPoint1().x) + "," + std::to_string(wall->getPoint1().y) + "," +
-						   std::to_string(wall->getPoint2().x) + "," + std::to_string(wall->getPoint2().y) + "_";
+			if (i > 0)
+			{
+				worldInfo += '_';
+			}
+			WorldSyncSender::appendWall(worldInfo, *walls[i]);
 		}
-		worldInfo = worldInfo.substr(0, worldInfo.size() - 1);
-		worldInfo += ";";
-		std::vector<GoalPtr> goals = RobotWorld::getRobotWorld().getGoals();
-		worldInfo += "Goals";
-		for(GoalPtr goal : goals)
+		worldInfo += ";Goals";
+		for (std::size_t i = 0; i < goals.size(); ++i)
 		{
-			worldInfo += std::to_string(goal->getPosition().x) + "," + std::to_string(goal->getPosition().y);
+			if (i > 0)
+			{
+				worldInfo += '_';
+			}
+			WorldSyncSender::appendGoal(worldInfo, *goals[i]);
+		}
+		// The ObjectId is sent along so that the remote copy of the robot shares its identity,
+		// which allows the receiver to match the records of a RobotStateFrame
+		if (!worldSnapshot->getRobots().empty())
+		{
+			worldInfo += ";Robot";
+			WorldSyncSender::appendRobot(worldInfo, *worldSnapshot->getRobots().front());
 		}
-		worldInfo += ";";
-		std::vector<RobotPtr> robots = RobotWorld::getRobotWorld().getRobots();
-		RobotPtr thisRobot = robots[0];
-		wxPoint currentPos = thisRobot->getPosition();
-		worldInfo += "Robot" + std::to_string(currentPos.x) + "," + std::to_string(currentPos.y) + "," + std::to_string(0.0) + "," + std::to_string(0.0);
 		return worldInfo;
 	}
 	/**
@@ -278,52 +345,159 @@ namespace Model
 	 */
 	void Robot::sendWorldInfo()
 	{
-		std::string remoteIpAdres = "localhost";
-		std::string remotePort = "12345";
+		startWorldSync(true);
+		worldSyncer = true;
+	}
+	/**
+	 *
+	 */
+	void Robot::startWorldSync(bool aReplyRequested)
+	{
+		RobotWorld& robotWorld = RobotWorld::getRobotWorld();
+		if (!robotWorld.getRobot(name))
+		{
+			return;
+		}
+		WorldSnapshotPtr worldSnapshot = robotWorld.getSnapshot();
+		if (worldSnapshot->getRobots().empty())
+		{
+			return;
+		}
 
-		if (Application::MainApplication::isArgGiven( "-remote_ip"))
+		WorldSyncSenderPtr sender;
 		{
-			remoteIpAdres = Application::MainApplication::getArg( "-remote_ip").value;
+			std::lock_guard<std::mutex> lock(worldSyncMutex);
+			if (worldSyncSender && !worldSyncSender->isFinished())
+			{
+				// Replacing the sender would drop the acknowledgements of the stream in flight
+				queuedWorldSync = queuedWorldSync.value_or(false) || aReplyRequested;
+				Application::Logger::log("World sync stream " + std::to_string(worldSyncSender->getStreamId()) + " is still in flight, the next one is queued");
+				return;
+			}
+
+			Messaging::PipelinedClientPtr client = getRemoteClient();
+			// The sender must not keep the robot alive, the robot owns the sender
+			std::weak_ptr<Robot> weakRobot = toPtr<Robot>();
+			worldSyncSender = std::make_shared<WorldSyncSender>(worldSnapshot->getRobots().front(),
+																[client](const Messaging::Message& aMessage, WorldSyncSender::ResponseFunction aResponseFunction)
+																{
+																	// The client compresses the chunks once the peer has said it can decompress them
+																	client->dispatchMessage(aMessage, aResponseFunction);
+																},
+																[weakRobot](bool aSucceeded)
+																{
+																	if (RobotPtr robot = weakRobot.lock())
+																	{
+																		robot->worldSyncFinished(aSucceeded);
+																	}
+																},
+																aReplyRequested);
+			sender = worldSyncSender;
 		}
-		if (Application::MainApplication::isArgGiven( "-remote_port"))
+		Application::Logger::log("World sync stream " + std::to_string(sender->getStreamId()) + ": " + std::to_string(sender->getNumberOfChunks()) + " chunk(s)");
+		sender->start();
+	}
+	/**
+	 *
+	 */
+	void Robot::worldSyncFinished(bool aSucceeded)
+	{
+		std::optional<bool> queued;
 		{
-			remotePort = Application::MainApplication::getArg( "-remote_port").value;
+			std::lock_guard<std::mutex> lock(worldSyncMutex);
+			queued.swap(queuedWorldSync);
 		}
-		std::string wallsString = getWorldInfo();
-		Application::Logger::log(wallsString);	
-		Model::RobotPtr robot = Model::RobotWorld::getRobotWorld().getRobot(name);
-		if(robot){
-			Messaging::Client c1ient(remoteIpAdres, static_cast<unsigned short>(std::stoi(remotePort)),robot);
-			Messaging::Message message( Messaging::SyncWorldRequest, wallsString);
-			c1ient.dispatchMessage( message);
-			
+		if (!aSucceeded)
+		{
+			Application::Logger::log(std::string("World sync failed") + (queued ? ", the queued one is started" : ""));
+		}
+		if (queued)
+		{
+			startWorldSync(*queued);
 		}
-		worldSyncer = true;
 	}
 	/**
 	 *
 	 */
-	wxRegion Robot::getRegion() const
+	Messaging::PipelinedClientPtr Robot::getRemoteClient()
 	{
-		wxPoint translatedPoints[] = { getFrontRight(), getFrontLeft(), getBackLeft(), getBackRight() };
-		return wxRegion( 4, translatedPoints); // @suppress("Avoid magic numbers")
+		std::unique_lock<std::recursive_mutex> lock(robotMutex);
+		if (!remoteClient)
+		{
+			std::string remoteIpAdres = "localhost";
+			std::string remotePort = "12345";
+
+			if (Application::MainApplication::isArgGiven( "-remote_ip"))
+			{
+				remoteIpAdres = Application::MainApplication::getArg( "-remote_ip").value;
+			}
+			if (Application::MainApplication::isArgGiven( "-remote_port"))
+			{
+				remotePort = Application::MainApplication::getArg( "-remote_port").value;
+			}
+			// The robot owns the client, so the client must not keep the robot alive
+			remoteClient = std::make_shared<Messaging::PipelinedClient>(remoteIpAdres,
+																		static_cast<unsigned short>(std::stoi(remotePort)),
+																		std::make_shared<Messaging::WeakResponseHandler>( toPtr<Robot>()));
+		}
+		return remoteClient;
+	}
+	/**
+	 *
+	 */
+	/* static */bool Robot::isPoseTransportDatagram()
+	{
+		return Application::MainApplication::isArgGiven( "-pose_transport") &&
+			   Application::MainApplication::getArg( "-pose_transport").value == "udp";
+	}
+	/**
+	 *
+	 */
+	Messaging::DatagramClientPtr Robot::getDatagramClient()
+	{
+		std::unique_lock<std::recursive_mutex> lock(robotMutex);
+		if (!datagramClient)
+		{
+			std::string remoteIpAdres = "localhost";
+			std::string remotePort = "12345";
+
+			if (Application::MainApplication::isArgGiven( "-remote_ip"))
+			{
+				remoteIpAdres = Application::MainApplication::getArg( "-remote_ip").value;
+			}
+			if (Application::MainApplication::isArgGiven( "-remote_port"))
+			{
+				remotePort = Application::MainApplication::getArg( "-remote_port").value;
+			}
+			datagramClient = std::make_shared<Messaging::DatagramClient>(	remoteIpAdres,
+																			static_cast<unsigned short>(std::stoi(remotePort)));
+		}
+		return datagramClient;
+	}
+	/**
+	 *
+	 */
+	Utils::OrientedBox Robot::getOrientedBox() const
+	{
+		Corners corners = getCorners();
+		return Utils::OrientedBox( corners.frontRight, corners.frontLeft, corners.backLeft, corners.backRight);
 	}
 	/**
 	 *
 	 */
-	bool Robot::intersects( const wxRegion& aRegion) const
+	bool Robot::intersects( const Utils::OrientedBox& anOrientedBox) const
 	{
-		wxRegion region = getRegion();
-		region.Intersect( aRegion);
-		return !region.IsEmpty();
+		return getOrientedBox().intersects( anOrientedBox);
 	}
 	/**
 	 *
 	 */
 	bool Robot::closeToOtherRobot(double maximumDistance) const
 	{
-		const std::vector<RobotPtr>& robots = RobotWorld::getRobotWorld().getRobots();
+		// Only the robots in the box around the robot can be that close
+		const std::vector<RobotPtr> robots = RobotWorld::getRobotWorld().getRobotsIn(SpatialIndex::Bounds::around(getPosition(), static_cast<int>(std::ceil(maximumDistance))));
 
+		wxPoint position = getPosition();
 		for (RobotPtr robot : robots)
 		{
 			if(robot){
@@ -348,70 +522,72 @@ namespace Model
 	 */
 	wxPoint Robot::getFrontLeft() const
 	{
-		// x and y are pointing to top left now
-		int x = position.x - (size.x / 2);
-		int y = position.y - (size.y / 2);
-
-		wxPoint originalFrontLeft( x, y);
-		double angle = Utils::Shape2DUtils::getAngle( front) + 0.5 * Utils::PI;
-
-		wxPoint frontLeft( static_cast<int>((originalFrontLeft.x - position.x) * std::cos( angle) - (originalFrontLeft.y - position.y) * std::sin( angle) + position.x),
-						 static_cast<int>((originalFrontLeft.y - position.y) * std::cos( angle) + (originalFrontLeft.x - position.x) * std::sin( angle) + position.y));
-
-		return frontLeft;
+		return getCorners().frontLeft;
 	}
 	/**
 	 *
 	 */
 	wxPoint Robot::getFrontRight() const
 	{
-		// x and y are pointing to top left now
-		int x = position.x - (size.x / 2);
-		int y = position.y - (size.y / 2);
-
-		wxPoint originalFrontRight( x + size.x, y);
-		double angle = Utils::Shape2DUtils::getAngle( front) + 0.5 * Utils::PI;
-
-		wxPoint frontRight( static_cast<int>((originalFrontRight.x - position.x) * std::cos( angle) - (originalFrontRight.y - position.y) * std::sin( angle) + position.x),
-						  static_cast<int>((originalFrontRight.y - position.y) * std::cos( angle) + (originalFrontRight.x - position.x) * std::sin( angle) + position.y));
-
-		return frontRight;
+		return getCorners().frontRight;
 	}
 	/**
 	 *
 	 */
 	wxPoint Robot::getBackLeft() const
 	{
-		// x and y are pointing to top left now
-		int x = position.x - (size.x / 2);
-		int y = position.y - (size.y / 2);
-
-		wxPoint originalBackLeft( x, y + size.y);
-
-		double angle = Utils::Shape2DUtils::getAngle( front) + 0.5 * Utils::PI;
-
-		wxPoint backLeft( static_cast<int>((originalBackLeft.x - position.x) * std::cos( angle) - (originalBackLeft.y - position.y) * std::sin( angle) + position.x),
-						static_cast<int>((originalBackLeft.y - position.y) * std::cos( angle) + (originalBackLeft.x - position.x) * std::sin( angle) + position.y));
-
-		return backLeft;
+		return getCorners().backLeft;
 	}
 	/**
 	 *
 	 */
 	wxPoint Robot::getBackRight() const
 	{
+		return getCorners().backRight;
+	}
+	/**
+	 *
+	 */
+	Robot::Corners Robot::getCorners() const
+	{
+		wxPoint position = getPosition();
+		wxSize size = getSize();
+		BoundedVector front = getFront();
+
+		std::lock_guard< std::mutex > lock( poseTransformBusy);
+		if (poseTransform.valid &&
+			poseTransform.position == position &&
+			poseTransform.size == size &&
+			poseTransform.frontX == front.x &&
+			poseTransform.frontY == front.y)
+		{
+			return poseTransform.corners;
+		}
+
 		// x and y are pointing to top left now
 		int x = position.x - (size.x / 2);
 		int y = position.y - (size.y / 2);
 
-		wxPoint originalBackRight( x + size.x, y + size.y);
-
 		double angle = Utils::Shape2DUtils::getAngle( front) + 0.5 * Utils::PI;
+		double cosAngle = std::cos( angle);
+		double sinAngle = std::sin( angle);
 
-		wxPoint backRight( static_cast<int>((originalBackRight.x - position.x) * std::cos( angle) - (originalBackRight.y - position.y) * std::sin( angle) + position.x),
-						 static_cast<int>((originalBackRight.y - position.y) * std::cos( angle) + (originalBackRight.x - position.x) * std::sin( angle) + position.y));
-
-		return backRight;
+		auto rotate = [&position, cosAngle, sinAngle]( const wxPoint& aPoint)
+		{
+			return wxPoint( static_cast<int>((aPoint.x - position.x) * cosAngle - (aPoint.y - position.y) * sinAngle + position.x),
+							static_cast<int>((aPoint.y - position.y) * cosAngle + (aPoint.x - position.x) * sinAngle + position.y));
+		};
+
+		poseTransform.valid = true;
+		poseTransform.position = position;
+		poseTransform.size = size;
+		poseTransform.frontX = front.x;
+		poseTransform.frontY = front.y;
+		poseTransform.corners = Corners{ rotate( wxPoint( x, y)),
+										 rotate( wxPoint( x + size.x, y)),
+										 rotate( wxPoint( x, y + size.y)),
+										 rotate( wxPoint( x + size.x, y + size.y)) };
+		return poseTransform.corners;
 	}
 	/**
 	 *
@@ -429,131 +605,103 @@ namespace Model
 	/**
 	 *
 	 */
-	std::vector<int> Robot::getNumbersFromString(std::string stringWithNumbers)
+	void Robot::syncWorld(std::string_view aWorldInfo)
 	{
-		std::vector<int> numbers;
-		std::string result;
-		std::istringstream numberStream(stringWithNumbers);
+		RobotWorld& robotWorld = RobotWorld::getRobotWorld();
 
-		while (std::getline(numberStream, result, ','))
+		std::vector<std::pair<wxPoint, wxPoint>> newWalls;
+		std::size_t numberOfGoals = 0;
+		std::size_t errors = 0;
 		{
-			numbers.push_back(stoi(result));
+			// The observers are notified once, of the whole world
+			RobotWorld::Transaction transaction(robotWorld);
+
+			newWalls.reserve(static_cast<std::size_t>(std::count(aWorldInfo.begin(), aWorldInfo.end(), '_')) + 1);
+
+			errors = WorldInfoParser::parse(aWorldInfo,
+											[&newWalls](const wxPoint& aPoint1, const wxPoint& aPoint2)
+											{
+												newWalls.emplace_back(aPoint1, aPoint2);
+											},
+											[&robotWorld, &numberOfGoals](const wxPoint& aPosition)
+											{
+												robotWorld.newGoal("A", aPosition, false);
+												++numberOfGoals;
+											},
+											[this](const WorldInfoParser::RobotInfo& aRobotInfo)
+											{
+												syncRobot(aRobotInfo, true);
+											});
+			robotWorld.newWalls(newWalls, false);
 		}
-		return numbers;
+
+		Application::Logger::log("World synced: " + std::to_string(newWalls.size()) + " walls, " + std::to_string(numberOfGoals) + " goals, " + std::to_string(errors) + " errors");
 	}
 	/**
 	 *
 	 */
-	void Robot::syncWalls(std::string& wallString)
+	void Robot::syncRobot(std::string_view aRobotString)
 	{
-		const std::regex word("(Walls)");
-		std::stringstream wallRegexStream;
-    	std::regex_replace(std::ostream_iterator<char>(wallRegexStream), wallString.begin(), wallString.end(), word, "");
-		wallString = wallRegexStream.str();
-
-		std::string result;
-		std::istringstream wallStream(wallString);
-
-		int x1, y1, x2, y2;
-
-		while (std::getline(wallStream, result, '_'))
+		if (aRobotString.substr(0, 5) == "Robot") // @suppress("Avoid magic numbers")
 		{
-			std::vector<int> coordinates = getNumbersFromString(result);
-			
-			x1 = coordinates[0];
-			y1 = coordinates[1];
-			x2 = coordinates[2];
-			y2 = coordinates[3];
-
-			RobotWorld::getRobotWorld().newWall(wxPoint(x1, y1), wxPoint(x2, y2));
-			Application::Logger::log("Wall created at " + std::to_string(x1) + "," + std::to_string(y1) + " and " + std::to_string(x2) + "," + std::to_string(y2));
+			aRobotString.remove_prefix(5); // @suppress("Avoid magic numbers")
 		}
-	}
-	/**
-	 *
-	 */
-	void Robot::syncGoals(std::string& goalString)
-	{
-		const std::regex word("(Goals)");
-		std::stringstream goalRegexStream;
-    	std::regex_replace(std::ostream_iterator<char>(goalRegexStream), goalString.begin(), goalString.end(), word, "");
-		goalString = goalRegexStream.str();
-
-		std::string result;
-		std::istringstream goalStream(goalString);
 
-		int x, y;
-
-		while (std::getline(goalStream, result, '_'))
+		WorldInfoParser::RobotInfo robotInfo;
+		if (!WorldInfoParser::parseRobot(aRobotString, robotInfo))
 		{
-			std::vector<int> coordinates = getNumbersFromString(result);
+			Application::Logger::log("Robot could not be parsed: " + std::string(aRobotString));
+			return;
+		}
 
-			x = coordinates[0];
-			y = coordinates[1];
-			RobotWorld::getRobotWorld().newGoal("A", wxPoint(x, y));
+		RobotPtr robot = syncRobot(robotInfo, false);
+		if (robot && !isDriving())
+		{
+			robot->notifyObservers();
 		}
 	}
 	/**
 	 *
 	 */
-	void Robot::syncRobot(std::string& robotString)
+	RobotPtr Robot::syncRobot(	const WorldInfoParser::RobotInfo& aRobotInfo,
+								bool anAddIfUnknown)
 	{
-		const std::regex word("(Robot)");
-		std::stringstream robotRegexStream;
-		std::regex_replace(std::ostream_iterator<char>(robotRegexStream), robotString.begin(), robotString.end(), word, "");
-		robotString = robotRegexStream.str();
-
-		std::string result;
-		std::istringstream robotStream(robotString);
+		RobotWorld& robotWorld = RobotWorld::getRobotWorld();
 
-		int x, y, fx, fy;
-
-		std::vector<int> coordinates = getNumbersFromString(robotString);
-		x = coordinates[0];
-		y = coordinates[1];
-		fx = coordinates[2];
-		fy = coordinates[3];
-		const std::vector<RobotPtr>& robots = RobotWorld::getRobotWorld().getRobots();
 		RobotPtr robot;
-		if (robots.size() > 1)
+		if (!aRobotInfo.objectId.empty())
 		{
-			robot = robots[1];
+			robot = robotWorld.getRobot(Base::ObjectId::fromWireString(std::string(aRobotInfo.objectId)));
 		}
-		if(!robot)
+		if (!robot && anAddIfUnknown && robotWorld.getRobots().size() == 1)
 		{
-			Application::Logger::log("Robot not found");
+			// The ObjectId is given before the robot is registered, the world and the views use it as key.
+			// Only the one remote robot is added, so interning the ObjectId of an older peer is bounded.
+			Base::ObjectId objectId = aRobotInfo.objectId.empty() ? Base::ObjectId() : Base::ObjectId(std::string(aRobotInfo.objectId));
+			robot = robotWorld.newRobot("Robot", aRobotInfo.position, false, objectId);
+			robot->setRemote(true);
+			return robot;
 		}
-		else
+		if (!robot)
 		{
-			Application::Logger::log("Moving robot: " + robot->asString());
-			robot->setPosition(wxPoint(x, y), false);
-			robot->setFront(BoundedVector(fx, fy), false);
-
-			if (!driving)
+			// Peers that do not send the ObjectId of their robot: the remote robot is the second one
+			const std::vector<RobotPtr>& robots = robotWorld.getRobots();
+			if (robots.size() > 1)
 			{
-				robot->notifyObservers();
+				robot = robots[1];
 			}
 		}
-	}
-	/**
-	 *
-	 */
-	void Robot::addNewRobot(std::string& robotString)
-	{
-		const std::regex word("(Robot)");
-		std::stringstream robotRegexStream;
-		std::regex_replace(std::ostream_iterator<char>(robotRegexStream), robotString.begin(), robotString.end(), word, "");
-		robotString = robotRegexStream.str();
 
-		std::string result;
-		std::istringstream robotStream(robotString);
-
-		int x, y;
-
-		std::vector<int> coordinates = getNumbersFromString(robotString);
-		x = coordinates[0];
-		y = coordinates[1];
-		RobotWorld::getRobotWorld().newRobot("Robot", wxPoint(x, y));
+		if(!robot)
+		{
+			Application::Logger::log("Robot not found");
+		}
+		else
+		{
+			robot->setPosition(aRobotInfo.position, false);
+			robot->setFront(aRobotInfo.front, false);
+		}
+		return robot;
 	}
 	/**
 	 *
@@ -589,42 +737,56 @@ namespace Model
 
 				aMessage.setMessageType(Messaging::SyncWorldResponse);
 				aMessage.setBody(response);
-				Application::Logger::log(syncmessage);
-				std::string result = "";
-				std::istringstream goalStream(syncmessage);
-				while (std::getline(goalStream, result, ';'))
+				// The response still carries the flags of the request
+				Messaging::Compression::compressFor(aMessage, aMessage);
+				syncWorld(syncmessage);
+
+				break;
+			}
+			case Messaging::SyncWorldChunkRequest:
+			{
+				std::string chunk = aMessage.getBody();
+				WorldSyncChunkHeader header;
+				std::string_view worldInfo;
+				if (!header.fromString(chunk, worldInfo))
 				{
-					if (result.find("Walls") != std::string::npos)
-					{
-						syncWalls(result);
-					}
-					if (result.find("Goals") != std::string::npos)
-					{
-						syncGoals(result);
-					}
-					if (result.find("Robot") != std::string::npos)
-					{
-						if(RobotWorld::getRobotWorld().getRobots().size() == 1)
-						{
-							addNewRobot(result);
-						}
-						else{
-							syncRobot(result);
-						}
-					}
+					TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": malformed world chunk"));
+					aMessage.setMessageType(Messaging::SyncWorldChunkResponse);
+					aMessage.setBody("0");
+					break;
 				}
+				// Every chunk is a complete fragment so it is applied as soon as it comes in
+				syncWorld(worldInfo);
 
+				bool streamComplete = worldSyncReceiver.chunkReceived(header);
+
+				aMessage.setMessageType(Messaging::SyncWorldChunkResponse);
+				aMessage.setBody(std::to_string(header.streamId) + "," + std::to_string(header.chunkIndex));
+
+				if (streamComplete && header.replyRequested)
+				{
+					startWorldSync(false);
+				}
 				break;
 			}
 			case::Messaging::SyncRobotRequest:
 			{
-				std::string syncmessage = aMessage.getBody();
-				if (syncmessage.find("Robot") != std::string::npos)
+				if (aMessage.message.find("Robot") != std::string::npos)
 				{
-					syncRobot(syncmessage);
+					syncRobot(aMessage.message);
 				}
 				break;
 			}
+			case::Messaging::SyncRobotFrameRequest:
+			{
+				RobotStateFrame frame = RobotStateFrame::fromMessageBody(aMessage.getBody());
+				// While driving the drive loop notifies the remote robots already
+				RobotWorld::getRobotWorld().applyRobotStateFrame(frame, !isDriving());
+
+				aMessage.setMessageType(Messaging::SyncRobotFrameResponse);
+				aMessage.setBody(std::to_string(frame.getRobotStates().size()));
+				break;
+			}
 			case::Messaging::StartRobotRequest:
 			{
 				startActing();
@@ -657,36 +819,22 @@ namespace Model
 			}
 			case Messaging::SyncWorldResponse:
 			{
-				std::string syncmessage = aMessage.getBody();
-				std::string result = "";
-				std::istringstream goalStream(syncmessage);
-				while (std::getline(goalStream, result, ';'))
-				{
-					if (result.find("Walls") != std::string::npos)
-					{
-						syncWalls(result);
-					}
-					if (result.find("Goals") != std::string::npos)
-					{
-						syncGoals(result);
-					}
-					if (result.find("Robot") != std::string::npos)
-					{
-						if(RobotWorld::getRobotWorld().getRobots().size() == 1)
-						{
-							addNewRobot(result);
-						}
-						else{
-							syncRobot(result);
-						}
-					}
-				}
+				syncWorld(aMessage.message);
+				break;
+			}
+			case Messaging::SyncWorldChunkResponse:
+			{
+				// The chunks are dispatched with a response function of their WorldSyncSender
 				break;
 			}
 			case Messaging::SyncRobotResponse:
 			{
 				break;
 			}
+			case Messaging::SyncRobotFrameResponse:
+			{
+				break;
+			}
 			default:
 			{
 				TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": default not implemented, ") + aMessage.asString());
@@ -701,7 +849,7 @@ namespace Model
 	{
 		std::ostringstream os;
 
-		os << "Robot " << name << " at (" << position.x << "," << position.y << ")";
+		os << "Robot " << name << " at (" << getPosition().x << "," << getPosition().y << ")";
 
 		return os.str();
 	}
@@ -713,34 +861,33 @@ namespace Model
 		std::ostringstream os;
 
 		os << "Robot:\n";
-		os << "Robot " << name << " at (" << position.x << "," << position.y << ")\n";
+		os << "Robot " << name << " at (" << getPosition().x << "," << getPosition().y << ")\n";
 
 		return os.str();
 	}
 	/**
 	 *
 	 */
-	void Robot::sendRobotPosMessage() 
+	void Robot::sendRobotStateFrame()
 	{
-		std::string message = "Robot" + std::to_string(position.x) + "," + std::to_string(position.y) + "," + std::to_string(front.x) + "," + std::to_string(front.y);
-		Messaging::Message msg( Messaging::SyncRobotRequest, message);
-		Model::RobotPtr robot = Model::RobotWorld::getRobotWorld().getRobot(name);
-		if(robot){	
-			std::string remoteIpAdres = "localhost";
-			std::string remotePort = "12345";
-			
-			if (Application::MainApplication::isArgGiven( "-remote_ip"))
-			{
-				remoteIpAdres = Application::MainApplication::getArg( "-remote_ip").value;
-			}
-			if (Application::MainApplication::isArgGiven( "-remote_port"))
-			{
-				remotePort = Application::MainApplication::getArg( "-remote_port").value;
-			}
-			if(robot){
-				Messaging::Client c1ient(remoteIpAdres, static_cast<unsigned short>(std::stoi(remotePort)),robot);
-				c1ient.dispatchMessage( msg);
-			}
+		// Only the first acting robot that is owned by this world sends the frame for all of them
+		WorldSnapshotPtr worldSnapshot = RobotWorld::getRobotWorld().getSnapshot();
+		const std::vector<RobotPtr>& robots = worldSnapshot->getRobots();
+		auto sender = std::find_if(robots.begin(), robots.end(), [](RobotPtr aRobot){ return aRobot && !aRobot->isRemote() && aRobot->isActing();});
+		if (sender == robots.end() || (*sender).get() != this)
+		{
+			return;
+		}
+
+		RobotStateFrame frame = RobotStateFrame::fromWorld();
+		Messaging::Message msg( Messaging::SyncRobotFrameRequest, frame.asMessageBody());
+		if (isPoseTransportDatagram())
+		{
+			// A lost frame is not sent again, the next frame replaces it anyway
+			getDatagramClient()->dispatchMessage( msg);
+		} else
+		{
+			getRemoteClient()->dispatchMessage( msg);
 		}
 	}
 	/**
@@ -751,33 +898,33 @@ namespace Model
 		try
 		{
 			// The runtime value always wins!!
-			speed = static_cast<float>(Application::MainApplication::getSettings().getSpeed());
+			setSpeed(static_cast<float>(Application::MainApplication::getSettings().getSpeed()), false);
 
 			// Compare a float/double with another float/double: use epsilon...
-			if (std::fabs(speed - 0.0) <= std::numeric_limits<float>::epsilon())
+			if (std::fabs(getSpeed() - 0.0) <= std::numeric_limits<float>::epsilon())
 			{
 				setSpeed(10.0, false); // @suppress("Avoid magic numbers")
 			}
 
 			// We use the real position for starters, not an estimated position.
-			startPosition = position;
+			startPosition = getPosition();
 
 			unsigned pathPoint = 0;
-			while (position.x > 0 && position.x < 500 && position.y > 0 && position.y < 500 && pathPoint < path.size()) // @suppress("Avoid magic numbers")
+			for (wxPoint position = getPosition(); position.x > 0 && position.x < 500 && position.y > 0 && position.y < 500 && pathPoint < path.size(); position = getPosition()) // @suppress("Avoid magic numbers")
 			{
 				// Do the update
-				const PathAlgorithm::Vertex& vertex = path[pathPoint+=static_cast<unsigned int>(speed)];
-				front = BoundedVector( vertex.asPoint(), position);
-				position.x = vertex.x;
-				position.y = vertex.y;
-				sendRobotPosMessage();
+				const PathAlgorithm::Vertex& vertex = path[pathPoint+=static_cast<unsigned int>(getSpeed())];
+				stateTable->setFront( stateIndex, BoundedVector( vertex.asPoint(), position));
+				stateTable->setPosition( stateIndex, vertex.asPoint());
+				RobotWorld::getRobotWorld().updateSpatialIndex( *this);
+				sendRobotStateFrame();
 
 				if (closeToOtherRobot(ROBOT_WARNING_DISTANCE) && !almostCollided)
 				{
 					almostCollided = true;
 					if (worldSyncer)
 					{
-						driving = false;
+						stateTable->setDriving( stateIndex, false);
 						startDriving();
 					}
 					else
@@ -795,13 +942,14 @@ namespace Model
 				if (arrived(goal) || collision())
 				{
 					Application::Logger::log(__PRETTY_FUNCTION__ + std::string(": arrived or collision"));
-					driving = false;
+					stateTable->setDriving( stateIndex, false);
 					almostCollided = false;
 					worldSyncer = false;
 				}
 
 				notifyObservers();
-				const std::vector<RobotPtr>& robots = RobotWorld::getRobotWorld().getRobots();
+				WorldSnapshotPtr worldSnapshot = RobotWorld::getRobotWorld().getSnapshot();
+				const std::vector<RobotPtr>& robots = worldSnapshot->getRobots();
 				RobotPtr remoteRobot;
 				if (robots.size() > 1)
 				{
@@ -817,11 +965,11 @@ namespace Model
 				std::this_thread::sleep_for( std::chrono::milliseconds( 100)); // @suppress("Avoid magic numbers")
 
 				// this should be the last thing in the loop
-				if(driving == false)
+				if(isDriving() == false)
 				{
 					break;
 				}
-			} // while
+			} // for
 		}
 		catch (std::exception& e)
 		{
@@ -845,9 +993,9 @@ namespace Model
 			// Turn off logging if not debugging AStar
 			Application::Logger::setDisable();
 
-			front = BoundedVector( aGoal->getPosition(), position);
+			stateTable->setFront( stateIndex, BoundedVector( aGoal->getPosition(), getPosition()));
 			//handleNotificationsFor( astar);
-			path = astar.search( position, aGoal->getPosition(), size);
+			path = astar.search( getPosition(), aGoal->getPosition(), getSize());
 			//stopHandlingNotificationsFor( astar);
 
 			Application::Logger::setDisable( false);
@@ -858,7 +1006,7 @@ namespace Model
 	 */
 	bool Robot::arrived(GoalPtr aGoal)
 	{
-		if (aGoal && intersects( aGoal->getRegion()))
+		if (aGoal && intersects( aGoal->getOrientedBox()))
 		{
 			return true;
 		}
@@ -869,22 +1017,29 @@ namespace Model
 	 */
 	bool Robot::collision()
 	{
-		wxPoint frontLeft = getFrontLeft();
-		wxPoint frontRight = getFrontRight();
-		wxPoint backLeft = getBackLeft();
-		wxPoint backRight = getBackRight();
-
-		const std::vector< WallPtr >& walls = RobotWorld::getRobotWorld().getWalls();
+		Corners corners = getCorners();
+		const wxPoint& frontLeft = corners.frontLeft;
+		const wxPoint& frontRight = corners.frontRight;
+		const wxPoint& backLeft = corners.backLeft;
+		const wxPoint& backRight = corners.backRight;
+
+		// Only the walls and robots that overlap the bounding box of the robot can collide with it
+		SpatialIndex::Bounds bounds = SpatialIndex::Bounds::of( frontLeft, backRight).include( frontRight).include( backLeft);
+
+		const std::vector< WallPtr > walls = RobotWorld::getRobotWorld().getWallsIn( bounds);
+		Utils::LineSegmentBatch wallLines;
+		wallLines.reserve( walls.size());
 		for (WallPtr wall : walls)
 		{
-			if (Utils::Shape2DUtils::intersect( frontLeft, frontRight, wall->getPoint1(), wall->getPoint2()) 	||
-				Utils::Shape2DUtils::intersect( frontLeft, backLeft, wall->getPoint1(), wall->getPoint2())		||
-				Utils::Shape2DUtils::intersect( frontRight, backRight, wall->getPoint1(), wall->getPoint2()))
-			{
-				return true;
-			}
+			wallLines.add( wall->getPoint1(), wall->getPoint2());
+		}
+		if (Utils::Shape2DUtils::intersectsAny( frontLeft, frontRight, wallLines) ||
+			Utils::Shape2DUtils::intersectsAny( frontLeft, backLeft, wallLines) ||
+			Utils::Shape2DUtils::intersectsAny( frontRight, backRight, wallLines))
+		{
+			return true;
 		}
-		const std::vector< RobotPtr >& robots = RobotWorld::getRobotWorld().getRobots();
+		const std::vector< RobotPtr > robots = RobotWorld::getRobotWorld().getRobotsIn( bounds);
 		for (RobotPtr robot : robots)
 		{
 			if(robot){		
@@ -892,7 +1047,7 @@ namespace Model
 				{
 					continue;
 				}
-				if(intersects(robot->getRegion()))
+				if(intersects(robot->getOrientedBox()))
 				{
 					return true;
 				}
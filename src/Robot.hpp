@@ -9,14 +9,19 @@
 #include "MessageHandler.hpp"
 #include "ModelObject.hpp"
 #include "Observer.hpp"
+#include "OrientedBox.hpp"
 #include "Point.hpp"
-#include "Region.hpp"
+#include "RobotStateTable.hpp"
 #include "Size.hpp"
+#include "WorldInfoParser.hpp"
+#include "WorldSync.hpp"
 
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
 
 #define ROBOT_WARNING_DISTANCE 100
@@ -27,6 +32,14 @@ namespace Messaging
 	class Message;
 	class Server;
 	typedef std::shared_ptr< Server > ServerPtr;
+	class PipelinedClient;
+	typedef std::shared_ptr< PipelinedClient > PipelinedClientPtr;
+	class DatagramServer;
+	typedef std::shared_ptr< DatagramServer > DatagramServerPtr;
+	class DatagramClient;
+	typedef std::shared_ptr< DatagramClient > DatagramClientPtr;
+	class RequestDispatcher;
+	typedef std::shared_ptr< RequestDispatcher > RequestDispatcherPtr;
 }
 
 namespace Model
@@ -58,6 +71,12 @@ namespace Model
 			 */
 			Robot(	const std::string& aName,
 					const wxPoint& aPosition);
+			/**
+			 * A robot with the ObjectId of a robot of another world
+			 */
+			Robot(	const std::string& aName,
+					const wxPoint& aPosition,
+					const Base::ObjectId& anObjectId);
 			/**
 			 *
 			 */
@@ -88,7 +107,7 @@ namespace Model
 			 */
 			wxPoint getPosition() const
 			{
-				return position;
+				return stateTable->getPosition( stateIndex);
 			}
 			/**
 			 *
@@ -119,7 +138,7 @@ namespace Model
 			 */
 			bool isActing() const
 			{
-				return acting;
+				return stateTable->isActing( stateIndex);
 			}
 			/**
 			 *
@@ -135,7 +154,7 @@ namespace Model
 			 */
 			bool isDriving() const
 			{
-				return driving;
+				return stateTable->isDriving( stateIndex);
 			}
 			/**
 			 *
@@ -153,6 +172,29 @@ namespace Model
 			{
 				return communicating;
 			}
+			/**
+			 *
+			 * @return true if this robot is a copy of a robot that is owned by a remote world
+			 */
+			bool isRemote() const
+			{
+				return stateTable->isRemote( stateIndex);
+			}
+			/**
+			 *
+			 */
+			void setRemote( bool aRemote)
+			{
+				stateTable->setRemote( stateIndex, aRemote);
+			}
+			/**
+			 *
+			 * @return The index of the row of this robot in the RobotStateTable of RobotWorld
+			 */
+			RobotStateTable::Index getStateIndex() const
+			{
+				return stateIndex;
+			}
 			/**
 			 * Starts a ServerConnection that listens at port 12345 unless given
 			 * an other port by specifying a command line argument -local_port=port
@@ -172,11 +214,11 @@ namespace Model
 			/**
 			 *
 			 */
-			wxRegion getRegion() const;
+			Utils::OrientedBox getOrientedBox() const;
 			/**
 			 *
 			 */
-			bool intersects( const wxRegion& aRegion) const;
+			bool intersects( const Utils::OrientedBox& anOrientedBox) const;
 			/**
 			 * Returns true if the distance between the midpoint of this robot and another robot is smaller than a certain maximum; false if not
 			 */
@@ -201,6 +243,21 @@ namespace Model
 			 *
 			 */
 			wxPoint getBackRight() const;
+			/**
+			 * The corners of the robot, rotated to its front
+			 */
+			struct Corners
+			{
+					wxPoint frontLeft;
+					wxPoint frontRight;
+					wxPoint backLeft;
+					wxPoint backRight;
+			};
+			/**
+			 * The corners are computed once per pose, as long as the position, size and front do not change
+			 * the cached corners are returned
+			 */
+			Corners getCorners() const;
 			/**
 			 * @name Observer functions
 			 */
@@ -267,21 +324,12 @@ namespace Model
 			wxPoint startPosition;
 			//@}
 			/**
-			 * Extracts the numbers from a string if they are separated by commas
-			 * @param stringWithNumbers The string to extract the numbers from
-			 * @return A vector of numbers extracted from the string
-			 */
-			std::vector<int> getNumbersFromString(std::string stringWithNumbers);
-			/**
-			 * Puts the goal(s) from another robotworld in the current robotworld
-			 * @param goalString The position(s) of the goal(s) from another world
-			 */
-			void syncGoals(std::string& goalString);
-			/**
-			 * Puts the wall(s) from another robotworld in the current robotworld
-			 * @param wallString The position(s) of the wall(s) from another world
+			 * Puts the walls, goals and robot of another robotworld in the current robotworld.
+			 * The observers of RobotWorld are notified once, after everything is put in.
+			 *
+			 * @param aWorldInfo The world info of another world as produced by getWorldInfo
 			 */
-			void syncWalls(std::string& wallString);
+			void syncWorld(std::string_view aWorldInfo);
 			/**
 			 * Puts the positions of the goals, walls, and robots of the current world into a string
 			 * @return The string with the information of the world
@@ -289,80 +337,112 @@ namespace Model
 			std::string getWorldInfo();
 			/**
 			 * Syncs the robot after a request
-			 * @param robotString The position and rotation of the robot
+			 * @param aRobotString The position and rotation of the robot
 			 */
-			void syncRobot(std::string& robotString);
+			void syncRobot(std::string_view aRobotString);
 		protected:
 			/**
-			 * Adds a robot based on the info from a client server message
-			 * @param robotString A string that contains the info of the robot
+			 * Syncs the robot with the ObjectId of the given robot info, or the remote robot if no ObjectId is given.
+			 * Does not notify any observers.
+			 *
+			 * @param aRobotInfo The parsed robot info
+			 * @param anAddIfUnknown If true the robot is added as a remote robot if there is only one robot in this world
+			 * @return The synced or added robot, nullptr if there is no such robot
 			 */
-			void addNewRobot(std::string& robotString);
+			RobotPtr syncRobot(	const WorldInfoParser::RobotInfo& aRobotInfo,
+								bool anAddIfUnknown);
 			/**
-			 * Sends the position of the robot over and over
+			 * Sends the poses of all robots owned by this world in one SyncRobotFrameRequest.
+			 * Only the first acting robot owned by this world sends the frame, so there is one
+			 * message per tick per peer regardless of the number of robots.
 			 */
-			void sendRobotPosMessage();
+			void sendRobotStateFrame();
 			/**
+			 * Streams the world to the remote world in SyncWorldChunkRequests
 			 *
+			 * @param aReplyRequested If true the remote world streams its world back after the last chunk
 			 */
-			void drive();
+			void startWorldSync(bool aReplyRequested);
 			/**
-			 *
+			 * Called when worldSyncSender is finished or failed, starts the queued world sync if any
 			 */
-			void calculateRoute( GoalPtr aGoal);
+			void worldSyncFinished(bool aSucceeded);
 			/**
+			 * The client is created at the first call and sends all messages to the remote world
+			 * over one connection, given by the command line arguments -remote_ip and -remote_port.
 			 *
+			 * @return The client for the messages to the remote world
 			 */
-			bool arrived( GoalPtr aGoal);
+			Messaging::PipelinedClientPtr getRemoteClient();
 			/**
+			 * The poses are sent over UDP if the command line argument -pose_transport=udp is given, over
+			 * the TCP connection of getRemoteClient otherwise. Both worlds should use the same setting.
 			 *
+			 * @return true if the poses are sent over UDP
 			 */
-			bool collision();
+			static bool isPoseTransportDatagram();
 			/**
-			*
+			 *
+			 * @return The client for the poses that are sent over UDP
 			 */
-
-		private:
+			Messaging::DatagramClientPtr getDatagramClient();
 			/**
 			 *
 			 */
-			std::string name;
+			void drive();
 			/**
 			 *
 			 */
-			wxSize size;
+			void calculateRoute( GoalPtr aGoal);
 			/**
 			 *
 			 */
-			wxPoint position;
+			bool arrived( GoalPtr aGoal);
 			/**
 			 *
 			 */
-			BoundedVector front;
+			bool collision();
 			/**
-			 *
+			*
 			 */
-			float speed;
+
+		private:
 			/**
 			 *
 			 */
-			GoalPtr goal;
+			std::string name;
 			/**
-			 *
+			 * The pose, kinematics and the acting, driving and remote flags are in the RobotStateTable of RobotWorld
 			 */
-			PathAlgorithm::AStar astar;
+			RobotStateTablePtr stateTable;
+			RobotStateTable::Index stateIndex;
+			/**
+			 * The pose the corners were computed for. The drive loop writes the pose in the table directly,
+			 * so the cache is checked against the pose in the table instead of being reset by the setters.
+			 */
+			struct PoseTransform
+			{
+					bool valid = false;
+					wxPoint position;
+					wxSize size;
+					double frontX = 0.0;
+					double frontY = 0.0;
+					Corners corners;
+			};
+			mutable PoseTransform poseTransform;
+			mutable std::mutex poseTransformBusy;
 			/**
 			 *
 			 */
-			PathAlgorithm::Path path;
+			GoalPtr goal;
 			/**
 			 *
 			 */
-			bool acting;
+			PathAlgorithm::AStar astar;
 			/**
 			 *
 			 */
-			bool driving;
+			PathAlgorithm::Path path;
 			/**
 			 *
 			 */
@@ -375,6 +455,20 @@ namespace Model
 			 * True if 'Sync world' has been pressed in the application before driving, false if not.
 			 */
 			bool worldSyncer;
+			/**
+			 * The outgoing world stream, if any
+			 */
+			WorldSyncSenderPtr worldSyncSender;
+			/**
+			 * A world sync that is started while worldSyncSender is still in flight waits until that one is
+			 * finished, the value is its aReplyRequested
+			 */
+			std::optional< bool > queuedWorldSync;
+			std::mutex worldSyncMutex;
+			/**
+			 * Keeps track of the incoming world streams
+			 */
+			WorldSyncReceiver worldSyncReceiver;
 			/**
 			 *
 			 */
@@ -387,6 +481,22 @@ namespace Model
 			 *
 			 */
 			Messaging::ServerPtr server;
+			/**
+			 * Handles the requests of the server on its own thread so the model updates do not block the network
+			 */
+			Messaging::RequestDispatcherPtr requestDispatcher;
+			/**
+			 *
+			 */
+			Messaging::PipelinedClientPtr remoteClient;
+			/**
+			 * Receives the poses if they are sent over UDP
+			 */
+			Messaging::DatagramServerPtr datagramServer;
+			/**
+			 *
+			 */
+			Messaging::DatagramClientPtr datagramClient;
 	};
 } // namespace Model
 #endif // ROBOT_HPP_
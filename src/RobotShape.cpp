@@ -95,7 +95,8 @@ namespace View
 	 */
 	bool RobotShape::occupies( const wxPoint& aPoint) const
 	{
-		wxPoint cornerPoints[] = { getRobot()->getFrontRight(), getRobot()->getFrontLeft(), getRobot()->getBackLeft(), getRobot()->getBackRight() };
+		Model::Robot::Corners corners = getRobot()->getCorners();
+		wxPoint cornerPoints[] = { corners.frontRight, corners.frontLeft, corners.backLeft, corners.backRight };
 		return Utils::Shape2DUtils::isInsidePolygon( cornerPoints, 4, aPoint);
 	}
 	/**
@@ -213,7 +214,8 @@ namespace View
 		{
 			dc.SetPen( wxPen( getNormalColour(), borderWidth, wxPENSTYLE_SOLID));
 		}
-		wxPoint cornerPoints[] = { getRobot()->getFrontRight(), getRobot()->getFrontLeft(), getRobot()->getBackLeft(), getRobot()->getBackRight() };
+		Model::Robot::Corners corners = getRobot()->getCorners();
+		wxPoint cornerPoints[] = { corners.frontRight, corners.frontLeft, corners.backLeft, corners.backRight };
 		dc.DrawPolygon( 4, cornerPoints);
 
 		dc.SetPen( wxPen(  "RED", borderWidth + 2, wxPENSTYLE_SOLID));
@@ -0,0 +1,123 @@
+#include "RobotStateFrame.hpp"
+
+#include "Logger.hpp"
+#include "Robot.hpp"
+#include "RobotWorld.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace Model
+{
+	/**
+	 *
+	 */
+	/* static */RobotStateFrame RobotStateFrame::fromWorld()
+	{
+		RobotStateFrame frame;
+		// Streams through the columns of the state table instead of visiting the robots
+		auto addOwnedRobots = [&frame](	const RobotStateTable::Block& aBlock,
+										std::size_t aNumberOfRows)
+		{
+			for (std::size_t row = 0; row < aNumberOfRows; ++row)
+			{
+				if (aBlock.inWorld[row] && !aBlock.remote[row])
+				{
+					frame.addRobotState( RobotState( aBlock.objectId[row],
+													 wxPoint( aBlock.positionX[row], aBlock.positionY[row]),
+													 BoundedVector( aBlock.frontX[row], aBlock.frontY[row])));
+				}
+			}
+		};
+		RobotWorld::getRobotWorld().getRobotStateTable()->forEachBlock( addOwnedRobots);
+		return frame;
+	}
+	/**
+	 *
+	 */
+	/* static */RobotStateFrame RobotStateFrame::fromMessageBody( const std::string& aMessageBody)
+	{
+		RobotStateFrame frame;
+
+		std::string body = aMessageBody;
+		if (body.compare( 0, 5, "Frame") == 0) // @suppress("Avoid magic numbers")
+		{
+			body.erase( 0, 5); // @suppress("Avoid magic numbers")
+		}
+
+		std::string record;
+		std::istringstream recordStream( body);
+		while (std::getline( recordStream, record, '_'))
+		{
+			try
+			{
+				std::vector< std::string > fields;
+				std::string field;
+				std::istringstream fieldStream( record);
+				while (std::getline( fieldStream, field, ','))
+				{
+					fields.push_back( field);
+				}
+				if (fields.size() != 5) // @suppress("Avoid magic numbers")
+				{
+					Application::Logger::log( __PRETTY_FUNCTION__ + std::string( ": skipping malformed record ") + record);
+					continue;
+				}
+				// Text that is neither an ObjectId nor interned here cannot match a robot, the record is skipped
+				Base::ObjectId objectId = Base::ObjectId::fromWireString( fields[4]);
+				if (objectId.isNull())
+				{
+					continue;
+				}
+				frame.addRobotState( RobotState( objectId,
+												 wxPoint( std::stoi( fields[0]), std::stoi( fields[1])),
+												 BoundedVector( std::stod( fields[2]), std::stod( fields[3]))));
+			}
+			catch (std::exception& e)
+			{
+				Application::Logger::log( __PRETTY_FUNCTION__ + std::string( ": skipping record ") + record + ", " + e.what());
+			}
+		}
+		return frame;
+	}
+	/**
+	 *
+	 */
+	std::string RobotStateFrame::asMessageBody() const
+	{
+		std::ostringstream os;
+		os << "Frame";
+		for (std::size_t i = 0; i < robotStates.size(); ++i)
+		{
+			const RobotState& robotState = robotStates[i];
+			if (i > 0)
+			{
+				os << '_';
+			}
+			os << robotState.position.x << "," << robotState.position.y << "," << robotState.front.x << "," << robotState.front.y << "," << robotState.objectId;
+		}
+		return os.str();
+	}
+	/**
+	 *
+	 */
+	std::string RobotStateFrame::asString() const
+	{
+		std::ostringstream os;
+		os << "RobotStateFrame with " << robotStates.size() << " robot(s)";
+		return os.str();
+	}
+	/**
+	 *
+	 */
+	std::string RobotStateFrame::asDebugString() const
+	{
+		std::ostringstream os;
+		os << asString() << ":\n";
+		for (const RobotState& robotState : robotStates)
+		{
+			os << robotState.objectId << " at (" << robotState.position.x << "," << robotState.position.y << ")\n";
+		}
+		return os.str();
+	}
+} // namespace Model
@@ -0,0 +1,108 @@
+#ifndef ROBOTSTATEFRAME_HPP_
+#define ROBOTSTATEFRAME_HPP_
+
+#include "Config.hpp"
+
+#include "BoundedVector.hpp"
+#include "ObjectId.hpp"
+#include "Point.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Model
+{
+	/**
+	 * The pose of one robot as it is transported in a RobotStateFrame
+	 */
+	struct RobotState
+	{
+			/**
+			 *
+			 */
+			RobotState() = default;
+			/**
+			 *
+			 */
+			RobotState(	const Base::ObjectId& anObjectId,
+						const wxPoint& aPosition,
+						const BoundedVector& aFront) :
+							objectId( anObjectId),
+							position( aPosition),
+							front( aFront)
+			{
+			}
+
+			Base::ObjectId objectId;
+			wxPoint position;
+			BoundedVector front;
+	};
+
+	/**
+	 * A RobotStateFrame packs the poses of all robots that are owned by this world into one message body.
+	 * Instead of one SyncRobotRequest per robot per tick, one SyncRobotFrameRequest per peer per tick is sent.
+	 *
+	 * The body format is "Frame" followed by '_' separated records "x,y,frontX,frontY,objectId".
+	 */
+	class RobotStateFrame
+	{
+		public:
+			/**
+			 *
+			 */
+			RobotStateFrame() = default;
+			/**
+			 *
+			 * @return A frame with the poses of all robots in RobotWorld that are not a copy of a remote robot
+			 */
+			static RobotStateFrame fromWorld();
+			/**
+			 *
+			 * @param aMessageBody A body as produced by RobotStateFrame::asMessageBody
+			 * @return The frame described by aMessageBody, records that cannot be parsed are skipped
+			 */
+			static RobotStateFrame fromMessageBody( const std::string& aMessageBody);
+			/**
+			 *
+			 */
+			void addRobotState( const RobotState& aRobotState)
+			{
+				robotStates.push_back( aRobotState);
+			}
+			/**
+			 *
+			 */
+			const std::vector< RobotState >& getRobotStates() const
+			{
+				return robotStates;
+			}
+			/**
+			 *
+			 */
+			bool empty() const
+			{
+				return robotStates.empty();
+			}
+			/**
+			 *
+			 * @return The ASCII representation suitable for parsing by RobotStateFrame::fromMessageBody
+			 */
+			std::string asMessageBody() const;
+			/**
+			 * @name Debug functions
+			 */
+			//@{
+			/**
+			 * Returns a 1-line description of the object
+			 */
+			std::string asString() const;
+			/**
+			 * Returns a description of the object with all data of the object usable for debugging
+			 */
+			std::string asDebugString() const;
+			//@}
+		private:
+			std::vector< RobotState > robotStates;
+	};
+} // namespace Model
+#endif // ROBOTSTATEFRAME_HPP_
@@ -0,0 +1,79 @@
+#include "RobotStateTable.hpp"
+
+#include "Trace.hpp"
+
+#include <stdexcept>
+
+namespace Model
+{
+	/**
+	 *
+	 */
+	RobotStateTable::~RobotStateTable()
+	{
+		for (std::atomic< Block* >& b : blocks)
+		{
+			delete b.load( std::memory_order_relaxed);
+		}
+	}
+	/**
+	 *
+	 */
+	RobotStateTable::Index RobotStateTable::allocate( const Base::ObjectId& anObjectId)
+	{
+		std::lock_guard< std::mutex > lock( allocationBusy);
+
+		Index index;
+		if (!releasedRows.empty())
+		{
+			index = releasedRows.back();
+			releasedRows.pop_back();
+		} else
+		{
+			index = numberOfRows.load( std::memory_order_relaxed);
+			if (index == maximumNumberOfBlocks * blockSize)
+			{
+				TRACE_DEVELOP( "The robot state table is full");
+				throw std::runtime_error( "The robot state table is full");
+			}
+			if (index % blockSize == 0)
+			{
+				blocks[index / blockSize].store( new Block(), std::memory_order_release);
+			}
+		}
+
+		Block& b = block( index);
+		std::size_t row = index % blockSize;
+		b.objectId[row] = anObjectId;
+		b.positionX[row] = 0;
+		b.positionY[row] = 0;
+		b.frontX[row] = 0.0;
+		b.frontY[row] = 0.0;
+		b.width[row] = 0;
+		b.height[row] = 0;
+		b.speed[row] = 0.0;
+		b.inWorld[row] = 0;
+		b.acting[row] = 0;
+		b.driving[row] = 0;
+		b.remote[row] = 0;
+		b.inUse[row] = 1;
+
+		if (index == numberOfRows.load( std::memory_order_relaxed))
+		{
+			numberOfRows.store( index + 1, std::memory_order_release);
+		}
+		return index;
+	}
+	/**
+	 *
+	 */
+	void RobotStateTable::release( Index anIndex)
+	{
+		std::lock_guard< std::mutex > lock( allocationBusy);
+
+		Block& b = block( anIndex);
+		b.inUse[anIndex % blockSize] = 0;
+		b.inWorld[anIndex % blockSize] = 0;
+		releasedRows.push_back( anIndex);
+	}
+} // namespace Model
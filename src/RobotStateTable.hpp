@@ -0,0 +1,282 @@
+#ifndef ROBOTSTATETABLE_HPP_
+#define ROBOTSTATETABLE_HPP_
+
+#include "Config.hpp"
+
+#include "BoundedVector.hpp"
+#include "ObjectId.hpp"
+#include "Point.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Model
+{
+	class RobotStateTable;
+	typedef std::shared_ptr< RobotStateTable > RobotStateTablePtr;
+
+	/**
+	 * The pose, kinematics and flags of all robots in a structure of arrays. Every Robot owns a row and
+	 * reads and writes its state through its index, so a pass over the state of all robots streams
+	 * through a few contiguous arrays instead of chasing the Robot objects over the heap.
+	 *
+	 * The rows are stored in blocks of blockSize rows. A block is never moved or freed while the table
+	 * exists, so the index of a row is stable and a row can be read while another thread allocates a
+	 * row. A released row is reused by the next allocate. The columns of a block are plain arrays,
+	 * a loop over a column of a block is vectorised by the compiler.
+	 *
+	 * Like the members of Robot that it replaces the columns are not locked, a row is written by the
+	 * thread that drives or syncs that robot.
+	 */
+	class RobotStateTable
+	{
+		public:
+			/**
+			 *
+			 */
+			typedef std::size_t Index;
+			/**
+			 *
+			 */
+			static constexpr std::size_t blockSize = 256; // @suppress("Avoid magic numbers")
+			/**
+			 * The table holds at most maximumNumberOfBlocks * blockSize robots
+			 */
+			static constexpr std::size_t maximumNumberOfBlocks = 4096; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			struct alignas( 64) Block // @suppress("Avoid magic numbers")
+			{
+					Base::ObjectId objectId[blockSize];
+					std::int32_t positionX[blockSize];
+					std::int32_t positionY[blockSize];
+					double frontX[blockSize];
+					double frontY[blockSize];
+					std::int32_t width[blockSize];
+					std::int32_t height[blockSize];
+					float speed[blockSize];
+					/**
+					 * 1 if the row belongs to a Robot
+					 */
+					std::uint8_t inUse[blockSize];
+					/**
+					 * 1 if the Robot is in the RobotWorld
+					 */
+					std::uint8_t inWorld[blockSize];
+					std::uint8_t acting[blockSize];
+					std::uint8_t driving[blockSize];
+					std::uint8_t remote[blockSize];
+			};
+			/**
+			 *
+			 */
+			RobotStateTable() = default;
+			/**
+			 *
+			 */
+			~RobotStateTable();
+			/**
+			 *
+			 */
+			RobotStateTable( const RobotStateTable&) = delete;
+			/**
+			 *
+			 */
+			RobotStateTable& operator=( const RobotStateTable&) = delete;
+			/**
+			 * Allocates a cleared row
+			 *
+			 * @throw std::runtime_error if the table is full
+			 */
+			Index allocate( const Base::ObjectId& anObjectId);
+			/**
+			 *
+			 */
+			void release( Index anIndex);
+			/**
+			 *
+			 * @return The number of rows in the blocks that are in use, including the released rows
+			 */
+			std::size_t getNumberOfRows() const
+			{
+				return numberOfRows.load( std::memory_order_acquire);
+			}
+			/**
+			 * Calls aFunction( const Block&, std::size_t aNumberOfRows) for every block in use, in order of the index
+			 */
+			template< typename Function >
+			void forEachBlock( Function aFunction) const
+			{
+				std::size_t rows = getNumberOfRows();
+				for (std::size_t block = 0; block * blockSize < rows; ++block)
+				{
+					aFunction( *blocks[block].load( std::memory_order_acquire), std::min( blockSize, rows - block * blockSize));
+				}
+			}
+			/**
+			 * @name Row access
+			 */
+			//@{
+			/**
+			 *
+			 */
+			const Base::ObjectId& getObjectId( Index anIndex) const
+			{
+				return block( anIndex).objectId[anIndex % blockSize];
+			}
+			/**
+			 *
+			 */
+			wxPoint getPosition( Index anIndex) const
+			{
+				const Block& b = block( anIndex);
+				return wxPoint( b.positionX[anIndex % blockSize], b.positionY[anIndex % blockSize]);
+			}
+			/**
+			 *
+			 */
+			void setPosition(	Index anIndex,
+								const wxPoint& aPosition)
+			{
+				Block& b = block( anIndex);
+				b.positionX[anIndex % blockSize] = aPosition.x;
+				b.positionY[anIndex % blockSize] = aPosition.y;
+			}
+			/**
+			 *
+			 */
+			BoundedVector getFront( Index anIndex) const
+			{
+				const Block& b = block( anIndex);
+				return BoundedVector( b.frontX[anIndex % blockSize], b.frontY[anIndex % blockSize]);
+			}
+			/**
+			 *
+			 */
+			void setFront(	Index anIndex,
+							const BoundedVector& aFront)
+			{
+				Block& b = block( anIndex);
+				b.frontX[anIndex % blockSize] = aFront.x;
+				b.frontY[anIndex % blockSize] = aFront.y;
+			}
+			/**
+			 *
+			 */
+			wxSize getSize( Index anIndex) const
+			{
+				const Block& b = block( anIndex);
+				return wxSize( b.width[anIndex % blockSize], b.height[anIndex % blockSize]);
+			}
+			/**
+			 *
+			 */
+			void setSize(	Index anIndex,
+							const wxSize& aSize)
+			{
+				Block& b = block( anIndex);
+				b.width[anIndex % blockSize] = aSize.x;
+				b.height[anIndex % blockSize] = aSize.y;
+			}
+			/**
+			 *
+			 */
+			float getSpeed( Index anIndex) const
+			{
+				return block( anIndex).speed[anIndex % blockSize];
+			}
+			/**
+			 *
+			 */
+			void setSpeed(	Index anIndex,
+							float aSpeed)
+			{
+				block( anIndex).speed[anIndex % blockSize] = aSpeed;
+			}
+			/**
+			 *
+			 */
+			bool isInWorld( Index anIndex) const
+			{
+				return block( anIndex).inWorld[anIndex % blockSize] != 0;
+			}
+			/**
+			 *
+			 */
+			void setInWorld(	Index anIndex,
+								bool anInWorld)
+			{
+				block( anIndex).inWorld[anIndex % blockSize] = anInWorld ? 1 : 0;
+			}
+			/**
+			 *
+			 */
+			bool isActing( Index anIndex) const
+			{
+				return block( anIndex).acting[anIndex % blockSize] != 0;
+			}
+			/**
+			 *
+			 */
+			void setActing(	Index anIndex,
+							bool anActing)
+			{
+				block( anIndex).acting[anIndex % blockSize] = anActing ? 1 : 0;
+			}
+			/**
+			 *
+			 */
+			bool isDriving( Index anIndex) const
+			{
+				return block( anIndex).driving[anIndex % blockSize] != 0;
+			}
+			/**
+			 *
+			 */
+			void setDriving(	Index anIndex,
+								bool aDriving)
+			{
+				block( anIndex).driving[anIndex % blockSize] = aDriving ? 1 : 0;
+			}
+			/**
+			 *
+			 */
+			bool isRemote( Index anIndex) const
+			{
+				return block( anIndex).remote[anIndex % blockSize] != 0;
+			}
+			/**
+			 *
+			 */
+			void setRemote(	Index anIndex,
+							bool aRemote)
+			{
+				block( anIndex).remote[anIndex % blockSize] = aRemote ? 1 : 0;
+			}
+			//@}
+
+		private:
+			/**
+			 *
+			 */
+			Block& block( Index anIndex) const
+			{
+				return *blocks[anIndex / blockSize].load( std::memory_order_acquire);
+			}
+
+			std::array< std::atomic< Block* >, maximumNumberOfBlocks > blocks{};
+			std::atomic< std::size_t > numberOfRows = 0;
+
+			std::mutex allocationBusy;
+			std::vector< Index > releasedRows;
+	}; // class RobotStateTable
+} // namespace Model
+
+#endif // ROBOTSTATETABLE_HPP_
@@ -3,13 +3,92 @@
 #include "Goal.hpp"
 #include "Logger.hpp"
 #include "Robot.hpp"
+#include "RobotStateFrame.hpp"
+#include "Trace.hpp"
 #include "Wall.hpp"
 #include "WayPoint.hpp"
 
-#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_set>
 
 namespace Model
 {
+	namespace
+	{
+		/**
+		 * The circle around the centre that holds the robot whatever its front, so turning does not move it in the index
+		 */
+		SpatialIndex::Bounds boundsOf( const Robot& aRobot)
+		{
+			wxSize size = aRobot.getSize();
+			int radius = static_cast< int >( std::ceil( std::hypot( std::abs( size.x), std::abs( size.y)) / 2.0));
+			return SpatialIndex::Bounds::around( aRobot.getPosition(), radius);
+		}
+		/**
+		 *
+		 */
+		SpatialIndex::Bounds boundsOf( const WayPoint& aWayPoint)
+		{
+			wxSize size = aWayPoint.getSize();
+			return SpatialIndex::Bounds::around( aWayPoint.getPosition(), (std::max( std::abs( size.x), std::abs( size.y)) + 1) / 2);
+		}
+		/**
+		 *
+		 */
+		SpatialIndex::Bounds boundsOf( const Wall& aWall)
+		{
+			return SpatialIndex::Bounds::of( aWall.getPoint1(), aWall.getPoint2());
+		}
+		/**
+		 * Resolves the ObjectIds of a query, objects that were deleted after the query are skipped
+		 */
+		template< typename T >
+		std::vector< std::shared_ptr< T > > resolve(	const ObjectRegistry< T >& aRegistry,
+														const std::vector< Base::ObjectId >& anObjectIds)
+		{
+			std::vector< std::shared_ptr< T > > objects;
+			objects.reserve( anObjectIds.size());
+			for (const Base::ObjectId& objectId : anObjectIds)
+			{
+				if (std::shared_ptr< T > object = aRegistry.find( objectId))
+				{
+					objects.push_back( object);
+				}
+			}
+			return objects;
+		}
+		/**
+		 *
+		 */
+		template< typename T >
+		void rebuild(	SpatialIndex& aSpatialIndex,
+						const ObjectRegistry< T >& aRegistry)
+		{
+			aSpatialIndex.clear();
+			for (const std::shared_ptr< T >& object : aRegistry.getObjects())
+			{
+				aSpatialIndex.update( object->getObjectId(), boundsOf( *object));
+			}
+		}
+		/**
+		 * Records the objects of aRegistry that are not in aKeepObjects as removed
+		 */
+		template< typename T >
+		void recordRemoved(	const ObjectRegistry< T >& aRegistry,
+							const std::unordered_set< Base::ObjectId >& aKeepObjects,
+							ChangeSet& aChangeSet)
+		{
+			for (const std::shared_ptr< T >& object : aRegistry.getObjects())
+			{
+				if (!aKeepObjects.contains( object->getObjectId()))
+				{
+					aChangeSet.remove( object->getObjectId());
+				}
+			}
+		}
+	} // namespace
+
 	/**
 	 *
 	 */
@@ -21,16 +100,50 @@ namespace Model
 	/**
 	 *
 	 */
-	RobotPtr RobotWorld::newRobot(	const std::string& aName /*= "New Robot"*/,
-									const wxPoint& aPosition /*= wxPoint(-1,-1)*/,
-									bool aNotifyObservers /*= true*/)
+	RobotWorld::Transaction::Transaction(	RobotWorld& aRobotWorld,
+											bool aNotifyObservers /* = true */) :
+								robotWorld( aRobotWorld),
+								notifyObservers( aNotifyObservers)
+	{
+		robotWorld.beginTransaction();
+	}
+	/**
+	 *
+	 */
+	RobotWorld::Transaction::~Transaction()
 	{
-		RobotPtr robot = std::make_shared<Robot>( aName, aPosition);
-		robots.push_back( robot);
-		if (aNotifyObservers == true)
+		// A destructor is noexcept, an exception of an observer must not terminate the application
+		try
 		{
-			notifyObservers();
+			robotWorld.commitTransaction( notifyObservers);
+		}
+		catch (std::exception& e)
+		{
+			TRACE_DEVELOP( std::string( "RobotWorld::Transaction: commit failed: ") + e.what());
 		}
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::Transaction::modify( const Base::ObjectId& anObjectId)
+	{
+		robotWorld.pendingChanges.modify( anObjectId);
+	}
+	/**
+	 *
+	 */
+	RobotPtr RobotWorld::newRobot(	const std::string& aName /*= "New Robot"*/,
+									const wxPoint& aPosition /*= wxPoint(-1,-1)*/,
+									bool aNotifyObservers /*= true*/,
+									const Base::ObjectId& anObjectId /*= Base::ObjectId()*/)
+	{
+		RobotPtr robot = anObjectId == Base::ObjectId() ? std::make_shared<Robot>( aName, aPosition) : std::make_shared<Robot>( aName, aPosition, anObjectId);
+
+		Transaction transaction( *this, aNotifyObservers);
+		robots.insert( robot);
+		robotIndex.update( robot->getObjectId(), boundsOf( *robot));
+		robotStateTable->setInWorld( robot->getStateIndex(), true);
+		pendingChanges.add( robot->getObjectId());
 		return robot;
 	}
 	/**
@@ -41,11 +154,11 @@ namespace Model
 											bool aNotifyObservers /*= true*/)
 	{
 		WayPointPtr wayPoint(new WayPoint( aName, aPosition));
-		wayPoints.push_back( wayPoint);
-		if (aNotifyObservers == true)
-		{
-			notifyObservers();
-		}
+
+		Transaction transaction( *this, aNotifyObservers);
+		wayPoints.insert( wayPoint);
+		wayPointIndex.update( wayPoint->getObjectId(), boundsOf( *wayPoint));
+		pendingChanges.add( wayPoint->getObjectId());
 		return wayPoint;
 	}
 	/**
@@ -56,11 +169,11 @@ namespace Model
 									bool aNotifyObservers /*= true*/)
 	{
 		GoalPtr goal = std::make_shared<Goal>( aName, aPosition);
-		goals.push_back( goal);
-		if (aNotifyObservers == true)
-		{
-			notifyObservers();
-		}
+
+		Transaction transaction( *this, aNotifyObservers);
+		goals.insert( goal);
+		goalIndex.update( goal->getObjectId(), boundsOf( *goal));
+		pendingChanges.add( goal->getObjectId());
 		return goal;
 	}
 	/**
@@ -71,12 +184,34 @@ namespace Model
 								bool aNotifyObservers /*= true*/)
 	{
 		WallPtr wall = std::make_shared<Wall>( aPoint1, aPoint2);
-		walls.push_back( wall);
-		if (aNotifyObservers == true)
+
+		Transaction transaction( *this, aNotifyObservers);
+		walls.insert( wall);
+		wallIndex.update( wall->getObjectId(), boundsOf( *wall));
+		pendingChanges.add( wall->getObjectId());
+		return wall;
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::newWalls(	const std::vector< std::pair< wxPoint, wxPoint > >& aWalls,
+								bool aNotifyObservers /*= true*/)
+	{
+		std::vector< WallPtr > newWalls;
+		newWalls.reserve( aWalls.size());
+		for (const std::pair< wxPoint, wxPoint >& wall : aWalls)
 		{
-			notifyObservers();
+			newWalls.push_back( std::make_shared<Wall>( wall.first, wall.second));
+		}
+
+		Transaction transaction( *this, aNotifyObservers);
+		walls.reserve( walls.size() + newWalls.size());
+		for (const WallPtr& wall : newWalls)
+		{
+			walls.insert( wall);
+			wallIndex.update( wall->getObjectId(), boundsOf( *wall));
+			pendingChanges.add( wall->getObjectId());
 		}
-		return wall;
 	}
 	/**
 	 *
@@ -84,17 +219,12 @@ namespace Model
 	void RobotWorld::deleteRobot( 	RobotPtr aRobot,
 									bool aNotifyObservers /*= true*/)
 	{
-		auto i = std::find_if( robots.begin(), robots.end(), [aRobot](RobotPtr r)
-							   {
-									return aRobot->getName() == r->getName();
-							   });
-		if (i != robots.end())
+		Transaction transaction( *this, aNotifyObservers);
+		if (robots.erase( aRobot->getObjectId()))
 		{
-			robots.erase( i);
-			if (aNotifyObservers == true)
-			{
-				notifyObservers();
-			}
+			robotIndex.erase( aRobot->getObjectId());
+			robotStateTable->setInWorld( aRobot->getStateIndex(), false);
+			pendingChanges.remove( aRobot->getObjectId());
 		}
 	}
 	/**
@@ -103,17 +233,11 @@ namespace Model
 	void RobotWorld::deleteWayPoint( 	WayPointPtr aWayPoint,
 										bool aNotifyObservers /*= true*/)
 	{
-		auto i = std::find_if( wayPoints.begin(), wayPoints.end(), [aWayPoint]( WayPointPtr w)
-							   {
-									return aWayPoint->getName() == w->getName();
-							   });
-		if (i != wayPoints.end())
+		Transaction transaction( *this, aNotifyObservers);
+		if (wayPoints.erase( aWayPoint->getObjectId()))
 		{
-			wayPoints.erase( i);
-			if (aNotifyObservers == true)
-			{
-				notifyObservers();
-			}
+			wayPointIndex.erase( aWayPoint->getObjectId());
+			pendingChanges.remove( aWayPoint->getObjectId());
 		}
 	}
 	/**
@@ -122,18 +246,11 @@ namespace Model
 	void RobotWorld::deleteGoal( 	GoalPtr aGoal,
 									bool aNotifyObservers /*= true*/)
 	{
-		auto i = std::find_if( goals.begin(), goals.end(), [aGoal]( GoalPtr g)
-							   {
-			return aGoal->getName() == g->getName();
-							   });
-		if (i != goals.end())
+		Transaction transaction( *this, aNotifyObservers);
+		if (goals.erase( aGoal->getObjectId()))
 		{
-			goals.erase( i);
-
-			if (aNotifyObservers == true)
-			{
-				notifyObservers();
-			}
+			goalIndex.erase( aGoal->getObjectId());
+			pendingChanges.remove( aGoal->getObjectId());
 		}
 	}
 	/**
@@ -142,20 +259,11 @@ namespace Model
 	void RobotWorld::deleteWall( 	WallPtr aWall,
 									bool aNotifyObservers /*= true*/)
 	{
-		auto i = std::find_if( walls.begin(), walls.end(), [aWall]( WallPtr w)
-							   {
-			return
-							aWall->getPoint1() == w->getPoint1() &&
-							aWall->getPoint2() == w->getPoint2();
-							   });
-		if (i != walls.end())
+		Transaction transaction( *this, aNotifyObservers);
+		if (walls.erase( aWall->getObjectId()))
 		{
-			walls.erase( i);
-
-			if (aNotifyObservers == true)
-			{
-				notifyObservers();
-			}
+			wallIndex.erase( aWall->getObjectId());
+			pendingChanges.remove( aWall->getObjectId());
 		}
 	}
 	/**
@@ -163,119 +271,188 @@ namespace Model
 	 */
 	RobotPtr RobotWorld::getRobot( const std::string& aName) const
 	{
-		if(	auto i = std::find_if(robots.begin(),robots.end(),[&aName](RobotPtr robot){return robot->getName() == aName;});
-			i != robots.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return robots.find( aName);
 	}
 	/**
 	 *
 	 */
 	RobotPtr RobotWorld::getRobot( const Base::ObjectId& anObjectId) const
 	{
-		if(	auto i = std::find_if(robots.begin(),robots.end(),[&anObjectId](RobotPtr robot){return robot->getObjectId() == anObjectId;});
-			i != robots.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return robots.find( anObjectId);
 	}
 	/**
 	 *
 	 */
 	WayPointPtr RobotWorld::getWayPoint( const std::string& aName) const
 	{
-		if(	auto i = std::find_if(wayPoints.begin(),wayPoints.end(),[&aName](WayPointPtr wayPoint){return wayPoint->getName() == aName;});
-			i != wayPoints.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return wayPoints.find( aName);
 	}
 	/**
 	 *
 	 */
 	WayPointPtr RobotWorld::getWayPoint( const Base::ObjectId& anObjectId) const
 	{
-		if(	auto i = std::find_if(wayPoints.begin(),wayPoints.end(),[&anObjectId](WayPointPtr wayPoint){return wayPoint->getObjectId() == anObjectId;});
-			i != wayPoints.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return wayPoints.find( anObjectId);
 	}
 	/**
 	 *
 	 */
 	GoalPtr RobotWorld::getGoal( const std::string& aName) const
 	{
-		if(	auto i = std::find_if(goals.begin(),goals.end(),[&aName](GoalPtr goal){return goal->getName() == aName;});
-			i != goals.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return goals.find( aName);
 	}
 	/**
 	 *
 	 */
 	GoalPtr RobotWorld::getGoal( const Base::ObjectId& anObjectId) const
 	{
-		if(	auto i = std::find_if(goals.begin(),goals.end(),[&anObjectId](GoalPtr goal){return goal->getObjectId() == anObjectId;});
-			i != goals.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return goals.find( anObjectId);
 	}
 	/**
 	 *
 	 */
 	WallPtr RobotWorld::getWall( const Base::ObjectId& anObjectId) const
 	{
-		if(	auto i = std::find_if(walls.begin(),walls.end(),[&anObjectId](WallPtr wall){return wall->getObjectId() == anObjectId;});
-			i != walls.end())
-		{
-			return *i;
-		}
-		return nullptr;
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return walls.find( anObjectId);
 	}
 
 	/**
 	 *
 	 */
-	const std::vector< RobotPtr >& RobotWorld::getRobots() const
+	std::vector< RobotPtr > RobotWorld::getRobots() const
+	{
+		return getSnapshot()->getRobots();
+	}
+	/**
+	 *
+	 */
+	std::vector< WayPointPtr > RobotWorld::getWayPoints() const
+	{
+		return getSnapshot()->getWayPoints();
+	}
+	/**
+	 *
+	 */
+	std::vector< GoalPtr > RobotWorld::getGoals() const
 	{
-		return robots;
+		return getSnapshot()->getGoals();
 	}
 	/**
 	 *
 	 */
-	const std::vector< WayPointPtr >& RobotWorld::getWayPoints() const
+	std::vector< WallPtr > RobotWorld::getWalls() const
 	{
-		return wayPoints;
+		return getSnapshot()->getWalls();
 	}
 	/**
 	 *
 	 */
-	const std::vector< GoalPtr >& RobotWorld::getGoals() const
+	void RobotWorld::updateSpatialIndex( const Robot& aRobot)
 	{
-		return goals;
+		robotIndex.move( aRobot.getObjectId(), boundsOf( aRobot));
 	}
 	/**
 	 *
 	 */
-	const std::vector< WallPtr >& RobotWorld::getWalls() const
+	void RobotWorld::updateSpatialIndex( const WayPoint& aWayPoint)
 	{
-		return walls;
+		SpatialIndex::Bounds bounds = boundsOf( aWayPoint);
+		wayPointIndex.move( aWayPoint.getObjectId(), bounds);
+		goalIndex.move( aWayPoint.getObjectId(), bounds);
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::updateSpatialIndex( const Wall& aWall)
+	{
+		wallIndex.move( aWall.getObjectId(), boundsOf( aWall));
+	}
+	/**
+	 *
+	 */
+	std::vector< RobotPtr > RobotWorld::getRobotsIn( const SpatialIndex::Bounds& aBounds) const
+	{
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return resolve( robots, robotIndex.query( aBounds));
+	}
+	/**
+	 *
+	 */
+	RobotPtr RobotWorld::getNearestRobot(	const wxPoint& aPoint,
+											double aMaximumDistance,
+											const Base::ObjectId& anExcludedObjectId /*= Base::ObjectId()*/) const
+	{
+		Base::ObjectId objectId = robotIndex.nearest( aPoint, aMaximumDistance, anExcludedObjectId);
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return objectId.isValid() ? robots.find( objectId) : nullptr;
+	}
+	/**
+	 *
+	 */
+	std::vector< WallPtr > RobotWorld::getWallsIn( const SpatialIndex::Bounds& aBounds) const
+	{
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return resolve( walls, wallIndex.query( aBounds));
+	}
+	/**
+	 *
+	 */
+	std::vector< WallPtr > RobotWorld::getWallsAlong(	const wxPoint& aPoint1,
+														const wxPoint& aPoint2) const
+	{
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return resolve( walls, wallIndex.query( aPoint1, aPoint2));
+	}
+	/**
+	 *
+	 */
+	std::vector< Base::ObjectId > RobotWorld::getObjectIdsAt(	const wxPoint& aPoint,
+																int aMargin) const
+	{
+		SpatialIndex::Bounds bounds = SpatialIndex::Bounds::around( aPoint, aMargin);
+		std::vector< Base::ObjectId > objectIds = robotIndex.query( bounds);
+		for (const SpatialIndex* spatialIndex : { &wayPointIndex, &goalIndex, &wallIndex })
+		{
+			std::vector< Base::ObjectId > found = spatialIndex->query( bounds);
+			objectIds.insert( objectIds.end(), found.begin(), found.end());
+		}
+		return objectIds;
+	}
+	/**
+	 *
+	 */
+	std::size_t RobotWorld::applyRobotStateFrame(	const RobotStateFrame& aRobotStateFrame,
+													bool aNotifyObservers /*= true*/)
+	{
+		std::size_t updated = 0;
+		Transaction transaction( *this, aNotifyObservers);
+		for (const RobotState& robotState : aRobotStateFrame.getRobotStates())
+		{
+			RobotPtr robot = getRobot( robotState.objectId);
+			if (robot)
+			{
+				robot->setPosition( robotState.position, false);
+				robot->setFront( robotState.front, false);
+				transaction.modify( robot->getObjectId());
+				++updated;
+			}
+		}
+		return updated;
 	}
 	/**
 	 *
 	 */
 	void RobotWorld::populate( int UNUSEDPARAM(aNumberOfWalls))
 	{
+		Transaction transaction( *this);
+
 		RobotWorld::getRobotWorld().newRobot( "Robot", wxPoint(163,111),false); // @suppress("Avoid magic numbers")
 
 //		static const wxPoint coordinates[] = {
@@ -293,24 +470,38 @@ namespace Model
 		
 		RobotWorld::getRobotWorld().newWall( wxPoint(7,234), wxPoint(419,234) ,false); // @suppress("Avoid magic numbers")
 		RobotWorld::getRobotWorld().newGoal( "Goal", wxPoint(320,285),false); // @suppress("Avoid magic numbers")
-		
-
-		notifyObservers();
 	}
 	/**
 	 *
 	 */
 	void RobotWorld::unpopulate( bool aNotifyObservers /*= true*/)
 	{
+		Transaction transaction( *this, aNotifyObservers);
+		for (const RobotPtr& robot : robots.getObjects())
+		{
+			robotStateTable->setInWorld( robot->getStateIndex(), false);
+			pendingChanges.remove( robot->getObjectId());
+		}
+		for (const WayPointPtr& wayPoint : wayPoints.getObjects())
+		{
+			pendingChanges.remove( wayPoint->getObjectId());
+		}
+		for (const GoalPtr& goal : goals.getObjects())
+		{
+			pendingChanges.remove( goal->getObjectId());
+		}
+		for (const WallPtr& wall : walls.getObjects())
+		{
+			pendingChanges.remove( wall->getObjectId());
+		}
 		robots.clear();
 		wayPoints.clear();
 		goals.clear();
 		walls.clear();
-
-		if (aNotifyObservers)
-		{
-			notifyObservers();
-		}
+		robotIndex.clear();
+		wayPointIndex.clear();
+		goalIndex.clear();
+		wallIndex.clear();
 	}
 	/**
 	 *
@@ -318,59 +509,27 @@ namespace Model
 	void RobotWorld::unpopulate(const std::vector<Base::ObjectId >& aKeepObjects,
 								bool aNotifyObservers /*= true*/)
 	{
-		if(robots.size()>0)
-		{
-			robots.erase(	std::remove_if(	robots.begin(),
-											robots.end(),
-											[&aKeepObjects](RobotPtr aRobot)
-											{
-											 return std::find(	aKeepObjects.begin(),
-																aKeepObjects.end(),
-																aRobot->getObjectId()) == aKeepObjects.end();
-											}),
-							robots.end());
-		}
-		if(wayPoints.size()>0)
-		{
-			wayPoints.erase(std::remove_if(	wayPoints.begin(),
-											wayPoints.end(),
-											[&aKeepObjects](WayPointPtr aWayPoint)
-											{
-											 return std::find(	aKeepObjects.begin(),
-																aKeepObjects.end(),
-																aWayPoint->getObjectId()) == aKeepObjects.end();
-											}),
-							wayPoints.end());
-		}
-		if(goals.size()>0)
-		{
-			goals.erase(	std::remove_if(	goals.begin(),
-											goals.end(),
-											[&aKeepObjects](GoalPtr aGoal)
-											{
-											 return std::find(	aKeepObjects.begin(),
-																aKeepObjects.end(),
-																aGoal->getObjectId()) == aKeepObjects.end();
-											}),
-							goals.end());
-		}
-		if(walls.size()>0)
-		{
-			walls.erase(	std::remove_if(	walls.begin(),
-											walls.end(),
-											[&aKeepObjects](WallPtr aWall)
-											{
-											 return std::find(	aKeepObjects.begin(),
-																aKeepObjects.end(),
-																aWall->getObjectId()) == aKeepObjects.end();
-											}),
-							walls.end());
-		}
+		const std::unordered_set< Base::ObjectId > keepObjects( aKeepObjects.begin(), aKeepObjects.end());
 
-		if (aNotifyObservers)
+		Transaction transaction( *this, aNotifyObservers);
+		for (const RobotPtr& robot : robots.getObjects())
 		{
-			notifyObservers();
+			robotStateTable->setInWorld( robot->getStateIndex(), keepObjects.contains( robot->getObjectId()));
 		}
+		recordRemoved( robots, keepObjects, pendingChanges);
+		recordRemoved( wayPoints, keepObjects, pendingChanges);
+		recordRemoved( goals, keepObjects, pendingChanges);
+		recordRemoved( walls, keepObjects, pendingChanges);
+
+		robots.keepOnly( keepObjects);
+		wayPoints.keepOnly( keepObjects);
+		goals.keepOnly( keepObjects);
+		walls.keepOnly( keepObjects);
+
+		rebuild( robotIndex, robots);
+		rebuild( wayPointIndex, wayPoints);
+		rebuild( goalIndex, goals);
+		rebuild( wallIndex, walls);
 	}
 	/**
 	 *
@@ -387,59 +546,73 @@ namespace Model
 			currentScenario = scenarioNumber;
 		}
 
+		// One transaction, the observers are notified once of the whole scenario
+		Transaction transaction( *this);
+
 		if (walls.empty())
 		{
 			createBorder();
 		}
 		removeNonBorderWalls();
 
+		for (const GoalPtr& goal : goals.getObjects())
+		{
+			pendingChanges.remove( goal->getObjectId());
+		}
+		for (const WayPointPtr& wayPoint : wayPoints.getObjects())
+		{
+			pendingChanges.remove( wayPoint->getObjectId());
+		}
 		goals.clear();
 		wayPoints.clear();
-		
+		goalIndex.clear();
+		wayPointIndex.clear();
+
 		if(robots.empty())
 		{
 			newRobot("Robot", wxPoint(0, 0));
 		}
-		RobotPtr robot = robots.front();
+		// The robot does not notify while worldBusy is held, the transaction reports it as modified
+		RobotPtr robot = robots.getObjects().front();
 		robot->clearPath();
+		transaction.modify( robot->getObjectId());
 		switch(currentScenario)
 		{
 			case S1_1:
 				Application::Logger::log("Scenario 1.1 created");
-				robot->setPosition(wxPoint(150,150));
+				robot->setPosition(wxPoint(150,150), false);
 				newGoal("Goal", wxPoint(450, 450), false);
 				break;
 			case S1_2:
 				Application::Logger::log("Scenario 1.2 created");
-				robot->setPosition(wxPoint(350,350));
+				robot->setPosition(wxPoint(350,350), false);
 				newGoal("Goal", wxPoint(50, 50), false);
 				break;
 			case S2_1:
 				Application::Logger::log("Scenario 2.1 created");
-				robot->setPosition(wxPoint(50,50));
+				robot->setPosition(wxPoint(50,50), false);
 				newGoal("Goal", wxPoint(450, 450), false);
 				break;
 			case S2_2:
 				Application::Logger::log("Scenario 2.2 created");
-				robot->setPosition(wxPoint(450,50));
+				robot->setPosition(wxPoint(450,50), false);
 				newGoal("Goal", wxPoint(50, 450), false);
 				break;
 			case S3_1:
 				Application::Logger::log("Scenario 3.1 created");
-				robot->setPosition(wxPoint(150,110));
+				robot->setPosition(wxPoint(150,110), false);
 				newGoal("Goal", wxPoint(450, 450), false);
 				newWall( wxPoint(0, 160), wxPoint(300, 160),false);
 				break;
 			case S3_2:
 				Application::Logger::log("Scenario 3.2 created");
-				robot->setPosition(wxPoint(350,390));
+				robot->setPosition(wxPoint(350,390), false);
 				newGoal("Goal", wxPoint(50, 50), false);
 				newWall( wxPoint(200, 340), wxPoint(500, 340),false);
 				break;
 			default:
 				break;
 		}
-		notifyObservers();
 	}
 	/**
 	*
@@ -456,40 +629,135 @@ namespace Model
 	 */
 	void RobotWorld::removeNonBorderWalls()
 	{
+		Transaction transaction( *this, false);
 		while (walls.size() > 4)
 		{
-			walls.pop_back();
+			wallIndex.erase( walls.getObjects().back()->getObjectId());
+			pendingChanges.remove( walls.getObjects().back()->getObjectId());
+			walls.popBack();
+		}
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::beginTransaction()
+	{
+		worldBusy.lock();
+		++transactionDepth;
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::commitTransaction( bool aNotifyObservers)
+	{
+		// Unlocks worldBusy if publishing the changes throws as well
+		std::unique_lock< std::recursive_mutex > lock( worldBusy, std::adopt_lock);
+		if (--transactionDepth > 0)
+		{
+			// The outermost transaction commits the changes of the nested ones
+			return;
+		}
+
+		bool changed = !pendingChanges.empty();
+		if (changed)
+		{
+			pendingChanges.setToVersion( pendingChanges.getFromVersion() + 1);
+			if (pendingChanges.changesObjects())
+			{
+				publishSnapshot( pendingChanges.getToVersion());
+			}
+			changeLog.push_back( pendingChanges);
+			if (changeLog.size() > maximumChangeLogSize)
+			{
+				changeLog.pop_front();
+			}
+			pendingChanges.clear();
+		}
+		lock.unlock();
+
+		if (changed && aNotifyObservers)
+		{
+			notifyObservers();
+		}
+	}
+	/**
+	 *
+	 */
+	std::uint64_t RobotWorld::getChangeVersion() const
+	{
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		return pendingChanges.getFromVersion();
+	}
+	/**
+	 *
+	 */
+	std::optional< ChangeSet > RobotWorld::getChangesSince( std::uint64_t aVersion) const
+	{
+		std::lock_guard< std::recursive_mutex > lock( worldBusy);
+		std::uint64_t currentVersion = pendingChanges.getFromVersion();
+		if (aVersion == currentVersion)
+		{
+			return ChangeSet( aVersion);
+		}
+		if (aVersion > currentVersion || changeLog.empty() || aVersion < changeLog.front().getFromVersion())
+		{
+			return std::nullopt;
 		}
+
+		ChangeSet changes( aVersion);
+		for (const ChangeSet& changeSet : changeLog)
+		{
+			if (changeSet.getToVersion() > aVersion)
+			{
+				changes.merge( changeSet);
+			}
+		}
+		return changes;
+	}
+	/**
+	 *
+	 */
+	void RobotWorld::publishSnapshot( std::uint64_t aVersion)
+	{
+		// Only the kinds of objects that changed since the previous snapshot are copied
+		snapshot.store( std::make_shared< const WorldSnapshot >(	aVersion,
+																	robots.getSharedObjects(),
+																	wayPoints.getSharedObjects(),
+																	goals.getSharedObjects(),
+																	walls.getSharedObjects()),
+						std::memory_order_release);
 	}
 	/**
 	 *
 	 */
 	std::string RobotWorld::asCode() const
 	{
+		WorldSnapshotPtr worldSnapshot = getSnapshot();
+
 		std::ostringstream os;
 		os << "\n\n";
-		for( RobotPtr ptr : robots)
+		for( RobotPtr ptr : worldSnapshot->getRobots())
 		{
 			os <<
 			"RobotWorld::getRobotWorld().newRobot( \"" <<
 			ptr->getName()
 			<< "\", wxPoint(" << ptr->getPosition().x << "," << ptr->getPosition().y << "),false);\n";
 		}
-		for( WallPtr ptr : walls)
+		for( WallPtr ptr : worldSnapshot->getWalls())
 		{
 			os <<
 			"RobotWorld::getRobotWorld().newWall( "
 			<< "wxPoint(" << ptr->getPoint1().x << "," << ptr->getPoint1().y << "),"
 			<< "wxPoint(" << ptr->getPoint2().x << "," << ptr->getPoint2().y << "),false);\n";
 		}
-		for( WayPointPtr ptr : wayPoints)
+		for( WayPointPtr ptr : worldSnapshot->getWayPoints())
 		{
 			os <<
 			"RobotWorld::getRobotWorld().newWayPoint( \"" <<
 			ptr->getName()
 			<< "\", wxPoint(" << ptr->getPosition().x << "," << ptr->getPosition().y << "),false);\n";
 		}
-		for( GoalPtr ptr : goals)
+		for( GoalPtr ptr : worldSnapshot->getGoals())
 		{
 			os <<
 			"RobotWorld::getRobotWorld().newGoal( \"" <<
@@ -511,23 +779,25 @@ namespace Model
 	 */
 	std::string RobotWorld::asDebugString() const
 	{
+		WorldSnapshotPtr worldSnapshot = getSnapshot();
+
 		std::ostringstream os;
 
 		os << asString() << '\n';
 
-		for( RobotPtr ptr : robots)
+		for( RobotPtr ptr : worldSnapshot->getRobots())
 		{
 			os << ptr->asDebugString() << '\n';
 		}
-		for( WayPointPtr ptr : wayPoints)
+		for( WayPointPtr ptr : worldSnapshot->getWayPoints())
 		{
 			os << ptr->asDebugString() << '\n';
 		}
-		for( GoalPtr ptr : goals)
+		for( GoalPtr ptr : worldSnapshot->getGoals())
 		{
 			os << ptr->asDebugString() << '\n';
 		}
-		for( WallPtr ptr : walls)
+		for( WallPtr ptr : worldSnapshot->getWalls())
 		{
 			os << ptr->asDebugString() << '\n';
 		}
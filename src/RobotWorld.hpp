@@ -3,9 +3,19 @@
 
 #include "Config.hpp"
 
+#include "ChangeSet.hpp"
 #include "ModelObject.hpp"
+#include "ObjectRegistry.hpp"
+#include "RobotStateTable.hpp"
+#include "SpatialIndex.hpp"
 #include "Widgets.hpp"
+#include "WorldSnapshot.hpp"
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace Model
@@ -36,6 +46,8 @@ namespace Model
 	class RobotWorld;
 	typedef std::shared_ptr<RobotWorld> RobotWorldPtr;
 
+	class RobotStateFrame;
+
 	/**
 	 *
 	 */
@@ -46,12 +58,56 @@ namespace Model
 			 *
 			 */
 			static RobotWorld& getRobotWorld();
+			/**
+			 * Groups changes of the world: the observers are notified once, when the outermost transaction
+			 * ends, and readers of the snapshot see all changes at once. The functions that change the world
+			 * can be called within the transaction, their aNotifyObservers is ignored then.
+			 *
+			 * The transaction holds the lock of the world, other threads that change the world or look up
+			 * objects wait until it ends.
+			 */
+			class Transaction
+			{
+				public:
+					/**
+					 *
+					 * @param aNotifyObservers If false the observers are not notified at the end of the transaction
+					 */
+					explicit Transaction(	RobotWorld& aRobotWorld,
+											bool aNotifyObservers = true);
+					/**
+					 * Commits the transaction
+					 */
+					~Transaction();
+					/**
+					 *
+					 */
+					Transaction( const Transaction&) = delete;
+					/**
+					 *
+					 */
+					Transaction& operator=( const Transaction&) = delete;
+					/**
+					 * Records that the object changed, e.g. its name or size, so that the observers look at it again
+					 */
+					void modify( const Base::ObjectId& anObjectId);
+
+				private:
+					RobotWorld& robotWorld;
+					bool notifyObservers;
+			};
+			/**
+			 * The number of ChangeSets that is kept for getChangesSince
+			 */
+			static constexpr std::size_t maximumChangeLogSize = 64; // @suppress("Avoid magic numbers")
 			/**
 			 *
+			 * @param anObjectId The ObjectId of the robot, a new one if it is the null ObjectId
 			 */
 			RobotPtr newRobot(	const std::string& aName = "New Robot",
 								const wxPoint& aPosition = wxPoint( -1, -1),
-								bool aNotifyObservers = true);
+								bool aNotifyObservers = true,
+								const Base::ObjectId& anObjectId = Base::ObjectId());
 			/**
 			 *
 			 */
@@ -70,6 +126,13 @@ namespace Model
 			WallPtr newWall(const wxPoint& aPoint1,
 							const wxPoint& aPoint2,
 							bool aNotifyObservers = true);
+			/**
+			 * Adds all walls at once. If aNotifyObservers is true the observers are notified once after all walls are added.
+			 *
+			 * @param aWalls The begin and end points of the new walls
+			 */
+			void newWalls(	const std::vector< std::pair< wxPoint, wxPoint > >& aWalls,
+							bool aNotifyObservers = true);
 			/**
 			 *
 			 */
@@ -118,22 +181,104 @@ namespace Model
 			 *
 			 */
 			WallPtr getWall( const Base::ObjectId& anObjectId) const;
+			/**
+			 * The robots of the current snapshot, a reader that looks at more than one kind of object or
+			 * calls this often should take the snapshot itself
+			 */
+			std::vector< RobotPtr > getRobots() const;
+			/**
+			 * @see getRobots
+			 */
+			std::vector< WayPointPtr > getWayPoints() const;
+			/**
+			 * @see getRobots
+			 */
+			std::vector< GoalPtr > getGoals() const;
+			/**
+			 * @see getRobots
+			 */
+			std::vector< WallPtr > getWalls() const;
+			/**
+			 * The current version of the set of objects. Does not lock, the snapshot stays valid and unchanged
+			 * while it is held.
+			 */
+			WorldSnapshotPtr getSnapshot() const
+			{
+				return snapshot.load( std::memory_order_acquire);
+			}
+			/**
+			 * Increases with every transaction that changed the world
+			 */
+			std::uint64_t getChangeVersion() const;
+			/**
+			 * Observers keep the version they have seen and ask for the changes since then when they are
+			 * notified, several notifications that are handled at once are merged into one ChangeSet.
+			 *
+			 * @return The changes from aVersion to the current version, nothing if aVersion is too old, the
+			 * observer has to look at the whole world then
+			 */
+			std::optional< ChangeSet > getChangesSince( std::uint64_t aVersion) const;
+			/**
+			 * The state of all robots, including the robots that are not (yet) in the world. The robots share
+			 * the ownership so the table outlives them.
+			 */
+			RobotStateTablePtr getRobotStateTable() const
+			{
+				return robotStateTable;
+			}
+			/**
+			 * Updates the bounding box of the object in the spatial index, to be called after the object
+			 * moved or changed its size. Does nothing if the object is not in this world.
+			 */
+			void updateSpatialIndex( const Robot& aRobot);
+			/**
+			 * @see updateSpatialIndex( const Robot&), the goals are included
+			 */
+			void updateSpatialIndex( const WayPoint& aWayPoint);
+			/**
+			 * @see updateSpatialIndex( const Robot&)
+			 */
+			void updateSpatialIndex( const Wall& aWall);
 			/**
 			 *
+			 * @return The robots whose bounding box overlaps aBounds
 			 */
-			const std::vector< RobotPtr >& getRobots() const;
+			std::vector< RobotPtr > getRobotsIn( const SpatialIndex::Bounds& aBounds) const;
 			/**
 			 *
+			 * @return The robot whose centre is nearest to aPoint and at most aMaximumDistance away, nullptr if there is none
 			 */
-			const std::vector< WayPointPtr >& getWayPoints() const;
+			RobotPtr getNearestRobot(	const wxPoint& aPoint,
+										double aMaximumDistance,
+										const Base::ObjectId& anExcludedObjectId = Base::ObjectId()) const;
 			/**
 			 *
+			 * @return The walls whose bounding box overlaps aBounds
 			 */
-			const std::vector< GoalPtr >& getGoals() const;
+			std::vector< WallPtr > getWallsIn( const SpatialIndex::Bounds& aBounds) const;
 			/**
 			 *
+			 * @return The walls whose bounding box overlaps the segment from aPoint1 to aPoint2
 			 */
-			const std::vector< WallPtr >& getWalls() const;
+			std::vector< WallPtr > getWallsAlong(	const wxPoint& aPoint1,
+													const wxPoint& aPoint2) const;
+			/**
+			 *
+			 * @return The ObjectIds of the robots, waypoints, goals and walls whose bounding box is at most aMargin away from aPoint
+			 */
+			std::vector< Base::ObjectId > getObjectIdsAt(	const wxPoint& aPoint,
+															int aMargin) const;
+			/**
+			 * Updates the pose of every robot in the frame that is known in this world by its ObjectId.
+			 * Robots in the frame that are unknown are ignored. The observers are notified once for the
+			 * whole frame.
+			 *
+			 * @param aRobotStateFrame The poses of the robots of a remote world
+			 * @param aNotifyObservers
+			 * @return The number of robots that were updated
+			 */
+			std::size_t applyRobotStateFrame(	const RobotStateFrame& aRobotStateFrame,
+												bool aNotifyObservers = true);
 			/**
 			 *
 			 */
@@ -161,7 +306,7 @@ namespace Model
 			std::string asCode() const;
 			/**
 			 *
-			 * @param aKeepObjects Keep the objects with these ObjectIdsin the world
+			 * @param aKeepObjects Keep the objects with these ObjectIds in the world
 			 * @param aNotifyObservers
 			 */
 			void unpopulate( const std::vector<Base::ObjectId >& aKeepObjects,
@@ -192,12 +337,55 @@ namespace Model
 
 		private:
 			/**
-			 * The vectors are mutable to allow for lazy instantiation
+			 * Locks the world, transactions nest
+			 */
+			void beginTransaction();
+			/**
+			 * Ends the transaction, the outermost transaction publishes the changes, unlocks the world and
+			 * notifies the observers if something changed
+			 */
+			void commitTransaction( bool aNotifyObservers);
+			/**
+			 * Publishes the objects in the registries as the snapshot of change version aVersion, expects
+			 * worldBusy to be held
+			 */
+			void publishSnapshot( std::uint64_t aVersion);
+			/**
+			 * Serialises the changes of the registries and the lookups in them. Recursive because the
+			 * transactions nest.
+			 */
+			mutable std::recursive_mutex worldBusy;
+			/**
+			 * The readers iterate the snapshot, the registries are only used by the writers and for lookups
+			 */
+			std::atomic< WorldSnapshotPtr > snapshot = std::make_shared< const WorldSnapshot >();
+			/**
+			 * The nesting of the transactions of the thread that holds worldBusy and the changes they made so far
+			 */
+			std::size_t transactionDepth = 0;
+			ChangeSet pendingChanges;
+			/**
+			 * The last maximumChangeLogSize ChangeSets, oldest first
+			 */
+			std::deque< ChangeSet > changeLog;
+			/**
+			 * Indexed by ObjectId and name, the lookups and deletes are O(1)
+			 */
+			ObjectRegistry< Robot > robots;
+			ObjectRegistry< WayPoint > wayPoints;
+			ObjectRegistry< Goal > goals;
+			ObjectRegistry< Wall > walls;
+			/**
+			 *
+			 */
+			RobotStateTablePtr robotStateTable = std::make_shared< RobotStateTable >();
+			/**
+			 * The bounding boxes of the objects, per kind of object
 			 */
-			mutable std::vector< RobotPtr > robots;
-			mutable std::vector< WayPointPtr > wayPoints;
-			mutable std::vector< GoalPtr > goals;
-			mutable std::vector< WallPtr > walls;
+			SpatialIndex robotIndex;
+			SpatialIndex wayPointIndex;
+			SpatialIndex goalIndex;
+			SpatialIndex wallIndex;
 
 			Scenarios currentScenario = NO_SCENARIO;
 	};
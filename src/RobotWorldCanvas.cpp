@@ -16,6 +16,8 @@
 #include "WayPointShape.hpp"
 
 #include <algorithm>
+#include <optional>
+#include <unordered_set>
 
 namespace View
 {
@@ -94,6 +96,7 @@ namespace View
 	 */
 	RobotWorldCanvas::~RobotWorldCanvas()
 	{
+		modelShapes.clear();
 		shapes.clear();
 
 		PopEventHandler();
@@ -373,19 +376,14 @@ namespace View
 	 */
 	bool RobotWorldCanvas::isShapeAt( const wxPoint& aPoint) const
 	{
-		return  std::any_of(shapes.begin(), 
-							shapes.end(), 
-							[&aPoint](ShapePtr aShape)
-							{ 
-								return aShape->occupies( aPoint);
-							});		
+		return findShapeAt( aPoint) != shapes.end();
 	}
 	/**
 	 *
 	 */
 	ShapePtr RobotWorldCanvas::getShapeAt( const wxPoint& aPoint) const
 	{
-		if(	auto i = std::find_if(shapes.begin(),shapes.end(),[&aPoint](ShapePtr shape){return shape->occupies( aPoint);});
+		if(	auto i = findShapeAt( aPoint);
 			i != shapes.end())
 		{
 			return *i;
@@ -397,7 +395,7 @@ namespace View
 	 */
 	bool RobotWorldCanvas::selectShapeAt( const wxPoint& aPoint)
 	{
-		if(	auto i = std::find_if(shapes.begin(),shapes.end(),[&aPoint](ShapePtr shape){return shape->occupies( aPoint);});
+		if(	auto i = findShapeAt( aPoint);
 			i != shapes.end())
 		{
 			setSelectedShape( *i);
@@ -450,6 +448,7 @@ namespace View
 	 */
 	void RobotWorldCanvas::unpopulate()
 	{
+		modelShapes.clear();
 		shapes.clear();
 		Model::RobotWorld::getRobotWorld().unpopulate();
 	}
@@ -1002,6 +1001,7 @@ namespace View
 		ShapePtr wall = std::make_shared<WallShape>(Model::RobotWorld::getRobotWorld().newWall( start->getCentre(), end->getCentre(),false),
 													start,
 													end);
+		modelShapes[wall->getModelObject()->getObjectId()] = wall;
 		shapes.push_back( wall);
 		shapes.push_back( start);
 		shapes.push_back( end);
@@ -1042,19 +1042,101 @@ namespace View
 	 */
 	void RobotWorldCanvas::handleNotification( wxNotifyEvent& UNUSEDPARAM(aNotifyEvent))
 	{
-		remove<Model::Robot,View::RobotShape>( Model::RobotWorld::getRobotWorld().getRobots());
-		add<Model::Robot,View::RobotShape>( Model::RobotWorld::getRobotWorld().getRobots());
+		Model::RobotWorld& robotWorld = Model::RobotWorld::getRobotWorld();
 
-		remove<Model::WayPoint,View::WayPointShape>( Model::RobotWorld::getRobotWorld().getWayPoints());
-		add<Model::WayPoint,View::WayPointShape>( Model::RobotWorld::getRobotWorld().getWayPoints());
+		// Several notifications may be pending, the first one applies the changes of all of them
+		if (std::optional< Model::ChangeSet > changes = robotWorld.getChangesSince( worldVersion))
+		{
+			applyChanges( *changes);
+			worldVersion = changes->getToVersion();
+		} else
+		{
+			// The version is read before the snapshot, the changes in between are applied again the next time, which is harmless
+			worldVersion = robotWorld.getChangeVersion();
+			synchronise( *robotWorld.getSnapshot());
+		}
+
+		Refresh();
+	}
+	/**
+	 *
+	 */
+	void RobotWorldCanvas::applyChanges( const Model::ChangeSet& aChangeSet)
+	{
+		for (const Base::ObjectId& objectId : aChangeSet.getRemoved())
+		{
+			if (auto i = modelShapes.find( objectId); i != modelShapes.end())
+			{
+				forgetShape( i->second);
+			}
+		}
 
-		remove<Model::Goal,View::GoalShape>( Model::RobotWorld::getRobotWorld().getGoals());
-		add<Model::Goal,View::GoalShape>( Model::RobotWorld::getRobotWorld().getGoals());
+		Model::RobotWorld& robotWorld = Model::RobotWorld::getRobotWorld();
+		for (const std::unordered_set< Base::ObjectId >* objectIds : { &aChangeSet.getAdded(), &aChangeSet.getModified() })
+		{
+			for (const Base::ObjectId& objectId : *objectIds)
+			{
+				if (Model::RobotPtr robot = robotWorld.getRobot( objectId))
+				{
+					addShapeFor< Model::Robot, RobotShape >( robot);
+				} else if (Model::WayPointPtr wayPoint = robotWorld.getWayPoint( objectId))
+				{
+					addShapeFor< Model::WayPoint, WayPointShape >( wayPoint);
+				} else if (Model::GoalPtr goal = robotWorld.getGoal( objectId))
+				{
+					addShapeFor< Model::Goal, GoalShape >( goal);
+				} else if (Model::WallPtr wall = robotWorld.getWall( objectId))
+				{
+					addShapeFor< Model::Wall, WallShape >( wall);
+				} else if (auto i = modelShapes.find( objectId); i != modelShapes.end())
+				{
+					// Removed again after aChangeSet was made
+					forgetShape( i->second);
+				}
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	void RobotWorldCanvas::synchronise( const Model::WorldSnapshot& aWorldSnapshot)
+	{
+		std::unordered_set< Base::ObjectId > objectIds;
+		objectIds.reserve( aWorldSnapshot.getRobots().size() + aWorldSnapshot.getWayPoints().size() + aWorldSnapshot.getGoals().size() + aWorldSnapshot.getWalls().size());
+		for (const Model::RobotPtr& robot : aWorldSnapshot.getRobots())
+		{
+			objectIds.insert( robot->getObjectId());
+		}
+		for (const Model::WayPointPtr& wayPoint : aWorldSnapshot.getWayPoints())
+		{
+			objectIds.insert( wayPoint->getObjectId());
+		}
+		for (const Model::GoalPtr& goal : aWorldSnapshot.getGoals())
+		{
+			objectIds.insert( goal->getObjectId());
+		}
+		for (const Model::WallPtr& wall : aWorldSnapshot.getWalls())
+		{
+			objectIds.insert( wall->getObjectId());
+		}
 
-		remove<Model::Wall,View::WallShape>( Model::RobotWorld::getRobotWorld().getWalls());
-		add<Model::Wall,View::WallShape>( Model::RobotWorld::getRobotWorld().getWalls());
+		std::vector< ShapePtr > removedShapes;
+		for (const auto& [objectId, shape] : modelShapes)
+		{
+			if (!objectIds.contains( objectId))
+			{
+				removedShapes.push_back( shape);
+			}
+		}
+		for (const ShapePtr& shape : removedShapes)
+		{
+			forgetShape( shape);
+		}
 
-		Refresh();
+		addShapesFor< Model::Robot, RobotShape >( aWorldSnapshot.getRobots());
+		addShapesFor< Model::WayPoint, WayPointShape >( aWorldSnapshot.getWayPoints());
+		addShapesFor< Model::Goal, GoalShape >( aWorldSnapshot.getGoals());
+		addShapesFor< Model::Wall, WallShape >( aWorldSnapshot.getWalls());
 	}
 	/**
 	 *
@@ -1174,6 +1256,7 @@ namespace View
 	{
 		aRobotShape->setRobotWorldCanvas(this);
 		aRobotShape->handleNotificationsFor(*aRobotShape->getRobot());
+		modelShapes[aRobotShape->getRobot()->getObjectId()] = aRobotShape;
 		shapes.push_back( std::dynamic_pointer_cast< Shape >( aRobotShape));
 	}
 	/**
@@ -1182,6 +1265,7 @@ namespace View
 	void RobotWorldCanvas::addShape( GoalShapePtr aGoalShape)
 	{
 		aGoalShape->handleNotificationsFor(*aGoalShape->getGoal());
+		modelShapes[aGoalShape->getGoal()->getObjectId()] = aGoalShape;
 		shapes.push_back( std::dynamic_pointer_cast< Shape >( aGoalShape));
 	}
 	/**
@@ -1190,6 +1274,7 @@ namespace View
 	void RobotWorldCanvas::addShape( WayPointShapePtr aWayPointShape)
 	{
 		aWayPointShape->handleNotificationsFor(*aWayPointShape->getWayPoint());
+		modelShapes[aWayPointShape->getWayPoint()->getObjectId()] = aWayPointShape;
 		shapes.push_back( std::dynamic_pointer_cast< Shape >( aWayPointShape));
 	}
 	/**
@@ -1205,6 +1290,7 @@ namespace View
 		aWallShape->setNode1(start);
 		aWallShape->setNode2(end);
 
+		modelShapes[aWallShape->getWall()->getObjectId()] = aWallShape;
 		shapes.push_back( start);
 		shapes.push_back( end);
 		shapes.push_back( aWallShape);
@@ -1214,55 +1300,107 @@ namespace View
 	 */
 	void RobotWorldCanvas::removeShape( RobotShapePtr aRobotShape)
 	{
-		aRobotShape->stopHandlingNotificationsFor( *aRobotShape->getRobot());
 		Model::RobotWorld::getRobotWorld().deleteRobot( aRobotShape->getRobot(), false);
-		removeGenericShape( aRobotShape);
+		forgetShape( aRobotShape);
 	}
 	/**
 	 *
 	 */
 	void RobotWorldCanvas::removeShape( GoalShapePtr aGoalShape)
 	{
-		aGoalShape->stopHandlingNotificationsFor( *aGoalShape->getGoal());
 		Model::RobotWorld::getRobotWorld().deleteGoal( aGoalShape->getGoal(), false);
-		removeGenericShape( aGoalShape);
+		forgetShape( aGoalShape);
 	}
 	/**
 	 *
 	 */
 	void RobotWorldCanvas::removeShape( WayPointShapePtr aWayPointShape)
 	{
-		aWayPointShape->stopHandlingNotificationsFor( *aWayPointShape->getWayPoint());
 		Model::RobotWorld::getRobotWorld().deleteWayPoint( aWayPointShape->getWayPoint(), false);
-		removeGenericShape( aWayPointShape);
+		forgetShape( aWayPointShape);
 	}
 	/**
 	 *
 	 */
 	void RobotWorldCanvas::removeShape( WallShapePtr aWallShape)
 	{
-		RectangleShapePtr start = aWallShape->hasEndPointAt( aWallShape->getBegin());
-		RectangleShapePtr end = aWallShape->hasEndPointAt( aWallShape->getEnd());
 		Model::RobotWorld::getRobotWorld().deleteWall( aWallShape->getWall(), false);
-		removeGenericShape( aWallShape);
-		removeGenericShape( start);
-		removeGenericShape( end);
+		forgetShape( aWallShape);
+	}
+	/**
+	 *
+	 */
+	std::vector< ShapePtr >::const_iterator RobotWorldCanvas::findShapeAt( const wxPoint& aPoint) const
+	{
+		// The spatial index of the world tells which model objects are near the point, only their shapes
+		// and the shapes without a model object (the end points of the walls) need the exact test
+		std::vector< Base::ObjectId > objectIds = Model::RobotWorld::getRobotWorld().getObjectIdsAt( aPoint, pickMargin);
+		std::unordered_set< Base::ObjectId > candidates( objectIds.begin(), objectIds.end());
+
+		return std::find_if(shapes.begin(),
+							shapes.end(),
+							[&aPoint, &candidates](ShapePtr aShape)
+							{
+								Model::ModelObjectPtr modelObject = aShape->getModelObject();
+								if (modelObject && !candidates.contains( modelObject->getObjectId()))
+								{
+									return false;
+								}
+								return aShape->occupies( aPoint);
+							});
 	}
 	/**
 	 *
 	 */
 	void RobotWorldCanvas::removeGenericShape( ShapePtr aShape)
 	{
+		if (Model::ModelObjectPtr modelObject = aShape->getModelObject())
+		{
+			if (auto i = modelShapes.find( modelObject->getObjectId()); i != modelShapes.end() && i->second == aShape)
+			{
+				modelShapes.erase( i);
+			}
+		}
 		if (isShapeSelected() && aShape->getObjectId() == getSelectedShape()->getObjectId())
 		{
 			setSelectedShape( nullptr);
 		}
-		shapes.erase( std::find_if( shapes.begin(),
-									shapes.end(),
-									[aShape](ShapePtr s)
-									{
-										return aShape->getObjectId() == s->getObjectId();
-									}));
+		auto i = std::find_if(	shapes.begin(),
+								shapes.end(),
+								[aShape](ShapePtr s)
+								{
+									return aShape->getObjectId() == s->getObjectId();
+								});
+		if (i != shapes.end())
+		{
+			shapes.erase( i);
+		}
+	}
+	/**
+	 *
+	 */
+	void RobotWorldCanvas::forgetShape( ShapePtr aShape)
+	{
+		if (RobotShapePtr robotShape = std::dynamic_pointer_cast< RobotShape >( aShape))
+		{
+			robotShape->stopHandlingNotificationsFor( *robotShape->getRobot());
+		} else if (GoalShapePtr goalShape = std::dynamic_pointer_cast< GoalShape >( aShape))
+		{
+			goalShape->stopHandlingNotificationsFor( *goalShape->getGoal());
+		} else if (WayPointShapePtr wayPointShape = std::dynamic_pointer_cast< WayPointShape >( aShape))
+		{
+			wayPointShape->stopHandlingNotificationsFor( *wayPointShape->getWayPoint());
+		} else if (WallShapePtr wallShape = std::dynamic_pointer_cast< WallShape >( aShape))
+		{
+			wallShape->stopHandlingNotificationsFor( *wallShape->getWall());
+			RectangleShapePtr start = wallShape->hasEndPointAt( wallShape->getBegin());
+			RectangleShapePtr end = wallShape->hasEndPointAt( wallShape->getEnd());
+			removeGenericShape( wallShape);
+			removeGenericShape( start);
+			removeGenericShape( end);
+			return;
+		}
+		removeGenericShape( aShape);
 	}
 	/**
 	 *
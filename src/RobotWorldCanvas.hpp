@@ -9,6 +9,8 @@
 #include "ViewObject.hpp"
 #include "Widgets.hpp"
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace View
@@ -281,6 +283,10 @@ namespace View
 			 *
 			 */
 			void removeGenericShape( ShapePtr aShape);
+			/**
+			 * Removes the Shape and the end points of a WallShape from the canvas, the ModelObject stays in the world
+			 */
+			void forgetShape( ShapePtr aShape);
 		private:
 			/**
 			 * @name Event handlers
@@ -332,7 +338,26 @@ namespace View
 			void OnNotificationEvent( wxNotifyEvent& aNotifyEvent);
 			//@}
 
+			/**
+			 * The distance in pixels around a point within which the model objects are candidates for picking,
+			 * it covers the parts of a shape that are outside the bounding box of its model object
+			 */
+			static constexpr int pickMargin = 16; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 * @return The first Shape in iteration order that returns true for Shape.ocuppies(aPoint), shapes.end() otherwise
+			 */
+			std::vector< ShapePtr >::const_iterator findShapeAt( const wxPoint& aPoint) const;
+
 			std::vector< ShapePtr > shapes;
+			/**
+			 * The Shapes of the ModelObjects in shapes, by the ObjectId of their ModelObject
+			 */
+			std::unordered_map< Base::ObjectId, ShapePtr > modelShapes;
+			/**
+			 * The change version of the world that the shapes show
+			 */
+			std::uint64_t worldVersion = 0;
 
 			enum
 			{
@@ -365,56 +390,42 @@ namespace View
 			Base::NotificationHandler< std::function< void( wxNotifyEvent&) > > * notificationHandler;
 
 			/**
-			 * This function removes all Shapes that look at a ModelObject that is not longer in RobotWorld
+			 * Applies the added, removed and modified ModelObjects to the Shapes, the cost is proportional to the
+			 * number of changes
+			 */
+			void applyChanges( const Model::ChangeSet& aChangeSet);
+			/**
+			 * Removes the Shapes of ModelObjects that are not in aWorldSnapshot and adds Shapes for the ModelObjects
+			 * that have none. Used when the changes since worldVersion are no longer known.
+			 */
+			void synchronise( const Model::WorldSnapshot& aWorldSnapshot);
+			/**
+			 * Adds a Shape for anObject if it has none. A Shape that looks at another object with the same ObjectId,
+			 * an object that was removed and added again, is replaced.
 			 */
 			template< typename T, typename S >
-			void remove( const std::vector<std::shared_ptr< T > >& aTs)
+			void addShapeFor( const std::shared_ptr< T >& anObject)
 			{
-				std::vector< ShapePtr> shapePtrs;
-				std::copy_if(	shapes.begin(),
-								shapes.end(),
-								std::back_inserter(shapePtrs),
-								[&aTs](ShapePtr aShape)
-								{
-									std::shared_ptr< S > shape = std::dynamic_pointer_cast< S >( aShape);
-									if (shape)
-									{
-										return std::find_if(	aTs.begin(),
-																aTs.end(),
-																[shape](std::shared_ptr< T > aT)
-																{
-																	return shape->getModelObject()->getObjectId() == aT->getObjectId();
-																}) == aTs.end();
-									}
-									return false;
-								});
-				for(ShapePtr shape : shapePtrs)
+				auto i = modelShapes.find( anObject->getObjectId());
+				if (i != modelShapes.end())
 				{
-					removeShape( std::dynamic_pointer_cast< S >( shape));
+					if (i->second->getModelObject().get() == anObject.get())
+					{
+						return;
+					}
+					forgetShape( i->second);
 				}
+				addShape( std::make_shared< S >( anObject));
 			}
 			/**
-			 * This function add Shapes for ModelObjects that are in RobotWorld but that have no Shape yet
+			 *
 			 */
 			template< typename T, typename S >
-			void add( const std::vector<std::shared_ptr< T > >& aTs)
+			void addShapesFor( const std::vector< std::shared_ptr< T > >& anObjects)
 			{
-				for(std::shared_ptr< T > t : aTs)
+				for (const std::shared_ptr< T >& object : anObjects)
 				{
-					auto result = std::find_if(	shapes.begin(),
-												shapes.end(),
-												[t](ShapePtr aShape)
-												{
-													if(aShape->getModelObject())
-													{
-														return aShape->getModelObject()->getObjectId() == t->getObjectId();
-													}
-													return false;
-												});
-					if( result == shapes.end())
-					{
-						addShape(std::shared_ptr< S >(new S(t)));
-					}
+					addShapeFor< T, S >( object);
 				}
 			}
 	};
@@ -7,9 +7,7 @@ namespace Messaging
 	 */
 	Server::Server(unsigned short aPort, RequestHandlerPtr aRequestHandler) :
 					port(aPort),
-					acceptor(CommunicationService::getCommunicationService().getIOContext()),
-					requestHandler(aRequestHandler),
-					timer( Messaging::CommunicationService::getCommunicationService().getIOContext())
+					requestHandler(aRequestHandler)
 	{
 	}
 } /* namespace Messaging */
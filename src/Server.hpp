@@ -3,11 +3,10 @@
 
 #include "Config.hpp"
 
-#include "Session.hpp"
 #include "CommunicationService.hpp"
+#include "RequestDispatcher.hpp"
+#include "Transport.hpp"
 
-#include <atomic>
-#include <iostream>
 #include <memory>
 
 namespace Messaging
@@ -31,143 +30,30 @@ namespace Messaging
 				return port;
 			}
 			/**
-			 *
+			 * Lets the model thread of aRequestDispatcher handle the requests, whatever the transport is. Must be called
+			 * before startHandlingRequests. Without a dispatcher the requests are handled on the thread that runs the io_context.
 			 */
-			void startHandlingRequests()
+			void setRequestDispatcher( RequestDispatcherPtr aRequestDispatcher)
 			{
-				boost::asio::ip::tcp::endpoint ep(boost::asio::ip::tcp::v4(), port);
-				acceptor.open(ep.protocol());
-				acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-				acceptor.bind(ep);
-				acceptor.listen();
-
-				stopAccepting.store(false);
-				handleAccept( nullptr, boost::system::error_code());
+				requestDispatcher = aRequestDispatcher;
 			}
 			/**
-			 *
+			 * Registers the request handler with the transport that is selected in the CommunicationService
 			 */
-			void stopHandlingRequests()
+			void startHandlingRequests()
 			{
-				stopAccepting.store(true);
-
-				timer.expires_from_now(boost::posix_time::seconds(1));
-				timer.async_wait([this](const boost::system::error_code& UNUSEDPARAM(e)) // @suppress("Method cannot be resolved")
-								 {
-									boost::asio::post(	[this]() // @suppress("Invalid arguments")
-														{
-															acceptor.cancel();
-														});
-								 });
+				transport = &CommunicationService::getCommunicationService().getTransport();
+				transport->registerRequestHandler( port, requestHandler, requestDispatcher);
 			}
-		private:
 			/**
-			 *	Handle any incoming connections
 			 *
-			 * @startuml
-			 * -> server: handleAccept
-			 * activate server
-			 * server -->> session
-			 * activate session
-			 * deactivate session
-			 * server -\ acceptor : asyn_accept(socket,(){handleAccept();})
-			 * server -> session : start
-			 * deactivate server
-			 * activate session
-			 * == Reading the request ==
-			 * session -\ session: readMessage
-			 * activate session
-			 * session -\ socket: async_read(socket, messageHeaderBuffer,(){handleHeaderRead();})
-			 * deactivate session
-			 * activate socket
-			 * server <-- session
-			 * deactivate session
-			 * deactivate session
-			 * deactivate session
-			 * session <- socket : handleHeaderRead()
-			 * deactivate socket
-			 * activate session
-			 * session -\ socket: async_read(socket,messageBodyBuffer,(){handleBodyRead();})
-			 * deactivate session
-			 * activate socket
-			 * session <- socket : handleBodyRead()
-			 * deactivate socket
-			 * activate session
-			 * session -> session : handleMessageRead(error)
-			 * activate session
-			 * session -> session : handleMessageRead()
-			 * activate session
-			 * == Handling the request ==
-			 * session -> requestHandler : handleRequest(message)
-			 * activate requestHandler
-			 * session <-- requestHandler
-			 * deactivate requestHandler
-			 * == Writing the response ==
-			 * session -> session: writeMessage(message)
-			 * activate session
-			 * session -\ socket: async_write(socket, messageHeaderBuffer,(){handleHeaderWriten();})
-			 * deactivate session
-			 * activate socket
-			 * deactivate session
-			 * deactivate session
-			 * deactivate session
-			 * session <- socket : handleHeaderWriten()
-			 * deactivate socket
-			 * activate session
-			 * session -\ socket: async_write(socket messageBodyBuffer,(){handleBodyWriten();})
-			 * deactivate session
-			 * activate socket
-			 * session <- socket : handleBodyWriten()
-			 * deactivate socket
-			 * activate session
-			 * session -> session : handleMessageWriten(error)
-			 * activate session
-			 * session -> session : handleMessageWritten()
-			 * activate session
-			 * deactivate session
-			 * deactivate session
-			 * destroy session
-			 * @enduml
 			 */
-			void handleAccept( 	ServerSession* aSession,
-								const boost::system::error_code& error)
+			void stopHandlingRequests()
 			{
-				if (!error)
-				{
-					if(!stopAccepting.load())
-					{
-						// Create the session that will handle the next incoming connection
-						ServerSession* session = new ServerSession( requestHandler);
-						// Let the acceptor wait for any new incoming connections
-						// and let it call server::handle_accept on the happy occasion
-						acceptor.async_accept(	session->getSocket(), // @suppress("Method cannot be resolved")
-												[this, session](const boost::system::error_code& error)
-												{
-							handleAccept(session,error);
-												});
-
-						// If there is a session, start it up....
-						if (aSession)
-						{
-							aSession->start();
-						}
-					}else
-					{
-						TRACE_DEVELOP("Server does not accept any sessions anymore");
-					}
-				} else
+				if (transport)
 				{
-					if (aSession)
-					{
-						delete aSession;
-					}
-					if(!stopAccepting && error != boost::asio::error::basic_errors::operation_aborted)
-					{
-						std::ostringstream os;
-						os << "************ " << __PRETTY_FUNCTION__ << ": " << error.message() << ", stopAccepting = " << stopAccepting;
-						TRACE_DEVELOP(os.str());
-						throw std::runtime_error( os.str());
-					}
+					transport->deregisterRequestHandler( port);
+					transport = nullptr;
 				}
 			}
 		private:
@@ -175,22 +61,18 @@ namespace Messaging
 			 *
 			 */
 			unsigned short port;
-			/**
-			 * Provides the ability to accept new connections
-			 */
-			boost::asio::ip::tcp::acceptor acceptor;
 			/**
 			 *
 			 */
-			std::atomic<bool> stopAccepting = false;
+			RequestHandlerPtr requestHandler;
 			/**
 			 *
 			 */
-			RequestHandlerPtr requestHandler;
+			RequestDispatcherPtr requestDispatcher;
 			/**
-			 *
+			 * The transport with which the server was started
 			 */
-			boost::asio::deadline_timer timer;
+			Transport* transport = nullptr;
 	};
 	/**
 	 *
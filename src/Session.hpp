@@ -4,14 +4,21 @@
 #include "Config.hpp"
 
 #include "CommunicationService.hpp"
+#include "Compression.hpp"
 #include "Message.hpp"
 #include "MessageHandler.hpp"
 #include "MessageTypes.hpp"
+#include "MessagingPool.hpp"
+#include "RequestDispatcher.hpp"
 
 #include <boost/asio.hpp>
 
+#include <array>
+#include <deque>
+#include <functional>
 #include <sstream>
 #include <string>
+#include <utility>
 
 namespace Messaging
 {
@@ -78,9 +85,33 @@ namespace Messaging
 			{
 				return socket;
 			}
+			/**
+			 * Ends the life of a session that has no outstanding asynchronous operations. Pooled sessions
+			 * go back to their SessionPool, other sessions are deleted.
+			 */
+			virtual void recycle()
+			{
+				// See https://isocpp.org/wiki/faq/freestore-mgmt#delete-this
+				delete this;
+			}
 		protected:
+			/**
+			 * Closes the socket and empties the message, keeping the capacity of the body for the next connection
+			 */
+			void clearSession()
+			{
+				boost::system::error_code ignored;
+				socket.close( ignored);
+				message.setMessageType( 0);
+				message.setCorrelationId( 0);
+				message.setFlags( Message::NoFlags);
+				message.message.clear();
+				legacyPeer = false;
+				acceptsCompressedBodies = Compression::isEnabled();
+			}
 			/**
 			 * readMessage will read the message in 2 a-sync reads, 1 for the header and 1 for the body.
+			 * A header of version 1.2 is read in 2 parts: the part that a 1.0 header has as well and the rest.
 			 * After each read a callback will be called that should handle the bytes just read.
 			 * After reading the full message handleMessageRead will be called
 			 * whose responsibility it is to handle the message as a whole.
@@ -91,14 +122,40 @@ namespace Messaging
 			 */
 			void readMessage()
 			{
-				headerBuffer.resize( message.getHeader().getHeaderLength());
 				boost::asio::async_read( socket, // @suppress("Invalid arguments")
-										 boost::asio::buffer( headerBuffer),
+										 boost::asio::buffer( headerBuffer.data(), Message::MessageHeader::legacyHeaderLength),
 										 [this](const boost::system::error_code& error,size_t bytes_transferred)
 										 {
-											handleHeaderRead(error,bytes_transferred);
+											handleHeaderStartRead(error,bytes_transferred);
 										 });
 			}
+			/**
+			 * This function is called after the part of the header that a 1.0 header has as well is read.
+			 * The version of the peer is taken from it, a session answers in the same version.
+			 */
+			void handleHeaderStartRead( const boost::system::error_code& error,
+										size_t bytes_transferred)
+			{
+				if (!error)
+				{
+					legacyPeer = Message::MessageHeader::isLegacyHeader( std::string_view( headerBuffer.data(), Message::MessageHeader::legacyHeaderLength));
+					if (legacyPeer)
+					{
+						handleHeaderRead( error, bytes_transferred);
+						return;
+					}
+					boost::asio::async_read( socket, // @suppress("Invalid arguments")
+											 boost::asio::buffer( headerBuffer.data() + Message::MessageHeader::legacyHeaderLength,
+																  Message::MessageHeader::headerLength - Message::MessageHeader::legacyHeaderLength),
+											 [this](const boost::system::error_code& error,size_t bytes_transferred)
+											 {
+												handleHeaderRead(error,bytes_transferred);
+											 });
+				} else
+				{
+					handleHeaderRead( error, bytes_transferred);
+				}
+			}
 			/**
 			 * This function is called after the header bytes are read.
 			 */
@@ -107,10 +164,11 @@ namespace Messaging
 			{
 				if (!error)
 				{
-					message.setHeader( Message::MessageHeader(std::string( headerBuffer.begin(), headerBuffer.end()))); // @suppress("Symbol is not resolved")
-					bodyBuffer.resize( message.getHeader().getMessageLength());
+					// The body is read straight into the message, whose capacity is kept between messages
+					std::size_t headerLength = legacyPeer ? Message::MessageHeader::legacyHeaderLength : Message::MessageHeader::headerLength;
+					message.setHeader( Message::MessageHeader( std::string_view( headerBuffer.data(), headerLength)));
 					boost::asio::async_read( socket, // @suppress("Invalid arguments")
-											 boost::asio::buffer( bodyBuffer),
+											 boost::asio::buffer( message.message),
 											 [this](const boost::system::error_code& error,size_t bytes_transferred)
 											 {
 												handleBodyRead(error,bytes_transferred);
@@ -133,7 +191,6 @@ namespace Messaging
 			{
 				if (!error)
 				{
-					message.setBody( std::string( bodyBuffer.begin(), bodyBuffer.end())); // @suppress("Symbol is not resolved")
 					handleMessageRead( error, bytes_transferred);
 				} else
 				{
@@ -150,6 +207,8 @@ namespace Messaging
 			{
 				if (!error)
 				{
+					// The handlers only get plain bodies, a body that cannot be decompressed becomes a CommunicationReadError
+					Compression::decompress( message);
 					handleMessageRead();
 				} else
 				{
@@ -169,10 +228,15 @@ namespace Messaging
 			 */
 			void writeMessage( const Message& aMessage)
 			{
-				message = aMessage;
+				if (&aMessage != &message)
+				{
+					message = aMessage;
+				}
+				// The header and body buffers must stay valid until the write is finished
+				std::size_t headerLength = message.getHeader( acceptsCompressedBodies).format( writeHeaderBuffer.data(), legacyPeer);
 				boost::asio::async_write(socket, // @suppress("Invalid arguments")
-										 boost::asio::buffer( message.getHeader().toString(), message.getHeader().getHeaderLength()),
-										 [this, aMessage](const boost::system::error_code& error, std::size_t UNUSEDPARAM(bytes_transferred))
+										 boost::asio::buffer( writeHeaderBuffer.data(), headerLength),
+										 [this](const boost::system::error_code& error, std::size_t UNUSEDPARAM(bytes_transferred))
 										 {
 											handleHeaderWritten(error);
 										 });
@@ -185,7 +249,7 @@ namespace Messaging
 				if (!error)
 				{
 					boost::asio::async_write(	socket, // @suppress("Invalid arguments")
-												boost::asio::buffer( message.getBody(), message.length()),
+												boost::asio::buffer( message.message),
 												[this](const boost::system::error_code& error, std::size_t UNUSEDPARAM(bytes_transferred))
 												{
 													handleBodyWritten(error);
@@ -241,11 +305,19 @@ namespace Messaging
 			/**
 			 *
 			 */
-			std::vector< char > headerBuffer;
+			std::array< char, Message::MessageHeader::headerLength > headerBuffer;
 			/**
 			 *
 			 */
-			std::vector< char > bodyBuffer;
+			std::array< char, Message::MessageHeader::headerLength > writeHeaderBuffer;
+			/**
+			 * True if the peer sent a 1.0 header, the messages to it are written with a 1.0 header as well
+			 */
+			bool legacyPeer = false;
+			/**
+			 * True if the messages of this session say that compressed bodies are accepted
+			 */
+			bool acceptsCompressedBodies = Compression::isEnabled();
 	};
 	// class Session
 	/**
@@ -263,6 +335,29 @@ namespace Messaging
 			{
 				sessionNumber = ++sessionCounter;
 			}
+			/**
+			 * Prepares a recycled session for a new connection
+			 */
+			void reset( RequestHandlerPtr aRequestHandler)
+			{
+				requestHandler = aRequestHandler;
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				clearSession();
+				requestHandler.reset();
+			}
+			/**
+			 * @see Session::recycle()
+			 */
+			virtual void recycle() override
+			{
+				SessionPool< ServerSession >::getSessionPool().release( this);
+			}
 			/**
 			 * @see Session::start()
 			 */
@@ -282,7 +377,7 @@ namespace Messaging
 				}else
 				{
 					TRACE_DEVELOP("*** ServerSession::handleMessageRead: " + message.asString());
-					delete this;
+					recycle();
 				}
 			}
 			/**
@@ -297,8 +392,7 @@ namespace Messaging
 				{
 					TRACE_DEVELOP("*** ServerSession::handleMessageWritten: " + message.asString());
 				}
-				// See https://isocpp.org/wiki/faq/freestore-mgmt#delete-this
-				delete this;
+				recycle();
 			}
 
 		private:
@@ -334,6 +428,32 @@ namespace Messaging
 			{
 				sessionNumber = ++sessionCounter;
 			}
+			/**
+			 * Prepares a recycled session for a new connection
+			 */
+			void reset( const Message& aMessage,
+						ResponseHandlerPtr aResponseHandler)
+			{
+				// Assignment keeps the capacity of the body
+				message = aMessage;
+				responseHandler = aResponseHandler;
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				clearSession();
+				responseHandler.reset();
+			}
+			/**
+			 * @see Session::recycle()
+			 */
+			virtual void recycle() override
+			{
+				SessionPool< ClientSession >::getSessionPool().release( this);
+			}
 			/**
 			 * @see Session::start()
 			 */
@@ -356,8 +476,7 @@ namespace Messaging
 					TRACE_DEVELOP("*** ClientSession::handleMessageRead: " + message.asString());
 				}
 
-				// See https://isocpp.org/wiki/faq/freestore-mgmt#delete-this
-				delete this;
+				recycle();
 			}
 			/**
 			 * @see Session::handleMessageWritten( Message& aMessage)
@@ -372,7 +491,7 @@ namespace Messaging
 				}else
 				{
 					TRACE_DEVELOP("*** ClientSession::handleMessageWritten: " + message.asString());
-					delete this;
+					recycle();
 				}
 			}
 		private:
@@ -391,6 +510,381 @@ namespace Messaging
 	};
 //	class ClientSession
 
+	/**
+	 * A PipelinedSession keeps its connection open for more than one request. The messages that are
+	 * sent are queued so a message can be sent while the previous one is still being written. Every
+	 * message is written in one gather write of its header and body.
+	 */
+	class PipelinedSession : virtual public Session
+	{
+		protected:
+			/**
+			 * Queues aMessage and starts writing it if no other message is being written.
+			 * Must be called from the thread that runs the io_context.
+			 */
+			void queueMessage( const Message& aMessage)
+			{
+				QueuedMessage& queuedMessage = writeQueue.emplace_back();
+				queuedMessage.headerLength = aMessage.getHeader( acceptsCompressedBodies).format( queuedMessage.header.data(), legacyPeer);
+				queuedMessage.body = MessagePool::getMessagePool().acquireBody( aMessage.length());
+				queuedMessage.body.append( aMessage.message);
+				if (writeQueue.size() == 1)
+				{
+					writeFirstQueuedMessage();
+				}
+			}
+			/**
+			 *
+			 */
+			void writeFirstQueuedMessage()
+			{
+				// References to the elements of a std::deque stay valid when elements are added at the end
+				const QueuedMessage& queuedMessage = writeQueue.front();
+				std::array< boost::asio::const_buffer, 2 > buffers = { boost::asio::buffer( queuedMessage.header.data(), queuedMessage.headerLength),
+																	   boost::asio::buffer( queuedMessage.body) };
+				boost::asio::async_write(socket, // @suppress("Invalid arguments")
+										 buffers,
+										 [this](const boost::system::error_code& error, std::size_t UNUSEDPARAM(bytes_transferred))
+										 {
+											handleQueuedMessageWritten(error);
+										 });
+			}
+			/**
+			 * Writes the next queued message if any. Session::handleMessageWritten is called when the queue is empty.
+			 * If the write failed the socket is closed, which ends the pending read as well.
+			 */
+			void handleQueuedMessageWritten( const boost::system::error_code& error)
+			{
+				if (!error)
+				{
+					MessagePool::getMessagePool().releaseBody( std::move( writeQueue.front().body));
+					writeQueue.pop_front();
+					if (!writeQueue.empty())
+					{
+						writeFirstQueuedMessage();
+						return;
+					}
+				} else
+				{
+					TRACE_DEVELOP("*** PipelinedSession::handleQueuedMessageWritten: " + error.message());
+					clearWriteQueue();
+					boost::system::error_code ignored;
+					socket.close( ignored);
+				}
+				handleMessageWritten();
+			}
+			/**
+			 * Gives the bodies of the queued messages back to the MessagePool
+			 */
+			void clearWriteQueue()
+			{
+				for (QueuedMessage& queuedMessage : writeQueue)
+				{
+					MessagePool::getMessagePool().releaseBody( std::move( queuedMessage.body));
+				}
+				writeQueue.clear();
+			}
+			/**
+			 * A formatted header and a body from the MessagePool
+			 */
+			struct QueuedMessage
+			{
+					std::array< char, Message::MessageHeader::headerLength > header;
+					std::size_t headerLength = Message::MessageHeader::headerLength;
+					std::string body;
+			};
+			/**
+			 * The messages that are waiting to be written, the front one is being written
+			 */
+			std::deque< QueuedMessage > writeQueue;
+			/**
+			 * True if the reading has stopped, after that the session is deleted as soon as the write queue is empty
+			 */
+			bool readingStopped = false;
+	};
+	// class PipelinedSession
+	/**
+	 * A PipelinedServerSession handles requests until the client closes the connection. The next request
+	 * is read while the response to the previous one is being written. The response carries the
+	 * correlation id of its request.
+	 *
+	 * A client that sends one request per connection, like ClientSession does, is served as well:
+	 * it closes the connection after the response, which ends the session. A client of protocol
+	 * version 1.0 is answered with 1.0 headers, its requests have no correlation id.
+	 */
+	class PipelinedServerSession : public PipelinedSession
+	{
+		public:
+			/**
+			 *
+			 * @param aRequestHandler
+			 * @param aRequestDispatcher If given the requests are handled by its model thread instead of the thread that runs the io_context
+			 */
+			explicit PipelinedServerSession( 	RequestHandlerPtr aRequestHandler,
+												RequestDispatcherPtr aRequestDispatcher = nullptr) :
+									requestHandler( aRequestHandler),
+									requestDispatcher( aRequestDispatcher)
+			{
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 * Prepares a recycled session for a new connection
+			 */
+			void reset( RequestHandlerPtr aRequestHandler,
+						RequestDispatcherPtr aRequestDispatcher = nullptr)
+			{
+				requestHandler = aRequestHandler;
+				requestDispatcher = aRequestDispatcher;
+				readingStopped = false;
+				numberOfDispatchedRequests = 0;
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				clearSession();
+				clearWriteQueue();
+				requestHandler.reset();
+				requestDispatcher.reset();
+			}
+			/**
+			 * @see Session::recycle()
+			 */
+			virtual void recycle() override
+			{
+				SessionPool< PipelinedServerSession >::getSessionPool().release( this);
+			}
+			/**
+			 * @see Session::start()
+			 */
+			virtual void start() override
+			{
+				readMessage();
+			}
+			/**
+			 * @see Session::handleMessageRead( Message& aMessage)
+			 */
+			virtual void handleMessageRead() override
+			{
+				if(message.getMessageType() != CommunicationReadError)
+				{
+					if (requestDispatcher)
+					{
+						dispatchRequest();
+					} else
+					{
+						requestHandler->handleRequest( message);
+						queueMessage( message);
+					}
+					readMessage();
+				}else
+				{
+					// The client closing the connection is the normal end of the session
+					if (message.message.find( "End of file") == std::string::npos)
+					{
+						TRACE_DEVELOP("*** PipelinedServerSession::handleMessageRead: " + message.asString());
+					}
+					readingStopped = true;
+					recycleWhenIdle();
+				}
+			}
+			/**
+			 * Called when the write queue is empty
+			 *
+			 * @see Session::handleMessageWritten( Message& aMessage)
+			 */
+			virtual void handleMessageWritten() override
+			{
+				recycleWhenIdle();
+			}
+		private:
+			/**
+			 * Hands the request to the model thread of the dispatcher. If the queue of the dispatcher is full
+			 * the request is answered with a ServerSideExceptionResponse right away.
+			 */
+			void dispatchRequest()
+			{
+				++numberOfDispatchedRequests;
+				if (!requestDispatcher->dispatch(	message,
+													requestHandler,
+													[this](const Message& aResponse)
+													{
+														handleDispatchedResponse( aResponse);
+													}))
+				{
+					--numberOfDispatchedRequests;
+					TRACE_DEVELOP("*** PipelinedServerSession::dispatchRequest: dispatch queue full, " + message.getHeader().asString());
+					message.setMessageType( ServerSideExceptionResponse);
+					message.setBody( "*** PipelinedServerSession::dispatchRequest: server busy");
+					queueMessage( message);
+				}
+			}
+			/**
+			 * Called on the thread that runs the io_context when the model thread has handled a request
+			 */
+			void handleDispatchedResponse( const Message& aResponse)
+			{
+				--numberOfDispatchedRequests;
+				if (socket.is_open())
+				{
+					queueMessage( aResponse);
+				} else
+				{
+					recycleWhenIdle();
+				}
+			}
+			/**
+			 * The session is recycled when the client has closed the connection, all responses are
+			 * written and no request is being handled by the dispatcher anymore
+			 */
+			void recycleWhenIdle()
+			{
+				if (readingStopped && writeQueue.empty() && numberOfDispatchedRequests == 0)
+				{
+					recycle();
+				}
+			}
+			/**
+			 *
+			 */
+			RequestHandlerPtr  requestHandler;
+			/**
+			 *
+			 */
+			RequestDispatcherPtr requestDispatcher;
+			/**
+			 * The number of requests that are handed to the dispatcher and not answered yet
+			 */
+			unsigned long numberOfDispatchedRequests = 0;
+			/**
+			 *
+			 */
+			unsigned long sessionNumber = 0;
+			/**
+			 *
+			 */
+			inline static unsigned long sessionCounter = 0;
+	};
+	// class PipelinedServerSession
+	/**
+	 * A PipelinedClientSession sends requests over one connection without waiting for the responses
+	 * of the previous requests. Every response, and the read error that ends the session, is passed
+	 * to the response function, which matches it to its request by the correlation id.
+	 */
+	class PipelinedClientSession : public PipelinedSession
+	{
+		public:
+			/**
+			 *
+			 */
+			typedef std::function< void( const Message&) > ResponseFunction;
+			/**
+			 *
+			 * @param aResponseFunction
+			 */
+			explicit PipelinedClientSession( ResponseFunction aResponseFunction) :
+							responseFunction( aResponseFunction)
+			{
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 * Prepares a recycled session for a new connection
+			 */
+			void reset( ResponseFunction aResponseFunction)
+			{
+				responseFunction = aResponseFunction;
+				readingStopped = false;
+				sessionNumber = ++sessionCounter;
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				clearSession();
+				clearWriteQueue();
+				responseFunction = nullptr;
+			}
+			/**
+			 * @see Session::recycle()
+			 */
+			virtual void recycle() override
+			{
+				SessionPool< PipelinedClientSession >::getSessionPool().release( this);
+			}
+			/**
+			 * Starts reading the responses, must be called after the socket is connected
+			 *
+			 * @see Session::start()
+			 */
+			virtual void start() override
+			{
+				readMessage();
+			}
+			/**
+			 * Sends aRequest. Must be called from the thread that runs the io_context.
+			 */
+			void sendMessage( const Message& aRequest)
+			{
+				queueMessage( aRequest);
+			}
+			/**
+			 * Closes the connection, the session is deleted after the pending read is ended.
+			 * Must be called from the thread that runs the io_context.
+			 */
+			void close()
+			{
+				boost::system::error_code ignored;
+				socket.close( ignored);
+			}
+			/**
+			 * @see Session::handleMessageRead( Message& aMessage)
+			 */
+			virtual void handleMessageRead() override
+			{
+				responseFunction( message);
+				if(message.getMessageType() != CommunicationReadError)
+				{
+					readMessage();
+				}else
+				{
+					readingStopped = true;
+					if (writeQueue.empty())
+					{
+						recycle();
+					}
+				}
+			}
+			/**
+			 * Called when the write queue is empty
+			 *
+			 * @see Session::handleMessageWritten( Message& aMessage)
+			 */
+			virtual void handleMessageWritten() override
+			{
+				if (readingStopped)
+				{
+					recycle();
+				}
+			}
+		private:
+			/**
+			 *
+			 */
+			ResponseFunction responseFunction;
+			/**
+			 *
+			 */
+			unsigned long sessionNumber = 0;
+			/**
+			 *
+			 */
+			inline static unsigned long sessionCounter = 0;
+	};
+	// class PipelinedClientSession
+
 }// namespace Messaging
 
 #endif // SESSION_HPP_
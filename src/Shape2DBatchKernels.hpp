@@ -0,0 +1,245 @@
+// No include guard: Shape2DUtils.cpp includes this file twice, once for the scalar and SSE2 lanes and once
+// in a region with the AVX2 target for the AVX2 lanes. It expects the lanes types, Line and ScalarLanes of
+// Shape2DUtils.cpp in an enclosing namespace; each copy gets a namespace of its own.
+
+		/**
+		 * The computation of Shape2DUtils::getIntersection and the test of Shape2DUtils::intersect for the lanes at anIndex
+		 */
+		template< typename Lanes >
+		typename Lanes::Mask intersectLanes(	const Line& aLine,
+												const LineSegmentBatch& aLines,
+												std::size_t anIndex)
+		{
+			typedef typename Lanes::Real Real;
+			Real x3 = Lanes::load( aLines.startX.data() + anIndex);
+			Real y3 = Lanes::load( aLines.startY.data() + anIndex);
+			Real x4 = Lanes::load( aLines.endX.data() + anIndex);
+			Real y4 = Lanes::load( aLines.endY.data() + anIndex);
+			Real x3mx4 = Lanes::subtract( x3, x4);
+			Real y3my4 = Lanes::subtract( y3, y4);
+
+			Real d = Lanes::subtract( Lanes::multiply( Lanes::broadcast( aLine.x1mx2), y3my4), Lanes::multiply( Lanes::broadcast( aLine.y1my2), x3mx4));
+			typename Lanes::Mask result = Lanes::greater( Lanes::absolute( d), Lanes::broadcast( std::numeric_limits< float >::epsilon()));
+
+			Real post = Lanes::subtract( Lanes::multiply( x3, y4), Lanes::multiply( y3, x4));
+			Real x = Lanes::divide( Lanes::subtract( Lanes::multiply( Lanes::broadcast( aLine.pre), x3mx4), Lanes::multiply( Lanes::broadcast( aLine.x1mx2), post)), d);
+			Real y = Lanes::divide( Lanes::subtract( Lanes::multiply( Lanes::broadcast( aLine.pre), y3my4), Lanes::multiply( Lanes::broadcast( aLine.y1my2), post)), d);
+
+			result = Lanes::both( result, Lanes::both( Lanes::greaterEqual( x, Lanes::broadcast( aLine.minimumX)), Lanes::lessEqual( x, Lanes::broadcast( aLine.maximumX))));
+			result = Lanes::both( result, Lanes::both( Lanes::greaterEqual( x, Lanes::minimum( x3, x4)), Lanes::lessEqual( x, Lanes::maximum( x3, x4))));
+			result = Lanes::both( result, Lanes::both( Lanes::greaterEqual( y, Lanes::broadcast( aLine.minimumY)), Lanes::lessEqual( y, Lanes::broadcast( aLine.maximumY))));
+			result = Lanes::both( result, Lanes::both( Lanes::greaterEqual( y, Lanes::minimum( y3, y4)), Lanes::lessEqual( y, Lanes::maximum( y3, y4))));
+
+			// intersect compares the truncated intersection with wxDefaultPosition, (-1,-1) counts as no intersection
+			typename Lanes::Mask isDefaultPosition = Lanes::both(	Lanes::both( Lanes::greater( x, Lanes::broadcast( -2.0)), Lanes::lessEqual( x, Lanes::broadcast( -1.0))),
+																	Lanes::both( Lanes::greater( y, Lanes::broadcast( -2.0)), Lanes::lessEqual( y, Lanes::broadcast( -1.0))));
+			return Lanes::butNot( result, isDefaultPosition);
+		}
+		/**
+		 * The test of Shape2DUtils::isOnLine for the lanes at anIndex
+		 */
+		template< typename Lanes >
+		typename Lanes::Mask isOnLineLanes(	const LineSegmentBatch& aLines,
+											double aPointX,
+											double aPointY,
+											double aRadius,
+											std::size_t anIndex)
+		{
+			typedef typename Lanes::Real Real;
+			Real startX = Lanes::load( aLines.startX.data() + anIndex);
+			Real startY = Lanes::load( aLines.startY.data() + anIndex);
+			Real endX = Lanes::load( aLines.endX.data() + anIndex);
+			Real endY = Lanes::load( aLines.endY.data() + anIndex);
+			Real pointX = Lanes::broadcast( aPointX);
+			Real pointY = Lanes::broadcast( aPointY);
+			Real radius = Lanes::broadcast( aRadius);
+
+			typename Lanes::Mask result = Lanes::both(	Lanes::greaterEqual( pointX, Lanes::subtract( Lanes::minimum( startX, endX), radius)),
+														Lanes::lessEqual( pointX, Lanes::add( Lanes::maximum( startX, endX), radius)));
+			result = Lanes::both( result, Lanes::both(	Lanes::greaterEqual( pointY, Lanes::subtract( Lanes::minimum( startY, endY), radius)),
+														Lanes::lessEqual( pointY, Lanes::add( Lanes::maximum( startY, endY), radius))));
+
+			Real dx = Lanes::subtract( startX, endX);
+			Real dy = Lanes::subtract( startY, endY);
+			Real normalLength = Lanes::squareRoot( Lanes::add( Lanes::multiply( dx, dx), Lanes::multiply( dy, dy)));
+			Real distance = Lanes::divide( Lanes::absolute( Lanes::subtract( Lanes::multiply( Lanes::subtract( pointX, endX), dy), Lanes::multiply( Lanes::subtract( pointY, endY), dx))), normalLength);
+
+			return Lanes::both( result, Lanes::less( distance, radius));
+		}
+		/**
+		 * The computation of Shape2DUtils::distance for the lanes at anIndex
+		 */
+		template< typename Lanes >
+		typename Lanes::Real distanceLanes(	double aPointX,
+											double aPointY,
+											const PointBatch& aPoints,
+											std::size_t anIndex)
+		{
+			typedef typename Lanes::Real Real;
+			Real dx = Lanes::subtract( Lanes::broadcast( aPointX), Lanes::load( aPoints.x.data() + anIndex));
+			Real dy = Lanes::subtract( Lanes::broadcast( aPointY), Lanes::load( aPoints.y.data() + anIndex));
+			return Lanes::squareRoot( Lanes::add( Lanes::multiply( dx, dx), Lanes::multiply( dy, dy)));
+		}
+		/**
+		 * The test of Shape2DUtils::isInsidePolygon for the lanes at anIndex
+		 */
+		template< typename Lanes >
+		typename Lanes::Mask isInsidePolygonLanes(	const wxPoint* aPolygon,
+													int aNumberOfPoints,
+													const PointBatch& aPoints,
+													std::size_t anIndex)
+		{
+			typedef typename Lanes::Real Real;
+			Real pointX = Lanes::load( aPoints.x.data() + anIndex);
+			Real pointY = Lanes::load( aPoints.y.data() + anIndex);
+
+			// Every crossed edge flips the result
+			typename Lanes::Mask inside = Lanes::none();
+			wxPoint p1 = aPolygon[0];
+			for (int i = 1; i <= aNumberOfPoints; i++)
+			{
+				wxPoint p2 = aPolygon[i % aNumberOfPoints];
+				if (p1.y != p2.y)
+				{
+					typename Lanes::Mask crosses = Lanes::both(	Lanes::greater( pointY, Lanes::broadcast( std::min( p1.y, p2.y))),
+																Lanes::lessEqual( pointY, Lanes::broadcast( std::max( p1.y, p2.y))));
+					crosses = Lanes::both( crosses, Lanes::lessEqual( pointX, Lanes::broadcast( std::max( p1.x, p2.x))));
+					if (p1.x != p2.x)
+					{
+						double dx = p2.x - p1.x;
+						double dy = p2.y - p1.y;
+						Real xinters = Lanes::add( Lanes::multiply( Lanes::broadcast( dx / dy), Lanes::subtract( pointY, Lanes::broadcast( p1.y))), Lanes::broadcast( p1.x));
+						crosses = Lanes::both( crosses, Lanes::lessEqual( pointX, xinters));
+					}
+					inside = Lanes::differ( inside, crosses);
+				}
+				p1 = p2;
+			}
+			return inside;
+		}
+		/**
+		 * Stores one byte per lane
+		 */
+		template< typename Lanes >
+		void storeMask(	typename Lanes::Mask aMask,
+						std::uint8_t* aDestination)
+		{
+			unsigned bits = Lanes::bits( aMask);
+			for (std::size_t lane = 0; lane < Lanes::width; ++lane)
+			{
+				aDestination[lane] = static_cast< std::uint8_t >( (bits >> lane) & 1);
+			}
+		}
+		/**
+		 * @name The batch loops, the vector lanes and then the remainder one at a time
+		 */
+		//@{
+		template< typename Lanes >
+		void intersectBatch(	const Line& aLine,
+								const LineSegmentBatch& aLines,
+								std::uint8_t* anIntersects)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aLines.size(); i += Lanes::width)
+			{
+				storeMask< Lanes >( intersectLanes< Lanes >( aLine, aLines, i), anIntersects + i);
+			}
+			for (; i < aLines.size(); ++i)
+			{
+				anIntersects[i] = intersectLanes< ScalarLanes >( aLine, aLines, i);
+			}
+		}
+		template< typename Lanes >
+		bool intersectsAnyBatch(	const Line& aLine,
+									const LineSegmentBatch& aLines)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aLines.size(); i += Lanes::width)
+			{
+				if (Lanes::bits( intersectLanes< Lanes >( aLine, aLines, i)) != 0)
+				{
+					return true;
+				}
+			}
+			for (; i < aLines.size(); ++i)
+			{
+				if (intersectLanes< ScalarLanes >( aLine, aLines, i))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		template< typename Lanes >
+		void isOnLineBatch(	const LineSegmentBatch& aLines,
+							double aPointX,
+							double aPointY,
+							double aRadius,
+							std::uint8_t* anIsOnLine)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aLines.size(); i += Lanes::width)
+			{
+				storeMask< Lanes >( isOnLineLanes< Lanes >( aLines, aPointX, aPointY, aRadius, i), anIsOnLine + i);
+			}
+			for (; i < aLines.size(); ++i)
+			{
+				anIsOnLine[i] = isOnLineLanes< ScalarLanes >( aLines, aPointX, aPointY, aRadius, i);
+			}
+		}
+		template< typename Lanes >
+		bool isOnAnyLineBatch(	const LineSegmentBatch& aLines,
+								double aPointX,
+								double aPointY,
+								double aRadius)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aLines.size(); i += Lanes::width)
+			{
+				if (Lanes::bits( isOnLineLanes< Lanes >( aLines, aPointX, aPointY, aRadius, i)) != 0)
+				{
+					return true;
+				}
+			}
+			for (; i < aLines.size(); ++i)
+			{
+				if (isOnLineLanes< ScalarLanes >( aLines, aPointX, aPointY, aRadius, i))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+		template< typename Lanes >
+		void distanceBatch(	double aPointX,
+							double aPointY,
+							const PointBatch& aPoints,
+							double* aDistances)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aPoints.size(); i += Lanes::width)
+			{
+				Lanes::store( aDistances + i, distanceLanes< Lanes >( aPointX, aPointY, aPoints, i));
+			}
+			for (; i < aPoints.size(); ++i)
+			{
+				aDistances[i] = distanceLanes< ScalarLanes >( aPointX, aPointY, aPoints, i);
+			}
+		}
+		template< typename Lanes >
+		void isInsidePolygonBatch(	const wxPoint* aPolygon,
+									int aNumberOfPoints,
+									const PointBatch& aPoints,
+									std::uint8_t* anIsInside)
+		{
+			std::size_t i = 0;
+			for (; i + Lanes::width <= aPoints.size(); i += Lanes::width)
+			{
+				storeMask< Lanes >( isInsidePolygonLanes< Lanes >( aPolygon, aNumberOfPoints, aPoints, i), anIsInside + i);
+			}
+			for (; i < aPoints.size(); ++i)
+			{
+				anIsInside[i] = isInsidePolygonLanes< ScalarLanes >( aPolygon, aNumberOfPoints, aPoints, i);
+			}
+		}
+		//@}
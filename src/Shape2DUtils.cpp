@@ -3,10 +3,218 @@
 #include "Logger.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHAPE2DUTILS_X86
+#endif
+
 namespace Utils
 {
+	namespace
+	{
+		/**
+		 * The operations of the batch kernels on one lane, the fallback and the tail of the vector loops
+		 */
+		struct ScalarLanes
+		{
+				typedef double Real;
+				typedef bool Mask;
+				static constexpr std::size_t width = 1;
+
+				static Real load( const double* aValue) { return *aValue; }
+				static void store( double* aDestination, Real aValue) { *aDestination = aValue; }
+				static Real broadcast( double aValue) { return aValue; }
+				static Real add( Real a, Real b) { return a + b; }
+				static Real subtract( Real a, Real b) { return a - b; }
+				static Real multiply( Real a, Real b) { return a * b; }
+				static Real divide( Real a, Real b) { return a / b; }
+				static Real squareRoot( Real a) { return std::sqrt( a); }
+				static Real absolute( Real a) { return std::fabs( a); }
+				static Real minimum( Real a, Real b) { return std::min( a, b); }
+				static Real maximum( Real a, Real b) { return std::max( a, b); }
+				static Mask less( Real a, Real b) { return a < b; }
+				static Mask lessEqual( Real a, Real b) { return a <= b; }
+				static Mask greater( Real a, Real b) { return a > b; }
+				static Mask greaterEqual( Real a, Real b) { return a >= b; }
+				static Mask both( Mask a, Mask b) { return a && b; }
+				static Mask butNot( Mask a, Mask b) { return a && !b; }
+				static Mask differ( Mask a, Mask b) { return a != b; }
+				static Mask none() { return false; }
+				static unsigned bits( Mask a) { return a ? 1 : 0; }
+		};
+
+#ifdef SHAPE2DUTILS_X86
+		/**
+		 * SSE2 is part of every x86-64 processor
+		 */
+		struct Sse2Lanes
+		{
+				typedef __m128d Real;
+				typedef __m128d Mask;
+				static constexpr std::size_t width = 2;
+
+				static Real load( const double* aValue) { return _mm_loadu_pd( aValue); }
+				static void store( double* aDestination, Real aValue) { _mm_storeu_pd( aDestination, aValue); }
+				static Real broadcast( double aValue) { return _mm_set1_pd( aValue); }
+				static Real add( Real a, Real b) { return _mm_add_pd( a, b); }
+				static Real subtract( Real a, Real b) { return _mm_sub_pd( a, b); }
+				static Real multiply( Real a, Real b) { return _mm_mul_pd( a, b); }
+				static Real divide( Real a, Real b) { return _mm_div_pd( a, b); }
+				static Real squareRoot( Real a) { return _mm_sqrt_pd( a); }
+				static Real absolute( Real a) { return _mm_andnot_pd( _mm_set1_pd( -0.0), a); }
+				static Real minimum( Real a, Real b) { return _mm_min_pd( a, b); }
+				static Real maximum( Real a, Real b) { return _mm_max_pd( a, b); }
+				static Mask less( Real a, Real b) { return _mm_cmplt_pd( a, b); }
+				static Mask lessEqual( Real a, Real b) { return _mm_cmple_pd( a, b); }
+				static Mask greater( Real a, Real b) { return _mm_cmpgt_pd( a, b); }
+				static Mask greaterEqual( Real a, Real b) { return _mm_cmpge_pd( a, b); }
+				static Mask both( Mask a, Mask b) { return _mm_and_pd( a, b); }
+				static Mask butNot( Mask a, Mask b) { return _mm_andnot_pd( b, a); }
+				static Mask differ( Mask a, Mask b) { return _mm_xor_pd( a, b); }
+				static Mask none() { return _mm_setzero_pd(); }
+				static unsigned bits( Mask a) { return static_cast< unsigned >( _mm_movemask_pd( a)); }
+		};
+#endif // SHAPE2DUTILS_X86
+
+		/**
+		 * The values of the line that is tested against the batch, computed once
+		 */
+		struct Line
+		{
+				Line(	const wxPoint& aStartLine,
+						const wxPoint& anEndLine) :
+							x1mx2( aStartLine.x - anEndLine.x),
+							y1my2( aStartLine.y - anEndLine.y),
+							pre( static_cast< double >( aStartLine.x) * anEndLine.y - static_cast< double >( aStartLine.y) * anEndLine.x),
+							minimumX( std::min( aStartLine.x, anEndLine.x)),
+							maximumX( std::max( aStartLine.x, anEndLine.x)),
+							minimumY( std::min( aStartLine.y, anEndLine.y)),
+							maximumY( std::max( aStartLine.y, anEndLine.y))
+				{
+				}
+				double x1mx2;
+				double y1my2;
+				double pre;
+				double minimumX;
+				double maximumX;
+				double minimumY;
+				double maximumY;
+		};
+		/**
+		 * The kernels for the scalar and SSE2 lanes
+		 */
+		namespace GenericKernels
+		{
+#include "Shape2DBatchKernels.hpp"
+		} // namespace GenericKernels
+
+		/**
+		 * The batch loops of one instruction set
+		 */
+		struct BatchKernels
+		{
+				const char* instructionSet;
+				void (*intersect)( const Line&, const LineSegmentBatch&, std::uint8_t*);
+				bool (*intersectsAny)( const Line&, const LineSegmentBatch&);
+				void (*isOnLine)( const LineSegmentBatch&, double, double, double, std::uint8_t*);
+				bool (*isOnAnyLine)( const LineSegmentBatch&, double, double, double);
+				void (*distance)( double, double, const PointBatch&, double*);
+				void (*isInsidePolygon)( const wxPoint*, int, const PointBatch&, std::uint8_t*);
+		};
+
+#ifdef SHAPE2DUTILS_X86
+// Everything up to the pop_options has the AVX2 target, also the kernels that are instantiated with the
+// AVX2 lanes, so the AVX vectors are never passed by a function without AVX. Only called after the
+// processor is checked for AVX2.
+#pragma GCC push_options
+#pragma GCC target("avx2")
+		/**
+		 * Only used by the kernels in Avx2Kernels, which are selected if the processor has AVX2
+		 */
+		struct Avx2Lanes
+		{
+				typedef __m256d Real;
+				typedef __m256d Mask;
+				static constexpr std::size_t width = 4;
+
+				static Real load( const double* aValue) { return _mm256_loadu_pd( aValue); }
+				static void store( double* aDestination, Real aValue) { _mm256_storeu_pd( aDestination, aValue); }
+				static Real broadcast( double aValue) { return _mm256_set1_pd( aValue); }
+				static Real add( Real a, Real b) { return _mm256_add_pd( a, b); }
+				static Real subtract( Real a, Real b) { return _mm256_sub_pd( a, b); }
+				static Real multiply( Real a, Real b) { return _mm256_mul_pd( a, b); }
+				static Real divide( Real a, Real b) { return _mm256_div_pd( a, b); }
+				static Real squareRoot( Real a) { return _mm256_sqrt_pd( a); }
+				static Real absolute( Real a) { return _mm256_andnot_pd( _mm256_set1_pd( -0.0), a); }
+				static Real minimum( Real a, Real b) { return _mm256_min_pd( a, b); }
+				static Real maximum( Real a, Real b) { return _mm256_max_pd( a, b); }
+				static Mask less( Real a, Real b) { return _mm256_cmp_pd( a, b, _CMP_LT_OQ); }
+				static Mask lessEqual( Real a, Real b) { return _mm256_cmp_pd( a, b, _CMP_LE_OQ); }
+				static Mask greater( Real a, Real b) { return _mm256_cmp_pd( a, b, _CMP_GT_OQ); }
+				static Mask greaterEqual( Real a, Real b) { return _mm256_cmp_pd( a, b, _CMP_GE_OQ); }
+				static Mask both( Mask a, Mask b) { return _mm256_and_pd( a, b); }
+				static Mask butNot( Mask a, Mask b) { return _mm256_andnot_pd( b, a); }
+				static Mask differ( Mask a, Mask b) { return _mm256_xor_pd( a, b); }
+				static Mask none() { return _mm256_setzero_pd(); }
+				static unsigned bits( Mask a) { return static_cast< unsigned >( _mm256_movemask_pd( a)); }
+		};
+		/**
+		 * The kernels again, with the AVX2 target
+		 */
+		namespace Avx2Kernels
+		{
+#include "Shape2DBatchKernels.hpp"
+		} // namespace Avx2Kernels
+#pragma GCC pop_options
+#endif // SHAPE2DUTILS_X86
+
+		/**
+		 *
+		 */
+		template< typename Lanes >
+		BatchKernels makeBatchKernels( const char* anInstructionSet)
+		{
+			return BatchKernels{ anInstructionSet,
+								 &GenericKernels::intersectBatch< Lanes >,
+								 &GenericKernels::intersectsAnyBatch< Lanes >,
+								 &GenericKernels::isOnLineBatch< Lanes >,
+								 &GenericKernels::isOnAnyLineBatch< Lanes >,
+								 &GenericKernels::distanceBatch< Lanes >,
+								 &GenericKernels::isInsidePolygonBatch< Lanes > };
+		}
+		/**
+		 * Selects the instruction set once, at the first call
+		 */
+		const BatchKernels& getBatchKernels()
+		{
+			static const BatchKernels batchKernels = []()
+			{
+#ifdef SHAPE2DUTILS_X86
+				if (__builtin_cpu_supports( "avx2"))
+				{
+					return BatchKernels{ "avx2",
+										 &Avx2Kernels::intersectBatch< Avx2Lanes >,
+										 &Avx2Kernels::intersectsAnyBatch< Avx2Lanes >,
+										 &Avx2Kernels::isOnLineBatch< Avx2Lanes >,
+										 &Avx2Kernels::isOnAnyLineBatch< Avx2Lanes >,
+										 &Avx2Kernels::distanceBatch< Avx2Lanes >,
+										 &Avx2Kernels::isInsidePolygonBatch< Avx2Lanes > };
+				}
+				if (__builtin_cpu_supports( "sse2"))
+				{
+					return makeBatchKernels< Sse2Lanes >( "sse2");
+				}
+#endif // SHAPE2DUTILS_X86
+				return makeBatchKernels< ScalarLanes >( "scalar");
+			}();
+			return batchKernels;
+		}
+	} // namespace
+
 	/**
 	 *
 	 * @param aStartpoint
@@ -381,6 +589,74 @@ namespace Utils
 		return result;
 		//return getCompassPoint( aPoint, aSize, aBorderPoint,aRadius) == aCompassPoint;
 	}
+	/**
+	 *
+	 */
+	/* static */void Shape2DUtils::intersect(	const wxPoint& aStartLine,
+												const wxPoint& anEndLine,
+												const LineSegmentBatch& aLines,
+												std::vector< std::uint8_t >& anIntersects)
+	{
+		anIntersects.resize( aLines.size());
+		getBatchKernels().intersect( Line( aStartLine, anEndLine), aLines, anIntersects.data());
+	}
+	/**
+	 *
+	 */
+	/* static */bool Shape2DUtils::intersectsAny(	const wxPoint& aStartLine,
+													const wxPoint& anEndLine,
+													const LineSegmentBatch& aLines)
+	{
+		return getBatchKernels().intersectsAny( Line( aStartLine, anEndLine), aLines);
+	}
+	/**
+	 *
+	 */
+	/* static */void Shape2DUtils::isOnLine(	const LineSegmentBatch& aLines,
+												const wxPoint& aPoint,
+												int aRadius,
+												std::vector< std::uint8_t >& anIsOnLine)
+	{
+		anIsOnLine.resize( aLines.size());
+		getBatchKernels().isOnLine( aLines, aPoint.x, aPoint.y, aRadius, anIsOnLine.data());
+	}
+	/**
+	 *
+	 */
+	/* static */bool Shape2DUtils::isOnAnyLine(	const LineSegmentBatch& aLines,
+												const wxPoint& aPoint,
+												int aRadius /* = 6 */)
+	{
+		return getBatchKernels().isOnAnyLine( aLines, aPoint.x, aPoint.y, aRadius);
+	}
+	/**
+	 *
+	 */
+	/* static */void Shape2DUtils::distance(	const wxPoint& aPoint,
+												const PointBatch& aPoints,
+												std::vector< double >& aDistances)
+	{
+		aDistances.resize( aPoints.size());
+		getBatchKernels().distance( aPoint.x, aPoint.y, aPoints, aDistances.data());
+	}
+	/**
+	 *
+	 */
+	/* static */void Shape2DUtils::isInsidePolygon(	const wxPoint* aPolygon,
+													int aNumberOfPoints,
+													const PointBatch& aPoints,
+													std::vector< std::uint8_t >& anIsInside)
+	{
+		anIsInside.resize( aPoints.size());
+		getBatchKernels().isInsidePolygon( aPolygon, aNumberOfPoints, aPoints, anIsInside.data());
+	}
+	/**
+	 *
+	 */
+	/* static */std::string Shape2DUtils::getBatchInstructionSet()
+	{
+		return getBatchKernels().instructionSet;
+	}
 	/**
 	 *
 	 */
@@ -8,10 +8,103 @@
 #include "Point.hpp"
 #include "Size.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Utils
 {
+	/**
+	 * Line segments as a structure of arrays, the input of the batch functions of Shape2DUtils
+	 */
+	struct LineSegmentBatch
+	{
+			/**
+			 *
+			 */
+			void add(	const wxPoint& aStartPoint,
+						const wxPoint& anEndPoint)
+			{
+				startX.push_back( aStartPoint.x);
+				startY.push_back( aStartPoint.y);
+				endX.push_back( anEndPoint.x);
+				endY.push_back( anEndPoint.y);
+			}
+			/**
+			 *
+			 */
+			void reserve( std::size_t aSize)
+			{
+				startX.reserve( aSize);
+				startY.reserve( aSize);
+				endX.reserve( aSize);
+				endY.reserve( aSize);
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				startX.clear();
+				startY.clear();
+				endX.clear();
+				endY.clear();
+			}
+			/**
+			 *
+			 */
+			std::size_t size() const
+			{
+				return startX.size();
+			}
+
+			std::vector< double > startX;
+			std::vector< double > startY;
+			std::vector< double > endX;
+			std::vector< double > endY;
+	};
+	/**
+	 * Points as a structure of arrays, the input of the batch functions of Shape2DUtils
+	 */
+	struct PointBatch
+	{
+			/**
+			 *
+			 */
+			void add( const wxPoint& aPoint)
+			{
+				x.push_back( aPoint.x);
+				y.push_back( aPoint.y);
+			}
+			/**
+			 *
+			 */
+			void reserve( std::size_t aSize)
+			{
+				x.reserve( aSize);
+				y.reserve( aSize);
+			}
+			/**
+			 *
+			 */
+			void clear()
+			{
+				x.clear();
+				y.clear();
+			}
+			/**
+			 *
+			 */
+			std::size_t size() const
+			{
+				return x.size();
+			}
+
+			std::vector< double > x;
+			std::vector< double > y;
+	};
+
 	/**
 	 *
 	 */
@@ -147,6 +240,65 @@ namespace Utils
 										CompassPoint aCompassPoint,
 										int aRadius = 6);
 
+			/**
+			 * @name Batch functions
+			 *
+			 * The batch functions test one line or point against all elements of a batch and give the same
+			 * results as the functions above for every element. They use AVX2 or SSE2 if the processor has it,
+			 * selected once at run time, and plain C++ otherwise.
+			 */
+			//@{
+			/**
+			 *
+			 * @param anIntersects Is resized to the size of aLines, 1 if the line intersects that line, 0 otherwise
+			 */
+			static void intersect(	const wxPoint& aStartLine,
+									const wxPoint& anEndLine,
+									const LineSegmentBatch& aLines,
+									std::vector< std::uint8_t >& anIntersects);
+			/**
+			 *
+			 * @return True if the line intersects any of aLines
+			 */
+			static bool intersectsAny(	const wxPoint& aStartLine,
+										const wxPoint& anEndLine,
+										const LineSegmentBatch& aLines);
+			/**
+			 *
+			 * @param anIsOnLine Is resized to the size of aLines, 1 if aPoint is within aRadius of that line, 0 otherwise
+			 */
+			static void isOnLine(	const LineSegmentBatch& aLines,
+									const wxPoint& aPoint,
+									int aRadius,
+									std::vector< std::uint8_t >& anIsOnLine);
+			/**
+			 *
+			 * @return True if aPoint is within aRadius of any of aLines
+			 */
+			static bool isOnAnyLine(	const LineSegmentBatch& aLines,
+										const wxPoint& aPoint,
+										int aRadius = 6);
+			/**
+			 *
+			 * @param aDistances Is resized to the size of aPoints, the distance between aPoint and that point
+			 */
+			static void distance(	const wxPoint& aPoint,
+									const PointBatch& aPoints,
+									std::vector< double >& aDistances);
+			/**
+			 *
+			 * @param anIsInside Is resized to the size of aPoints, 1 if that point is inside the polygon, 0 otherwise
+			 */
+			static void isInsidePolygon(	const wxPoint* aPolygon,
+											int aNumberOfPoints,
+											const PointBatch& aPoints,
+											std::vector< std::uint8_t >& anIsInside);
+			/**
+			 *
+			 * @return "avx2", "sse2" or "scalar", the instruction set the batch functions use on this processor
+			 */
+			static std::string getBatchInstructionSet();
+			//@}
 			/**
 			 *
 			 */
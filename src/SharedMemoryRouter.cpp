@@ -0,0 +1,520 @@
+#include "SharedMemoryRouter.hpp"
+
+#include "CommunicationService.hpp"
+#include "Compression.hpp"
+#include "MessageTypes.hpp"
+#include "Trace.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __MINGW32__
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Messaging
+{
+	namespace
+	{
+		/**
+		 * The time a receiver waits for a record before it checks whether it should stop
+		 */
+		const boost::posix_time::milliseconds receiveTimeout( 100); // @suppress("Avoid magic numbers")
+		/**
+		 * The time a sender waits for room in a full queue
+		 */
+		const boost::posix_time::milliseconds sendTimeout( 100); // @suppress("Avoid magic numbers")
+		/**
+		 *
+		 */
+		boost::posix_time::ptime timeoutFromNow( const boost::posix_time::milliseconds& aTimeout)
+		{
+			return boost::posix_time::microsec_clock::universal_time() + aTimeout;
+		}
+	}
+	/**
+	 *
+	 */
+	/* static */SharedMemoryRouter& SharedMemoryRouter::getSharedMemoryRouter()
+	{
+		static SharedMemoryRouter sharedMemoryRouter;
+		return sharedMemoryRouter;
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::registerRequestHandler(	unsigned short aPort,
+														RequestHandlerPtr aRequestHandler,
+														RequestDispatcherPtr aRequestDispatcher)
+	{
+		std::unique_lock< std::mutex > lock( routerMutex);
+		if (requestReceivers.find( aPort) != requestReceivers.end())
+		{
+			std::ostringstream os;
+			os << __PRETTY_FUNCTION__ << ": only one server per port allowed, port = " << aPort;
+			throw std::runtime_error( os.str());
+		}
+
+		std::unique_ptr< Receiver > receiver = std::make_unique< Receiver >();
+		receiver->queueName = requestQueueName( aPort);
+		receiver->queue = createQueue( receiver->queueName);
+		startReceiving( *receiver,
+						[this, aRequestHandler, aRequestDispatcher](const RecordHeader& aRecordHeader, std::string&& aBody)
+						{
+							handleRequest( aRequestHandler, aRequestDispatcher, aRecordHeader, std::move( aBody));
+						});
+		requestReceivers.emplace( aPort, std::move( receiver));
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::deregisterRequestHandler( unsigned short aPort)
+	{
+		std::unique_ptr< Receiver > receiver;
+		{
+			std::unique_lock< std::mutex > lock( routerMutex);
+			auto result = requestReceivers.find( aPort);
+			if (result == requestReceivers.end())
+			{
+				return;
+			}
+			receiver = std::move( result->second);
+			requestReceivers.erase( result);
+		}
+		stopReceiving( *receiver);
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::routeMessage(	unsigned short aPort,
+											const Message& aRequest,
+											ResponseFunction aResponseFunction)
+	{
+		RecordHeader recordHeader;
+		std::memset( &recordHeader, 0, sizeof( recordHeader));
+		recordHeader.replyTo = processId;
+		recordHeader.messageLength = static_cast< std::uint32_t >( aRequest.length());
+		recordHeader.messageType = aRequest.getMessageType();
+		recordHeader.flags = aRequest.getHeader( acceptsCompressedBodies).getFlags();
+
+		std::string reason;
+		if (sizeof( RecordHeader) + aRequest.length() > maximumRecordSize)
+		{
+			reason = "message too large, " + aRequest.getHeader().asString();
+		} else
+		{
+			{
+				std::unique_lock< std::mutex > lock( routerMutex);
+				startReplyReceiver();
+				recordHeader.sequenceNumber = ++sequenceCounter;
+				pendingResponses[recordHeader.sequenceNumber] = PendingResponse{ aRequest.getCorrelationId(), aResponseFunction, std::chrono::steady_clock::now() + pendingResponseTimeout };
+			}
+			// The sender thread fails the request if it cannot be sent
+			if (queueRecord( UnsentRecord{ requestQueueName( aPort), recordHeader, aRequest.message, true }))
+			{
+				return;
+			}
+			std::unique_lock< std::mutex > lock( routerMutex);
+			pendingResponses.erase( recordHeader.sequenceNumber);
+			reason = "too many requests wait to be sent";
+		}
+
+		Message error( aRequest);
+		error.setMessageType( CommunicationWriteError);
+		error.setBody( "*** SharedMemoryRouter::routeMessage: " + reason);
+		TRACE_DEVELOP(error.getBody());
+		boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+							[error, aResponseFunction]()
+							{
+								aResponseFunction( error);
+							});
+	}
+	/**
+	 *
+	 */
+	SharedMemoryRouter::SharedMemoryRouter() :
+#ifdef __MINGW32__
+								processId( static_cast< std::uint32_t >( _getpid())),
+#else
+								processId( static_cast< std::uint32_t >( getpid())),
+#endif
+								unsentRecords( maximumNumberOfUnsentRecords)
+	{
+		senderThread = std::thread( [this]()
+									{
+										sendQueuedRecords();
+									});
+	}
+	/**
+	 *
+	 */
+	SharedMemoryRouter::~SharedMemoryRouter()
+	{
+		// The records that are still queued are sent first
+		unsentRecords.shutDown();
+		if (senderThread.joinable())
+		{
+			senderThread.join();
+		}
+		for (auto& [port, receiver] : requestReceivers)
+		{
+			stopReceiving( *receiver);
+		}
+		if (replyReceiver)
+		{
+			stopReceiving( *replyReceiver);
+		}
+	}
+	/**
+	 *
+	 */
+	/* static */std::string SharedMemoryRouter::requestQueueName( unsigned short aPort)
+	{
+		return "robotworld_" + std::to_string( aPort);
+	}
+	/**
+	 *
+	 */
+	/* static */std::string SharedMemoryRouter::replyQueueName( std::uint32_t aProcessId)
+	{
+		return "robotworld_reply_" + std::to_string( aProcessId);
+	}
+	/**
+	 *
+	 */
+	/* static */std::unique_ptr< boost::interprocess::message_queue > SharedMemoryRouter::createQueue( const std::string& aQueueName)
+	{
+		boost::interprocess::message_queue::remove( aQueueName.c_str());
+		return std::make_unique< boost::interprocess::message_queue >(	boost::interprocess::create_only,
+																		aQueueName.c_str(),
+																		maximumNumberOfRecords,
+																		maximumRecordSize);
+	}
+	/**
+	 *
+	 */
+	/* static */void SharedMemoryRouter::startReceiving(	Receiver& aReceiver,
+															std::function< void( const RecordHeader&, std::string&&) > aRecordFunction,
+															std::function< void() > aTimerFunction /* = std::function< void() >() */)
+	{
+		aReceiver.thread = std::thread( [&aReceiver, aRecordFunction, aTimerFunction]()
+										{
+											const std::chrono::milliseconds timerInterval( receiveTimeout.total_milliseconds());
+											std::chrono::steady_clock::time_point nextTimerCall = std::chrono::steady_clock::now() + timerInterval;
+
+											std::vector< char > record( maximumRecordSize);
+											while (aReceiver.running.load())
+											{
+												// Also when records keep coming in and the receive does not time out
+												if (aTimerFunction && std::chrono::steady_clock::now() >= nextTimerCall)
+												{
+													aTimerFunction();
+													nextTimerCall = std::chrono::steady_clock::now() + timerInterval;
+												}
+
+												boost::interprocess::message_queue::size_type receivedSize = 0;
+												unsigned int priority = 0;
+												try
+												{
+													if (!aReceiver.queue->timed_receive( record.data(), record.size(), receivedSize, priority, timeoutFromNow( receiveTimeout)))
+													{
+														continue;
+													}
+												}
+												catch (boost::interprocess::interprocess_exception& e)
+												{
+													TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": ") + e.what());
+													break;
+												}
+
+												RecordHeader recordHeader;
+												if (receivedSize < sizeof( recordHeader))
+												{
+													TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": record shorter than its header"));
+													continue;
+												}
+												std::memcpy( &recordHeader, record.data(), sizeof( recordHeader));
+												if (recordHeader.messageLength != receivedSize - sizeof( recordHeader))
+												{
+													TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": truncated record"));
+													continue;
+												}
+												aRecordFunction( recordHeader, std::string( record.data() + sizeof( recordHeader), recordHeader.messageLength));
+											}
+										});
+	}
+	/**
+	 *
+	 */
+	/* static */void SharedMemoryRouter::stopReceiving( Receiver& aReceiver)
+	{
+		aReceiver.running.store( false);
+		if (aReceiver.thread.joinable())
+		{
+			aReceiver.thread.join();
+		}
+		boost::interprocess::message_queue::remove( aReceiver.queueName.c_str());
+	}
+	/**
+	 *
+	 */
+	/* static */bool SharedMemoryRouter::sendRecord(	boost::interprocess::message_queue& aQueue,
+														const RecordHeader& aRecordHeader,
+														const std::string& aBody)
+	{
+		std::vector< char > record( sizeof( aRecordHeader) + aBody.length());
+		std::memcpy( record.data(), &aRecordHeader, sizeof( aRecordHeader));
+		std::memcpy( record.data() + sizeof( aRecordHeader), aBody.data(), aBody.length());
+		try
+		{
+			return aQueue.timed_send( record.data(), record.size(), 0, timeoutFromNow( sendTimeout));
+		}
+		catch (boost::interprocess::interprocess_exception& e)
+		{
+			TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": ") + e.what());
+			return false;
+		}
+	}
+	/**
+	 *
+	 */
+	bool SharedMemoryRouter::queueRecord( UnsentRecord&& aRecord)
+	{
+		return unsentRecords.tryEnqueue( std::move( aRecord));
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::sendQueuedRecords()
+	{
+		while (std::optional< UnsentRecord > record = unsentRecords.dequeue())
+		{
+			if (sendQueuedRecord( *record))
+			{
+				continue;
+			}
+			if (record->isRequest)
+			{
+				failPendingResponse( record->recordHeader.sequenceNumber, "request could not be sent to " + record->queueName);
+			} else
+			{
+				TRACE_DEVELOP("*** SharedMemoryRouter::sendQueuedRecords: response could not be sent to " + record->queueName);
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	bool SharedMemoryRouter::sendQueuedRecord( const UnsentRecord& aRecord)
+	{
+		boost::interprocess::message_queue* queue = openQueue( aRecord.queueName);
+		if (!queue)
+		{
+			return false;
+		}
+		if (sendRecord( *queue, aRecord.recordHeader, aRecord.body))
+		{
+			return true;
+		}
+		// The queue may be left behind by a process that is gone, the next record opens it again
+		openQueues.erase( aRecord.queueName);
+		return false;
+	}
+	/**
+	 *
+	 */
+	boost::interprocess::message_queue* SharedMemoryRouter::openQueue( const std::string& aQueueName)
+	{
+		auto result = openQueues.find( aQueueName);
+		if (result != openQueues.end())
+		{
+			return result->second.get();
+		}
+		try
+		{
+			std::unique_ptr< boost::interprocess::message_queue > queue = std::make_unique< boost::interprocess::message_queue >(	boost::interprocess::open_only,
+																																	aQueueName.c_str());
+			return openQueues.emplace( aQueueName, std::move( queue)).first->second.get();
+		}
+		catch (boost::interprocess::interprocess_exception& e)
+		{
+			TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string( ": ") + aQueueName + ", " + e.what());
+			return nullptr;
+		}
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::failPendingResponse(	std::uint32_t aSequenceNumber,
+													const std::string& aReason)
+	{
+		PendingResponse pendingResponse;
+		{
+			std::unique_lock< std::mutex > lock( routerMutex);
+			auto result = pendingResponses.find( aSequenceNumber);
+			if (result == pendingResponses.end())
+			{
+				return;
+			}
+			pendingResponse = std::move( result->second);
+			pendingResponses.erase( result);
+		}
+
+		Message error( CommunicationWriteError, "*** SharedMemoryRouter: " + aReason);
+		error.setCorrelationId( pendingResponse.correlationId);
+		TRACE_DEVELOP(error.getBody());
+		boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+							[error, responseFunction = std::move( pendingResponse.responseFunction)]()
+							{
+								responseFunction( error);
+							});
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::expirePendingResponses()
+	{
+		std::vector< PendingResponse > expiredResponses;
+		{
+			std::unique_lock< std::mutex > lock( routerMutex);
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			// The sequence numbers wrap around, so every pending response is checked
+			for (auto pendingResponse = pendingResponses.begin(); pendingResponse != pendingResponses.end();)
+			{
+				if (pendingResponse->second.deadline <= now)
+				{
+					expiredResponses.push_back( std::move( pendingResponse->second));
+					pendingResponse = pendingResponses.erase( pendingResponse);
+				} else
+				{
+					++pendingResponse;
+				}
+			}
+		}
+		for (PendingResponse& pendingResponse : expiredResponses)
+		{
+			Message error( CommunicationReadError, "*** SharedMemoryRouter: no response within the timeout");
+			error.setCorrelationId( pendingResponse.correlationId);
+			TRACE_DEVELOP(error.getBody());
+			boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+								[error, responseFunction = std::move( pendingResponse.responseFunction)]()
+								{
+									responseFunction( error);
+								});
+		}
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::handleRequest(	RequestHandlerPtr aRequestHandler,
+											RequestDispatcherPtr aRequestDispatcher,
+											const RecordHeader& aRecordHeader,
+											std::string&& aBody)
+	{
+		boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+							[this, aRequestHandler, aRequestDispatcher, aRecordHeader, body = std::move( aBody)]()
+							{
+								Message message( aRecordHeader.messageType, body);
+								message.setFlags( aRecordHeader.flags);
+								if (!Compression::decompress( message))
+								{
+									sendResponse( aRecordHeader, message);
+									return;
+								}
+								if (!aRequestDispatcher)
+								{
+									aRequestHandler->handleRequest( message);
+									sendResponse( aRecordHeader, message);
+									return;
+								}
+								// The dispatcher calls the response function on the io_context
+								if (!aRequestDispatcher->dispatch(	message,
+																	aRequestHandler,
+																	[this, aRecordHeader](const Message& aResponse)
+																	{
+																		sendResponse( aRecordHeader, aResponse);
+																	}))
+								{
+									TRACE_DEVELOP("*** SharedMemoryRouter::handleRequest: dispatch queue full, " + message.getHeader().asString());
+									message.setMessageType( ServerSideExceptionResponse);
+									message.setBody( "*** SharedMemoryRouter::handleRequest: server busy");
+									sendResponse( aRecordHeader, message);
+								}
+							});
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::sendResponse(	const RecordHeader& aRequestHeader,
+											const Message& aResponse)
+	{
+		RecordHeader responseHeader( aRequestHeader);
+		responseHeader.messageType = aResponse.getMessageType();
+		responseHeader.flags = aResponse.getHeader( acceptsCompressedBodies).getFlags();
+		responseHeader.messageLength = static_cast< std::uint32_t >( aResponse.length());
+
+		// The sender thread does the sending, the io_context does not wait for room in the reply queue
+		if (sizeof( RecordHeader) + aResponse.length() > maximumRecordSize || !queueRecord( UnsentRecord{ replyQueueName( aRequestHeader.replyTo), responseHeader, aResponse.message, false }))
+		{
+			TRACE_DEVELOP("*** SharedMemoryRouter::sendResponse: response could not be sent, " + aResponse.getHeader().asString());
+		}
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::handleResponse(	const RecordHeader& aRecordHeader,
+												std::string&& aBody)
+	{
+		PendingResponse pendingResponse;
+		{
+			std::unique_lock< std::mutex > lock( routerMutex);
+			auto result = pendingResponses.find( aRecordHeader.sequenceNumber);
+			if (result == pendingResponses.end())
+			{
+				TRACE_DEVELOP("*** SharedMemoryRouter::handleResponse: response without request");
+				return;
+			}
+			pendingResponse = std::move( result->second);
+			pendingResponses.erase( result);
+		}
+
+		Message response( aRecordHeader.messageType, aBody);
+		response.setCorrelationId( pendingResponse.correlationId);
+		response.setFlags( aRecordHeader.flags);
+		Compression::decompress( response);
+		boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+							[response, responseFunction = std::move( pendingResponse.responseFunction)]()
+							{
+								responseFunction( response);
+							});
+	}
+	/**
+	 *
+	 */
+	void SharedMemoryRouter::startReplyReceiver()
+	{
+		if (replyReceiver)
+		{
+			return;
+		}
+		replyReceiver = std::make_unique< Receiver >();
+		replyReceiver->queueName = replyQueueName( processId);
+		replyReceiver->queue = createQueue( replyReceiver->queueName);
+		startReceiving( *replyReceiver,
+						[this](const RecordHeader& aRecordHeader, std::string&& aBody)
+						{
+							handleResponse( aRecordHeader, std::move( aBody));
+						},
+						[this]()
+						{
+							expirePendingResponses();
+						});
+	}
+} // namespace Messaging
@@ -0,0 +1,258 @@
+#ifndef SHAREDMEMORYROUTER_HPP_
+#define SHAREDMEMORYROUTER_HPP_
+
+#include "Config.hpp"
+
+#include "Compression.hpp"
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "Queue.hpp"
+#include "Transport.hpp"
+
+#include <boost/interprocess/ipc/message_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Messaging
+{
+	/**
+	 * The SharedMemoryRouter is the transport for TransportType::SharedMemory, between processes on the same host.
+	 *
+	 * Every Server gets a request queue "robotworld_<port>" and every process that sends requests gets one reply
+	 * queue "robotworld_reply_<pid>". The queues are boost::interprocess::message_queues: fixed size ring buffers
+	 * of records in shared memory. A record is a RecordHeader followed by the body, so no text header has to be
+	 * formatted or parsed. A receiver thread per queue waits for records and hands them to the io_context of the
+	 * CommunicationService, so the request and response handlers are called on the same thread as with TCP.
+	 * If the server has a RequestDispatcher its model thread handles the requests, as with TCP.
+	 *
+	 * The records are sent by a sender thread, which may have to wait for room in a full queue. A queue that
+	 * could not be opened or sent to is opened again for the next record, so a server that is restarted is
+	 * found again. A request that is not answered within pendingResponseTimeout, e.g. because the server
+	 * process died, gets a CommunicationReadError. The receiver thread of the reply queue checks the deadlines.
+	 */
+	class SharedMemoryRouter : public RouterTransport
+	{
+		public:
+			/**
+			 * The maximum number of records in a queue
+			 */
+			static constexpr std::size_t maximumNumberOfRecords = 64;
+			/**
+			 * The maximum size of a record, the header included
+			 */
+			static constexpr std::size_t maximumRecordSize = 64 * 1024;
+			/**
+			 * The maximum number of records that wait for the sender thread
+			 */
+			static constexpr std::size_t maximumNumberOfUnsentRecords = 4 * maximumNumberOfRecords;
+			/**
+			 * The time a request waits for its response
+			 */
+			static constexpr std::chrono::seconds pendingResponseTimeout = std::chrono::seconds( 60); // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			static SharedMemoryRouter& getSharedMemoryRouter();
+			/**
+			 * Creates the request queue for aPort and starts receiving requests
+			 *
+			 * @see Transport::registerRequestHandler
+			 */
+			virtual void registerRequestHandler(	unsigned short aPort,
+													RequestHandlerPtr aRequestHandler,
+													RequestDispatcherPtr aRequestDispatcher) override;
+			/**
+			 * Stops receiving requests for aPort and removes its request queue
+			 *
+			 * @see Transport::deregisterRequestHandler
+			 */
+			virtual void deregisterRequestHandler( unsigned short aPort) override;
+			/**
+			 * Sends aRequest to the request queue of aPort. The response is handed to aResponseFunction.
+			 * If the request cannot be sent aResponseFunction gets a CommunicationWriteError.
+			 *
+			 * @see RouterTransport::routeMessage
+			 */
+			virtual void routeMessage(	unsigned short aPort,
+										const Message& aRequest,
+										ResponseFunction aResponseFunction) override;
+		private:
+			/**
+			 * The fixed size part of a record
+			 */
+			struct RecordHeader
+			{
+					/**
+					 * The process id of the requester, names its reply queue
+					 */
+					std::uint32_t replyTo;
+					/**
+					 * Ties the response to its request
+					 */
+					std::uint32_t sequenceNumber;
+					/**
+					 * The length of the body that follows the header
+					 */
+					std::uint32_t messageLength;
+					/**
+					 *
+					 */
+					char messageType;
+					/**
+					 * The Message::Flags of the message
+					 */
+					unsigned char flags;
+			};
+			/**
+			 * A queue and the thread that receives its records
+			 */
+			struct Receiver
+			{
+					std::unique_ptr< boost::interprocess::message_queue > queue;
+					std::string queueName;
+					std::thread thread;
+					std::atomic< bool > running = true;
+			};
+			/**
+			 * A request that waits for its response
+			 */
+			struct PendingResponse
+			{
+					unsigned long correlationId;
+					ResponseFunction responseFunction;
+					std::chrono::steady_clock::time_point deadline;
+			};
+			/**
+			 * A record that waits for the sender thread
+			 */
+			struct UnsentRecord
+			{
+					std::string queueName;
+					RecordHeader recordHeader;
+					std::string body;
+					/**
+					 * A request that cannot be sent is failed, a response that cannot be sent is traced
+					 */
+					bool isRequest;
+			};
+			/**
+			 *
+			 */
+			SharedMemoryRouter();
+			/**
+			 * Stops the receivers and removes the queues of this process
+			 */
+			~SharedMemoryRouter();
+			/**
+			 *
+			 */
+			static std::string requestQueueName( unsigned short aPort);
+			/**
+			 *
+			 */
+			static std::string replyQueueName( std::uint32_t aProcessId);
+			/**
+			 * Creates a queue with aQueueName, a queue that is left behind by a crashed process is removed first
+			 */
+			static std::unique_ptr< boost::interprocess::message_queue > createQueue( const std::string& aQueueName);
+			/**
+			 * Starts the thread that receives the records of aReceiver and calls aRecordFunction for every record
+			 *
+			 * @param aTimerFunction If given it is called by the thread about every receiveTimeout
+			 */
+			static void startReceiving(	Receiver& aReceiver,
+										std::function< void( const RecordHeader&, std::string&&) > aRecordFunction,
+										std::function< void() > aTimerFunction = std::function< void() >());
+			/**
+			 * Stops the thread of aReceiver and removes its queue
+			 */
+			static void stopReceiving( Receiver& aReceiver);
+			/**
+			 * Sends a record, does not block longer than a short time if the queue is full
+			 *
+			 * @return true if the record is sent
+			 */
+			static bool sendRecord(	boost::interprocess::message_queue& aQueue,
+									const RecordHeader& aRecordHeader,
+									const std::string& aBody);
+			/**
+			 * Hands aRecord to the sender thread
+			 *
+			 * @return false if too many records wait for the sender thread
+			 */
+			bool queueRecord( UnsentRecord&& aRecord);
+			/**
+			 * The sender thread, sends the queued records until the router is destroyed
+			 */
+			void sendQueuedRecords();
+			/**
+			 * Sends aRecord on the sender thread
+			 *
+			 * @return true if the record is sent
+			 */
+			bool sendQueuedRecord( const UnsentRecord& aRecord);
+			/**
+			 * Opens the queue with aQueueName, the opened queues are kept open until a send to them fails.
+			 * Must only be called by the sender thread.
+			 *
+			 * @return The queue or nullptr if it does not exist
+			 */
+			boost::interprocess::message_queue* openQueue( const std::string& aQueueName);
+			/**
+			 * Passes a CommunicationWriteError with aReason to the response function of the request with aSequenceNumber
+			 */
+			void failPendingResponse(	std::uint32_t aSequenceNumber,
+										const std::string& aReason);
+			/**
+			 * Passes a CommunicationReadError to the response functions of the requests whose deadline has passed
+			 */
+			void expirePendingResponses();
+			/**
+			 * Handles a request from another process on the io_context, or on the model thread of aRequestDispatcher
+			 * if it is given, and sends the response back
+			 */
+			void handleRequest(	RequestHandlerPtr aRequestHandler,
+								RequestDispatcherPtr aRequestDispatcher,
+								const RecordHeader& aRecordHeader,
+								std::string&& aBody);
+			/**
+			 * Sends aResponse to the reply queue of the request with aRequestHeader
+			 */
+			void sendResponse(	const RecordHeader& aRequestHeader,
+								const Message& aResponse);
+			/**
+			 * Hands the response to the response function that waits for it
+			 */
+			void handleResponse(	const RecordHeader& aRecordHeader,
+									std::string&& aBody);
+			/**
+			 * Creates the reply queue of this process if it is not there yet. Must be called with routerMutex locked.
+			 */
+			void startReplyReceiver();
+
+			std::uint32_t processId;
+			/**
+			 * True if the records that are sent say that compressed bodies are accepted
+			 */
+			bool acceptsCompressedBodies = Compression::isEnabled();
+			std::map< unsigned short, std::unique_ptr< Receiver > > requestReceivers;
+			std::unique_ptr< Receiver > replyReceiver;
+			std::map< std::string, std::unique_ptr< boost::interprocess::message_queue > > openQueues;
+			std::map< std::uint32_t, PendingResponse > pendingResponses;
+			std::uint32_t sequenceCounter = 0;
+			std::mutex routerMutex;
+			Base::Queue< UnsentRecord > unsentRecords;
+			std::thread senderThread;
+	};
+} // namespace Messaging
+
+#endif // SHAREDMEMORYROUTER_HPP_
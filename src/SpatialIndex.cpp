@@ -0,0 +1,280 @@
+#include "SpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Model
+{
+	/**
+	 *
+	 */
+	bool SpatialIndex::Bounds::overlaps(	const wxPoint& aPoint1,
+											const wxPoint& aPoint2) const
+	{
+		double dx = aPoint2.x - aPoint1.x;
+		double dy = aPoint2.y - aPoint1.y;
+		double entry = 0.0;
+		double exit = 1.0;
+		// The segment is p1 + t * (p2 - p1), clip t against the 4 sides
+		const double p[] = { -dx, dx, -dy, dy };
+		const double q[] = { static_cast< double >( aPoint1.x - left), static_cast< double >( right - aPoint1.x), static_cast< double >( aPoint1.y - top), static_cast< double >( bottom - aPoint1.y) };
+		for (int i = 0; i < 4; ++i) // @suppress("Avoid magic numbers")
+		{
+			if (p[i] == 0.0)
+			{
+				if (q[i] < 0.0)
+				{
+					return false;
+				}
+			} else
+			{
+				double t = q[i] / p[i];
+				if (p[i] < 0.0)
+				{
+					entry = std::max( entry, t);
+				} else
+				{
+					exit = std::min( exit, t);
+				}
+				if (entry > exit)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+	/**
+	 *
+	 */
+	SpatialIndex::SpatialIndex( int aCellSize /*= defaultCellSize*/) :
+								cellSize( aCellSize > 0 ? aCellSize : defaultCellSize)
+	{
+	}
+	/**
+	 *
+	 */
+	template< typename Visitor >
+	void SpatialIndex::visit(	const Bounds& aBounds,
+								Visitor aVisitor) const
+	{
+		CellRange queryCells = cellsOf( aBounds);
+		for (int column = queryCells.left; column <= queryCells.right; ++column)
+		{
+			for (int row = queryCells.top; row <= queryCells.bottom; ++row)
+			{
+				auto cell = cells.find( cellKey( column, row));
+				if (cell == cells.end())
+				{
+					continue;
+				}
+				for (const Base::ObjectId& objectId : cell->second)
+				{
+					const Entry& entry = entries.at( objectId);
+					// Report an object that spans several cells only in the first cell it shares with the query
+					if (column != std::max( entry.cells.left, queryCells.left) || row != std::max( entry.cells.top, queryCells.top))
+					{
+						continue;
+					}
+					if (entry.bounds.overlaps( aBounds))
+					{
+						aVisitor( objectId, entry.bounds);
+					}
+				}
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::update(	const Base::ObjectId& anObjectId,
+								const Bounds& aBounds)
+	{
+		std::lock_guard< std::mutex > lock( indexBusy);
+		CellRange cellRange = cellsOf( aBounds);
+		auto [entry, inserted] = entries.try_emplace( anObjectId, Entry{ aBounds, cellRange });
+		if (inserted)
+		{
+			addToCells( anObjectId, cellRange);
+		} else
+		{
+			moveEntry( anObjectId, entry->second, aBounds);
+		}
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::move(	const Base::ObjectId& anObjectId,
+								const Bounds& aBounds)
+	{
+		std::lock_guard< std::mutex > lock( indexBusy);
+		auto entry = entries.find( anObjectId);
+		if (entry == entries.end())
+		{
+			return;
+		}
+		moveEntry( anObjectId, entry->second, aBounds);
+	}
+	/**
+	 *
+	 */
+	bool SpatialIndex::erase( const Base::ObjectId& anObjectId)
+	{
+		std::lock_guard< std::mutex > lock( indexBusy);
+		auto entry = entries.find( anObjectId);
+		if (entry == entries.end())
+		{
+			return false;
+		}
+		removeFromCells( anObjectId, entry->second.cells);
+		entries.erase( entry);
+		return true;
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::clear()
+	{
+		std::lock_guard< std::mutex > lock( indexBusy);
+		entries.clear();
+		cells.clear();
+	}
+	/**
+	 *
+	 */
+	std::size_t SpatialIndex::size() const
+	{
+		std::lock_guard< std::mutex > lock( indexBusy);
+		return entries.size();
+	}
+	/**
+	 *
+	 */
+	std::vector< Base::ObjectId > SpatialIndex::query( const Bounds& aBounds) const
+	{
+		std::vector< Base::ObjectId > result;
+		std::lock_guard< std::mutex > lock( indexBusy);
+		visit( aBounds, [&result]( const Base::ObjectId& anObjectId, const Bounds&)
+							{
+								result.push_back( anObjectId);
+							});
+		return result;
+	}
+	/**
+	 *
+	 */
+	std::vector< Base::ObjectId > SpatialIndex::query(	const wxPoint& aPoint1,
+														const wxPoint& aPoint2) const
+	{
+		std::vector< Base::ObjectId > result;
+		std::lock_guard< std::mutex > lock( indexBusy);
+		visit( Bounds::of( aPoint1, aPoint2), [&result, &aPoint1, &aPoint2]( const Base::ObjectId& anObjectId, const Bounds& aBounds)
+											{
+												if (aBounds.overlaps( aPoint1, aPoint2))
+												{
+													result.push_back( anObjectId);
+												}
+											});
+		return result;
+	}
+	/**
+	 *
+	 */
+	Base::ObjectId SpatialIndex::nearest(	const wxPoint& aPoint,
+											double aMaximumDistance,
+											const Base::ObjectId& anExcludedObjectId /*= Base::ObjectId()*/) const
+	{
+		Base::ObjectId result;
+		double nearestDistance = std::numeric_limits< double >::max();
+		std::lock_guard< std::mutex > lock( indexBusy);
+		visit( Bounds::around( aPoint, static_cast< int >( std::ceil( aMaximumDistance))),
+			   [&]( const Base::ObjectId& anObjectId, const Bounds& aBounds)
+			   {
+					if (anObjectId == anExcludedObjectId)
+					{
+						return;
+					}
+					double dx = (aBounds.left + aBounds.right) / 2.0 - aPoint.x;
+					double dy = (aBounds.top + aBounds.bottom) / 2.0 - aPoint.y;
+					double distance = std::sqrt( dx * dx + dy * dy);
+					if (distance <= aMaximumDistance && distance < nearestDistance)
+					{
+						nearestDistance = distance;
+						result = anObjectId;
+					}
+			   });
+		return result;
+	}
+	/**
+	 *
+	 */
+	SpatialIndex::CellRange SpatialIndex::cellsOf( const Bounds& aBounds) const
+	{
+		// Floor division, the world may have negative coordinates
+		auto cellOf = [this]( int aCoordinate)
+		{
+			return aCoordinate >= 0 ? aCoordinate / cellSize : -((-aCoordinate - 1) / cellSize) - 1;
+		};
+		return CellRange{ cellOf( aBounds.left), cellOf( aBounds.top), cellOf( aBounds.right), cellOf( aBounds.bottom) };
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::moveEntry(	const Base::ObjectId& anObjectId,
+									Entry& anEntry,
+									const Bounds& aBounds)
+	{
+		CellRange cellRange = cellsOf( aBounds);
+		if (anEntry.cells != cellRange)
+		{
+			removeFromCells( anObjectId, anEntry.cells);
+			addToCells( anObjectId, cellRange);
+			anEntry.cells = cellRange;
+		}
+		anEntry.bounds = aBounds;
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::addToCells(	const Base::ObjectId& anObjectId,
+									const CellRange& aCellRange)
+	{
+		for (int column = aCellRange.left; column <= aCellRange.right; ++column)
+		{
+			for (int row = aCellRange.top; row <= aCellRange.bottom; ++row)
+			{
+				cells[cellKey( column, row)].push_back( anObjectId);
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	void SpatialIndex::removeFromCells(	const Base::ObjectId& anObjectId,
+										const CellRange& aCellRange)
+	{
+		for (int column = aCellRange.left; column <= aCellRange.right; ++column)
+		{
+			for (int row = aCellRange.top; row <= aCellRange.bottom; ++row)
+			{
+				auto cell = cells.find( cellKey( column, row));
+				if (cell == cells.end())
+				{
+					continue;
+				}
+				std::vector< Base::ObjectId >& objectIds = cell->second;
+				auto i = std::find( objectIds.begin(), objectIds.end(), anObjectId);
+				if (i != objectIds.end())
+				{
+					*i = objectIds.back();
+					objectIds.pop_back();
+				}
+				if (objectIds.empty())
+				{
+					cells.erase( cell);
+				}
+			}
+		}
+	}
+} // namespace Model
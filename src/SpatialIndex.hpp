@@ -0,0 +1,207 @@
+#ifndef SPATIALINDEX_HPP_
+#define SPATIALINDEX_HPP_
+
+#include "Config.hpp"
+
+#include "ObjectId.hpp"
+#include "Point.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Model
+{
+	/**
+	 * A uniform grid over the bounding boxes of objects, a spatial hash: only the cells that hold an
+	 * object exist. An object is in every cell its bounding box overlaps.
+	 *
+	 * Updating an object that stays within the same cells only replaces its bounding box, so the
+	 * per-tick update of a moving robot is O(1). A query visits the cells of the query box and reports
+	 * every object once, an object that spans several cells is reported in the first cell that both
+	 * share. With objects spread over the world a query costs O(1) instead of O(N).
+	 *
+	 * All functions lock, objects are updated and queried from the robot threads and the GUI thread.
+	 */
+	class SpatialIndex
+	{
+		public:
+			/**
+			 * An axis aligned box, the right and bottom are included
+			 */
+			struct Bounds
+			{
+					int left = 0;
+					int top = 0;
+					int right = 0;
+					int bottom = 0;
+					/**
+					 *
+					 */
+					static Bounds around(	const wxPoint& aPoint,
+											int aMargin)
+					{
+						return Bounds{ aPoint.x - aMargin, aPoint.y - aMargin, aPoint.x + aMargin, aPoint.y + aMargin };
+					}
+					/**
+					 *
+					 */
+					static Bounds of(	const wxPoint& aPoint1,
+										const wxPoint& aPoint2)
+					{
+						return Bounds{ std::min( aPoint1.x, aPoint2.x), std::min( aPoint1.y, aPoint2.y), std::max( aPoint1.x, aPoint2.x), std::max( aPoint1.y, aPoint2.y) };
+					}
+					/**
+					 * Grows the box to include aPoint
+					 */
+					Bounds& include( const wxPoint& aPoint)
+					{
+						left = std::min( left, aPoint.x);
+						top = std::min( top, aPoint.y);
+						right = std::max( right, aPoint.x);
+						bottom = std::max( bottom, aPoint.y);
+						return *this;
+					}
+					/**
+					 *
+					 */
+					Bounds grownBy( int aMargin) const
+					{
+						return Bounds{ left - aMargin, top - aMargin, right + aMargin, bottom + aMargin };
+					}
+					/**
+					 *
+					 */
+					bool overlaps( const Bounds& aBounds) const
+					{
+						return left <= aBounds.right && aBounds.left <= right && top <= aBounds.bottom && aBounds.top <= bottom;
+					}
+					/**
+					 * Clips the segment against the box (Liang-Barsky)
+					 */
+					bool overlaps(	const wxPoint& aPoint1,
+									const wxPoint& aPoint2) const;
+					/**
+					 *
+					 */
+					bool operator==( const Bounds& aBounds) const = default;
+			};
+			/**
+			 *
+			 */
+			static constexpr int defaultCellSize = 64; // @suppress("Avoid magic numbers")
+			/**
+			 *
+			 */
+			explicit SpatialIndex( int aCellSize = defaultCellSize);
+			/**
+			 * Inserts the object or, if it is already in the index, moves it to its new bounding box
+			 */
+			void update(	const Base::ObjectId& anObjectId,
+							const Bounds& aBounds);
+			/**
+			 * Moves the object if it is in the index, does nothing otherwise
+			 */
+			void move(	const Base::ObjectId& anObjectId,
+						const Bounds& aBounds);
+			/**
+			 *
+			 * @return False if the object is not in the index
+			 */
+			bool erase( const Base::ObjectId& anObjectId);
+			/**
+			 *
+			 */
+			void clear();
+			/**
+			 *
+			 */
+			std::size_t size() const;
+			/**
+			 *
+			 * @return The objects whose bounding box overlaps aBounds
+			 */
+			std::vector< Base::ObjectId > query( const Bounds& aBounds) const;
+			/**
+			 *
+			 * @return The objects whose bounding box overlaps the segment from aPoint1 to aPoint2
+			 */
+			std::vector< Base::ObjectId > query(	const wxPoint& aPoint1,
+													const wxPoint& aPoint2) const;
+			/**
+			 *
+			 * @param aPoint
+			 * @param aMaximumDistance Objects whose centre is further away are ignored
+			 * @param anExcludedObjectId E.g. the object that asks for its nearest neighbour
+			 * @return The object whose bounding box centre is nearest to aPoint, the null ObjectId if there is none
+			 */
+			Base::ObjectId nearest(	const wxPoint& aPoint,
+									double aMaximumDistance,
+									const Base::ObjectId& anExcludedObjectId = Base::ObjectId()) const;
+
+		private:
+			/**
+			 * The range of cells of a bounding box
+			 */
+			struct CellRange
+			{
+					int left;
+					int top;
+					int right;
+					int bottom;
+					bool operator==( const CellRange& aCellRange) const = default;
+			};
+			/**
+			 *
+			 */
+			struct Entry
+			{
+					Bounds bounds;
+					CellRange cells;
+			};
+			/**
+			 *
+			 */
+			CellRange cellsOf( const Bounds& aBounds) const;
+			/**
+			 *
+			 */
+			static std::uint64_t cellKey(	int aColumn,
+											int aRow)
+			{
+				return (static_cast< std::uint64_t >( static_cast< std::uint32_t >( aColumn)) << 32) | static_cast< std::uint32_t >( aRow); // @suppress("Avoid magic numbers")
+			}
+			/**
+			 * Moves the object to other cells only if its new bounding box is in other cells, expects the lock to be held
+			 */
+			void moveEntry(	const Base::ObjectId& anObjectId,
+							Entry& anEntry,
+							const Bounds& aBounds);
+			/**
+			 *
+			 */
+			void addToCells(	const Base::ObjectId& anObjectId,
+								const CellRange& aCellRange);
+			/**
+			 *
+			 */
+			void removeFromCells(	const Base::ObjectId& anObjectId,
+									const CellRange& aCellRange);
+			/**
+			 * Calls aVisitor once for every object whose bounding box overlaps aBounds, expects the lock to be held
+			 */
+			template< typename Visitor >
+			void visit(	const Bounds& aBounds,
+						Visitor aVisitor) const;
+
+			int cellSize;
+			mutable std::mutex indexBusy;
+			std::unordered_map< Base::ObjectId, Entry > entries;
+			std::unordered_map< std::uint64_t, std::vector< Base::ObjectId > > cells;
+	}; // class SpatialIndex
+} // namespace Model
+
+#endif // SPATIALINDEX_HPP_
@@ -0,0 +1,578 @@
+#ifndef TCPTRANSPORT_HPP_
+#define TCPTRANSPORT_HPP_
+
+#include "Config.hpp"
+
+#include "CommunicationService.hpp"
+#include "Session.hpp"
+#include "Transport.hpp"
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Messaging
+{
+	/**
+	 * Accepts the TCP connections to one port, every connection is served by a PipelinedServerSession
+	 */
+	class TcpAcceptor : public std::enable_shared_from_this< TcpAcceptor >
+	{
+		public:
+			/**
+			 *
+			 */
+			TcpAcceptor(	unsigned short aPort,
+							RequestHandlerPtr aRequestHandler,
+							RequestDispatcherPtr aRequestDispatcher) :
+								port( aPort),
+								acceptor( CommunicationService::getCommunicationService().getIOContext()),
+								requestHandler( aRequestHandler),
+								requestDispatcher( aRequestDispatcher),
+								timer( CommunicationService::getCommunicationService().getIOContext())
+			{
+			}
+			/**
+			 *
+			 */
+			void start()
+			{
+				boost::asio::ip::tcp::endpoint ep(boost::asio::ip::tcp::v4(), port);
+				acceptor.open(ep.protocol());
+				acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+				acceptor.bind(ep);
+				acceptor.listen();
+
+				stopAccepting.store(false);
+				handleAccept( nullptr, boost::system::error_code());
+			}
+			/**
+			 * Stops accepting connections, the pending accept is cancelled a second later
+			 */
+			void stop()
+			{
+				stopAccepting.store(true);
+
+				timer.expires_from_now(boost::posix_time::seconds(1));
+				timer.async_wait([self = shared_from_this()](const boost::system::error_code& UNUSEDPARAM(e)) // @suppress("Method cannot be resolved")
+								 {
+									boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(), // @suppress("Invalid arguments")
+														[self]()
+														{
+															self->acceptor.cancel();
+														});
+								 });
+			}
+		private:
+			/**
+			 *	Handle any incoming connections
+			 *
+			 *	Every connection is served by a PipelinedServerSession, which serves both clients that send
+			 *	one request per connection and PipelinedClients that keep the connection open.
+			 *
+			 * @startuml
+			 * -> server: handleAccept
+			 * activate server
+			 * server -->> session
+			 * activate session
+			 * deactivate session
+			 * server -\ acceptor : asyn_accept(socket,(){handleAccept();})
+			 * server -> session : start
+			 * deactivate server
+			 * activate session
+			 * == Reading the request ==
+			 * session -\ session: readMessage
+			 * activate session
+			 * session -\ socket: async_read(socket, messageHeaderBuffer,(){handleHeaderRead();})
+			 * deactivate session
+			 * activate socket
+			 * server <-- session
+			 * deactivate session
+			 * deactivate session
+			 * deactivate session
+			 * session <- socket : handleHeaderRead()
+			 * deactivate socket
+			 * activate session
+			 * session -\ socket: async_read(socket,messageBodyBuffer,(){handleBodyRead();})
+			 * deactivate session
+			 * activate socket
+			 * session <- socket : handleBodyRead()
+			 * deactivate socket
+			 * activate session
+			 * session -> session : handleMessageRead(error)
+			 * activate session
+			 * session -> session : handleMessageRead()
+			 * activate session
+			 * == Handling the request ==
+			 * session -> requestHandler : handleRequest(message)
+			 * activate requestHandler
+			 * session <-- requestHandler
+			 * deactivate requestHandler
+			 * == Writing the response ==
+			 * session -> session: writeMessage(message)
+			 * activate session
+			 * session -\ socket: async_write(socket, messageHeaderBuffer,(){handleHeaderWriten();})
+			 * deactivate session
+			 * activate socket
+			 * deactivate session
+			 * deactivate session
+			 * deactivate session
+			 * session <- socket : handleHeaderWriten()
+			 * deactivate socket
+			 * activate session
+			 * session -\ socket: async_write(socket messageBodyBuffer,(){handleBodyWriten();})
+			 * deactivate session
+			 * activate socket
+			 * session <- socket : handleBodyWriten()
+			 * deactivate socket
+			 * activate session
+			 * session -> session : handleMessageWriten(error)
+			 * activate session
+			 * session -> session : handleMessageWritten()
+			 * activate session
+			 * deactivate session
+			 * deactivate session
+			 * destroy session
+			 * @enduml
+			 */
+			void handleAccept( 	PipelinedServerSession* aSession,
+								const boost::system::error_code& error)
+			{
+				if (!error)
+				{
+					if(!stopAccepting.load())
+					{
+						// Take the session that will handle the next incoming connection from the pool
+						PipelinedServerSession* session = SessionPool< PipelinedServerSession >::getSessionPool().acquire( requestHandler, requestDispatcher);
+						// Let the acceptor wait for any new incoming connections
+						// and let it call server::handle_accept on the happy occasion
+						acceptor.async_accept(	session->getSocket(), // @suppress("Method cannot be resolved")
+												[self = shared_from_this(), session](const boost::system::error_code& error)
+												{
+							self->handleAccept(session,error);
+												});
+
+						// If there is a session, start it up....
+						if (aSession)
+						{
+							aSession->start();
+						}
+					}else
+					{
+						TRACE_DEVELOP("Server does not accept any sessions anymore");
+					}
+				} else
+				{
+					if (aSession)
+					{
+						aSession->recycle();
+					}
+					if(!stopAccepting && error != boost::asio::error::basic_errors::operation_aborted)
+					{
+						std::ostringstream os;
+						os << "************ " << __PRETTY_FUNCTION__ << ": " << error.message() << ", stopAccepting = " << stopAccepting;
+						TRACE_DEVELOP(os.str());
+						throw std::runtime_error( os.str());
+					}
+				}
+			}
+			/**
+			 *
+			 */
+			unsigned short port;
+			/**
+			 * Provides the ability to accept new connections
+			 */
+			boost::asio::ip::tcp::acceptor acceptor;
+			/**
+			 *
+			 */
+			std::atomic<bool> stopAccepting = false;
+			/**
+			 *
+			 */
+			RequestHandlerPtr requestHandler;
+			/**
+			 *
+			 */
+			RequestDispatcherPtr requestDispatcher;
+			/**
+			 *
+			 */
+			boost::asio::deadline_timer timer;
+	}; // class TcpAcceptor
+	/**
+	 * A TcpChannel sends the requests over one TCP connection. The connection is made when the first
+	 * request is sent and is made again after it is lost.
+	 *
+	 * Apart from sendMessage all members are only used by the thread that runs the io_context.
+	 */
+	class TcpChannel : public Channel, public std::enable_shared_from_this< TcpChannel >
+	{
+		public:
+			/**
+			 *
+			 */
+			TcpChannel(	const std::string& aHostName,
+						unsigned short aPort,
+						Transport::ResponseFunction aResponseFunction) :
+							host( aHostName),
+							port( aPort),
+							responseFunction( aResponseFunction)
+			{
+			}
+			/**
+			 * @see Channel::sendMessage
+			 */
+			virtual void sendMessage( Message&& aRequest) override
+			{
+				boost::asio::post(	CommunicationService::getCommunicationService().getIOContext(),
+									[self = shared_from_this(), request = std::move( aRequest)]()
+									{
+										self->writeMessage( request);
+									});
+			}
+			/**
+			 * @see Channel::close
+			 */
+			virtual void close() override
+			{
+				if (session)
+				{
+					session->close();
+				}
+			}
+		private:
+			/**
+			 *
+			 */
+			void writeMessage( const Message& aRequest)
+			{
+				if (session && connected)
+				{
+					session->sendMessage( aRequest);
+					return;
+				}
+				unsentMessages.push_back( aRequest);
+				if (!session)
+				{
+					connect();
+				}
+			}
+			/**
+			 *
+			 */
+			void connect()
+			{
+				std::shared_ptr< TcpChannel > self = shared_from_this();
+				session = SessionPool< PipelinedClientSession >::getSessionPool().acquire(	[self](const Message& aResponse)
+																							{
+																								self->handleResponse( aResponse);
+																							});
+				try
+				{
+					// The remote address is resolved once, and again after a connect failed
+					if (!endpoint)
+					{
+						boost::asio::ip::tcp::resolver resolver( CommunicationService::getCommunicationService().getIOContext()); // @suppress("Ambiguous problem")
+						endpoint = *resolver.resolve( boost::asio::ip::tcp::v4(), host, std::to_string(port)).begin();
+					}
+
+					PipelinedClientSession* connectingSession = session;
+					session->getSocket().async_connect( *endpoint, // @suppress("Method cannot be resolved") // @suppress("Invalid arguments")
+														[self, connectingSession](const boost::system::error_code& error)
+														{
+															self->handleConnect( connectingSession, error);
+														});
+				}
+				catch (std::exception& e)
+				{
+					TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": ") + e.what());
+					handleConnect( session, boost::asio::error::host_not_found);
+				}
+			}
+			/**
+			 *
+			 */
+			void handleConnect( PipelinedClientSession* aSession,
+								const boost::system::error_code& error)
+			{
+				if (!error)
+				{
+					connected = true;
+					aSession->start();
+					for (const Message& message : unsentMessages)
+					{
+						aSession->sendMessage( message);
+					}
+					unsentMessages.clear();
+				} else
+				{
+					std::ostringstream os;
+					os << __PRETTY_FUNCTION__ << ": error connecting to " << host << ":" << port << ", reason: " << error.message();
+					TRACE_DEVELOP(os.str());
+
+					session = nullptr;
+					endpoint.reset();
+					unsentMessages.clear();
+					aSession->recycle();
+					responseFunction( Message( CommunicationReadError, os.str()));
+				}
+			}
+			/**
+			 *
+			 */
+			void handleResponse( const Message& aResponse)
+			{
+				if (aResponse.getMessageType() == CommunicationReadError)
+				{
+					// The session deletes itself after this
+					session = nullptr;
+					connected = false;
+
+					// The error ends the connection, it is not the response to the last request
+					Message error( aResponse);
+					error.setCorrelationId( 0);
+					responseFunction( error);
+					return;
+				}
+				responseFunction( aResponse);
+			}
+
+			std::string host;
+			unsigned short port;
+			Transport::ResponseFunction responseFunction;
+
+			std::optional< boost::asio::ip::tcp::endpoint > endpoint;
+			PipelinedClientSession* session = nullptr;
+			bool connected = false;
+			std::vector< Message > unsentMessages;
+	}; // class TcpChannel
+	/**
+	 * The transport for TransportType::Tcp. A Client makes a connection per request, a PipelinedClient
+	 * keeps its connection open, the server side serves both with a PipelinedServerSession.
+	 */
+	class TcpTransport : public Transport
+	{
+		public:
+			/**
+			 *
+			 */
+			static TcpTransport& getTcpTransport()
+			{
+				static TcpTransport tcpTransport;
+				return tcpTransport;
+			}
+			/**
+			 * @see Transport::registerRequestHandler
+			 */
+			virtual void registerRequestHandler(	unsigned short aPort,
+													RequestHandlerPtr aRequestHandler,
+													RequestDispatcherPtr aRequestDispatcher) override
+			{
+				std::shared_ptr< TcpAcceptor > tcpAcceptor = std::make_shared< TcpAcceptor >( aPort, aRequestHandler, aRequestDispatcher);
+				{
+					std::unique_lock< std::mutex > lock( acceptorsMutex);
+					if (!acceptors.emplace( aPort, tcpAcceptor).second)
+					{
+						throw std::runtime_error( __PRETTY_FUNCTION__ + std::string( ": only one server per port allowed, port = ") + std::to_string( aPort));
+					}
+				}
+				tcpAcceptor->start();
+			}
+			/**
+			 * @see Transport::deregisterRequestHandler
+			 */
+			virtual void deregisterRequestHandler( unsigned short aPort) override
+			{
+				std::shared_ptr< TcpAcceptor > tcpAcceptor;
+				{
+					std::unique_lock< std::mutex > lock( acceptorsMutex);
+					auto result = acceptors.find( aPort);
+					if (result == acceptors.end())
+					{
+						return;
+					}
+					tcpAcceptor = result->second;
+					acceptors.erase( result);
+				}
+				tcpAcceptor->stop();
+			}
+			/**
+			 * @see Transport::dispatchMessage
+			 *
+			 * @startuml
+			 * -> transport: dispatchMessage(message)
+			 * activate transport
+			 * transport -->> session
+			 * activate session
+			 * deactivate session
+			 * transport -->> endpoint
+			 * transport -\ socket: async_connect(endpoint,(){handleConnect();})
+			 * <-- transport
+			 * deactivate transport
+			 * transport <- socket : handleConnect(session,error)
+			 * activate socket
+			 * activate transport
+			 * transport -> session :start
+			 * deactivate transport
+			 * deactivate socket
+			 * activate session
+			 * == Writing the request ==
+			 * session -> session: writeMessage(message)
+			 * activate session
+			 * session -\ socket: async_write(socket,messageHeaderBuffer,(){handleHeaderWriten();})
+			 * deactivate session
+			 * activate socket
+			 * transport <-- session
+			 * deactivate session
+			 * session <- socket : handleHeaderWriten()
+			 * deactivate socket
+			 * activate session
+			 * session -\ socket: async_write(socket,messageBodyBuffer,(){handleBodyWriten();})
+			 * deactivate session
+			 * activate socket
+			 * session <- socket : handleBodyWriten()
+			 * deactivate socket
+			 * activate session
+			 * session -> session : handleMessageWritten(error)
+			 * activate session
+			 * session -> session : handleMessageWritten()
+			 * activate session
+			 * == Reading the response ==
+			 * session -> session: readMessage
+			 * activate session
+			 * session -\ socket: async_read(socket messageHeaderBuffer, (){handleHeaderRead();})
+			 * deactivate session
+			 * activate socket
+			 * deactivate session
+			 * deactivate session
+			 * deactivate session
+			 * session <- socket : handleHeaderRead(message,error)
+			 * deactivate socket
+			 * activate session
+			 * session -\ socket: async_read(socket messageBodyBuffer,(){handleBodyRead();})
+			 * deactivate session
+			 * activate socket
+			 * session <- socket : handleBodyRead()
+			 * deactivate socket
+			 * activate session
+			 * session -> session : handleMessageRead(error)
+			 * activate session
+			 * session -> session : handleMessageRead()
+			 * activate session
+			 * == Handling the response ==
+			 * session -> responseHandler: handleResponse(message)
+			 * activate responseHandler
+			 * session <-- responseHandler
+			 * deactivate responseHandler
+			 * deactivate session
+			 * deactivate session
+			 * destroy session
+			 * @enduml
+			 */
+			virtual void dispatchMessage(	const std::string& aHostName,
+											unsigned short aPort,
+											const Message& aRequest,
+											ResponseHandlerPtr aResponseHandler) override
+			{
+				boost::asio::ip::tcp::endpoint endpoint = resolve( aHostName, aPort);
+
+				// Take the session that will handle the next outgoing connection from the pool
+				ClientSession* session = SessionPool< ClientSession >::getSessionPool().acquire(	aRequest,
+																									aResponseHandler);
+
+				// Let the session handle any outgoing messages
+				session->getSocket().async_connect( endpoint, // @suppress("Method cannot be resolved") // @suppress("Invalid arguments")
+													[this, session, endpoint](const boost::system::error_code& error)
+													{
+														handleConnect(session, endpoint, error);
+													});
+			}
+			/**
+			 * @see Transport::openChannel
+			 */
+			virtual ChannelPtr openChannel(	const std::string& aHostName,
+											unsigned short aPort,
+											ResponseFunction aResponseFunction) override
+			{
+				return std::make_shared< TcpChannel >( aHostName, aPort, aResponseFunction);
+			}
+		private:
+			/**
+			 *
+			 */
+			TcpTransport() = default;
+			/**
+			 * Resolves aHostName once, the endpoint is kept until a connect to it fails
+			 *
+			 * @throw boost::system::system_error if aHostName cannot be resolved
+			 */
+			boost::asio::ip::tcp::endpoint resolve(	const std::string& aHostName,
+													unsigned short aPort)
+			{
+				std::unique_lock< std::mutex > lock( endpointsMutex);
+				auto result = endpoints.find( std::make_pair( aHostName, aPort));
+				if (result != endpoints.end())
+				{
+					return result->second;
+				}
+				boost::asio::ip::tcp::resolver resolver( CommunicationService::getCommunicationService().getIOContext()); // @suppress("Ambiguous problem")
+				boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve( boost::asio::ip::tcp::v4(), aHostName, std::to_string( aPort)).begin();
+				endpoints.emplace( std::make_pair( aHostName, aPort), endpoint);
+				return endpoint;
+			}
+			/**
+			 *
+			 */
+			void handleConnect( ClientSession* aSession,
+								const boost::asio::ip::tcp::endpoint& anEndpoint,
+								const boost::system::error_code& error)
+			{
+				if (!error)
+				{
+					aSession->start();
+				} else
+				{
+					// The socket is not connected, so the address is not asked from the socket
+					std::ostringstream os;
+					os << __PRETTY_FUNCTION__ << ": error connecting to " << anEndpoint.address().to_string() << ":" << anEndpoint.port() << ", reason: " << error.message();
+					TRACE_DEVELOP(os.str());
+
+					{
+						// The host may have another address by now
+						std::unique_lock< std::mutex > lock( endpointsMutex);
+						std::erase_if( endpoints, [&anEndpoint](const auto& anEntry){return anEntry.second == anEndpoint;});
+					}
+					aSession->recycle();
+				}
+			}
+			/**
+			 *
+			 */
+			std::map< unsigned short, std::shared_ptr< TcpAcceptor > > acceptors;
+			/**
+			 *
+			 */
+			std::mutex acceptorsMutex;
+			/**
+			 * (host name, port) -> the resolved endpoint
+			 */
+			std::map< std::pair< std::string, unsigned short >, boost::asio::ip::tcp::endpoint > endpoints;
+			/**
+			 *
+			 */
+			std::mutex endpointsMutex;
+	}; // class TcpTransport
+} // namespace Messaging
+
+#endif // TCPTRANSPORT_HPP_
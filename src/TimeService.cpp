@@ -0,0 +1,59 @@
+#include "TimeService.hpp"
+
+#include <time.h>
+
+namespace Utils
+{
+	namespace
+	{
+		/**
+		 *
+		 */
+		std::int64_t toNanoseconds( const timespec& aTime)
+		{
+			return static_cast< std::int64_t >( aTime.tv_sec) * 1000000000 + aTime.tv_nsec; // @suppress("Avoid magic numbers")
+		}
+	} // namespace
+	/**
+	 *
+	 */
+	/* static */ std::chrono::system_clock::time_point TimeService::coarseNow()
+	{
+#ifdef CLOCK_REALTIME_COARSE
+		timespec time;
+		if (clock_gettime( CLOCK_REALTIME_COARSE, &time) == 0)
+		{
+			return std::chrono::system_clock::time_point( std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::nanoseconds( toNanoseconds( time))));
+		}
+#endif
+		return std::chrono::system_clock::now();
+	}
+	/**
+	 *
+	 */
+	/* static */ std::chrono::steady_clock::time_point TimeService::coarseSteadyNow()
+	{
+#ifdef CLOCK_MONOTONIC_COARSE
+		// steady_clock is CLOCK_MONOTONIC, the coarse variant has the same epoch
+		timespec time;
+		if (clock_gettime( CLOCK_MONOTONIC_COARSE, &time) == 0)
+		{
+			return std::chrono::steady_clock::time_point( std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::nanoseconds( toNanoseconds( time))));
+		}
+#endif
+		return std::chrono::steady_clock::now();
+	}
+	/**
+	 *
+	 */
+	/* static */ std::int64_t TimeService::refreshOffset( std::int64_t aSteadyNow)
+	{
+		std::int64_t wall = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::system_clock::now().time_since_epoch()).count();
+		std::int64_t offset = wall - aSteadyNow;
+
+		// The offset is stored before its time, a thread that sees the new time sees the new offset
+		wallClockOffset.store( offset, std::memory_order_relaxed);
+		offsetTime.store( aSteadyNow, std::memory_order_release);
+		return offset;
+	}
+} // namespace Utils
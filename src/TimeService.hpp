@@ -0,0 +1,76 @@
+#ifndef TIMESERVICE_HPP_
+#define TIMESERVICE_HPP_
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Utils
+{
+	/**
+	 * The TimeService provides the wall clock without a system call, without a lock and without a thread.
+	 *
+	 * now is precise: it reads the monotonic clock, which the C library reads from the vDSO without entering the
+	 * kernel, and adds the offset of the wall clock to the monotonic clock. The first call after the offset is
+	 * offsetRefreshInterval old recalculates it, so a change of the wall clock is followed within offsetRefreshInterval.
+	 *
+	 * coarseNow and coarseSteadyNow read the coarse clocks of the kernel if the platform has them. They are as
+	 * cheap as now but only as precise as the timer tick of the kernel, a few milliseconds.
+	 */
+	class TimeService
+	{
+		public:
+			/**
+			 *
+			 */
+			static constexpr std::chrono::seconds offsetRefreshInterval = std::chrono::seconds( 1);
+			/**
+			 *
+			 * @return The wall clock with the precision of the monotonic clock
+			 */
+			static std::chrono::system_clock::time_point now()
+			{
+				std::int64_t steady = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch()).count();
+				// The time of the offset is read first, the offset that belongs to it is stored before it
+				std::int64_t time = offsetTime.load( std::memory_order_acquire);
+				std::int64_t offset = wallClockOffset.load( std::memory_order_relaxed);
+				if (steady - time >= std::chrono::nanoseconds( offsetRefreshInterval).count())
+				{
+					offset = refreshOffset( steady);
+				}
+				return std::chrono::system_clock::time_point( std::chrono::duration_cast< std::chrono::system_clock::duration >( std::chrono::nanoseconds( steady + offset)));
+			}
+			/**
+			 *
+			 * @return The wall clock with the precision of the timer tick
+			 */
+			static std::chrono::system_clock::time_point coarseNow();
+			/**
+			 *
+			 * @return The monotonic clock with the precision of the timer tick
+			 */
+			static std::chrono::steady_clock::time_point coarseSteadyNow();
+			/**
+			 *
+			 */
+			TimeService() = delete;
+		private:
+			/**
+			 * Recalculates the offset of the wall clock to aSteadyNow. Threads that do this at the same time
+			 * all store about the same offset.
+			 *
+			 * @return The new offset in nanoseconds
+			 */
+			static std::int64_t refreshOffset( std::int64_t aSteadyNow);
+
+			/**
+			 * In nanoseconds. The time of the offset starts one interval in the past so the first call calculates it.
+			 */
+			inline static std::atomic< std::int64_t > wallClockOffset = 0;
+			inline static std::atomic< std::int64_t > offsetTime = -std::chrono::nanoseconds( offsetRefreshInterval).count();
+	}; // class TimeService
+} // namespace Utils
+
+#endif // TIMESERVICE_HPP_
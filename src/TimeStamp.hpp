@@ -3,18 +3,61 @@
 
 #include "Config.hpp"
 
+#include "TimeService.hpp"
+
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
 #include <string>
 
 namespace Utils
 {
 	/**
+	 * The same format as TimeStamp() but for aTimePoint instead of now.
 	 *
+	 * The date and time up to the second are formatted once per second per thread, only the microseconds
+	 * are formatted on every call.
+	 */
+	inline std::string TimeStamp( const std::chrono::system_clock::time_point& aTimePoint)
+	{
+		thread_local std::int64_t cachedSecond = -1;
+		thread_local std::string cachedSecondText;
+
+		std::int64_t sinceEpoch = std::chrono::duration_cast< std::chrono::microseconds >( aTimePoint.time_since_epoch()).count();
+		std::int64_t second = sinceEpoch / 1000000; // @suppress("Avoid magic numbers")
+		std::int64_t microseconds = sinceEpoch % 1000000; // @suppress("Avoid magic numbers")
+		if (microseconds < 0)
+		{
+			--second;
+			microseconds += 1000000; // @suppress("Avoid magic numbers")
+		}
+
+		if (second != cachedSecond)
+		{
+			boost::posix_time::ptime utc_time = boost::posix_time::from_time_t( static_cast< std::time_t >( second));
+			auto local_time = boost::date_time::c_local_adjustor< boost::posix_time::ptime >::utc_to_local( utc_time);
+			cachedSecondText = boost::posix_time::to_simple_string(local_time);
+			cachedSecond = second;
+		}
+
+		// Like boost::posix_time::to_simple_string the fraction is left out if it is 0
+		if (microseconds == 0)
+		{
+			return cachedSecondText;
+		}
+		char fraction[8]; // @suppress("Avoid magic numbers")
+		std::snprintf( fraction, sizeof( fraction), ".%06d", static_cast< int >( microseconds));
+		return cachedSecondText + fraction;
+	}
+	/**
+	 * Now, in local time
 	 */
 	inline std::string TimeStamp()
 	{
-		auto local_time = boost::posix_time::microsec_clock::local_time();
-		return boost::posix_time::to_simple_string(local_time);
+		return TimeStamp( TimeService::now());
 	}
 } /* namespace Utils */
 
@@ -1,8 +1,10 @@
 #include "Trace.hpp"
 
+#include "AsyncTrace.hpp"
 #include "StdOutTraceFunction.hpp"
 #include "TimeStamp.hpp"
 
+#include <charconv>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -20,6 +22,7 @@ namespace Base
 	/* static */ bool Trace::traceLineNumber = true;
 	/* static */ bool Trace::traceThreadId = true;
 	/* static */ bool Trace::traceExceptions = true;
+	/* static */ std::atomic< bool > Trace::asyncTraceOn = false;
 
 	/**
 	 *
@@ -34,6 +37,27 @@ namespace Base
 	 */
 	std::map< std::thread::id, unsigned long > threadIndentionLevels;
 
+	/**
+	 *
+	 */
+	std::string TraceValue::asString() const
+	{
+		switch (type)
+		{
+			case Integer:
+				return std::to_string( integer);
+			case Unsigned:
+				return std::to_string( unsignedInteger);
+			case Real:
+			{
+				char buffer[32]; // @suppress("Avoid magic numbers")
+				auto [end, error] = std::to_chars( buffer, buffer + sizeof( buffer), real);
+				return error == std::errc() ? std::string( buffer, end) : std::to_string( real);
+			}
+		}
+		return "";
+	}
+
 	/**
 	 *
 	 */
@@ -68,6 +92,53 @@ namespace Base
 			traceConstructor( aLineNumber);
 		}
 	}
+	/**
+	 *
+	 */
+	Trace::Trace(	const char* aFunctionName,
+					long aLineNumber 	/* = 0 */,
+					bool withTimeStamp 	/* = false */,
+					bool aTraceCDtor 	/* = true*/) :
+					traceTimeStamp( withTimeStamp),
+					traceCDtor( aTraceCDtor)
+	{
+		if (Trace::isAsyncTraceEnabled())
+		{
+			callSite = aFunctionName;
+		} else
+		{
+			traceText = aFunctionName;
+		}
+		if (traceCDtor == true)
+		{
+			traceConstructor( aLineNumber);
+		}
+	}
+	/**
+	 *
+	 */
+	Trace::Trace(	const char* aFunctionName,
+					const std::string& aText,
+					long aLineNumber 	/* = 0 */,
+					bool withTimeStamp 	/* = false */,
+					bool aTraceCDtor 	/* = true*/) :
+					traceTimeStamp( withTimeStamp),
+					traceCDtor( aTraceCDtor)
+	{
+		if (Trace::isAsyncTraceEnabled())
+		{
+			// No concatenation on the tracing thread
+			callSite = aFunctionName;
+			traceText = aText;
+		} else
+		{
+			traceText = aFunctionName + std::string(" ") + aText;
+		}
+		if (traceCDtor == true)
+		{
+			traceConstructor( aLineNumber);
+		}
+	}
 	/**
 	 *
 	 */
@@ -78,12 +149,59 @@ namespace Base
 			traceDestructor();
 		}
 	}
+	/**
+	 *
+	 */
+	/* static */ void Trace::enableAsyncTrace( bool enable /* = true */)
+	{
+		if (enable)
+		{
+			AsyncTrace::getAsyncTrace().start();
+			asyncTraceOn.store( true);
+		} else
+		{
+			asyncTraceOn.store( false);
+			AsyncTrace::getAsyncTrace().stop();
+		}
+	}
+	/**
+	 *
+	 */
+	/* static */ bool Trace::enableBinaryTrace( const std::string& aFileName /* = "trace.bin" */)
+	{
+		if (!AsyncTrace::getAsyncTrace().openBinaryTrace( aFileName))
+		{
+			return false;
+		}
+		enableAsyncTrace();
+		return true;
+	}
+	/**
+	 *
+	 */
+	/* static */ void Trace::disableBinaryTrace()
+	{
+		AsyncTrace::getAsyncTrace().closeBinaryTrace();
+	}
+	/**
+	 *
+	 */
+	/* static */ void Trace::flushTrace()
+	{
+		AsyncTrace::getAsyncTrace().flush();
+	}
 	/**
 	 *
 	 */
 	/* static */void Trace::trace(	const std::string& aText,
 									bool withTimeStamp /* = Trace::isTimeStampEnabled() */)
 	{
+		if (Trace::traceOn && Trace::isAsyncTraceEnabled())
+		{
+			AsyncTrace::getAsyncTrace().record( '>', nullptr, aText, AsyncTrace::noLineNumber, withTimeStamp);
+			return;
+		}
+
 		std::ostringstream os;
 
 		if(withTimeStamp==true)
@@ -102,6 +220,11 @@ namespace Base
 									long aLineNumber,
 									bool withTimeStamp /* = Trace::isTimeStampEnabled() */)
 	{
+		if (Trace::traceOn && Trace::isAsyncTraceEnabled())
+		{
+			AsyncTrace::getAsyncTrace().record( '>', nullptr, aText + aFunctionName + " ( line " + std::to_string( aLineNumber) + ")", AsyncTrace::noLineNumber, withTimeStamp);
+			return;
+		}
 
 		std::ostringstream os;
 
@@ -115,12 +238,58 @@ namespace Base
 		Trace::traceFormattedString(os.str(), '>');
 
 	}
+	/**
+	 *
+	 */
+	/* static */void Trace::traceValues(	const char* aFunctionName,
+											long aLineNumber,
+											std::initializer_list< TraceValue > someValues,
+											bool withTimeStamp /* = Trace::isTimeStampEnabled() */)
+	{
+		if (Trace::traceOn && Trace::isAsyncTraceEnabled())
+		{
+			AsyncTrace::getAsyncTrace().recordValues( aFunctionName, someValues, Trace::traceLineNumber ? aLineNumber : AsyncTrace::noLineNumber, withTimeStamp);
+			return;
+		}
+
+		std::ostringstream os;
+
+		if(withTimeStamp==true)
+		{
+			os << Utils::TimeStamp() << ": ";
+		}
+
+		os << aFunctionName;
+		std::size_t numberOfValues = 0;
+		for (const TraceValue& value : someValues)
+		{
+			if (++numberOfValues > maximumNumberOfValues)
+			{
+				os << " ...";
+				break;
+			}
+			os << " " << value.asString();
+		}
+		if (Trace::traceLineNumber)
+		{
+			os << " (line " << aLineNumber << ")";
+		}
+
+		Trace::traceFormattedString(os.str(), '>');
+	}
 	/**
 	 *
 	 */
 	void Trace::traceConstructor( long aLineNumber) const
 	{
-		if(traceText.length() > 0)
+		bool hasText = callSite || traceText.length() > 0;
+		if (Trace::traceOn && Trace::isAsyncTraceEnabled())
+		{
+			AsyncTrace::getAsyncTrace().record( '+', callSite, hasText ? traceText : "Ctor: ??? No Text ???", Trace::traceLineNumber && hasText ? aLineNumber : AsyncTrace::noLineNumber, traceTimeStamp && hasText);
+			return;
+		}
+
+		if(hasText)
 		{
 			std::ostringstream os;
 
@@ -129,7 +298,7 @@ namespace Base
 				os << Utils::TimeStamp() <<  ": ";
 			}
 
-			os << traceText;
+			os << getTraceText();
 
 			if(Trace::traceLineNumber)
 			{
@@ -147,7 +316,14 @@ namespace Base
 	 */
 	void Trace::traceDestructor() const
 	{
-		if(traceText.length() > 0)
+		bool hasText = callSite || traceText.length() > 0;
+		if (Trace::traceOn && Trace::isAsyncTraceEnabled())
+		{
+			AsyncTrace::getAsyncTrace().record( '-', callSite, hasText ? traceText : "Dtor: ??? No Text ???", AsyncTrace::noLineNumber, traceTimeStamp && hasText);
+			return;
+		}
+
+		if(hasText)
 		{
 			std::ostringstream os;
 
@@ -156,13 +332,24 @@ namespace Base
 				os << Utils::TimeStamp() << ": ";
 			}
 
-			os << traceText;
+			os << getTraceText();
 			Trace::traceFormattedString( os.str(), '-');
 		} else
 		{
 			Trace::traceFormattedString("Dtor: ??? No Text ???", '-');
 		}
 	}
+	/**
+	 *
+	 */
+	std::string Trace::getTraceText() const
+	{
+		if (callSite)
+		{
+			return traceText.length() > 0 ? callSite + std::string(" ") + traceText : std::string( callSite);
+		}
+		return traceText;
+	}
 	/**
 	 *
 	 */
@@ -171,50 +358,58 @@ namespace Base
 	{
 		if(Trace::traceOn)
 		{
-			std::ostringstream os;
-			std::string margin;
+			std::lock_guard< std::mutex > lock( traceFunctionMutex);
+			traceFunction->trace( formatTraceLine( std::this_thread::get_id(), aTraceMarker, aText, threadIndentionLevels));
+		}
+	}
+	/**
+	 *
+	 */
+	/* static */std::string Trace::formatTraceLine(	std::thread::id aThreadId,
+													char aTraceMarker,
+													const std::string& aText,
+													std::map< std::thread::id, unsigned long >& someIndentionLevels)
+	{
+		std::ostringstream os;
+		std::string margin;
 
-			if(Trace::traceThreadId)
+		if(Trace::traceThreadId)
+		{
+			#if __cplusplus <= 201703L
+			if(someIndentionLevels.find(aThreadId)!=someIndentionLevels.end())
+			#else
+			if(!someIndentionLevels.contains(aThreadId)) // @suppress("Method cannot be resolved")
+			#endif
 			{
-				std::thread::id currentThreadId = std::this_thread::get_id();
-				#if __cplusplus <= 201703L
-				if(threadIndentionLevels.find(currentThreadId)!=threadIndentionLevels.end())
-				#else
-				if(!threadIndentionLevels.contains(currentThreadId)) // @suppress("Method cannot be resolved")
-				#endif
+				someIndentionLevels.insert(std::make_pair(aThreadId,0));
+			}
+			switch(aTraceMarker)
+			{
+				case '+':
 				{
-					threadIndentionLevels.insert(std::make_pair(currentThreadId,0));
+					margin.insert(0, someIndentionLevels[aThreadId], ' ');
+					someIndentionLevels[aThreadId] += INDENTIONLEVEL;
+					break;
 				}
-				switch(aTraceMarker)
+				case '-':
 				{
-					case '+':
-					{
-						margin.insert(0, threadIndentionLevels[currentThreadId], ' ');
-						threadIndentionLevels[currentThreadId] += INDENTIONLEVEL;
-						break;
-					}
-					case '-':
-					{
-						threadIndentionLevels[currentThreadId] -= INDENTIONLEVEL;
-						margin.insert(0, threadIndentionLevels[currentThreadId], ' ');
-						break;
-					}
-					default:
-					{
-						margin.insert(0, threadIndentionLevels[currentThreadId], ' ');
-						break;
-					}
+					someIndentionLevels[aThreadId] -= INDENTIONLEVEL;
+					margin.insert(0, someIndentionLevels[aThreadId], ' ');
+					break;
+				}
+				default:
+				{
+					margin.insert(0, someIndentionLevels[aThreadId], ' ');
+					break;
 				}
-
-				os << margin << currentThreadId << ": " << aTraceMarker << " " << aText;
-			}else
-			{
-				os << margin <<  aTraceMarker << " " << aText;
 			}
 
-			std::lock_guard< std::mutex > lock( traceFunctionMutex);
-			traceFunction->trace(os.str());
+			os << margin << aThreadId << ": " << aTraceMarker << " " << aText;
+		}else
+		{
+			os << margin <<  aTraceMarker << " " << aText;
 		}
+		return os.str();
 	}
 
 
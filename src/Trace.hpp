@@ -5,13 +5,83 @@
 
 #include "ITraceFunction.hpp"
 
+#include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <fstream>
+#include <initializer_list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 namespace Base
 {
+	/**
+	 * A number that is traced with TRACE_VALUES_DEVELOP. The asynchronous trace keeps it as a number, so
+	 * it is only formatted by the background thread, and the binary trace writes it as a typed argument.
+	 */
+	struct TraceValue
+	{
+			/**
+			 *
+			 */
+			enum Type : std::uint8_t
+			{
+				Integer,
+				Unsigned,
+				Real
+			};
+			/**
+			 * The value 0
+			 */
+			TraceValue() :
+								type( Integer),
+								integer( 0)
+			{
+			}
+			/**
+			 *
+			 */
+			template< std::signed_integral Number >
+			TraceValue( Number aNumber) :
+								type( Integer),
+								integer( aNumber)
+			{
+			}
+			/**
+			 *
+			 */
+			template< std::unsigned_integral Number >
+			TraceValue( Number aNumber) :
+								type( Unsigned),
+								unsignedInteger( aNumber)
+			{
+			}
+			/**
+			 *
+			 */
+			template< std::floating_point Number >
+			TraceValue( Number aNumber) :
+								type( Real),
+								real( aNumber)
+			{
+			}
+			/**
+			 * Returns the decimal representation of the value, a real is written as short as it can be read back
+			 */
+			std::string asString() const;
+
+			Type type;
+			union
+			{
+					std::int64_t integer;
+					std::uint64_t unsignedInteger;
+					double real;
+			};
+	};
+
 	/**
 	 * This Trace class can be used instead of just using std::cout.
 	 * Most of the time one just uses the tracing MACROs below and not the class itself.
@@ -19,6 +89,8 @@ namespace Base
 	 */
 	class Trace
 	{
+			friend class AsyncTrace;
+
 		public:
 			/**
 			 *
@@ -35,6 +107,22 @@ namespace Base
 					long aLineNumber    = 0,
 					bool withTimeStamp  = false,
 					bool aTraceCDtor 	= true);
+			/**
+			 * aFunctionName must live as long as the application, like __PRETTY_FUNCTION__. The asynchronous
+			 * trace only keeps the pointer and the binary trace interns it as call site.
+			 */
+			explicit Trace(	const char* aFunctionName,
+							long aLineNumber    = 0,
+							bool withTimeStamp  = false,
+							bool aTraceCDtor 	= true);
+			/**
+			 * @see Trace( const char*, long, bool, bool)
+			 */
+			Trace(	const char* aFunctionName,
+					const std::string& aText,
+					long aLineNumber    = 0,
+					bool withTimeStamp  = false,
+					bool aTraceCDtor 	= true);
 			/**
 			 *
 			 */
@@ -101,8 +189,39 @@ namespace Base
 			 */
 			static void setTraceFunction( std::unique_ptr<ITraceFunction> aTraceFunction)
 			{
+				std::lock_guard< std::mutex > lock( traceFunctionMutex);
 				traceFunction = std::move(aTraceFunction);
 			}
+			/**
+			 * In asynchronous mode the tracing thread only writes a record into a buffer of its own, a background
+			 * thread formats the records and calls the trace function. Use this to keep tracing out of the network
+			 * and model threads. Disabling waits until the records that are written are traced.
+			 *
+			 * @see AsyncTrace
+			 */
+			static void enableAsyncTrace( bool enable = true);
+			/**
+			 *
+			 */
+			static bool isAsyncTraceEnabled()
+			{
+				return asyncTraceOn.load( std::memory_order_relaxed);
+			}
+			/**
+			 * Waits until the records of the asynchronous mode that are written up to now are traced
+			 */
+			static void flushTrace();
+			/**
+			 * Enables the asynchronous mode and writes the trace to aFileName in the BinaryTraceFormat instead of
+			 * to the trace function. Use tracedecoder to turn the file into text or a Chrome trace.
+			 *
+			 * @return False if the file cannot be opened
+			 */
+			static bool enableBinaryTrace( const std::string& aFileName = "trace.bin");
+			/**
+			 * Closes the binary trace file, the trace function is used again
+			 */
+			static void disableBinaryTrace();
 			/**
 			 *
 			 */
@@ -115,6 +234,20 @@ namespace Base
 			                  	const char* aFunctionName,
 			                  	long aLineNumber,
 			                  	bool withTimeStamp = Trace::isTimeStampEnabled());
+			/**
+			 * The maximum number of values of traceValues, the values after it are left out
+			 */
+			static constexpr std::size_t maximumNumberOfValues = 8;
+			/**
+			 * Traces aFunctionName followed by someValues. In asynchronous mode the values are copied as numbers
+			 * into the record and the calling thread does not format them.
+			 *
+			 * @param aFunctionName Must live as long as the application, like __PRETTY_FUNCTION__
+			 */
+			static void traceValues(	const char* aFunctionName,
+										long aLineNumber,
+										std::initializer_list< TraceValue > someValues,
+										bool withTimeStamp = Trace::isTimeStampEnabled());
 		private:
 			/**
 			 *
@@ -124,11 +257,22 @@ namespace Base
 			 *
 			 */
 			void traceDestructor() const;
+			/**
+			 *
+			 */
+			std::string getTraceText() const;
 			/**
 			 *
 			 */
 			static void traceFormattedString(	const std::string& aText,
 												char aTraceMarker);	// 	This text will be prepended
+			/**
+			 * Prepends the indention and thread id of aThreadId and aTraceMarker to aText
+			 */
+			static std::string formatTraceLine(	std::thread::id aThreadId,
+												char aTraceMarker,
+												const std::string& aText,
+												std::map< std::thread::id, unsigned long >& someIndentionLevels);
 
 			/**
 			 *
@@ -150,7 +294,15 @@ namespace Base
 			 *
 			 */
 			static bool	traceExceptions;
+			/**
+			 *
+			 */
+			static std::atomic< bool > asyncTraceOn;
 
+			/**
+			 * Only set if the asynchronous trace was enabled at construction, traceText is the rest of the text then
+			 */
+			const char* callSite = nullptr;
 			/**
 			 *
 			 */
@@ -201,6 +353,12 @@ namespace Base
  * Traces the text.
  */
 #define TRACE_DEVELOP(a_text)               	Base::Trace::trace(a_text)
+/**
+ * \def TRACE_VALUES_DEVELOP(...)
+ * Traces the function name followed by the numbers, e.g. TRACE_VALUES_DEVELOP(queueSize, elapsedSeconds).
+ * The numbers are not formatted by the tracing thread in asynchronous mode.
+ */
+#define TRACE_VALUES_DEVELOP(...)           	Base::Trace::traceValues(__PRETTY_FUNCTION__, __LINE__, {__VA_ARGS__})
 /**
  * The TS-variants do the same as the non-TS-variants but prepend a time stamp to the output.
  */
@@ -212,6 +370,7 @@ namespace Base
 #define FUNCTRACE_DEVELOP()
 #define FUNCTRACE_TEXT_DEVELOP(a_text)
 #define TRACE_DEVELOP(a_text)
+#define TRACE_VALUES_DEVELOP(...)
 #define TSFUNCTRACE_DEVELOP()
 #define TSFUNCTRACE_TEXT_DEVELOP(a_text)
 #define TSTRACE_DEVELOP(a_text)
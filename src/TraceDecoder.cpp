@@ -0,0 +1,398 @@
+#include "Config.hpp"
+
+#include "BinaryTraceFormat.hpp"
+#include "TimeStamp.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// \file
+// The trace decoder reads a binary trace that is written with Base::Trace::enableBinaryTrace and writes
+// it as the text that Base::Trace writes or as Chrome trace event JSON (chrome://tracing, Perfetto).
+// Run "tracedecoder -help" for the options.
+
+namespace Base
+{
+	namespace
+	{
+		/**
+		 *
+		 */
+		const int INDENTIONLEVEL = 3;
+		/**
+		 *
+		 */
+		struct Options
+		{
+				std::string format = "text";
+				std::string input;
+				std::string output;
+		};
+		/**
+		 *
+		 */
+		void printUsage()
+		{
+			std::cout << "Usage: tracedecoder [-format=text|chrome] [-output=file] trace.bin\n"
+					  << "  -format=text    The text of the trace function, with indention per thread (default)\n"
+					  << "  -format=chrome  Chrome trace event JSON, load it in chrome://tracing or ui.perfetto.dev\n"
+					  << "  -output=file    Write to file instead of to standard output" << std::endl;
+		}
+		/**
+		 *
+		 */
+		Options parseOptions(	int argc,
+								char* argv[])
+		{
+			Options options;
+			for (int i = 1; i < argc; ++i)
+			{
+				std::string argument = argv[i];
+				if (argument.compare( 0, 8, "-format=") == 0) // @suppress("Avoid magic numbers")
+				{
+					options.format = argument.substr( 8); // @suppress("Avoid magic numbers")
+				} else if (argument.compare( 0, 8, "-output=") == 0) // @suppress("Avoid magic numbers")
+				{
+					options.output = argument.substr( 8); // @suppress("Avoid magic numbers")
+				} else if (!argument.empty() && argument[0] != '-')
+				{
+					options.input = argument;
+				} else
+				{
+					throw std::invalid_argument( "unknown option " + argument);
+				}
+			}
+			if (options.input.empty())
+			{
+				throw std::invalid_argument( "no trace file given");
+			}
+			if (options.format != "text" && options.format != "chrome")
+			{
+				throw std::invalid_argument( "unknown format " + options.format);
+			}
+			return options;
+		}
+		/**
+		 *
+		 */
+		std::string escapeJson( const std::string& aText)
+		{
+			std::ostringstream os;
+			for (char c : aText)
+			{
+				switch (c)
+				{
+					case '"':
+						os << "\\\"";
+						break;
+					case '\\':
+						os << "\\\\";
+						break;
+					case '\n':
+						os << "\\n";
+						break;
+					case '\t':
+						os << "\\t";
+						break;
+					default:
+						if (static_cast< unsigned char >( c) < 0x20) // @suppress("Avoid magic numbers")
+						{
+							os << "\\u" << std::hex << std::setw( 4) << std::setfill( '0') << static_cast< int >( c) << std::dec; // @suppress("Avoid magic numbers")
+						} else
+						{
+							os << c;
+						}
+						break;
+				}
+			}
+			return os.str();
+		}
+		/**
+		 *
+		 */
+		std::string argumentToString( const BinaryTraceFormat::Argument& anArgument)
+		{
+			switch (anArgument.type)
+			{
+				case BinaryTraceFormat::IntegerArgument:
+					return std::to_string( anArgument.integer);
+				case BinaryTraceFormat::UnsignedArgument:
+					return std::to_string( anArgument.unsignedInteger);
+				case BinaryTraceFormat::RealArgument:
+				{
+					// As short as it can be read back, std::to_string would round to 6 decimals
+					char buffer[32]; // @suppress("Avoid magic numbers")
+					auto [end, error] = std::to_chars( buffer, buffer + sizeof( buffer), anArgument.real);
+					return error == std::errc() ? std::string( buffer, end) : std::to_string( anArgument.real);
+				}
+				case BinaryTraceFormat::StringArgument:
+					return anArgument.text;
+			}
+			return "";
+		}
+		/**
+		 * Writes the events in the format of the trace functions
+		 */
+		class TextWriter
+		{
+			public:
+				TextWriter(	std::ostream& anOutput,
+							std::int64_t aWallClockOffset) :
+								output( anOutput),
+								wallClockOffset( aWallClockOffset)
+				{
+				}
+				void writeEvent(	const BinaryTraceFormat::Event& anEvent,
+									const std::string& aCallSite)
+				{
+					unsigned long& indentionLevel = threadIndentionLevels[anEvent.threadId];
+					if (anEvent.traceMarker == '-' && indentionLevel >= INDENTIONLEVEL)
+					{
+						indentionLevel -= INDENTIONLEVEL;
+					}
+					output << std::string( indentionLevel, ' ') << anEvent.threadId << ": " << anEvent.traceMarker << " ";
+					if (anEvent.traceMarker == '+')
+					{
+						indentionLevel += INDENTIONLEVEL;
+					}
+
+					if (anEvent.flags & BinaryTraceFormat::WithTimeStamp)
+					{
+						std::chrono::nanoseconds wallClock( static_cast< std::int64_t >( anEvent.time) + wallClockOffset);
+						output << Utils::TimeStamp( std::chrono::system_clock::time_point( std::chrono::duration_cast< std::chrono::system_clock::duration >( wallClock))) << ": ";
+					}
+					std::string separator;
+					if (!aCallSite.empty())
+					{
+						output << aCallSite;
+						separator = " ";
+					}
+					for (const BinaryTraceFormat::Argument& argument : anEvent.arguments)
+					{
+						output << separator << argumentToString( argument);
+						separator = " ";
+					}
+					if (anEvent.lineNumber >= 0)
+					{
+						output << " (line " << anEvent.lineNumber << ")";
+					}
+					output << '\n';
+				}
+				void writeDropped(	std::uint64_t aThreadId,
+									std::uint64_t aNumberOfEvents)
+				{
+					output << "*** AsyncTrace: " << aNumberOfEvents << " trace records of thread " << aThreadId << " dropped, the buffer was full\n";
+				}
+				void finish()
+				{
+				}
+			private:
+				std::ostream& output;
+				std::int64_t wallClockOffset;
+				std::map< std::uint64_t, unsigned long > threadIndentionLevels;
+		};
+		/**
+		 * Writes the events as Chrome trace events: '+' begins a slice, '-' ends it and '>' is an instant event
+		 */
+		class ChromeWriter
+		{
+			public:
+				explicit ChromeWriter( std::ostream& anOutput) :
+								output( anOutput)
+				{
+					output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+				}
+				void writeEvent(	const BinaryTraceFormat::Event& anEvent,
+									const std::string& aCallSite)
+				{
+					const char* phase = anEvent.traceMarker == '+' ? "B" : anEvent.traceMarker == '-' ? "E" : "i";
+					std::string name = aCallSite.empty() && !anEvent.arguments.empty() ? argumentToString( anEvent.arguments.front()) : aCallSite;
+
+					startEvent( anEvent.time, anEvent.threadId);
+					output << ",\"ph\":\"" << phase << "\",\"name\":\"" << escapeJson( name) << "\"";
+					if (anEvent.traceMarker != '+' && anEvent.traceMarker != '-')
+					{
+						output << ",\"s\":\"t\"";
+					}
+					output << ",\"args\":{";
+					std::string separator;
+					if (anEvent.lineNumber >= 0)
+					{
+						output << "\"line\":" << anEvent.lineNumber;
+						separator = ",";
+					}
+					for (std::size_t i = 0; i < anEvent.arguments.size(); ++i)
+					{
+						const BinaryTraceFormat::Argument& argument = anEvent.arguments[i];
+						output << separator << "\"arg" << i << "\":";
+						// JSON has no infinity or NaN, those reals are written as strings
+						if (argument.type == BinaryTraceFormat::StringArgument ||
+							(argument.type == BinaryTraceFormat::RealArgument && !std::isfinite( argument.real)))
+						{
+							output << "\"" << escapeJson( argumentToString( argument)) << "\"";
+						} else
+						{
+							output << argumentToString( argument);
+						}
+						separator = ",";
+					}
+					output << "}}";
+				}
+				void writeDropped(	std::uint64_t aThreadId,
+									std::uint64_t aNumberOfEvents)
+				{
+					startEvent( lastTime, aThreadId);
+					output << ",\"ph\":\"i\",\"s\":\"t\",\"name\":\"dropped\",\"args\":{\"events\":" << aNumberOfEvents << "}}";
+				}
+				void finish()
+				{
+					output << "]}\n";
+				}
+			private:
+				void startEvent(	std::uint64_t aTime,
+									std::uint64_t aThreadId)
+				{
+					if (firstEvent)
+					{
+						firstTime = aTime;
+						firstEvent = false;
+					} else
+					{
+						output << ",";
+					}
+					lastTime = aTime;
+					// Chrome wants microseconds, relative to the first event so the fraction keeps the nanoseconds
+					output << "\n{\"pid\":1,\"tid\":" << aThreadId << ",\"ts\":" << std::fixed << std::setprecision( 3) << static_cast< double >( aTime - std::min( aTime, firstTime)) / 1000.0; // @suppress("Avoid magic numbers")
+				}
+
+				std::ostream& output;
+				bool firstEvent = true;
+				std::uint64_t firstTime = 0;
+				std::uint64_t lastTime = 0;
+		};
+		/**
+		 *
+		 */
+		template< typename Writer >
+		void decode(	std::istream& anInput,
+						Writer& aWriter)
+		{
+			std::map< std::uint32_t, std::string > callSites;
+			BinaryTraceFormat::Event event;
+			std::uint64_t recordType = 0;
+			while (BinaryTraceFormat::readNumber( anInput, recordType, 1))
+			{
+				switch (recordType)
+				{
+					case BinaryTraceFormat::CallSiteRecord:
+					{
+						std::uint32_t id = 0;
+						std::string text;
+						if (!BinaryTraceFormat::readCallSite( anInput, id, text))
+						{
+							throw std::runtime_error( "truncated call site record");
+						}
+						callSites[id] = text;
+						break;
+					}
+					case BinaryTraceFormat::EventRecord:
+					{
+						if (!BinaryTraceFormat::readEvent( anInput, event))
+						{
+							throw std::runtime_error( "truncated event record");
+						}
+						aWriter.writeEvent( event, callSites[event.callSiteId]);
+						break;
+					}
+					case BinaryTraceFormat::DroppedRecord:
+					{
+						std::uint64_t threadId = 0;
+						std::uint64_t numberOfEvents = 0;
+						if (!BinaryTraceFormat::readDropped( anInput, threadId, numberOfEvents))
+						{
+							throw std::runtime_error( "truncated dropped record");
+						}
+						aWriter.writeDropped( threadId, numberOfEvents);
+						break;
+					}
+					default:
+					{
+						throw std::runtime_error( "unknown record type " + std::to_string( recordType));
+					}
+				}
+			}
+			aWriter.finish();
+		}
+		/**
+		 *
+		 */
+		void run( const Options& anOptions)
+		{
+			std::ifstream input( anOptions.input, std::ios_base::in | std::ios_base::binary);
+			if (!input)
+			{
+				throw std::runtime_error( "cannot open " + anOptions.input);
+			}
+			std::int64_t wallClockOffset = 0;
+			if (!BinaryTraceFormat::readHeader( input, wallClockOffset))
+			{
+				throw std::runtime_error( anOptions.input + " is not a binary trace");
+			}
+
+			std::ofstream file;
+			if (!anOptions.output.empty())
+			{
+				file.open( anOptions.output);
+				if (!file)
+				{
+					throw std::runtime_error( "cannot open " + anOptions.output);
+				}
+			}
+			std::ostream& output = anOptions.output.empty() ? std::cout : file;
+
+			if (anOptions.format == "chrome")
+			{
+				ChromeWriter writer( output);
+				decode( input, writer);
+			} else
+			{
+				TextWriter writer( output, wallClockOffset);
+				decode( input, writer);
+			}
+		}
+	} // namespace
+} // namespace Base
+
+/**
+ *
+ */
+int main( 	int argc,
+			char* argv[])
+{
+	if (argc > 1 && (std::string( argv[1]) == "-help" || std::string( argv[1]) == "-h"))
+	{
+		Base::printUsage();
+		return 0;
+	}
+	try
+	{
+		Base::run( Base::parseOptions( argc, argv));
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << __PRETTY_FUNCTION__ << ": " << e.what() << std::endl;
+		Base::printUsage();
+		return 1;
+	}
+	return 0;
+}
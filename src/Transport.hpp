@@ -0,0 +1,178 @@
+#ifndef TRANSPORT_HPP_
+#define TRANSPORT_HPP_
+
+#include "Config.hpp"
+
+#include "Message.hpp"
+#include "MessageHandler.hpp"
+#include "MessageTypes.hpp"
+#include "RequestDispatcher.hpp"
+#include "Trace.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Messaging
+{
+	/**
+	 * A Channel carries the requests of a PipelinedClient to one server. A request is sent without waiting
+	 * for the responses to the previous requests, the responses carry the correlation id of their request.
+	 *
+	 * Every response is passed to the response function that is given when the channel is opened. A
+	 * CommunicationReadError with correlation id 0 means that the channel lost its connection, the requests
+	 * that were sent before are not answered anymore. The next request makes a new connection.
+	 */
+	class Channel
+	{
+		public:
+			/**
+			 *
+			 */
+			virtual ~Channel() = default;
+			/**
+			 * Sends aRequest. May be called from any thread.
+			 */
+			virtual void sendMessage( Message&& aRequest) = 0;
+			/**
+			 * Closes the connection of the channel if it has one. Must be called from the thread that runs the io_context.
+			 */
+			virtual void close() = 0;
+	}; // class Channel
+	typedef std::shared_ptr< Channel > ChannelPtr;
+
+	/**
+	 * A Transport moves the messages of the Client, PipelinedClient and Server. There is one transport
+	 * per TransportType, CommunicationService::getTransport returns the one that is selected.
+	 *
+	 * The request and response handlers are always called on the thread that runs the io_context,
+	 * or on the model thread of a RequestDispatcher, whatever the transport is.
+	 */
+	class Transport
+	{
+		public:
+			/**
+			 *
+			 */
+			typedef std::function< void( const Message&) > ResponseFunction;
+			/**
+			 *
+			 */
+			virtual ~Transport() = default;
+			/**
+			 * Serves the requests that are sent to aPort with aRequestHandler
+			 *
+			 * @param aRequestDispatcher If given the requests are handled by its model thread instead of the thread that runs the io_context
+			 * @throw std::runtime_error if there already is a request handler for aPort
+			 */
+			virtual void registerRequestHandler(	unsigned short aPort,
+													RequestHandlerPtr aRequestHandler,
+													RequestDispatcherPtr aRequestDispatcher) = 0;
+			/**
+			 * Stops serving the requests that are sent to aPort
+			 */
+			virtual void deregisterRequestHandler( unsigned short aPort) = 0;
+			/**
+			 * Sends one request to the server of aPort on aHostName. The response is passed to aResponseHandler,
+			 * a request that fails is traced and gets no response. May be called from any thread.
+			 */
+			virtual void dispatchMessage(	const std::string& aHostName,
+											unsigned short aPort,
+											const Message& aRequest,
+											ResponseHandlerPtr aResponseHandler) = 0;
+			/**
+			 * Opens a channel to the server of aPort on aHostName, no connection is made before the first request.
+			 *
+			 * @param aResponseFunction Gets the responses to the requests of the channel
+			 */
+			virtual ChannelPtr openChannel(	const std::string& aHostName,
+											unsigned short aPort,
+											ResponseFunction aResponseFunction) = 0;
+	}; // class Transport
+
+	/**
+	 * The base of the transports that hand every request with its own response function to the
+	 * server, without connections. The host name is ignored: the server is in this process or on this host.
+	 */
+	class RouterTransport : public Transport
+	{
+		public:
+			/**
+			 * Hands aRequest to the request handler of aPort and the response to aResponseFunction.
+			 * If the request cannot be delivered aResponseFunction gets a CommunicationReadError or
+			 * CommunicationWriteError with the correlation id of aRequest. May be called from any thread.
+			 */
+			virtual void routeMessage(	unsigned short aPort,
+										const Message& aRequest,
+										ResponseFunction aResponseFunction) = 0;
+			/**
+			 * @see Transport::dispatchMessage
+			 */
+			virtual void dispatchMessage(	const std::string& UNUSEDPARAM(aHostName),
+											unsigned short aPort,
+											const Message& aRequest,
+											ResponseHandlerPtr aResponseHandler) override
+			{
+				routeMessage(	aPort,
+								aRequest,
+								[aResponseHandler](const Message& aResponse)
+								{
+									// Errors are traced and not passed to the response handler as a ClientSession does
+									if (aResponse.getMessageType() != CommunicationReadError && aResponse.getMessageType() != CommunicationWriteError)
+									{
+										aResponseHandler->handleResponse( aResponse);
+									} else
+									{
+										TRACE_DEVELOP("*** RouterTransport: " + aResponse.asString());
+									}
+								});
+			}
+			/**
+			 * @see Transport::openChannel
+			 */
+			virtual ChannelPtr openChannel(	const std::string& UNUSEDPARAM(aHostName),
+											unsigned short aPort,
+											ResponseFunction aResponseFunction) override
+			{
+				return std::make_shared< RouterChannel >( *this, aPort, aResponseFunction);
+			}
+		private:
+			/**
+			 * Routes every request on its own, there is no connection to lose
+			 */
+			class RouterChannel : public Channel
+			{
+				public:
+					/**
+					 *
+					 */
+					RouterChannel(	RouterTransport& aRouterTransport,
+									unsigned short aPort,
+									ResponseFunction aResponseFunction) :
+										routerTransport( aRouterTransport),
+										port( aPort),
+										responseFunction( aResponseFunction)
+					{
+					}
+					/**
+					 * @see Channel::sendMessage
+					 */
+					virtual void sendMessage( Message&& aRequest) override
+					{
+						routerTransport.routeMessage( port, aRequest, responseFunction);
+					}
+					/**
+					 * @see Channel::close
+					 */
+					virtual void close() override
+					{
+					}
+				private:
+					RouterTransport& routerTransport;
+					unsigned short port;
+					ResponseFunction responseFunction;
+			}; // class RouterChannel
+	}; // class RouterTransport
+} // namespace Messaging
+
+#endif // TRANSPORT_HPP_
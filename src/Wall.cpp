@@ -1,6 +1,7 @@
 #include "Wall.hpp"
 
 #include "Logger.hpp"
+#include "RobotWorld.hpp"
 #include "Shape2DUtils.hpp"
 
 #include <sstream>
@@ -23,6 +24,7 @@ namespace Model
 							bool aNotifyObservers /*= true*/)
 	{
 		point1 = aPoint1;
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -35,6 +37,7 @@ namespace Model
 							bool aNotifyObservers /*= true*/)
 	{
 		point2 = aPoint2;
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
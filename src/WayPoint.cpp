@@ -1,6 +1,7 @@
 #include "WayPoint.hpp"
 
 #include "Logger.hpp"
+#include "RobotWorld.hpp"
 
 #include <sstream>
 
@@ -48,6 +49,7 @@ wxSize WayPoint::getSize() const
 							bool aNotifyObservers /*= true*/)
 	{
 		size = aSize;
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -60,6 +62,7 @@ wxSize WayPoint::getSize() const
 								bool aNotifyObservers /*= true*/)
 	{
 		position = aPosition;
+		RobotWorld::getRobotWorld().updateSpatialIndex( *this);
 		if (aNotifyObservers == true)
 		{
 			notifyObservers();
@@ -68,27 +71,16 @@ wxSize WayPoint::getSize() const
 	/**
 	 *
 	 */
-	wxRegion WayPoint::getRegion() const
+	Utils::OrientedBox WayPoint::getOrientedBox() const
 	{
-		// x and y are pointing to top left now
-		int x = position.x - (size.x / 2);
-		int y = position.y - (size.y / 2);
-
-		wxPoint originalUpperLeft( x, y);
-		wxPoint originalUpperRight( x + size.x, y);
-		wxPoint originalBottomLeft( x, y + size.y);
-		wxPoint originalBottomRight( x + size.x, y + size.y);
-
-		wxPoint originalPoints[] = { originalUpperRight, originalUpperLeft, originalBottomLeft, originalBottomRight };
-
-		return wxRegion( 4, originalPoints);
+		return Utils::OrientedBox::around( position, size);
 	}
 	/**
 	 *
 	 */
-	bool WayPoint::intersects( const wxRegion& aRegion) const
+	bool WayPoint::intersects( const Utils::OrientedBox& anOrientedBox) const
 	{
-		return getRegion().Intersect( aRegion);
+		return getOrientedBox().intersects( anOrientedBox);
 	}
 	/**
 	 *
@@ -4,8 +4,8 @@
 #include "Config.hpp"
 
 #include "ModelObject.hpp"
+#include "OrientedBox.hpp"
 #include "Point.hpp"
-#include "Region.hpp"
 
 namespace Model
 {
@@ -60,11 +60,11 @@ namespace Model
 			/**
 			 *
 			 */
-			wxRegion getRegion() const;
+			Utils::OrientedBox getOrientedBox() const;
 			/**
 			 *
 			 */
-			bool intersects( const wxRegion& aRegion) const;
+			bool intersects( const Utils::OrientedBox& anOrientedBox) const;
 			/**
 			 * @name Debug functions
 			 */
@@ -0,0 +1,218 @@
+#ifndef WORLDINFOPARSER_HPP_
+#define WORLDINFOPARSER_HPP_
+
+#include "Config.hpp"
+
+#include "BoundedVector.hpp"
+#include "Point.hpp"
+
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+
+namespace Model
+{
+	/**
+	 * Single pass parser for the world info as produced by Robot::getWorldInfo:
+	 *
+	 * 		Walls<x1>,<y1>,<x2>,<y2>_<x1>,<y1>,<x2>,<y2>;Goals<x>,<y>_<x>,<y>;Robot<x>,<y>,<frontX>,<frontY>#<objectId>
+	 *
+	 * The parser works directly on the given std::string_view and does not allocate: every wall, goal and robot
+	 * is handed to the given callbacks as soon as it is parsed. Records that cannot be parsed are skipped.
+	 */
+	class WorldInfoParser
+	{
+		public:
+			/**
+			 *
+			 */
+			struct RobotInfo
+			{
+					wxPoint position;
+					BoundedVector front;
+					/**
+					 * Empty if the sender did not send its ObjectId. Points into the parsed text.
+					 */
+					std::string_view objectId;
+			};
+			/**
+			 * Parses the world info
+			 *
+			 * @param aWorldInfo The world info text
+			 * @param aWallFunction Called as aWallFunction( const wxPoint&, const wxPoint&) for every wall
+			 * @param aGoalFunction Called as aGoalFunction( const wxPoint&) for every goal
+			 * @param aRobotFunction Called as aRobotFunction( const RobotInfo&) for every robot
+			 * @return The number of records that could not be parsed
+			 */
+			template< typename WallFunction, typename GoalFunction, typename RobotFunction >
+			static std::size_t parse(	std::string_view aWorldInfo,
+										WallFunction aWallFunction,
+										GoalFunction aGoalFunction,
+										RobotFunction aRobotFunction)
+			{
+				std::size_t errors = 0;
+				while (!aWorldInfo.empty())
+				{
+					std::string_view section = nextToken( aWorldInfo, ';');
+					if (skipKeyword( section, "Walls"))
+					{
+						while (!section.empty())
+						{
+							std::string_view record = nextToken( section, '_');
+							int values[4];
+							if (parseNumbers( record, values, 4))
+							{
+								aWallFunction( wxPoint( values[0], values[1]), wxPoint( values[2], values[3]));
+							} else if (!record.empty())
+							{
+								++errors;
+							}
+						}
+					} else if (skipKeyword( section, "Goals"))
+					{
+						while (!section.empty())
+						{
+							std::string_view record = nextToken( section, '_');
+							int values[2];
+							if (parseNumbers( record, values, 2))
+							{
+								aGoalFunction( wxPoint( values[0], values[1]));
+							} else if (!record.empty())
+							{
+								++errors;
+							}
+						}
+					} else if (skipKeyword( section, "Robot"))
+					{
+						RobotInfo robotInfo;
+						if (parseRobot( section, robotInfo))
+						{
+							aRobotFunction( robotInfo);
+						} else
+						{
+							++errors;
+						}
+					} else if (!section.empty())
+					{
+						++errors;
+					}
+				}
+				return errors;
+			}
+			/**
+			 * Parses "<x>,<y>,<frontX>,<frontY>[#<objectId>]"
+			 *
+			 * @return true if the robot could be parsed, false otherwise
+			 */
+			static bool parseRobot(	std::string_view aRobotText,
+									RobotInfo& aRobotInfo)
+			{
+				std::string_view::size_type objectIdSeparator = aRobotText.find( '#');
+				if (objectIdSeparator != std::string_view::npos)
+				{
+					aRobotInfo.objectId = aRobotText.substr( objectIdSeparator + 1);
+					aRobotText = aRobotText.substr( 0, objectIdSeparator);
+				}
+
+				int position[2];
+				double front[2] = { 0.0, 0.0 };
+				std::string_view x = nextToken( aRobotText, ',');
+				std::string_view y = nextToken( aRobotText, ',');
+				if (!parseNumber( x, position[0]) || !parseNumber( y, position[1]))
+				{
+					return false;
+				}
+				// The front is optional, the world sync sends 0.0 as front
+				for (double& frontValue : front)
+				{
+					std::string_view token = nextToken( aRobotText, ',');
+					if (!token.empty() && !parseNumber( token, frontValue))
+					{
+						return false;
+					}
+				}
+				aRobotInfo.position = wxPoint( position[0], position[1]);
+				aRobotInfo.front = BoundedVector( front[0], front[1]);
+				return true;
+			}
+			/**
+			 * Parses exactly aNumberOfValues comma separated integers
+			 *
+			 * @return true if exactly aNumberOfValues integers could be parsed, false otherwise
+			 */
+			static bool parseNumbers(	std::string_view aText,
+										int* aValues,
+										std::size_t aNumberOfValues)
+			{
+				for (std::size_t i = 0; i < aNumberOfValues; ++i)
+				{
+					if (!parseNumber( nextToken( aText, ','), aValues[i]))
+					{
+						return false;
+					}
+				}
+				return aText.empty();
+			}
+			/**
+			 * Parses a number that must fill the complete token. Doubles as "12.000000" are accepted
+			 * for integer values and are truncated, as was done by std::stoi.
+			 */
+			template< typename Number >
+			static bool parseNumber(	std::string_view aToken,
+										Number& aValue)
+			{
+				const char* first = aToken.data();
+				const char* last = aToken.data() + aToken.size();
+				if (first != last && *first == '+')
+				{
+					++first;
+				}
+				auto [end, error] = std::from_chars( first, last, aValue);
+				if (error != std::errc() || end == first)
+				{
+					return false;
+				}
+				if constexpr (std::is_integral_v< Number >)
+				{
+					if (end != last && *end == '.')
+					{
+						// Skip the fraction
+						++end;
+						while (end != last && *end >= '0' && *end <= '9')
+						{
+							++end;
+						}
+					}
+				}
+				return end == last;
+			}
+			/**
+			 * Returns the text up to aSeparator and removes it, including the separator, from aText
+			 */
+			static std::string_view nextToken(	std::string_view& aText,
+												char aSeparator)
+			{
+				std::string_view::size_type separator = aText.find( aSeparator);
+				std::string_view token = aText.substr( 0, separator);
+				aText.remove_prefix( separator == std::string_view::npos ? aText.size() : separator + 1);
+				return token;
+			}
+		private:
+			/**
+			 * Removes aKeyword from the start of aText if it is there
+			 *
+			 * @return true if aKeyword was removed, false otherwise
+			 */
+			static bool skipKeyword(	std::string_view& aText,
+										std::string_view aKeyword)
+			{
+				if (aText.substr( 0, aKeyword.size()) == aKeyword)
+				{
+					aText.remove_prefix( aKeyword.size());
+					return true;
+				}
+				return false;
+			}
+	};
+} // namespace Model
+#endif // WORLDINFOPARSER_HPP_
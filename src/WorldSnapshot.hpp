@@ -0,0 +1,115 @@
+#ifndef WORLDSNAPSHOT_HPP_
+#define WORLDSNAPSHOT_HPP_
+
+#include "Config.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Model
+{
+	class Robot;
+	typedef std::shared_ptr<Robot> RobotPtr;
+
+	class WayPoint;
+	typedef std::shared_ptr<WayPoint> WayPointPtr;
+
+	class Goal;
+	typedef std::shared_ptr<Goal> GoalPtr;
+
+	class Wall;
+	typedef std::shared_ptr<Wall> WallPtr;
+
+	class WorldSnapshot;
+	typedef std::shared_ptr< const WorldSnapshot > WorldSnapshotPtr;
+
+	/**
+	 * An immutable version of the objects in RobotWorld. Every change of the set of objects publishes a
+	 * new version, a reader that holds a snapshot sees a consistent set of objects however long it
+	 * holds it, and the snapshot is freed when the last reader drops it.
+	 *
+	 * Only the set of objects is versioned, the objects themselves are shared with the world and can
+	 * still be moved by their robot threads. The objects of a kind that did not change are shared with
+	 * the previous snapshot, a new robot does not copy the walls.
+	 */
+	class WorldSnapshot
+	{
+		public:
+			/**
+			 *
+			 */
+			template< typename T >
+			using SharedObjects = std::shared_ptr< const std::vector< std::shared_ptr< T > > >;
+			/**
+			 * The empty world
+			 */
+			WorldSnapshot() :
+								robots( std::make_shared< const std::vector< RobotPtr > >()),
+								wayPoints( std::make_shared< const std::vector< WayPointPtr > >()),
+								goals( std::make_shared< const std::vector< GoalPtr > >()),
+								walls( std::make_shared< const std::vector< WallPtr > >())
+			{
+			}
+			/**
+			 *
+			 */
+			WorldSnapshot(	std::uint64_t aVersion,
+							SharedObjects< Robot > aRobots,
+							SharedObjects< WayPoint > aWayPoints,
+							SharedObjects< Goal > aGoals,
+							SharedObjects< Wall > aWalls) :
+								version( aVersion),
+								robots( std::move( aRobots)),
+								wayPoints( std::move( aWayPoints)),
+								goals( std::move( aGoals)),
+								walls( std::move( aWalls))
+			{
+			}
+			/**
+			 * Increases with every published version
+			 */
+			std::uint64_t getVersion() const
+			{
+				return version;
+			}
+			/**
+			 *
+			 */
+			const std::vector< RobotPtr >& getRobots() const
+			{
+				return *robots;
+			}
+			/**
+			 *
+			 */
+			const std::vector< WayPointPtr >& getWayPoints() const
+			{
+				return *wayPoints;
+			}
+			/**
+			 *
+			 */
+			const std::vector< GoalPtr >& getGoals() const
+			{
+				return *goals;
+			}
+			/**
+			 *
+			 */
+			const std::vector< WallPtr >& getWalls() const
+			{
+				return *walls;
+			}
+
+		private:
+			const std::uint64_t version = 0;
+			const SharedObjects< Robot > robots;
+			const SharedObjects< WayPoint > wayPoints;
+			const SharedObjects< Goal > goals;
+			const SharedObjects< Wall > walls;
+	}; // class WorldSnapshot
+} // namespace Model
+
+#endif // WORLDSNAPSHOT_HPP_
@@ -0,0 +1,343 @@
+#include "WorldSync.hpp"
+
+#include "Goal.hpp"
+#include "Logger.hpp"
+#include "MessageTypes.hpp"
+#include "Robot.hpp"
+#include "RobotWorld.hpp"
+#include "Trace.hpp"
+#include "Wall.hpp"
+#include "WorldInfoParser.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace Model
+{
+	namespace
+	{
+		/**
+		 * Appends the decimal representation of aNumber without a temporary std::string
+		 */
+		template< typename Number >
+		void appendNumber(	std::string& aString,
+							Number aNumber)
+		{
+			char buffer[32]; // @suppress("Avoid magic numbers")
+			auto [end, error] = std::to_chars( buffer, buffer + sizeof( buffer), aNumber);
+			if (error == std::errc())
+			{
+				aString.append( buffer, end);
+			}
+		}
+	}
+	/**
+	 *
+	 */
+	bool WorldSyncChunkHeader::fromString(	std::string_view aChunkBody,
+											std::string_view& aWorldInfo)
+	{
+		std::string_view::size_type separator = aChunkBody.find( '|');
+		if (separator == std::string_view::npos)
+		{
+			return false;
+		}
+		aWorldInfo = aChunkBody.substr( separator + 1);
+		std::string_view header = aChunkBody.substr( 0, separator);
+
+		unsigned long reply = 0;
+		if (!WorldInfoParser::parseNumber( WorldInfoParser::nextToken( header, ','), streamId) ||
+			!WorldInfoParser::parseNumber( WorldInfoParser::nextToken( header, ','), chunkIndex) ||
+			!WorldInfoParser::parseNumber( WorldInfoParser::nextToken( header, ','), numberOfChunks) ||
+			!WorldInfoParser::parseNumber( WorldInfoParser::nextToken( header, ','), reply))
+		{
+			return false;
+		}
+		replyRequested = reply != 0;
+		return chunkIndex < numberOfChunks;
+	}
+	/**
+	 *
+	 */
+	void WorldSyncChunkHeader::appendTo( std::string& aChunkBody) const
+	{
+		appendNumber( aChunkBody, streamId);
+		aChunkBody += ',';
+		appendNumber( aChunkBody, chunkIndex);
+		aChunkBody += ',';
+		appendNumber( aChunkBody, numberOfChunks);
+		aChunkBody += ',';
+		aChunkBody += replyRequested ? '1' : '0';
+		aChunkBody += '|';
+	}
+	/**
+	 *
+	 */
+	WorldSyncSender::WorldSyncSender(	RobotPtr aRobot,
+										DispatchFunction aDispatchFunction,
+										FinishFunction aFinishFunction,
+										bool aReplyRequested,
+										std::size_t aMaximumRecordsPerChunk /* = defaultMaximumRecordsPerChunk */,
+										std::size_t aWindowSize /* = defaultWindowSize */) :
+								streamId( ++streamCounter),
+								robot( aRobot),
+								worldSnapshot( RobotWorld::getRobotWorld().getSnapshot()),
+								walls( worldSnapshot->getWalls()),
+								goals( worldSnapshot->getGoals()),
+								dispatchFunction( aDispatchFunction),
+								finishFunction( aFinishFunction),
+								replyRequested( aReplyRequested),
+								maximumRecordsPerChunk( std::max( aMaximumRecordsPerChunk, std::size_t( 1))),
+								windowSize( std::max( aWindowSize, std::size_t( 1)))
+	{
+		std::size_t numberOfRecords = walls.size() + goals.size();
+		numberOfChunks = std::max( (numberOfRecords + maximumRecordsPerChunk - 1) / maximumRecordsPerChunk, std::size_t( 1));
+	}
+	/**
+	 *
+	 */
+	void WorldSyncSender::start()
+	{
+		std::unique_lock< std::mutex > lock( senderMutex);
+		fillWindow( lock);
+	}
+	/**
+	 *
+	 */
+	void WorldSyncSender::handleResponse( const Messaging::Message& aResponse)
+	{
+		std::unique_lock< std::mutex > lock( senderMutex);
+		if (failed)
+		{
+			return;
+		}
+
+		std::string_view body( aResponse.message);
+		unsigned long acknowledgedStreamId = 0;
+		if (aResponse.getMessageType() != Messaging::SyncWorldChunkResponse ||
+			!WorldInfoParser::parseNumber( WorldInfoParser::nextToken( body, ','), acknowledgedStreamId) ||
+			acknowledgedStreamId != streamId)
+		{
+			// An error response, or the receiver could not use the chunk: the world would stay incomplete
+			failed = true;
+			TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": world sync stream ") + std::to_string( streamId) + " failed, " + aResponse.asString());
+			reportFinished( lock);
+			return;
+		}
+
+		++acknowledgedChunks;
+		if (acknowledgedChunks >= numberOfChunks)
+		{
+			reportFinished( lock);
+			return;
+		}
+		fillWindow( lock);
+	}
+	/**
+	 *
+	 */
+	bool WorldSyncSender::isFinished() const
+	{
+		std::unique_lock< std::mutex > lock( senderMutex);
+		return failed || acknowledgedChunks >= numberOfChunks;
+	}
+	/**
+	 *
+	 */
+	bool WorldSyncSender::isFailed() const
+	{
+		std::unique_lock< std::mutex > lock( senderMutex);
+		return failed;
+	}
+	/**
+	 *
+	 */
+	void WorldSyncSender::fillWindow( std::unique_lock< std::mutex >& aLock)
+	{
+		std::size_t firstChunk = nextChunk;
+		while (!failed && nextChunk < numberOfChunks && nextChunk - acknowledgedChunks < windowSize)
+		{
+			++nextChunk;
+		}
+		std::size_t lastChunk = nextChunk;
+		aLock.unlock();
+
+		// The snapshot does not change, the reserved chunks are serialised without the lock.
+		// The response function does not keep the sender alive, a replaced sender ignores its responses.
+		std::weak_ptr< WorldSyncSender > weakSender = weak_from_this();
+		for (std::size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+		{
+			dispatchFunction(	Messaging::Message( Messaging::SyncWorldChunkRequest, serialiseChunk( chunk)),
+								[weakSender](const Messaging::Message& aResponse)
+								{
+									if (WorldSyncSenderPtr sender = weakSender.lock())
+									{
+										sender->handleResponse( aResponse);
+									}
+								});
+		}
+	}
+	/**
+	 *
+	 */
+	void WorldSyncSender::reportFinished( std::unique_lock< std::mutex >& aLock)
+	{
+		if (finishReported)
+		{
+			return;
+		}
+		finishReported = true;
+		bool succeeded = !failed;
+		aLock.unlock();
+
+		if (finishFunction)
+		{
+			finishFunction( succeeded);
+		}
+	}
+	/**
+	 *
+	 */
+	std::string WorldSyncSender::serialiseChunk( std::size_t aChunkIndex) const
+	{
+		std::size_t first = aChunkIndex * maximumRecordsPerChunk;
+		std::size_t last = std::min( first + maximumRecordsPerChunk, walls.size() + goals.size());
+
+		std::string chunk;
+		// Every record is at most 4 numbers of 11 characters plus the separators
+		chunk.reserve( 64 + (last - first) * 48); // @suppress("Avoid magic numbers")
+
+		WorldSyncChunkHeader header;
+		header.streamId = streamId;
+		header.chunkIndex = aChunkIndex;
+		header.numberOfChunks = numberOfChunks;
+		header.replyRequested = replyRequested;
+		header.appendTo( chunk);
+
+		if (first < walls.size())
+		{
+			chunk += "Walls";
+			for (std::size_t i = first; i < std::min( last, walls.size()); ++i)
+			{
+				if (i != first)
+				{
+					chunk += '_';
+				}
+				appendWall( chunk, *walls[i]);
+			}
+		}
+		if (last > walls.size())
+		{
+			if (first < walls.size())
+			{
+				chunk += ';';
+			}
+			chunk += "Goals";
+			for (std::size_t i = std::max( first, walls.size()); i < last; ++i)
+			{
+				if (i != std::max( first, walls.size()))
+				{
+					chunk += '_';
+				}
+				appendGoal( chunk, *goals[i - walls.size()]);
+			}
+		}
+		if (aChunkIndex + 1 == numberOfChunks && robot)
+		{
+			if (first < last)
+			{
+				chunk += ';';
+			}
+			chunk += "Robot";
+			appendRobot( chunk, *robot);
+		}
+		return chunk;
+	}
+	/**
+	 *
+	 */
+	/* static */void WorldSyncSender::appendWall(	std::string& aWorldInfo,
+													const Wall& aWall)
+	{
+		appendNumber( aWorldInfo, aWall.getPoint1().x);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aWall.getPoint1().y);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aWall.getPoint2().x);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aWall.getPoint2().y);
+	}
+	/**
+	 *
+	 */
+	/* static */void WorldSyncSender::appendGoal(	std::string& aWorldInfo,
+													const Goal& aGoal)
+	{
+		appendNumber( aWorldInfo, aGoal.getPosition().x);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aGoal.getPosition().y);
+	}
+	/**
+	 *
+	 */
+	/* static */void WorldSyncSender::appendRobot(	std::string& aWorldInfo,
+													const Robot& aRobot)
+	{
+		appendNumber( aWorldInfo, aRobot.getPosition().x);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aRobot.getPosition().y);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aRobot.getFront().x);
+		aWorldInfo += ',';
+		appendNumber( aWorldInfo, aRobot.getFront().y);
+		aWorldInfo += '#';
+		aWorldInfo += aRobot.getObjectId().toString();
+	}
+	/**
+	 *
+	 */
+	bool WorldSyncReceiver::chunkReceived( const WorldSyncChunkHeader& aHeader)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		std::unique_lock< std::mutex > lock( receiverMutex);
+		expireStreams( now);
+
+		auto [stream, inserted] = incomingStreams.try_emplace( aHeader.streamId);
+		IncomingStream& incomingStream = stream->second;
+		if (inserted)
+		{
+			incomingStream.numberOfChunks = aHeader.numberOfChunks;
+		} else if (incomingStream.numberOfChunks != aHeader.numberOfChunks)
+		{
+			TRACE_DEVELOP(__PRETTY_FUNCTION__ + std::string(": chunk of world sync stream ") + std::to_string( aHeader.streamId) + " with a different number of chunks");
+			return false;
+		}
+		incomingStream.lastChunkTime = now;
+		incomingStream.receivedChunkIndices.insert( aHeader.chunkIndex);
+
+		if (incomingStream.receivedChunkIndices.size() >= incomingStream.numberOfChunks)
+		{
+			incomingStreams.erase( stream);
+			return true;
+		}
+		return false;
+	}
+	/**
+	 *
+	 */
+	void WorldSyncReceiver::expireStreams( std::chrono::steady_clock::time_point aNow)
+	{
+		for (auto stream = incomingStreams.begin(); stream != incomingStreams.end();)
+		{
+			if (aNow - stream->second.lastChunkTime > streamTimeout)
+			{
+				Application::Logger::log( "World sync stream " + std::to_string( stream->first) + " expired after " + std::to_string( stream->second.receivedChunkIndices.size()) + " of " + std::to_string( stream->second.numberOfChunks) + " chunk(s)");
+				stream = incomingStreams.erase( stream);
+			} else
+			{
+				++stream;
+			}
+		}
+	}
+} // namespace Model
@@ -0,0 +1,224 @@
+#ifndef WORLDSYNC_HPP_
+#define WORLDSYNC_HPP_
+
+#include "Config.hpp"
+
+#include "Message.hpp"
+#include "WorldSnapshot.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Model
+{
+	class Robot;
+	typedef std::shared_ptr<Robot> RobotPtr;
+
+	class Goal;
+	typedef std::shared_ptr<Goal> GoalPtr;
+
+	class Wall;
+	typedef std::shared_ptr<Wall> WallPtr;
+
+	/**
+	 * The header that precedes the world info in the body of a SyncWorldChunkRequest:
+	 *
+	 * 		<streamId>,<chunkIndex>,<numberOfChunks>,<replyRequested>|<world info>
+	 *
+	 * The world info of a chunk is a fragment in the format of Robot::getWorldInfo, so every chunk
+	 * can be applied on its own by Robot::syncWorld.
+	 */
+	struct WorldSyncChunkHeader
+	{
+			unsigned long streamId = 0;
+			unsigned long chunkIndex = 0;
+			unsigned long numberOfChunks = 0;
+			bool replyRequested = false;
+			/**
+			 *
+			 * @param aChunkBody The body of a SyncWorldChunkRequest
+			 * @param aWorldInfo Is set to the world info fragment following the header
+			 * @return true if the header could be parsed, false otherwise
+			 */
+			bool fromString(	std::string_view aChunkBody,
+								std::string_view& aWorldInfo);
+			/**
+			 *
+			 */
+			void appendTo( std::string& aChunkBody) const;
+	};
+
+	/**
+	 * Streams the walls, goals and robot of RobotWorld to a remote world in chunks of at most
+	 * maximumRecordsPerChunk walls and goals. At most windowSize chunks are unacknowledged at any
+	 * time, the next chunk is sent when a SyncWorldChunkResponse comes in. Only one chunk is
+	 * serialised at a time so the memory use does not grow with the size of the world.
+	 *
+	 * If a chunk is rejected by the receiver, or gets a CommunicationReadError or CommunicationWriteError
+	 * response, the stream fails and no further chunks are sent.
+	 */
+	class WorldSyncSender : public std::enable_shared_from_this< WorldSyncSender >
+	{
+		public:
+			/**
+			 * Function that is called with the response to a chunk
+			 */
+			typedef std::function< void( const Messaging::Message&) > ResponseFunction;
+			/**
+			 * Function that sends a message to the remote world and passes its response to aResponseFunction
+			 */
+			typedef std::function< void( const Messaging::Message&, ResponseFunction) > DispatchFunction;
+			/**
+			 * Function that is called once, with true when all chunks are acknowledged or false when the stream failed
+			 */
+			typedef std::function< void( bool) > FinishFunction;
+
+			static constexpr std::size_t defaultMaximumRecordsPerChunk = 512;
+			static constexpr std::size_t defaultWindowSize = 4;
+			/**
+			 * Takes a snapshot of the pointers to the current walls, goals and robot of RobotWorld.
+			 *
+			 * @param aRobot The robot that is sent along, its ObjectId is shared with the remote copy
+			 * @param aDispatchFunction Sends the chunks
+			 * @param aFinishFunction Is called when the stream is finished or failed
+			 * @param aReplyRequested If true the receiver streams its world back after the last chunk
+			 */
+			WorldSyncSender(	RobotPtr aRobot,
+								DispatchFunction aDispatchFunction,
+								FinishFunction aFinishFunction,
+								bool aReplyRequested,
+								std::size_t aMaximumRecordsPerChunk = defaultMaximumRecordsPerChunk,
+								std::size_t aWindowSize = defaultWindowSize);
+			/**
+			 * Sends the first window of chunks. The sender must be owned by a std::shared_ptr.
+			 */
+			void start();
+			/**
+			 * Handles the response to one of the chunks: an acknowledgement sends the next chunk if any,
+			 * an error or a rejection fails the stream.
+			 */
+			void handleResponse( const Messaging::Message& aResponse);
+			/**
+			 *
+			 * @return true if all chunks are sent and acknowledged or if the stream failed
+			 */
+			bool isFinished() const;
+			/**
+			 *
+			 * @return true if the stream failed
+			 */
+			bool isFailed() const;
+			/**
+			 *
+			 */
+			unsigned long getStreamId() const
+			{
+				return streamId;
+			}
+			/**
+			 *
+			 */
+			std::size_t getNumberOfChunks() const
+			{
+				return numberOfChunks;
+			}
+			/**
+			 * @name Serialisation of the world info records
+			 *
+			 * These functions append the record with std::to_chars to the given string,
+			 * without the separator in front of the record.
+			 */
+			//@{
+			static void appendWall(	std::string& aWorldInfo,
+									const Wall& aWall);
+			static void appendGoal(	std::string& aWorldInfo,
+									const Goal& aGoal);
+			static void appendRobot(	std::string& aWorldInfo,
+										const Robot& aRobot);
+			//@}
+		private:
+			/**
+			 * Reserves chunks until the window is full or all chunks are reserved, then unlocks aLock and sends
+			 * them, so that the dispatch does not hold up the acknowledgements of other threads.
+			 */
+			void fillWindow( std::unique_lock< std::mutex >& aLock);
+			/**
+			 * Calls the finish function if the stream is finished and it was not called before
+			 */
+			void reportFinished( std::unique_lock< std::mutex >& aLock);
+			/**
+			 *
+			 */
+			std::string serialiseChunk( std::size_t aChunkIndex) const;
+
+			unsigned long streamId;
+			RobotPtr robot;
+			/**
+			 * Holds the version of the world that is streamed, walls and goals refer to it
+			 */
+			WorldSnapshotPtr worldSnapshot;
+			const std::vector< WallPtr >& walls;
+			const std::vector< GoalPtr >& goals;
+			DispatchFunction dispatchFunction;
+			FinishFunction finishFunction;
+			bool replyRequested;
+			std::size_t maximumRecordsPerChunk;
+			std::size_t windowSize;
+			std::size_t numberOfChunks;
+			std::size_t nextChunk = 0;
+			std::size_t acknowledgedChunks = 0;
+			bool failed = false;
+			bool finishReported = false;
+			mutable std::mutex senderMutex;
+
+			inline static std::atomic< unsigned long > streamCounter = 0;
+	};
+	typedef std::shared_ptr< WorldSyncSender > WorldSyncSenderPtr;
+
+	/**
+	 * Keeps track of the chunks of the incoming streams. A chunk that arrives twice is counted once,
+	 * a stream that gets no chunk for streamTimeout is dropped.
+	 */
+	class WorldSyncReceiver
+	{
+		public:
+			/**
+			 * The time an incomplete stream is kept after its last chunk
+			 */
+			static constexpr std::chrono::seconds streamTimeout = std::chrono::seconds( 60); // @suppress("Avoid magic numbers")
+			/**
+			 * Registers the chunk described by aHeader.
+			 *
+			 * @return true if this was the last missing chunk of its stream, false otherwise
+			 */
+			bool chunkReceived( const WorldSyncChunkHeader& aHeader);
+		private:
+			/**
+			 *
+			 */
+			struct IncomingStream
+			{
+					std::size_t numberOfChunks = 0;
+					std::set< unsigned long > receivedChunkIndices;
+					std::chrono::steady_clock::time_point lastChunkTime;
+			};
+			/**
+			 * Drops the incomplete streams whose last chunk came in before aNow - streamTimeout
+			 */
+			void expireStreams( std::chrono::steady_clock::time_point aNow);
+			/**
+			 * streamId -> the chunks received so far
+			 */
+			std::map< unsigned long, IncomingStream > incomingStreams;
+			std::mutex receiverMutex;
+	};
+} // namespace Model
+#endif // WORLDSYNC_HPP_